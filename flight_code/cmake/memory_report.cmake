@@ -0,0 +1,477 @@
+# Stack and memory report of the flight software, run with cmake -P once
+# the flight target links
+#
+# The worst case stack of each root is found along the call graph written
+# by -fcallgraph-info=su, which carries the frame of each function from
+# -fstack-usage. Calls through function pointers aren't in the graph, so
+# the known ones are given as caller>callee pairs. The thread mode roots
+# and each ISR root are assumed to nest, each ISR adding its exception
+# entry. The use of each memory region and its largest symbols are read
+# from the link map, along with the space left for the stack. The report
+# is written and printed, and the build fails if the worst case stack is
+# over its limit, or over the space left for it, or a region is over its
+# limit. A stamp is touched when the report passes.
+#
+# Lists are separated by commas:
+#   BUILD_DIR      build directory, searched for the call graphs
+#   MAP_FILE       link map
+#   REPORT         report file
+#   STAMP          file touched when the report passes
+#   THREAD_ROOTS   thread mode roots
+#   ISR_ROOTS      ISR roots
+#   CALLS          function pointer calls, caller>callee
+#   ISR_BYTES      stack of each ISR entry, bytes
+#   UNKNOWN_BYTES  stack allowed for a call without stack usage, bytes
+#   STACK_LIMIT    worst case stack limit, bytes, empty for the space left
+#   REGION_LIMITS  region use limits, REGION=PERCENT
+#   TOP_SYMBOLS    largest symbols listed for each region
+cmake_minimum_required(VERSION 3.13)
+foreach (var THREAD_ROOTS ISR_ROOTS CALLS REGION_LIMITS)
+  string(REPLACE "," ";" ${var} "${${var}}")
+endforeach ()
+
+# Pads a string on the left or right to a width
+function (padLeft STR WIDTH OUT)
+  string(LENGTH "${STR}" len)
+  while (len LESS WIDTH)
+    string(PREPEND STR " ")
+    math(EXPR len "${len} + 1")
+  endwhile ()
+  set(${OUT} "${STR}" PARENT_SCOPE)
+endfunction ()
+function (padRight STR WIDTH OUT)
+  string(LENGTH "${STR}" len)
+  while (len LESS WIDTH)
+    string(APPEND STR " ")
+    math(EXPR len "${len} + 1")
+  endwhile ()
+  set(${OUT} "${STR}" PARENT_SCOPE)
+endfunction ()
+# Percent to one decimal place
+function (percent NUM DEN OUT)
+  if (DEN GREATER 0)
+    math(EXPR permille "${NUM} * 1000 / ${DEN}")
+    math(EXPR whole "${permille} / 10")
+    math(EXPR tenth "${permille} % 10")
+    set(${OUT} "${whole}.${tenth}%" PARENT_SCOPE)
+  else ()
+    set(${OUT} "-" PARENT_SCOPE)
+  endif ()
+endfunction ()
+
+# Call graph
+file(GLOB_RECURSE ci_files "${BUILD_DIR}/*.ci")
+if (NOT ci_files)
+  message(FATAL_ERROR "No call graphs in ${BUILD_DIR}, -fcallgraph-info "
+    "needs GCC 10 or later")
+endif ()
+set(funcs)
+foreach (ci ${ci_files})
+  file(STRINGS ${ci} lines REGEX "^(node|edge): ")
+  foreach (line IN LISTS lines)
+    if (line MATCHES [[^node: { title: "([^"]+)" label: "([^\"]*)\\n([^\"]*)\\n([0-9]+) bytes \(([a-z,]+)\)]])
+      # A function defined here, with its frame
+      set(title "${CMAKE_MATCH_1}")
+      set(decl "${CMAKE_MATCH_2}")
+      set(loc "${CMAKE_MATCH_3}")
+      set(bytes ${CMAKE_MATCH_4})
+      set(kind "${CMAKE_MATCH_5}")
+      string(MAKE_C_IDENTIFIER "${title}" id)
+      if (NOT DEFINED bytes_${id})
+        list(APPEND funcs ${id})
+        set(bytes_${id} 0)
+      endif ()
+      # Inline functions emitted in several units keep the largest frame
+      if (bytes GREATER bytes_${id})
+        set(bytes_${id} ${bytes})
+      endif ()
+      set(decl_${id} "${decl}")
+      get_filename_component(file "${loc}" NAME)
+      set(loc_${id} "${file}")
+      if (kind MATCHES "dynamic")
+        set(dynamic_${id} TRUE)
+      endif ()
+    elseif (line MATCHES [[^node: { title: "([^"]+)" label: "([^\"]*)]])
+      # A function declared here, defined elsewhere or in a library
+      set(decl "${CMAKE_MATCH_2}")
+      string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" id)
+      if (NOT DEFINED decl_${id})
+        set(decl_${id} "${decl}")
+      endif ()
+    elseif (line MATCHES [[^edge: { sourcename: "([^"]+)" targetname: "([^"]+)"]])
+      set(target "${CMAKE_MATCH_2}")
+      string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" src)
+      if (target STREQUAL "__indirect_call")
+        set(indirect_${src} TRUE)
+      else ()
+        string(MAKE_C_IDENTIFIER "${target}" dst)
+        list(APPEND calls_${src} ${dst})
+      endif ()
+    endif ()
+  endforeach ()
+endforeach ()
+# Function names, qualified, without the return type, template arguments,
+# and parameters
+foreach (id IN LISTS funcs)
+  set(name "${decl_${id}}")
+  set(prev "")
+  while (NOT name STREQUAL prev)
+    set(prev "${name}")
+    string(REGEX REPLACE "<[^<>]*>" "" name "${name}")
+  endwhile ()
+  string(REGEX REPLACE "\\(.*$" "" name "${name}")
+  string(REGEX REPLACE "^.* " "" name "${name}")
+  set(name_${id} "${name}")
+endforeach ()
+# Functions of a name, with or without its qualifiers
+function (findFuncs NAME OUT)
+  set(found)
+  foreach (id IN LISTS funcs)
+    if ((name_${id} STREQUAL NAME) OR (name_${id} MATCHES "::${NAME}$"))
+      list(APPEND found ${id})
+    endif ()
+  endforeach ()
+  set(${OUT} ${found} PARENT_SCOPE)
+endfunction ()
+# Function pointer calls
+foreach (call IN LISTS CALLS)
+  if (NOT call MATCHES "^([^>]+)>([^>]+)$")
+    message(FATAL_ERROR "Function pointer call ${call} isn't caller>callee")
+  endif ()
+  set(callee "${CMAKE_MATCH_2}")
+  findFuncs("${CMAKE_MATCH_1}" srcs)
+  findFuncs("${callee}" dsts)
+  if (NOT srcs OR NOT dsts)
+    message(WARNING "Function pointer call ${call} not found")
+  endif ()
+  foreach (src IN LISTS srcs)
+    list(APPEND calls_${src} ${dsts})
+  endforeach ()
+endforeach ()
+
+# Worst case stack from a function, bytes, and the callee on that path.
+# Recursion, calls through unknown function pointers, dynamic frames, and
+# calls to functions without stack usage are noted.
+function (stackWorst ID)
+  get_property(done GLOBAL PROPERTY worst_${ID} SET)
+  if (done)
+    return()
+  endif ()
+  get_property(active GLOBAL PROPERTY active_${ID})
+  if (active)
+    set_property(GLOBAL APPEND PROPERTY recursive ${ID})
+    return()
+  endif ()
+  set_property(GLOBAL PROPERTY active_${ID} TRUE)
+  if (indirect_${ID})
+    set_property(GLOBAL APPEND PROPERTY indirect ${ID})
+  endif ()
+  if (dynamic_${ID})
+    set_property(GLOBAL APPEND PROPERTY dynamic ${ID})
+  endif ()
+  set(best 0)
+  set(next "")
+  foreach (callee IN LISTS calls_${ID})
+    if (DEFINED bytes_${callee})
+      stackWorst(${callee})
+      get_property(depth GLOBAL PROPERTY worst_${callee})
+      if (NOT depth)
+        set(depth ${bytes_${callee}})
+      endif ()
+    else ()
+      set_property(GLOBAL APPEND PROPERTY unknown ${callee})
+      set(depth ${UNKNOWN_BYTES})
+    endif ()
+    if (depth GREATER best)
+      set(best ${depth})
+      set(next ${callee})
+    endif ()
+  endforeach ()
+  math(EXPR total "${bytes_${ID}} + ${best}")
+  set_property(GLOBAL PROPERTY worst_${ID} ${total})
+  set_property(GLOBAL PROPERTY next_${ID} "${next}")
+  set_property(GLOBAL PROPERTY active_${ID} FALSE)
+endfunction ()
+
+set(report "Worst case stack, bytes\n")
+set(stack_total 0)
+set(num_isr 0)
+foreach (root IN LISTS THREAD_ROOTS ISR_ROOTS)
+  findFuncs("${root}" ids)
+  if (NOT ids)
+    message(WARNING "Stack root ${root} not found")
+    continue()
+  endif ()
+  set(worst 0)
+  set(worst_id "")
+  foreach (id IN LISTS ids)
+    stackWorst(${id})
+    get_property(depth GLOBAL PROPERTY worst_${id})
+    if (depth GREATER_EQUAL worst)
+      set(worst ${depth})
+      set(worst_id ${id})
+    endif ()
+  endforeach ()
+  if (root IN_LIST ISR_ROOTS)
+    set(kind "ISR")
+    math(EXPR num_isr "${num_isr} + 1")
+  else ()
+    set(kind "thread")
+  endif ()
+  math(EXPR stack_total "${stack_total} + ${worst}")
+  string(APPEND report "\n${kind} ${root}: ${worst}\n")
+  # The worst case path
+  set(id ${worst_id})
+  while (NOT id STREQUAL "")
+    if (DEFINED bytes_${id})
+      padLeft("${bytes_${id}}" 8 col)
+      string(APPEND report "${col}  ${name_${id}}  ${loc_${id}}\n")
+      get_property(id GLOBAL PROPERTY next_${id})
+    else ()
+      padLeft("${UNKNOWN_BYTES}" 8 col)
+      string(APPEND report "${col}  ${decl_${id}}  (no stack usage)\n")
+      set(id "")
+    endif ()
+  endwhile ()
+endforeach ()
+math(EXPR isr_entry "${num_isr} * ${ISR_BYTES}")
+math(EXPR stack_total "${stack_total} + ${isr_entry}")
+string(APPEND report "\nISR entries: ${num_isr} x ${ISR_BYTES}\n")
+string(APPEND report "Total, nested: ${stack_total}\n")
+# Notes on what the bound can't account for
+foreach (note recursive indirect dynamic unknown)
+  get_property(ids GLOBAL PROPERTY ${note})
+  if (NOT ids)
+    continue()
+  endif ()
+  list(REMOVE_DUPLICATES ids)
+  set(names)
+  foreach (id IN LISTS ids)
+    if (DEFINED name_${id})
+      list(APPEND names "${name_${id}}")
+    else ()
+      list(APPEND names "${decl_${id}}")
+    endif ()
+  endforeach ()
+  list(SORT names)
+  list(JOIN names ", " names)
+  if (note STREQUAL "recursive")
+    string(APPEND report "Recursion, not bounded: ${names}\n")
+  elseif (note STREQUAL "indirect")
+    string(APPEND report "Unknown function pointer calls in: ${names}\n")
+  elseif (note STREQUAL "dynamic")
+    string(APPEND report "Dynamic frames: ${names}\n")
+  else ()
+    string(APPEND report
+      "No stack usage, ${UNKNOWN_BYTES} bytes allowed: ${names}\n")
+  endif ()
+endforeach ()
+
+# Link map
+file(STRINGS ${MAP_FILE} lines)
+set(regions)
+set(in_memory FALSE)
+set(in_map FALSE)
+set(skip FALSE)
+set(out_name "")
+set(in_name "")
+set(in_size 0)
+set(in_region "")
+set(in_sym "")
+# Region of an address, or empty
+function (regionOf ADDR OUT)
+  foreach (r IN LISTS regions)
+    if ((ADDR GREATER_EQUAL origin_${r}) AND (ADDR LESS end_${r}))
+      set(${OUT} ${r} PARENT_SCOPE)
+      return()
+    endif ()
+  endforeach ()
+  set(${OUT} "" PARENT_SCOPE)
+endfunction ()
+# Adds an output section to the regions it occupies
+macro (addOutput VMA SIZE LMA)
+  if ((NOT skip) AND (${SIZE} GREATER 0))
+    regionOf(${VMA} vma_region)
+    if (vma_region)
+      math(EXPR used_${vma_region} "${used_${vma_region}} + ${SIZE}")
+    endif ()
+    if (NOT "${LMA}" STREQUAL "")
+      regionOf(${LMA} lma_region)
+      if (lma_region AND NOT lma_region STREQUAL vma_region)
+        math(EXPR used_${lma_region} "${used_${lma_region}} + ${SIZE}")
+      endif ()
+    endif ()
+  endif ()
+endmacro ()
+# Adds the pending input section to the symbols of its region
+macro (flushInput)
+  if ((NOT skip) AND in_region AND (in_size GREATER 0))
+    # Zero padded so the sizes sort as strings
+    string(LENGTH "${in_size}" len)
+    set(key "${in_size}")
+    while (len LESS 10)
+      string(PREPEND key "0")
+      math(EXPR len "${len} + 1")
+    endwhile ()
+    if (in_sym)
+      list(APPEND syms_${in_region} "${key} ${in_sym}")
+    else ()
+      list(APPEND syms_${in_region} "${key} ${in_name}")
+    endif ()
+  endif ()
+  set(in_size 0)
+  set(in_sym "")
+endmacro ()
+# Adds an input section
+macro (addInput NAME ADDR SIZE FILE)
+  flushInput()
+  math(EXPR in_addr "0x${ADDR}")
+  math(EXPR in_size "0x${SIZE}")
+  get_filename_component(in_file "${FILE}" NAME)
+  set(in_name "${NAME} (${in_file})")
+  regionOf(${in_addr} in_region)
+endmacro ()
+foreach (line IN LISTS lines)
+  if (line STREQUAL "Memory Configuration")
+    set(in_memory TRUE)
+  elseif (line STREQUAL "Linker script and memory map")
+    set(in_memory FALSE)
+    set(in_map TRUE)
+  elseif (in_memory)
+    if (line MATCHES "^([A-Za-z_][A-Za-z0-9_]*) +0x([0-9a-fA-F]+) +0x([0-9a-fA-F]+)")
+      set(r ${CMAKE_MATCH_1})
+      list(APPEND regions ${r})
+      math(EXPR origin_${r} "0x${CMAKE_MATCH_2}")
+      math(EXPR length_${r} "0x${CMAKE_MATCH_3}")
+      math(EXPR end_${r} "${origin_${r}} + ${length_${r}}")
+      set(used_${r} 0)
+      set(syms_${r})
+    endif ()
+  elseif (NOT in_map)
+    continue()
+  elseif (line MATCHES "^(\\.[^ ]+|/DISCARD/)(.*)$")
+    # Output section, its address and size wrapped onto the next line if
+    # the name is long
+    flushInput()
+    set(out_name "${CMAKE_MATCH_1}")
+    set(rest "${CMAKE_MATCH_2}")
+    set(skip FALSE)
+    if (out_name MATCHES "^(\\.debug|\\.comment|\\.ARM\\.attributes|/DISCARD/)")
+      set(skip TRUE)
+    endif ()
+    set(out_pending TRUE)
+    if (rest MATCHES "^ +0x([0-9a-f]+) +0x([0-9a-f]+)( load address 0x([0-9a-f]+))?")
+      set(out_pending FALSE)
+      set(lma "")
+      if (CMAKE_MATCH_4)
+        math(EXPR lma "0x${CMAKE_MATCH_4}")
+      endif ()
+      math(EXPR vma "0x${CMAKE_MATCH_1}")
+      math(EXPR size "0x${CMAKE_MATCH_2}")
+      addOutput(${vma} ${size} "${lma}")
+    endif ()
+  elseif (out_pending AND (line MATCHES "^ +0x([0-9a-f]+) +0x([0-9a-f]+)( load address 0x([0-9a-f]+))?$"))
+    set(out_pending FALSE)
+    set(lma "")
+    if (CMAKE_MATCH_4)
+      math(EXPR lma "0x${CMAKE_MATCH_4}")
+    endif ()
+    math(EXPR vma "0x${CMAKE_MATCH_1}")
+    math(EXPR size "0x${CMAKE_MATCH_2}")
+    addOutput(${vma} ${size} "${lma}")
+  elseif (line MATCHES "^ (\\.[^ ]+|COMMON) +0x([0-9a-f]+) +0x([0-9a-f]+) (.+)$")
+    set(out_pending FALSE)
+    addInput("${CMAKE_MATCH_1}" ${CMAKE_MATCH_2} ${CMAKE_MATCH_3}
+      "${CMAKE_MATCH_4}")
+  elseif (line MATCHES "^ (\\.[^ ]+|COMMON)$")
+    # Input section, its address and size on the next line
+    flushInput()
+    set(out_pending FALSE)
+    set(wrapped "${CMAKE_MATCH_1}")
+  elseif (wrapped AND (line MATCHES "^ +0x([0-9a-f]+) +0x([0-9a-f]+) (.+)$"))
+    addInput("${wrapped}" ${CMAKE_MATCH_1} ${CMAKE_MATCH_2} "${CMAKE_MATCH_3}")
+    set(wrapped "")
+  elseif (line MATCHES "^ +0x([0-9a-f]+) +(_estack|_ebss) = ")
+    math(EXPR ${CMAKE_MATCH_2} "0x${CMAKE_MATCH_1}")
+  elseif (line MATCHES "^ +0x([0-9a-f]+) +([^ 0*][^=]*)$")
+    # The first symbol at the start of an input section names it
+    set(sym "${CMAKE_MATCH_2}")
+    math(EXPR addr "0x${CMAKE_MATCH_1}")
+    if ((in_size GREATER 0) AND (NOT in_sym) AND (addr EQUAL in_addr))
+      set(in_sym "${sym}")
+    endif ()
+  else ()
+    set(wrapped "")
+  endif ()
+endforeach ()
+flushInput()
+
+string(APPEND report "\nMemory regions, bytes\n")
+set(fail "")
+foreach (r IN LISTS regions)
+  padRight("${r}" 8 col_r)
+  padLeft("${used_${r}}" 10 col_u)
+  padLeft("${length_${r}}" 10 col_l)
+  percent(${used_${r}} ${length_${r}} pct)
+  padLeft("${pct}" 8 col_p)
+  string(APPEND report "${col_r}${col_u} of ${col_l}${col_p}\n")
+  foreach (limit IN LISTS REGION_LIMITS)
+    if ((limit MATCHES "^${r}=([0-9]+)$") AND
+        (used_${r} GREATER 0))
+      math(EXPR used_pct "${used_${r}} * 100")
+      math(EXPR limit_pct "${length_${r}} * ${CMAKE_MATCH_1}")
+      if (used_pct GREATER limit_pct)
+        string(APPEND fail
+          "${r} use of ${pct} over its limit of ${CMAKE_MATCH_1}%\n")
+      endif ()
+    endif ()
+  endforeach ()
+endforeach ()
+foreach (r IN LISTS regions)
+  if (NOT syms_${r})
+    continue()
+  endif ()
+  list(SORT syms_${r})
+  list(REVERSE syms_${r})
+  string(APPEND report "\nLargest in ${r}, bytes\n")
+  set(n 0)
+  foreach (sym IN LISTS syms_${r})
+    if (n EQUAL TOP_SYMBOLS)
+      break()
+    endif ()
+    string(REGEX MATCH "^0*([0-9]+) (.*)$" sym "${sym}")
+    padLeft("${CMAKE_MATCH_1}" 10 col)
+    string(APPEND report "${col}  ${CMAKE_MATCH_2}\n")
+    math(EXPR n "${n} + 1")
+  endforeach ()
+endforeach ()
+
+# Limits
+string(APPEND report "\n")
+if (DEFINED _estack AND DEFINED _ebss)
+  math(EXPR stack_space "${_estack} - ${_ebss}")
+  string(APPEND report "Stack space left by the link: ${stack_space}\n")
+  if (stack_total GREATER stack_space)
+    string(APPEND fail
+      "Worst case stack ${stack_total} over the space left, ${stack_space}\n")
+  endif ()
+endif ()
+if (NOT "${STACK_LIMIT}" STREQUAL "")
+  string(APPEND report "Stack limit: ${STACK_LIMIT}\n")
+  if (stack_total GREATER STACK_LIMIT)
+    string(APPEND fail
+      "Worst case stack ${stack_total} over its limit, ${STACK_LIMIT}\n")
+  endif ()
+endif ()
+if (fail)
+  string(APPEND report "FAIL\n${fail}")
+else ()
+  string(APPEND report "PASS\n")
+endif ()
+file(WRITE ${REPORT} "${report}")
+message("${report}")
+if (fail)
+  file(REMOVE ${STAMP})
+  message(FATAL_ERROR "Memory limits exceeded, see ${REPORT}")
+endif ()
+file(TOUCH ${STAMP})
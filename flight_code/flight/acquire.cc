@@ -0,0 +1,88 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/acquire.h"
+#include "flight/global_defs.h"
+#include "flight/pres_i2c.h"
+#include "flight/gnss_uart.h"
+#include "flight/adc_scan.h"
+#include "flight/msg.h"
+
+/*
+* Sensors on slow buses are sampled from the main loop, which the frame ISR
+* preempts, so their transfers overlap with the nav, VMS, and datalog time
+* of the frame instead of adding to it. Completed samples are handed to
+* the frame through double buffers. Only devices that do not share a bus
+* with the frame are sampled here: the air data sensor and the GNSS
+* receiver share nothing with the IMU, while the FMU static pressure sensor
+* shares the IMU SPI bus and stays in the frame. The analog channels are
+* scanned continuously, one conversion per pass, and read by the analog,
+* battery, and system modules.
+*/
+
+namespace {
+/* Whether pitot static is installed */
+bool pitot_static_installed_;
+/* Frame count, one acquisition is started per frame */
+volatile uint32_t frame_cnt_ = 0;
+uint32_t acq_frame_cnt_ = 0;
+}  // namespace
+
+void AcquireInit(const SensorConfig &cfg) {
+  pitot_static_installed_ = cfg.pitot_static_installed;
+  /* Initialize GNSS */
+  if (!GnssUartInit(cfg.gnss)) {
+    MsgError("Unable to initialize GNSS.");
+  }
+  /* Initialize pressure transducers */
+  if (pitot_static_installed_) {
+    PresI2cInit(cfg);
+  }
+  /* Start the analog scan */
+  AdcScanInit();
+}
+void AcquireRun() {
+  /* Check for a new frame */
+  bool new_frame = (acq_frame_cnt_ != frame_cnt_);
+  acq_frame_cnt_ = frame_cnt_;
+  /* GNSS */
+  GnssUartPoll();
+  /* Pressure transducers */
+  if (pitot_static_installed_) {
+    PresI2cPoll(new_frame);
+  }
+  /* Analog channels */
+  AdcScanPoll();
+}
+void AcquireRead(SensorData * const data) {
+  if (!data) {return;}
+  /* Latest completed samples */
+  GnssUartRead(data);
+  if (pitot_static_installed_) {
+    PresI2cRead(data);
+  }
+  /* Trigger the next acquisition */
+  frame_cnt_ = frame_cnt_ + 1;
+}
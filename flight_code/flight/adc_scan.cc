@@ -0,0 +1,109 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/adc_scan.h"
+#include <cmath>
+#include "flight/global_defs.h"
+#include "flight/double_buffer.h"
+#include "flight/hal.h"
+
+/*
+* Continuous round-robin scan of the analog channels from the main loop.
+* Each poll performs a single conversion of the next channel in the scan,
+* accumulating ADC_OVERSAMPLING conversions per channel, after which the
+* averages, standard deviations, and conversion rates of all channels are
+* published together. The frame reads the latest published block and
+* never waits on a conversion.
+*/
+
+namespace {
+/* Scan pins */
+#if defined(__FMU_R_V2__)
+static constexpr std::array<int8_t, NUM_ADC_CH> PINS_ = {
+  AIN_PINS[0], AIN_PINS[1], AIN_PINS[2], AIN_PINS[3],
+  AIN_PINS[4], AIN_PINS[5], AIN_PINS[6], AIN_PINS[7],
+  BATTERY_VOLTAGE_PIN, BATTERY_CURRENT_PIN
+};
+#elif defined(__FMU_R_V2_BETA__)
+static constexpr std::array<int8_t, NUM_ADC_CH> PINS_ = AIN_PINS;
+#else
+static constexpr std::array<int8_t, NUM_ADC_CH> PINS_ = {
+  AIN_PINS[0], AIN_PINS[1], INPUT_VOLTAGE_PIN, REGULATED_VOLTAGE_PIN,
+  SBUS_VOLTAGE_PIN, PWM_VOLTAGE_PIN
+};
+#endif
+/* Accumulators, integer so the sums of squares are exact */
+std::array<uint64_t, NUM_ADC_CH> sum_;
+std::array<uint64_t, NUM_ADC_CH> sum_sq_;
+std::size_t ch_ = 0;
+int num_conv_ = 0;
+int64_t block_start_us_;
+/* Published blocks */
+DoubleBuffer<AdcScanData> adc_buf_;
+}  // namespace
+
+void AdcScanInit() {
+  sum_.fill(0);
+  sum_sq_.fill(0);
+  ch_ = 0;
+  num_conv_ = 0;
+  block_start_us_ = HalMicros();
+}
+void AdcScanPoll() {
+  uint64_t cnt = static_cast<uint64_t>(HalAnalogRead(PINS_[ch_]));
+  sum_[ch_] += cnt;
+  sum_sq_[ch_] += cnt * cnt;
+  if (++ch_ < NUM_ADC_CH) {return;}
+  /* End of a pass through the scan */
+  ch_ = 0;
+  if (++num_conv_ < ADC_OVERSAMPLING) {return;}
+  /* End of a block */
+  int64_t now_us = HalMicros();
+  float rate_hz = static_cast<float>(ADC_OVERSAMPLING) * 1e6f /
+                  static_cast<float>(now_us - block_start_us_);
+  AdcScanData *data = adc_buf_.back();
+  for (std::size_t i = 0; i < NUM_ADC_CH; i++) {
+    float mean = static_cast<float>(sum_[i]) /
+                 static_cast<float>(ADC_OVERSAMPLING);
+    float var = static_cast<float>(sum_sq_[i] - sum_[i] * sum_[i] /
+                                   ADC_OVERSAMPLING) /
+                static_cast<float>(ADC_OVERSAMPLING - 1);
+    data->cnt[i] = mean;
+    data->noise_cnt[i] = std::sqrt(var);
+    data->rate_hz[i] = rate_hz;
+  }
+  adc_buf_.Publish();
+  sum_.fill(0);
+  sum_sq_.fill(0);
+  num_conv_ = 0;
+  block_start_us_ = now_us;
+}
+void AdcScanRead(AdcScanData * const data) {
+  /*
+  * Only the frame reads the scan and it can't be interrupted by the main
+  * loop, so every reader in a frame gets the same block
+  */
+  adc_buf_.Read(data);
+}
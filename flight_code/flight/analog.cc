@@ -25,13 +25,20 @@
 
 #include "flight/analog.h"
 #include "flight/global_defs.h"
+#include "flight/adc_scan.h"
 #include "flight/config.h"
 #include "flight/msg.h"
 #include "polytools/polytools.h"
 
+namespace {
+AdcScanData adc_;
+}  // namespace
+
 void AnalogRead(AdcData * const data) {
+  AdcScanRead(&adc_);
   for (std::size_t i = 0; i < NUM_AIN_PINS; i++) {
-    data->volt[i] = static_cast<float>(analogRead(AIN_PINS[i])) *
-                             AIN_VOLTAGE_SCALE;
+    data->volt[i] = adc_.cnt[ADC_AIN_CH + i] * AIN_VOLTAGE_SCALE;
+    data->noise_v[i] = adc_.noise_cnt[ADC_AIN_CH + i] * AIN_VOLTAGE_SCALE;
+    data->rate_hz[i] = adc_.rate_hz[ADC_AIN_CH + i];
   }
 }
@@ -27,14 +27,18 @@
 
 #include "flight/battery.h"
 #include "flight/global_defs.h"
+#include "flight/adc_scan.h"
 #include "flight/config.h"
 #include "flight/msg.h"
 
+namespace {
+AdcScanData adc_;
+}  // namespace
+
 void BatteryRead(PowerModuleData * const data) {
-  data->voltage_v = static_cast<float>(analogRead(BATTERY_VOLTAGE_PIN)) *
-                    AIN_VOLTAGE_SCALE;
-  data->current_v = static_cast<float>(analogRead(BATTERY_CURRENT_PIN)) *
-                     AIN_VOLTAGE_SCALE;
+  AdcScanRead(&adc_);
+  data->voltage_v = adc_.cnt[ADC_BATTERY_VOLTAGE_CH] * AIN_VOLTAGE_SCALE;
+  data->current_v = adc_.cnt[ADC_BATTERY_CURRENT_CH] * AIN_VOLTAGE_SCALE;
 }
 
 #endif
@@ -59,6 +59,17 @@ AircraftConfig config = {
       .transducer = bfs::AMS5915_0010_D,
       .sampling_period_ms = FRAME_PERIOD_MS,
       .bus = &PRES_I2C_BUS
+    },
+    .redundant_imu_installed = false,
+    .redundant_imu = {
+      .dev = VN_CS,
+      .frame_rate = FRAME_RATE_HZ,
+      .bus = &IMU_SPI_BUS,
+      .accel_bias_mps2 = {0, 0, 0},
+      .mag_bias_ut = {0, 0, 0},
+      .accel_scale = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+      .mag_scale = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+      .rotation = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}
     }
   },
   .nav = {
@@ -72,5 +83,17 @@ AircraftConfig config = {
     .aircraft_type = bfs::FIXED_WING,
     .bus = &Serial4,
     .baud = 57600
+  },
+  .control = {
+    .throttle_ch = 0,
+    .roll_ch = 1,
+    .pitch_ch = 2,
+    .yaw_ch = 3,
+    .motor_arm_ch = 4,
+    .mode_ch = 5,
+    .excite_ch = 6,
+    .effector_ch = {0, 1, 2, 3, 4},
+    .cnt_zero = {1000, 1500, 1500, 1500, 1500},
+    .cnt_scale = {1000, 20, 20, 20, 20}
   }
 };
@@ -0,0 +1,274 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/control.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numbers>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+#include "flight/control_blocks.h"
+#include "flight/allocation.h"
+#include "flight/gain_table.h"
+#include "flight/excite_table.h"
+#include "flight/msg.h"
+
+/*
+* Baseline fixed-wing control law: manual and attitude stabilized modes,
+* for an aircraft with a motor ESC and left aileron, right aileron,
+* elevator, and rudder servos. The inceptor channels and the output channel
+* of each effector are given in the control config. Surface commands are
+* in degrees, positive trailing edge down and left.
+*/
+
+namespace {
+/* Frame period, s */
+static constexpr float DT_S_ = static_cast<float>(FRAME_PERIOD_MS) / 1000.0f;
+static constexpr float D2R_ = std::numbers::pi_v<float> / 180.0f;
+/* SBUS range */
+static constexpr float SBUS_MIN_ = 172;
+static constexpr float SBUS_MAX_ = 1811;
+static constexpr float SBUS_CENTER_ = 0.5f * (SBUS_MIN_ + SBUS_MAX_);
+static constexpr float SBUS_HALF_RANGE_ = 0.5f * (SBUS_MAX_ - SBUS_MIN_);
+/* Modes */
+enum Mode : int8_t {
+  MODE_MANUAL = 0,
+  MODE_STABILIZED = 1
+};
+/* Surface limit, deg, and attitude command limits, rad */
+static constexpr float SURF_LIMIT_DEG_ = 25;
+static constexpr float ROLL_LIMIT_RAD_ = 45 * D2R_;
+static constexpr float PITCH_LIMIT_RAD_ = 20 * D2R_;
+/* Attitude loops, surface deg per rad of error and per rad/s of rate */
+static constexpr CtrlPid<float>::Config ROLL_PID_ = {
+  .kp = 40, .ki = 10, .kd = 5, .dt_s = DT_S_,
+  .min = -SURF_LIMIT_DEG_, .max = SURF_LIMIT_DEG_
+};
+static constexpr CtrlPid<float>::Config PITCH_PID_ = {
+  .kp = 50, .ki = 15, .kd = 6, .dt_s = DT_S_,
+  .min = -SURF_LIMIT_DEG_, .max = SURF_LIMIT_DEG_
+};
+/*
+* Roll and pitch gain scale over indicated airspeed, m/s, and altitude
+* above home, m, roughly the inverse of dynamic pressure about the 17 m/s
+* trim speed. The telemetry parameters from GAIN_PARAM_IDX_ to the end,
+* 8 to 23, are reserved for the schedule, in table order, so it can be
+* tuned from the ground station. The defaults are replaced only once every
+* one of them is finite and positive; a partly set or invalid block keeps
+* the defaults, since a zero scale would disable the attitude loops.
+*/
+using GainSchedule = GainTable<float, 4, 2, 2>;
+static constexpr GainSchedule GAIN_SCHED_DEFAULT_(
+  GainAxis<float, 4>::Uniform(10, 25),
+  GainAxis<float, 2>({0, 300}),
+  {{
+    {{{2.0f, 2.0f}, {2.1f, 2.1f}}},
+    {{{1.3f, 1.3f}, {1.35f, 1.35f}}},
+    {{{0.7f, 0.7f}, {0.75f, 0.75f}}},
+    {{{0.45f, 0.45f}, {0.5f, 0.5f}}}
+  }});
+static_assert(GainSchedule::size() <= NUM_TELEM_PARAMS,
+              "Gain schedule doesn't fit in the telemetry parameters");
+static constexpr std::size_t GAIN_PARAM_IDX_ = NUM_TELEM_PARAMS -
+                                               GainSchedule::size();
+/*
+* System identification: an orthogonal multisine on the roll, pitch, and
+* yaw commands, with a 10 s period, started by the excitation switch in
+* stabilized mode and run for a number of periods. The table is built at
+* init so a test point costs a table read per frame.
+*/
+static constexpr std::size_t EXCITE_PERIOD_ = 10000 / FRAME_PERIOD_MS;
+static constexpr std::size_t EXCITE_FIRST_HARMONIC_ = 2;
+static constexpr std::size_t EXCITE_HARMONICS_ = 10;
+static constexpr std::size_t EXCITE_PERIODS_ = 2;
+static constexpr std::array<float, 3> EXCITE_AMP_DEG_ = {2, 2, 2};
+/* Rate gyro prefilter cutoff, Hz */
+static constexpr float RATE_FILT_HZ_ = 10;
+/*
+* Allocation of the virtual commands, throttle and roll, pitch, and yaw
+* surface deg, to the motor and surfaces. Roll and pitch have priority over
+* yaw, so surfaces shared between axes, such as elevons, keep attitude
+* control when they saturate.
+*/
+static constexpr std::size_t NUM_VIRTUAL_ = 4;
+static constexpr std::size_t NUM_EFFECTORS_ = NUM_CONTROL_EFFECTORS;
+using Allocator = EffectorAllocator<float, NUM_VIRTUAL_, NUM_EFFECTORS_>;
+static constexpr Allocator::Config ALLOC_ = {
+  .mix = {{
+    {1, 0, 0, 0},
+    {0, 1, 0, 0},
+    {0, -1, 0, 0},
+    {0, 0, -1, 0},
+    {0, 0, 0, -1}
+  }},
+  .trim = {0, 0, 0, 0, 0},
+  .min = {0, -SURF_LIMIT_DEG_, -SURF_LIMIT_DEG_, -SURF_LIMIT_DEG_,
+          -SURF_LIMIT_DEG_},
+  .max = {1, SURF_LIMIT_DEG_, SURF_LIMIT_DEG_, SURF_LIMIT_DEG_,
+          SURF_LIMIT_DEG_},
+  .priority = {2, 0, 0, 1},
+  .offset = -1,
+  /* Output channels and counts are set from the control config */
+  .ch = {-1, -1, -1, -1, -1},
+  .cnt_zero = {},
+  .cnt_scale = {}
+};
+/* Control law state */
+ControlConfig cfg_ = {};
+int8_t mode_ = MODE_MANUAL;
+CtrlPid<float> roll_pid_, pitch_pid_;
+CtrlFilter<float, 1> roll_rate_filt_, pitch_rate_filt_;
+Allocator alloc_(ALLOC_);
+GainSchedule gain_sched_ = GAIN_SCHED_DEFAULT_;
+std::array<float, GainSchedule::size()> gain_param_ = {};
+MultisineTable<3, EXCITE_PERIOD_> excite_;
+bool excite_sw_ = false;
+/*
+* Reloads the gain schedule when its telemetry parameters change. They are
+* compared bitwise, since a NaN never compares equal, so a rejected block
+* is evaluated and warned about once rather than every frame.
+*/
+void GainParamUpdate(const VmsTelemData &telem) {
+  const float *param = telem.param.data() + GAIN_PARAM_IDX_;
+  if (std::memcmp(gain_param_.data(), param,
+                  gain_param_.size() * sizeof(float)) == 0) {
+    return;
+  }
+  std::copy_n(param, gain_param_.size(), gain_param_.begin());
+  if (GainParamsPositive(gain_param_.data(), gain_param_.size())) {
+    gain_sched_.Load(gain_param_.data(), gain_param_.size());
+    return;
+  }
+  gain_sched_ = GAIN_SCHED_DEFAULT_;
+  if (std::any_of(gain_param_.begin(), gain_param_.end(),
+                  [](const float v) {return v != 0;})) {
+    MsgWarning("Gain schedule parameters not all positive, using defaults.\n");
+  }
+}
+/* Normalized stick, -1 to 1, and throttle, 0 to 1 */
+float Stick(const InceptorData &inceptor, const int8_t ch) {
+  return std::clamp((inceptor.ch[ch] - SBUS_CENTER_) / SBUS_HALF_RANGE_,
+                    -1.0f, 1.0f);
+}
+float Throttle(const InceptorData &inceptor) {
+  return std::clamp((inceptor.ch[cfg_.throttle_ch] - SBUS_MIN_) /
+                    (SBUS_MAX_ - SBUS_MIN_), 0.0f, 1.0f);
+}
+bool InceptorCh(const int8_t ch) {
+  return (ch >= 0) && (ch < NUM_SBUS_CH);
+}
+}  // namespace
+
+void ControlInit(const ControlConfig &cfg) {
+  if (!InceptorCh(cfg.throttle_ch) || !InceptorCh(cfg.roll_ch) ||
+      !InceptorCh(cfg.pitch_ch) || !InceptorCh(cfg.yaw_ch) ||
+      !InceptorCh(cfg.motor_arm_ch) || !InceptorCh(cfg.mode_ch) ||
+      !InceptorCh(cfg.excite_ch)) {
+    MsgError("Control law inceptor channel out of range.");
+  }
+  for (const int8_t ch : cfg.effector_ch) {
+    if ((ch < 0) || (static_cast<std::size_t>(ch) >= NUM_EFFECTOR_CH)) {
+      MsgError("Control law effector channel out of range.");
+    }
+  }
+  cfg_ = cfg;
+  Allocator::Config alloc = ALLOC_;
+  alloc.ch = cfg.effector_ch;
+  alloc.cnt_zero = cfg.cnt_zero;
+  alloc.cnt_scale = cfg.cnt_scale;
+  mode_ = MODE_MANUAL;
+  alloc_ = Allocator(alloc);
+  roll_pid_ = CtrlPid<float>(ROLL_PID_);
+  pitch_pid_ = CtrlPid<float>(PITCH_PID_);
+  roll_rate_filt_ = CtrlLowPass1(RATE_FILT_HZ_, DT_S_);
+  pitch_rate_filt_ = CtrlLowPass1(RATE_FILT_HZ_, DT_S_);
+  gain_sched_ = GAIN_SCHED_DEFAULT_;
+  gain_param_.fill(0);
+  excite_sw_ = false;
+  if (!excite_.Build(EXCITE_AMP_DEG_, EXCITE_FIRST_HARMONIC_,
+                     EXCITE_HARMONICS_)) {
+    MsgWarning("Excitation harmonics reach the Nyquist frequency.\n");
+  }
+}
+void ControlRun(const SysData &sys, const SensorData &sensor,
+                const NavData &nav, const VmsTelemData &telem,
+                VmsData *vms) {
+  (void)sys;
+  if (!vms) {return;}
+  GainParamUpdate(telem);
+  const InceptorData &inceptor = sensor.inceptor;
+  /* Motor arm and mode switches, failsafe is manual and disarmed */
+  bool failsafe = inceptor.failsafe;
+  vms->motors_enabled = !failsafe &&
+                        (Stick(inceptor, cfg_.motor_arm_ch) > 0.5f);
+  int8_t mode = (!failsafe && nav.nav_initialized &&
+                 (Stick(inceptor, cfg_.mode_ch) > 0)) ?
+                MODE_STABILIZED : MODE_MANUAL;
+  float p = roll_rate_filt_.Run(nav.gyro_radps[0]);
+  float q = pitch_rate_filt_.Run(nav.gyro_radps[1]);
+  /* Throttle, roll, pitch, and yaw */
+  std::array<float, NUM_VIRTUAL_> cmd;
+  cmd[0] = vms->motors_enabled ? Throttle(inceptor) : 0;
+  cmd[3] = SURF_LIMIT_DEG_ * Stick(inceptor, cfg_.yaw_ch);
+  if (mode == MODE_STABILIZED) {
+    if (mode_ != MODE_STABILIZED) {
+      roll_pid_.Reset();
+      pitch_pid_.Reset();
+    }
+    float roll_cmd = ROLL_LIMIT_RAD_ * Stick(inceptor, cfg_.roll_ch);
+    float pitch_cmd = PITCH_LIMIT_RAD_ * Stick(inceptor, cfg_.pitch_ch);
+    std::array<float, 2> scale = gain_sched_.Lookup(nav.ias_mps,
+                                                    nav.alt_rel_m);
+    cmd[1] = roll_pid_.Run(roll_cmd - nav.roll_rad, -p, scale[0]);
+    cmd[2] = pitch_pid_.Run(pitch_cmd - nav.pitch_rad, -q, scale[1]);
+    vms->aux[0] = roll_cmd;
+    vms->aux[1] = pitch_cmd;
+  } else {
+    cmd[1] = SURF_LIMIT_DEG_ * Stick(inceptor, cfg_.roll_ch);
+    cmd[2] = SURF_LIMIT_DEG_ * Stick(inceptor, cfg_.pitch_ch);
+    vms->aux[0] = nav.roll_rad;
+    vms->aux[1] = nav.pitch_rad;
+  }
+  /* Excitation, started on the switch and stopped outside stabilized */
+  bool excite_sw = Stick(inceptor, cfg_.excite_ch) > 0.5f;
+  if (mode != MODE_STABILIZED) {
+    excite_.Stop();
+  } else if (excite_sw && !excite_sw_) {
+    excite_.Start(EXCITE_PERIODS_);
+  }
+  excite_sw_ = excite_sw;
+  vms->aux[5] = excite_.active();
+  std::array<float, 3> excite = excite_.Run();
+  for (std::size_t i = 0; i < excite.size(); i++) {
+    cmd[i + 1] += excite[i];
+    vms->aux[i + 2] = excite[i];
+  }
+  mode_ = mode;
+  vms->mode = mode;
+  vms->throttle_cmd_prcnt = 100 * cmd[0];
+  /* Effector commands and PWM pulse widths */
+  alloc_.Write(alloc_.Run(cmd), &vms->pwm, &vms->sbus);
+}
@@ -25,7 +25,7 @@
 
 #include "flight/datalog.h"
 #include "flight/msg.h"
-#include "logger/logger.h"
+#include "flight/hal.h"
 #include "framing/framing.h"
 #include "./pb_encode.h"
 #include "./pb_decode.h"
@@ -42,10 +42,6 @@
 namespace {
 /* Datalog file name */
 static const char * DATA_LOG_NAME_ = "flight_data";
-/* SD card */
-SdFat32 sd_;
-/* Logger object */
-bfs::Logger<400> logger_(&sd_);
 /* Framing */
 bfs::Encoder<DatalogMessage_size> encoder;
 /* nanopb buffer for encoding */
@@ -57,10 +53,8 @@ DatalogMessage datalog_msg_;
 
 void DatalogInit() {
   MsgInfo("Initializing datalog...");
-  /* Initialize SD card */
-  sd_.begin(SdioConfig(FIFO_SDIO));
-  /* Initialize logger */
-  int file_num = logger_.Init(DATA_LOG_NAME_);
+  /* Initialize storage */
+  int file_num = HalStorageInit(DATA_LOG_NAME_);
   if (file_num < 0) {
     MsgError("Unable to initialize datalog.");
   }
@@ -77,6 +71,10 @@ void DatalogAdd(const AircraftData &ref) {
   datalog_msg_.sys_sbus_volt = ref.sys.sbus_volt;
   #endif
   datalog_msg_.sys_time_s = static_cast<double>(ref.sys.sys_time_us) / 1e6;
+  for (std::size_t i = 0; i < NUM_FRAME_STAGES; i++) {
+    datalog_msg_.sys_stage_time_us[i] = ref.sys.stage_time_us[i];
+  }
+  datalog_msg_.sys_vms_overruns = ref.sys.vms_overruns;
   /* Inceptor data */
   datalog_msg_.incept_new_data = ref.sensor.inceptor.new_data;
   datalog_msg_.incept_lost_frame = ref.sensor.inceptor.lost_frame;
@@ -86,17 +84,22 @@ void DatalogAdd(const AircraftData &ref) {
   for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
     datalog_msg_.incept_ch[i] = ref.sensor.inceptor.ch[i];
   }
-  /* IMU data */
-  datalog_msg_.imu_new_data = ref.sensor.imu.new_imu_data;
-  datalog_msg_.imu_new_mag_data = ref.sensor.imu.new_mag_data;
-  datalog_msg_.imu_healthy = ref.sensor.imu.imu_healthy;
-  datalog_msg_.imu_mag_healthy = ref.sensor.imu.mag_healthy;
-  datalog_msg_.imu_die_temp_c = ref.sensor.imu.die_temp_c;
+  datalog_msg_.incept_time_s =
+    static_cast<double>(ref.sensor.inceptor_sample.time_us) / 1e6;
+  /* IMU data, the primary source as acquired */
+  const bfs::ImuData &imu = ref.sensor.redundancy.imu[0];
+  datalog_msg_.imu_new_data = imu.new_imu_data;
+  datalog_msg_.imu_new_mag_data = imu.new_mag_data;
+  datalog_msg_.imu_healthy = imu.imu_healthy;
+  datalog_msg_.imu_mag_healthy = imu.mag_healthy;
+  datalog_msg_.imu_die_temp_c = imu.die_temp_c;
   for (std::size_t i = 0; i < 3; i++) {
-    datalog_msg_.imu_accel_mps2[i] = ref.sensor.imu.accel_mps2[i];
-    datalog_msg_.imu_gyro_radps[i] = ref.sensor.imu.gyro_radps[i];
-    datalog_msg_.imu_mag_ut[i] = ref.sensor.imu.mag_ut[i];
+    datalog_msg_.imu_accel_mps2[i] = imu.accel_mps2[i];
+    datalog_msg_.imu_gyro_radps[i] = imu.gyro_radps[i];
+    datalog_msg_.imu_mag_ut[i] = imu.mag_ut[i];
   }
+  datalog_msg_.imu_time_s =
+    static_cast<double>(ref.sensor.redundancy.imu_sample[0].time_us) / 1e6;
   /* GNSS data */
   datalog_msg_.gnss_new_data = ref.sensor.gnss.new_data;
   datalog_msg_.gnss_healthy = ref.sensor.gnss.healthy;
@@ -119,16 +122,23 @@ void DatalogAdd(const AircraftData &ref) {
   }
   datalog_msg_.gnss_lat_rad = ref.sensor.gnss.lat_rad;
   datalog_msg_.gnss_lon_rad = ref.sensor.gnss.lon_rad;
-  /* Pressure data */
+  datalog_msg_.gnss_time_s =
+    static_cast<double>(ref.sensor.gnss_sample.time_us) / 1e6;
+  /* Pressure data, the primary static source as acquired */
+  const bfs::PresData &static_pres = ref.sensor.redundancy.static_pres[0];
   datalog_msg_.pitot_static_installed = ref.sensor.pitot_static_installed;
-  datalog_msg_.pres_static_new_data = ref.sensor.static_pres.new_data;
-  datalog_msg_.pres_static_healthy = ref.sensor.static_pres.healthy;
-  datalog_msg_.pres_static_pres_pa = ref.sensor.static_pres.pres_pa;
-  datalog_msg_.pres_static_die_temp_c = ref.sensor.static_pres.die_temp_c;
+  datalog_msg_.pres_static_new_data = static_pres.new_data;
+  datalog_msg_.pres_static_healthy = static_pres.healthy;
+  datalog_msg_.pres_static_pres_pa = static_pres.pres_pa;
+  datalog_msg_.pres_static_die_temp_c = static_pres.die_temp_c;
   datalog_msg_.pres_diff_new_data = ref.sensor.diff_pres.new_data;
   datalog_msg_.pres_diff_healthy = ref.sensor.diff_pres.healthy;
   datalog_msg_.pres_diff_pres_pa = ref.sensor.diff_pres.pres_pa;
   datalog_msg_.pres_diff_die_temp_c = ref.sensor.diff_pres.die_temp_c;
+  datalog_msg_.pres_static_time_s = static_cast<double>(
+    ref.sensor.redundancy.static_pres_sample[0].time_us) / 1e6;
+  datalog_msg_.pres_diff_time_s =
+    static_cast<double>(ref.sensor.diff_pres_sample.time_us) / 1e6;
   /* Analog data */
   for (std::size_t i = 0; i < NUM_AIN_PINS; i++) {
     datalog_msg_.adc_volt[i] = ref.sensor.adc.volt[i];
@@ -217,6 +227,59 @@ void DatalogAdd(const AircraftData &ref) {
     ref.telem.flight_plan[ref.telem.current_waypoint].y;
   datalog_msg_.waypoint_z =
     ref.telem.flight_plan[ref.telem.current_waypoint].z;
+  /* Redundant sensor data */
+  const bfs::ImuData &rdnt_imu = ref.sensor.redundancy.imu[1];
+  datalog_msg_.rdnt_imu_new_data = rdnt_imu.new_imu_data;
+  datalog_msg_.rdnt_imu_new_mag_data = rdnt_imu.new_mag_data;
+  datalog_msg_.rdnt_imu_healthy = rdnt_imu.imu_healthy;
+  datalog_msg_.rdnt_imu_mag_healthy = rdnt_imu.mag_healthy;
+  datalog_msg_.rdnt_imu_die_temp_c = rdnt_imu.die_temp_c;
+  for (std::size_t i = 0; i < 3; i++) {
+    datalog_msg_.rdnt_imu_accel_mps2[i] = rdnt_imu.accel_mps2[i];
+    datalog_msg_.rdnt_imu_gyro_radps[i] = rdnt_imu.gyro_radps[i];
+    datalog_msg_.rdnt_imu_mag_ut[i] = rdnt_imu.mag_ut[i];
+  }
+  datalog_msg_.rdnt_imu_time_s =
+    static_cast<double>(ref.sensor.redundancy.imu_sample[1].time_us) / 1e6;
+  const bfs::PresData &rdnt_static = ref.sensor.redundancy.static_pres[1];
+  datalog_msg_.rdnt_pres_static_new_data = rdnt_static.new_data;
+  datalog_msg_.rdnt_pres_static_healthy = rdnt_static.healthy;
+  datalog_msg_.rdnt_pres_static_pres_pa = rdnt_static.pres_pa;
+  datalog_msg_.rdnt_pres_static_die_temp_c = rdnt_static.die_temp_c;
+  datalog_msg_.rdnt_pres_static_time_s = static_cast<double>(
+    ref.sensor.redundancy.static_pres_sample[1].time_us) / 1e6;
+  /* Vote data */
+  const VoteData &imu_vote = ref.sensor.redundancy.imu_vote;
+  const VoteData &static_vote = ref.sensor.redundancy.static_pres_vote;
+  datalog_msg_.vote_imu_miscompare = imu_vote.miscompare;
+  datalog_msg_.vote_imu_source = imu_vote.source;
+  datalog_msg_.vote_imu_switch_cnt = imu_vote.switch_cnt;
+  datalog_msg_.vote_static_miscompare = static_vote.miscompare;
+  datalog_msg_.vote_static_source = static_vote.source;
+  datalog_msg_.vote_static_switch_cnt = static_vote.switch_cnt;
+  for (std::size_t i = 0; i < NUM_REDUNDANT_SRC; i++) {
+    datalog_msg_.vote_imu_health[i] = imu_vote.health[i];
+    datalog_msg_.vote_static_health[i] = static_vote.health[i];
+  }
+  /* IMU calibration */
+  datalog_msg_.cal_accel_stored = ref.sensor.imu_cal.accel_stored;
+  datalog_msg_.cal_mag_stored = ref.sensor.imu_cal.mag_stored;
+  datalog_msg_.cal_accel_samples = ref.sensor.imu_cal.accel_samples;
+  datalog_msg_.cal_mag_samples = ref.sensor.imu_cal.mag_samples;
+  datalog_msg_.cal_accel_resid = ref.sensor.imu_cal.accel_resid;
+  datalog_msg_.cal_mag_resid = ref.sensor.imu_cal.mag_resid;
+  /* Vibration spectra, the latest update, vibe_new_data flags each update */
+  const VibrationData &vibe = ref.sensor.vibration;
+  datalog_msg_.vibe_new_data = vibe.new_data;
+  datalog_msg_.vibe_nyquist_hz = vibe.nyquist_hz;
+  for (std::size_t i = 0; i < NUM_VIBE_AXES; i++) {
+    datalog_msg_.vibe_rms[i] = vibe.rms[i];
+    datalog_msg_.vibe_peak_hz[i] = vibe.peak_hz[i];
+    datalog_msg_.vibe_peak_amp[i] = vibe.peak_amp[i];
+    for (std::size_t j = 0; j < NUM_VIBE_BANDS; j++) {
+      datalog_msg_.vibe_band_rms[i * NUM_VIBE_BANDS + j] = vibe.band_rms[i][j];
+    }
+  }
   /* Encode */
   stream_ = pb_ostream_from_buffer(data_buffer_, sizeof(data_buffer_));
   if (!pb_encode(&stream_, DatalogMessage_fields, &datalog_msg_)) {
@@ -231,11 +294,11 @@ void DatalogAdd(const AircraftData &ref) {
     return;
   }
   /* Write the data */
-  logger_.Write(encoder.Data(), encoder.Size());
+  HalStorageWrite(encoder.Data(), encoder.Size());
 }
 void DatalogClose() {
-  logger_.Close();
+  HalStorageClose();
 }
 void DatalogFlush() {
-  logger_.Flush();
+  HalStorageFlush();
 }
@@ -27,30 +27,20 @@
 #include "flight/global_defs.h"
 #include "flight/config.h"
 #include "flight/msg.h"
-
-namespace {
-/* Effectors */
-bfs::SbusTx sbus;
-bfs::PwmTx<NUM_PWM_PINS> pwm;
-}  // namespace
+#include "flight/hal.h"
 
 void EffectorsInit() {
   MsgInfo("Intializing effectors...");
-  /* Init SBUS */
-  sbus.Init(&SBUS_UART);
-  /* Init PWM */
-  pwm.Init(PWM_PINS);
+  /* Init SBUS and PWM */
+  HalEffectorsInit();
   MsgInfo("done.\n");
 }
 void EffectorsCmd(const VmsData &vms) {
   /* Set effector commands */
-  sbus.ch(vms.sbus.cnt);
-  sbus.ch17(vms.sbus.ch17);
-  sbus.ch18(vms.sbus.ch18);
-  pwm.ch(vms.pwm.cnt);
+  HalSbusCmd(vms.sbus);
+  HalPwmCmd(vms.pwm);
 }
 void EffectorsWrite() {
   /* Write the effector commands */
-  sbus.Write();
-  pwm.Write();
+  HalEffectorsWrite();
 }
@@ -25,15 +25,13 @@
 
 #include "flight/hardware_defs.h"
 #include "flight/global_defs.h"
-#include "flight/config.h"
-#include "flight/msg.h"
-#include "flight/sys.h"
-#include "flight/sensors.h"
+#include "flight/frame.h"
+#include "flight/hal.h"
 #include "flight/effectors.h"
-#include "flight/nav.h"
-#include "flight/vms.h"
-#include "flight/datalog.h"
-#include "flight/telem.h"
+#if defined(__TIMING_CAL__)
+#include "flight/msg.h"
+#include "flight/timing_cal.h"
+#endif
 
 /* Aircraft data */
 AircraftData data;
@@ -62,45 +60,24 @@ void run() {
   digitalWriteFast(BFS_INT1, HIGH);
   digitalWriteFast(BFS_INT2, LOW);
   #endif
-  /* System data */
-  SysRead(&data.sys);
-  /* Sensor data */
-  SensorsRead(&data.sensor);
-  /* Nav filter */
-  NavRun(data.sensor, &data.nav);
-  /* VMS */
-  VmsRun(data.sys, data.sensor, data.nav, data.telem, &data.vms);
-  /* Command effectors */
-  EffectorsCmd(data.vms);
-  /* Datalog */
-  DatalogAdd(data);
-  /* Telemetry */
-  TelemUpdate(data, &data.telem);
-  /* Frame duration */
-  SysFrameEnd();
+  /* Sensors, nav, VMS, effector commands, datalog, and telemetry */
+  FrameRun(&data);
 }
 
 int main() {
-  /* Init the message bus */
+  #if defined(__TIMING_CAL__)
+  /* Print the timing calibration kernel cycles instead of flying */
+  HalInit();
   MsgBegin();
-  /* Init system */
-  SysInit();
-  /* Init sensors */
-  SensorsInit(config.sensor);
-  /* Init nav */
-  NavInit(config.nav);
-  /* Init effectors */
-  EffectorsInit();
-  /* Init VMS */
-  VmsInit();
-  /* Init telemetry */
-  TelemInit(config, &data.telem);
-  /* Init datalog */
-  DatalogInit();
+  TimingCalRun();
+  HalHalt();
+  #endif
+  /* Init the flight software */
+  FrameInit(&data);
   /* Attach data ready interrupt */
-  attachInterrupt(IMU_DRDY, run, RISING);
+  HalAttachFrame(run);
   while (1) {
-    /* Flush datalog */
-    DatalogFlush();
+    /* Background acquisition and datalog flushing */
+    FrameBackground();
   }
 }
@@ -0,0 +1,124 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/frame.h"
+#include "flight/global_defs.h"
+#include "flight/config.h"
+#include "flight/msg.h"
+#include "flight/sys.h"
+#include "flight/sensors.h"
+#include "flight/vote.h"
+#include "flight/imu_cal.h"
+#include "flight/param_store.h"
+#include "flight/vibration.h"
+#include "flight/profile.h"
+#include "flight/acquire.h"
+#include "flight/effectors.h"
+#include "flight/nav.h"
+#include "flight/vms.h"
+#include "flight/datalog.h"
+#include "flight/telem.h"
+
+void FrameInit(AircraftData * const data) {
+  if (!data) {return;}
+  /* Init the message bus */
+  MsgBegin();
+  /* Init system */
+  SysInit();
+  /* Init sensors */
+  SensorsInit(config.sensor);
+  /* Init nav */
+  NavInit(config.nav);
+  /* Init effectors */
+  EffectorsInit();
+  /* Init VMS */
+  VmsInit();
+  /* Init telemetry */
+  TelemInit(config, &data->telem);
+  /* Init datalog */
+  DatalogInit();
+}
+void FrameRun(AircraftData * const data) {
+  if (!data) {return;}
+  /* System data */
+  SysRead(&data->sys);
+  ProfileRead(&data->sys.stage_time_us);
+  data->sys.vms_overruns = VmsOverruns();
+  /* Sensor data */
+  ProfileStart(FRAME_STAGE_SENSORS);
+  SensorsRead(&data->sensor);
+  ProfileStop(FRAME_STAGE_SENSORS);
+  /* Vote redundant sensors */
+  ProfileStart(FRAME_STAGE_VOTE);
+  VoteRun(&data->sensor);
+  ProfileStop(FRAME_STAGE_VOTE);
+  /* IMU calibration, motors enabled from the previous frame */
+  ImuCalSample(data->sensor.redundancy.imu[0], data->vms.motors_enabled);
+  ImuCalRead(&data->sensor.imu_cal);
+  /* Vibration spectra of the voted IMU */
+  VibrationSample(data->sensor.imu);
+  VibrationRead(&data->sensor.vibration);
+  /* Nav filter */
+  ProfileStart(FRAME_STAGE_NAV);
+  NavRun(data->sensor, &data->nav);
+  ProfileStop(FRAME_STAGE_NAV);
+  /* VMS */
+  ProfileStart(FRAME_STAGE_VMS);
+  VmsRun(data->sys, data->sensor, data->nav, data->telem, &data->vms);
+  ProfileStop(FRAME_STAGE_VMS);
+  /* Command effectors */
+  ProfileStart(FRAME_STAGE_EFFECTORS);
+  EffectorsCmd(data->vms);
+  ProfileStop(FRAME_STAGE_EFFECTORS);
+  /* Datalog */
+  ProfileStart(FRAME_STAGE_DATALOG);
+  DatalogAdd(*data);
+  ProfileStop(FRAME_STAGE_DATALOG);
+  /* Telemetry */
+  ProfileStart(FRAME_STAGE_TELEM);
+  TelemUpdate(*data, &data->telem);
+  ProfileStop(FRAME_STAGE_TELEM);
+  /* Frame duration */
+  SysFrameEnd();
+}
+void FrameBackground() {
+  /*
+  * VMS rate groups below the frame rate first, so the other background
+  * work doesn't delay them toward their next release
+  */
+  VmsBackground();
+  /* Background sensor acquisition */
+  AcquireRun();
+  /* IMU calibration */
+  ImuCalRun();
+  /* Parameters set from the ground station */
+  ParamStoreRun();
+  /* Vibration spectra */
+  VibrationRun();
+  /* VMS frame budget */
+  VmsBudgetCheck();
+  /* Flush datalog */
+  DatalogFlush();
+}
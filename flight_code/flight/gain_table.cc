@@ -0,0 +1,79 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/gain_table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+/*
+* Interval and fraction of x on an axis, held at the ends. A NaN x holds
+* the interval of the last lookup, at its lower breakpoint.
+*/
+void Find(const float * const bp, const std::size_t n, const float x,
+          int32_t * const idx, std::size_t * const i, float * const frac) {
+  if (n < 2) {
+    *i = 0;
+    *frac = 0;
+    return;
+  }
+  std::size_t last = std::min(static_cast<std::size_t>(std::max(*idx, 0)),
+                              n - 2);
+  if (std::isnan(x)) {
+    *i = last;
+    *frac = 0;
+    return;
+  }
+  *i = GainInterval(bp, n, x, last);
+  *idx = static_cast<int32_t>(*i);
+  *frac = std::clamp((x - bp[*i]) / (bp[*i + 1] - bp[*i]), 0.0f, 1.0f);
+}
+}  // namespace
+
+void GainTableLookup(const float * x_bp, const int32_t nx,
+                     const float * y_bp, const int32_t ny,
+                     const float * val, const int32_t m,
+                     const float x, const float y, int32_t * idx,
+                     float * gains) {
+  if (!x_bp || !y_bp || !val || !idx || !gains || (nx < 1) || (ny < 1) ||
+      (m < 1)) {
+    return;
+  }
+  std::size_t sx = static_cast<std::size_t>(nx);
+  std::size_t sy = static_cast<std::size_t>(ny);
+  std::size_t sm = static_cast<std::size_t>(m);
+  std::size_t i, j;
+  float fx, fy;
+  Find(x_bp, sx, x, &idx[0], &i, &fx);
+  Find(y_bp, sy, y, &idx[1], &j, &fy);
+  std::size_t ix = std::min(i + 1, sx - 1), jy = std::min(j + 1, sy - 1);
+  auto cell = [&](const std::size_t a, const std::size_t b) {
+    return val + (a * sy + b) * sm;
+  };
+  GainInterp(cell(i, j), cell(i, jy), cell(ix, j), cell(ix, jy), sm, fx, fy,
+             gains);
+}
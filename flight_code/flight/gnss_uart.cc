@@ -0,0 +1,143 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/gnss_uart.h"
+#include "flight/global_defs.h"
+#include "flight/double_buffer.h"
+#include "flight/ubx.h"
+#include "flight/hal.h"
+
+/*
+* UBX bytes are drained and parsed from the main loop in bounded slices,
+* and each completed epoch is published to a double buffer, so the frame
+* cost of GNSS is a fixed size copy regardless of how much UBX traffic
+* arrived during the frame.
+*
+* The receiver sends each epoch as a burst of UBX messages right after the
+* solution is computed, so epochs are timed by the arrival of the first
+* byte of the burst, rather than when parsing completed. The FMU has no
+* time pulse input; the arrival time is the time the byte was read, less
+* the time to receive the bytes read after it.
+*/
+
+namespace {
+/* Fix with arrival time */
+struct GnssSample {
+  bfs::GnssData data;
+  int64_t time_us;
+};
+/* Receiver */
+UbxParser ubx_;
+/* Completed fixes */
+DoubleBuffer<GnssSample> gnss_buf_;
+/* Bytes parsed per poll */
+static constexpr std::size_t MAX_BYTES_PER_POLL_ = 64;
+uint8_t rx_buf_[MAX_BYTES_PER_POLL_];
+/* Time to wait for UBX data on init, ms */
+static constexpr int32_t INIT_TIMEOUT_MS_ = 5000;
+/* Missed epochs before the receiver is unhealthy */
+static constexpr int64_t HEALTHY_EPOCHS_ = 5;
+int64_t healthy_timeout_us_;
+/* Fixes older than two epochs are stale */
+int64_t max_sample_age_us_;
+/* Time to receive a byte, us */
+int64_t byte_time_us_;
+/* Arrival time of the first byte of the epoch being parsed */
+bool epoch_started_ = false;
+int64_t epoch_start_us_;
+}  // namespace
+
+bool GnssUartInit(const bfs::GnssConfig &cfg) {
+  if (!HalGnssBegin(cfg)) {return false;}
+  healthy_timeout_us_ = HEALTHY_EPOCHS_ * cfg.sampling_period_ms * 1000;
+  max_sample_age_us_ = 2 * cfg.sampling_period_ms * 1000;
+  /* 10 bits per byte with start and stop bits */
+  byte_time_us_ = (cfg.baud > 0) ? 10000000 / cfg.baud : 0;
+  /* Wait for a complete epoch */
+  for (int32_t t_ms = 0; t_ms < INIT_TIMEOUT_MS_; t_ms++) {
+    std::size_t n;
+    while ((n = HalGnssRead(rx_buf_, sizeof(rx_buf_))) > 0) {
+      for (std::size_t i = 0; i < n; i++) {
+        if (ubx_.Parse(rx_buf_[i])) {
+          return true;
+        }
+      }
+    }
+    HalDelayMs(1);
+  }
+  return false;
+}
+void GnssUartPoll() {
+  std::size_t n = HalGnssRead(rx_buf_, sizeof(rx_buf_));
+  int64_t read_us = HalMicros();
+  for (std::size_t i = 0; i < n; i++) {
+    if (!epoch_started_) {
+      epoch_started_ = true;
+      epoch_start_us_ = read_us -
+                        static_cast<int64_t>(n - 1 - i) * byte_time_us_;
+    }
+    if (ubx_.Parse(rx_buf_[i])) {
+      epoch_started_ = false;
+      GnssSample *sample = gnss_buf_.back();
+      const UbxNavData &ubx = ubx_.data();
+      sample->time_us = epoch_start_us_;
+      sample->data.new_data = true;
+      sample->data.healthy = true;
+      sample->data.fix = ubx.fix;
+      sample->data.num_sats = ubx.num_sats;
+      sample->data.week = ubx.week;
+      sample->data.tow_ms = ubx.tow_ms;
+      sample->data.alt_wgs84_m = ubx.alt_wgs84_m;
+      sample->data.alt_msl_m = ubx.alt_msl_m;
+      sample->data.hdop = ubx.hdop;
+      sample->data.vdop = ubx.vdop;
+      sample->data.track_rad = ubx.track_rad;
+      sample->data.spd_mps = ubx.spd_mps;
+      sample->data.horz_acc_m = ubx.horz_acc_m;
+      sample->data.vert_acc_m = ubx.vert_acc_m;
+      sample->data.vel_acc_mps = ubx.vel_acc_mps;
+      sample->data.track_acc_rad = ubx.track_acc_rad;
+      sample->data.ned_vel_mps[0] = ubx.ned_vel_mps[0];
+      sample->data.ned_vel_mps[1] = ubx.ned_vel_mps[1];
+      sample->data.ned_vel_mps[2] = ubx.ned_vel_mps[2];
+      sample->data.lat_rad = ubx.lat_rad;
+      sample->data.lon_rad = ubx.lon_rad;
+      gnss_buf_.Publish();
+    }
+  }
+}
+void GnssUartRead(SensorData * const data) {
+  if (!data) {return;}
+  GnssSample sample;
+  bool new_data = gnss_buf_.Read(&sample);
+  int64_t age_us = HalMicros() - sample.time_us;
+  data->gnss = sample.data;
+  data->gnss.new_data = new_data;
+  data->gnss.healthy = (gnss_buf_.count() > 0) &&
+                       (age_us < healthy_timeout_us_);
+  data->gnss_sample.time_us = sample.time_us;
+  data->gnss_sample.fresh = (gnss_buf_.count() > 0) &&
+                            (age_us <= max_sample_age_us_);
+}
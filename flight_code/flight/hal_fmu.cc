@@ -0,0 +1,395 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/hal.h"
+#include <algorithm>
+#include "flight/hardware_defs.h"
+#include "flight/global_defs.h"
+#include "flight/config.h"
+#include "mpu9250/mpu9250.h"
+#include "bme280/bme280.h"
+#include "ams5915/ams5915.h"
+#include "sbus/sbus.h"
+#include "pwm/pwm.h"
+#include "logger/logger.h"
+
+/* FMU implementation of the hardware abstraction layer */
+
+namespace {
+/* Sensors */
+bfs::Mpu9250 imu_;
+bfs::Mpu9250 redundant_imu_;
+bfs::Bme280 fmu_static_pres_;
+bfs::Ams5915 static_pres_;
+bfs::Ams5915 diff_pres_;
+/*
+* Non-blocking reads on the air data I2C bus. Wire only offers blocking
+* transfers, which wait without bound on a stretched clock or a stuck
+* slave, so reads are driven from the I2C peripheral registers, after Wire
+* has set up the pins and clock: LPI2C1 behind Wire on the Teensy 4.1, and
+* I2C1 behind Wire1 on the Teensy 3.6. Each poll checks the peripheral
+* status and returns.
+*/
+uint8_t pres_i2c_buf_[HAL_I2C_MAX_READ];
+std::size_t pres_i2c_len_ = 0;
+std::size_t pres_i2c_cnt_ = 0;
+#if !defined(__IMXRT1062__)
+/* Address sent, the receive is yet to start */
+bool pres_i2c_addr_phase_ = false;
+#endif
+/* Effectors */
+bfs::SbusTx sbus_;
+bfs::PwmTx<NUM_PWM_PINS> pwm_;
+/* GNSS receiver */
+HardwareSerial *gnss_bus_ = nullptr;
+/*
+* Inceptor receiver. The Teensy core owns the UART interrupt and buffers
+* the received bytes, so they are drained from a timer interrupt at a
+* fraction of the SBUS frame time and stamped by their position in the
+* buffer. SBUS is 100000 baud, 8E2: 12 bits per byte. The timer runs at a
+* higher priority than the frame, the GPIO interrupt at the core default of
+* 128, so a long frame doesn't delay the drain and open false gaps between
+* the bytes of an SBUS frame. On the Teensy 4.1 the PIT channels share an
+* interrupt, so the effector timer runs at this priority too.
+*/
+IntervalTimer inceptor_timer_;
+void (*inceptor_rx_)(const uint8_t, const int64_t) = nullptr;
+static constexpr int32_t SBUS_BAUD_ = 100000;
+static constexpr int64_t SBUS_BYTE_US_ = 120;
+static constexpr int32_t INCEPTOR_POLL_US_ = 500;
+static constexpr uint8_t INCEPTOR_PRIORITY_ = 64;
+/* SD card */
+SdFat32 sd_;
+/* Logger object */
+bfs::Logger<400> logger_(&sd_);
+/* Frame ISR and data ready edge times */
+void (*frame_isr_)() = nullptr;
+volatile int64_t imu_drdy_us_ = 0;
+volatile int64_t redundant_imu_drdy_us_ = 0;
+/* Redundant IMU edge already stamped by the frame, see below */
+volatile bool redundant_imu_drdy_held_ = false;
+/* The IMU data ready edge starts the frame */
+void ImuDrdyIsr() {
+  imu_drdy_us_ = micros64();
+  frame_isr_();
+}
+void RedundantImuDrdyIsr() {
+  if (redundant_imu_drdy_held_) {
+    redundant_imu_drdy_held_ = false;
+    return;
+  }
+  redundant_imu_drdy_us_ = micros64();
+}
+/* Redundant IMU data ready edge waiting on its interrupt */
+bool RedundantImuDrdyPending() {
+  #if defined(__IMXRT1062__)
+  /* GPIO interrupt status register, 6 words past the data register */
+  return portOutputRegister(VN_DRDY)[6] & digitalPinToBitMask(VN_DRDY);
+  #else
+  return *portConfigRegister(VN_DRDY) & PORT_PCR_ISF;
+  #endif
+}
+void InceptorIsr() {
+  int n = SBUS_UART.available();
+  int64_t t_us = micros64();
+  for (int i = 0; i < n; i++) {
+    inceptor_rx_(static_cast<uint8_t>(SBUS_UART.read()),
+                 t_us - static_cast<int64_t>(n - 1 - i) * SBUS_BYTE_US_);
+  }
+}
+}  // namespace
+
+void HalInit() {
+  /* Pullup CS pins */
+  pinMode(IMU_CS, OUTPUT);
+  pinMode(VN_CS, OUTPUT);
+  pinMode(PRES_CS, OUTPUT);
+  digitalWriteFast(IMU_CS, HIGH);
+  digitalWriteFast(VN_CS, HIGH);
+  digitalWriteFast(PRES_CS, HIGH);
+  /* Initialize buses */
+  #if defined(__FMU_R_V2__) || defined(__FMU_R_V2_BETA__)
+  /* I2C */
+  Wire.begin();
+  Wire.setClock(PRES_I2C_CLOCK_HZ);
+  #endif
+  #if defined(__FMU_R_V1__)
+  /* I2C */
+  Wire1.begin();
+  Wire1.setClock(PRES_I2C_CLOCK_HZ);
+  /* BFS */
+  pinMode(BFS_INT1, OUTPUT);
+  pinMode(BFS_INT2, OUTPUT);
+  #endif
+  SPI.begin();
+  /* Setup analog for voltage monitoring */
+  analogReadResolution(ANALOG_RESOLUTION_BITS);
+  /* Enable the cycle counter */
+  ARM_DEMCR = ARM_DEMCR | ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL = ARM_DWT_CTRL | ARM_DWT_CTRL_CYCCNTENA;
+}
+int64_t HalMicros() {
+  return micros64();
+}
+void HalDelayMs(const int32_t ms) {
+  delay(ms);
+}
+void HalHalt() {
+  while (1) {}
+}
+void HalAttachFrame(void (*isr)()) {
+  frame_isr_ = isr;
+  attachInterrupt(IMU_DRDY, ImuDrdyIsr, RISING);
+}
+uint32_t HalCycles() {
+  return ARM_DWT_CYCCNT;
+}
+uint32_t HalCycleHz() {
+  #if defined(__IMXRT1062__)
+  return F_CPU_ACTUAL;
+  #else
+  return F_CPU;
+  #endif
+}
+void HalMsgBegin() {
+  MSG_BUS.begin(115200);
+  if (DEBUG) {
+    while (!MSG_BUS) {}
+  }
+}
+void HalMsgPrint(const char * str) {
+  MSG_BUS.print(str);
+}
+bool HalImuInit(const bfs::ImuConfig &cfg) {
+  return imu_.Init(cfg);
+}
+bool HalImuRead(bfs::ImuData * const data) {
+  return imu_.Read(data);
+}
+int64_t HalImuDrdyTime() {
+  /* Set by the frame ISR itself */
+  return imu_drdy_us_;
+}
+bool HalRedundantImuInit(const bfs::ImuConfig &cfg) {
+  if (!redundant_imu_.Init(cfg)) {return false;}
+  attachInterrupt(VN_DRDY, RedundantImuDrdyIsr, RISING);
+  return true;
+}
+bool HalRedundantImuRead(bfs::ImuData * const data) {
+  return redundant_imu_.Read(data);
+}
+int64_t HalRedundantImuDrdyTime() {
+  /*
+  * Both data ready pins are on the same GPIO interrupt, port A on the
+  * Teensy 3.6 and GPIO6-9 on the Teensy 4.1, so the redundant IMU ISR can't
+  * run above the frame. An edge during the frame would be stamped only once
+  * the frame returns, so a pending edge is stamped here instead, late by
+  * at most the time since the frame started, and its ISR keeps that stamp.
+  */
+  noInterrupts();
+  if (!redundant_imu_drdy_held_ && RedundantImuDrdyPending()) {
+    redundant_imu_drdy_us_ = micros64();
+    redundant_imu_drdy_held_ = true;
+  }
+  int64_t t = redundant_imu_drdy_us_;
+  interrupts();
+  return t;
+}
+bool HalFmuStaticPresInit(const bfs::PresConfig &cfg) {
+  return fmu_static_pres_.Init(cfg);
+}
+bool HalFmuStaticPresRead(bfs::PresData * const data) {
+  return fmu_static_pres_.Read(data);
+}
+bool HalStaticPresInit(const bfs::PresConfig &cfg) {
+  return static_pres_.Init(cfg);
+}
+bool HalDiffPresInit(const bfs::PresConfig &cfg) {
+  return diff_pres_.Init(cfg);
+}
+#if defined(__IMXRT1062__)
+void HalPresI2cReadStart(const uint8_t addr, const std::size_t len) {
+  pres_i2c_len_ = std::min(len, HAL_I2C_MAX_READ);
+  pres_i2c_cnt_ = 0;
+  /* Clear the FIFOs and flags, then queue START, receive, and STOP */
+  IMXRT_LPI2C1.MCR = IMXRT_LPI2C1.MCR | LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+  IMXRT_LPI2C1.MSR = LPI2C_MSR_SDF | LPI2C_MSR_NDF | LPI2C_MSR_ALF |
+                     LPI2C_MSR_FEF | LPI2C_MSR_PLTF;
+  IMXRT_LPI2C1.MTDR = LPI2C_MTDR_CMD_START |
+                      static_cast<uint32_t>((addr << 1) | 1);
+  IMXRT_LPI2C1.MTDR = LPI2C_MTDR_CMD_RECEIVE |
+                      static_cast<uint32_t>(pres_i2c_len_ - 1);
+  IMXRT_LPI2C1.MTDR = LPI2C_MTDR_CMD_STOP;
+}
+HalI2cStatus HalPresI2cReadPoll(uint8_t * const buf) {
+  uint32_t msr = IMXRT_LPI2C1.MSR;
+  if (msr & (LPI2C_MSR_NDF | LPI2C_MSR_ALF | LPI2C_MSR_FEF |
+             LPI2C_MSR_PLTF)) {
+    return HAL_I2C_ERROR;
+  }
+  while (pres_i2c_cnt_ < pres_i2c_len_) {
+    uint32_t rx = IMXRT_LPI2C1.MRDR;
+    if (rx & LPI2C_MRDR_RXEMPTY) {break;}
+    pres_i2c_buf_[pres_i2c_cnt_++] = static_cast<uint8_t>(rx);
+  }
+  /* Done once the STOP is sent and every byte read */
+  if ((pres_i2c_cnt_ < pres_i2c_len_) || !(msr & LPI2C_MSR_SDF)) {
+    return HAL_I2C_BUSY;
+  }
+  std::copy_n(pres_i2c_buf_, pres_i2c_len_, buf);
+  return HAL_I2C_DONE;
+}
+void HalPresI2cAbort() {
+  IMXRT_LPI2C1.MCR = IMXRT_LPI2C1.MCR | LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+}
+#else
+void HalPresI2cReadStart(const uint8_t addr, const std::size_t len) {
+  pres_i2c_len_ = std::min(len, HAL_I2C_MAX_READ);
+  pres_i2c_cnt_ = 0;
+  pres_i2c_addr_phase_ = true;
+  /* START, then the address with the read bit */
+  I2C1_S = I2C_S_IICIF | I2C_S_ARBL;
+  I2C1_C1 = I2C_C1_IICEN | I2C_C1_MST | I2C_C1_TX;
+  I2C1_D = static_cast<uint8_t>((addr << 1) | 1);
+}
+HalI2cStatus HalPresI2cReadPoll(uint8_t * const buf) {
+  uint8_t s = I2C1_S;
+  if (s & I2C_S_ARBL) {return HAL_I2C_ERROR;}
+  /* Each byte transferred sets the interrupt flag */
+  if (!(s & I2C_S_IICIF)) {return HAL_I2C_BUSY;}
+  I2C1_S = I2C_S_IICIF;
+  if (pres_i2c_addr_phase_) {
+    if (s & I2C_S_RXAK) {
+      I2C1_C1 = I2C_C1_IICEN;
+      return HAL_I2C_ERROR;
+    }
+    /* Switch to receive, NACK the byte if it is the only one, and start
+    * its transfer with a dummy read */
+    pres_i2c_addr_phase_ = false;
+    I2C1_C1 = I2C_C1_IICEN | I2C_C1_MST |
+              ((pres_i2c_len_ == 1) ? I2C_C1_TXAK : 0);
+    (void) I2C1_D;
+    return HAL_I2C_BUSY;
+  }
+  if (pres_i2c_cnt_ + 1 == pres_i2c_len_) {
+    /* STOP before reading the last byte, so no further byte is clocked */
+    I2C1_C1 = I2C_C1_IICEN;
+  } else if (pres_i2c_cnt_ + 2 == pres_i2c_len_) {
+    /* NACK the last byte */
+    I2C1_C1 = I2C_C1_IICEN | I2C_C1_MST | I2C_C1_TXAK;
+  }
+  pres_i2c_buf_[pres_i2c_cnt_++] = I2C1_D;
+  if (pres_i2c_cnt_ < pres_i2c_len_) {return HAL_I2C_BUSY;}
+  std::copy_n(pres_i2c_buf_, pres_i2c_len_, buf);
+  return HAL_I2C_DONE;
+}
+void HalPresI2cAbort() {
+  /* Release the bus, a slave still holding it is left to the recovery */
+  I2C1_C1 = I2C_C1_IICEN;
+}
+#endif
+void HalPresI2cTakeover() {
+  /* SDA released, SCL driven open drain and released high */
+  pinMode(PRES_I2C_SDA, INPUT_PULLUP);
+  pinMode(PRES_I2C_SCL, OUTPUT_OPENDRAIN);
+  digitalWriteFast(PRES_I2C_SCL, HIGH);
+}
+bool HalPresI2cSda() {
+  return digitalReadFast(PRES_I2C_SDA);
+}
+void HalPresI2cSda(const bool high) {
+  pinMode(PRES_I2C_SDA, OUTPUT_OPENDRAIN);
+  digitalWriteFast(PRES_I2C_SDA, high);
+}
+void HalPresI2cScl(const bool high) {
+  digitalWriteFast(PRES_I2C_SCL, high);
+}
+void HalPresI2cRestart() {
+  PRES_I2C_BUS.begin();
+  PRES_I2C_BUS.setClock(PRES_I2C_CLOCK_HZ);
+}
+bool HalGnssBegin(const bfs::GnssConfig &cfg) {
+  if (!cfg.bus) {return false;}
+  gnss_bus_ = cfg.bus;
+  gnss_bus_->begin(cfg.baud);
+  return true;
+}
+std::size_t HalGnssRead(uint8_t * const buf, const std::size_t len) {
+  std::size_t n = 0;
+  while ((n < len) && (gnss_bus_->available() > 0)) {
+    buf[n++] = static_cast<uint8_t>(gnss_bus_->read());
+  }
+  return n;
+}
+bool HalInceptorBegin(void (*rx)(const uint8_t byte, const int64_t time_us)) {
+  if (!rx) {return false;}
+  inceptor_rx_ = rx;
+  SBUS_UART.begin(SBUS_BAUD_, SERIAL_8E2_RXINV_TXINV);
+  inceptor_timer_.priority(INCEPTOR_PRIORITY_);
+  return inceptor_timer_.begin(InceptorIsr, INCEPTOR_POLL_US_);
+}
+int32_t HalAnalogRead(const int8_t pin) {
+  return analogRead(pin);
+}
+void HalEffectorsInit() {
+  sbus_.Init(&SBUS_UART);
+  pwm_.Init(PWM_PINS);
+}
+/* The effector timer can preempt the frame, so commands are set atomically */
+void HalSbusCmd(const SbusCmd &cmd) {
+  noInterrupts();
+  sbus_.ch(cmd.cnt);
+  sbus_.ch17(cmd.ch17);
+  sbus_.ch18(cmd.ch18);
+  interrupts();
+}
+void HalPwmCmd(const PwmCmd &cmd) {
+  noInterrupts();
+  pwm_.ch(cmd.cnt);
+  interrupts();
+}
+void HalEffectorsWrite() {
+  sbus_.Write();
+  pwm_.Write();
+}
+uint8_t HalEepromRead(const std::size_t addr) {
+  return EEPROM.read(addr);
+}
+void HalEepromWrite(const std::size_t addr, const uint8_t val) {
+  EEPROM.write(addr, val);
+}
+int HalStorageInit(const char * name) {
+  sd_.begin(SdioConfig(FIFO_SDIO));
+  return logger_.Init(name);
+}
+void HalStorageWrite(const uint8_t * const data, const std::size_t len) {
+  logger_.Write(data, len);
+}
+void HalStorageFlush() {
+  logger_.Flush();
+}
+void HalStorageClose() {
+  logger_.Close();
+}
@@ -0,0 +1,580 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/imu_cal.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "flight/global_defs.h"
+#include "flight/double_buffer.h"
+#include "flight/msg.h"
+#include "flight/hal.h"
+#include "flight/param_store.h"
+#include "checksum/checksum.h"
+
+/*
+* Estimates the accelerometer and magnetometer calibration from samples
+* taken while the aircraft is handled on the ground with the motors
+* disabled. The frame offers each primary IMU sample through a double
+* buffer; the main loop recovers the sensor frame sample, before the
+* applied calibration and rotation, and adds it to the normal equations of
+* a general ellipsoid fit. Samples are binned by direction so that long
+* stretches in one attitude do not dominate the fit, and accelerometer
+* samples are only taken while stationary.
+*
+* Once the samples cover enough directions, the fit is solved in bounded
+* steps: a Cholesky factorization one column at a time, the substitutions,
+* the ellipsoid center, one Jacobi rotation at a time for the ellipsoid
+* axes, and the calibration. Each step is a few hundred operations, so the
+* estimator never holds off the rest of the main loop. The accelerometer
+* is scaled to gravity; the magnetometer keeps the mean field magnitude
+* and is corrected for hard and soft iron. A calibration that passes its
+* checks is written to EEPROM, one byte per step, and replaces the
+* configured calibration on the next boot.
+*/
+
+namespace {
+/* Sample offered by the frame */
+struct CalSample {
+  bool motors_enabled;
+  bool new_mag_data;
+  std::array<float, 3> accel_mps2;
+  std::array<float, 3> gyro_radps;
+  std::array<float, 3> mag_ut;
+};
+DoubleBuffer<CalSample> sample_buf_;
+/* Status */
+ImuCalData status_ = {};
+DoubleBuffer<ImuCalData> status_buf_;
+/* Calibration, y = scale * x + bias */
+struct Cal {
+  std::array<float, 3> bias;
+  std::array<std::array<float, 3>, 3> scale;
+};
+/* Ellipsoid fit unknowns */
+static constexpr std::size_t N_ = 9;
+/* Direction bins, each axis split into negative, level, and positive */
+static constexpr std::size_t NUM_BINS_ = 27;
+static constexpr uint8_t MAX_BIN_SAMPLES_ = 25;
+/* Accelerometer: samples on each of the six faces, while stationary */
+static constexpr uint8_t MIN_FACE_SAMPLES_ = 10;
+static constexpr float MAX_STATIONARY_GYRO_RADPS_ = 0.05f;
+static constexpr float MAX_STATIONARY_ACCEL_ERR_ = 0.1f;
+/* Magnetometer: occupied direction bins */
+static constexpr uint8_t MIN_BIN_SAMPLES_ = 5;
+static constexpr std::size_t MIN_MAG_BINS_ = 14;
+/* Minimum time between samples added to a fit, us */
+static constexpr int64_t SAMPLE_PERIOD_US_ = 100000;
+/* Jacobi sweeps, three rotations each */
+static constexpr std::size_t MAX_SWEEPS_ = 8;
+/* Calibration checks */
+static constexpr double MIN_SCALE_ = 0.5;
+static constexpr double MAX_SCALE_ = 2.0;
+static constexpr float MAX_RESID_ = 0.05f;
+/* Normalizing magnitudes */
+static constexpr float G_MPS2_ = 9.80665f;
+static constexpr float MAG_NORM_UT_ = 50.0f;
+enum class FitState : int8_t {
+  COLLECT,
+  FACTOR,
+  SOLVE,
+  CENTER,
+  EIGEN,
+  COMPOSE,
+  DONE
+};
+struct Fit {
+  FitState state;
+  std::size_t step;
+  int64_t sample_us;
+  int32_t n;
+  /* Lower triangle of the normal equations */
+  std::array<std::array<double, N_>, N_> hth;
+  std::array<double, N_> hty;
+  std::array<uint8_t, NUM_BINS_> bin_cnt;
+  /* Cholesky factor and solution */
+  std::array<std::array<double, N_>, N_> l;
+  std::array<double, N_> p;
+  /* Ellipsoid matrix, center, and axes */
+  double a[3][3];
+  double o[3];
+  double v[3][3];
+  float resid;
+  Cal cal;
+};
+Fit accel_;
+Fit mag_;
+/* Applied calibration and rotation, to recover sensor frame samples */
+std::array<std::array<float, 3>, 3> rot_;
+std::array<float, 3> accel_bias_, mag_bias_;
+std::array<std::array<float, 3>, 3> accel_scale_inv_, mag_scale_inv_;
+/* Persistent storage, after the telemetry parameters */
+static constexpr std::size_t STORE_ADDR_ = 128;
+static_assert(STORE_ADDR_ >= PARAM_STORE_SIZE,
+              "Calibration store overlaps the parameter store");
+static constexpr uint8_t STORE_HEADER_[] = {'C', 'A', 'L'};
+static constexpr uint8_t STORE_ACCEL_ = 0x01;
+static constexpr uint8_t STORE_MAG_ = 0x02;
+static constexpr std::size_t CAL_SIZE_ = 12 * sizeof(float);
+static constexpr std::size_t FLAGS_IDX_ = sizeof(STORE_HEADER_);
+static constexpr std::size_t ACCEL_IDX_ = FLAGS_IDX_ + 1;
+static constexpr std::size_t MAG_IDX_ = ACCEL_IDX_ + CAL_SIZE_;
+static constexpr std::size_t CHK_IDX_ = MAG_IDX_ + CAL_SIZE_;
+static constexpr std::size_t STORE_SIZE_ = CHK_IDX_ + sizeof(uint16_t);
+uint8_t store_buf_[STORE_SIZE_];
+/* Bytes of the store written, the full size when idle */
+std::size_t store_idx_ = STORE_SIZE_;
+bfs::Fletcher16 checksum_;
+
+void Pack(const Cal &cal, uint8_t * const buf) {
+  memcpy(buf, cal.bias.data(), 3 * sizeof(float));
+  for (std::size_t i = 0; i < 3; i++) {
+    memcpy(buf + (3 + 3 * i) * sizeof(float), cal.scale[i].data(),
+           3 * sizeof(float));
+  }
+}
+void Unpack(const uint8_t * const buf, Cal * const cal) {
+  memcpy(cal->bias.data(), buf, 3 * sizeof(float));
+  for (std::size_t i = 0; i < 3; i++) {
+    memcpy(cal->scale[i].data(), buf + (3 + 3 * i) * sizeof(float),
+           3 * sizeof(float));
+  }
+}
+uint16_t StoreChecksum() {
+  return checksum_.Compute(store_buf_, CHK_IDX_);
+}
+/* Starts writing a calibration to the store */
+void Store(const Cal &cal, const std::size_t idx, const uint8_t flag) {
+  Pack(cal, store_buf_ + idx);
+  store_buf_[FLAGS_IDX_] |= flag;
+  uint16_t chk = StoreChecksum();
+  store_buf_[CHK_IDX_] = static_cast<uint8_t>(chk >> 8);
+  store_buf_[CHK_IDX_ + 1] = static_cast<uint8_t>(chk);
+  store_idx_ = 0;
+}
+/* Inverse of a 3x3 matrix, returns false if singular */
+template<typename T>
+bool Inv3(const T m[3][3], T inv[3][3]) {
+  T det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+          m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+          m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+  if (std::fabs(det) < static_cast<T>(1e-12)) {return false;}
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {
+      std::size_t r0 = (j + 1) % 3, r1 = (j + 2) % 3;
+      std::size_t c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+      inv[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+    }
+  }
+  return true;
+}
+/* Recovers the sensor frame sample from a calibrated, rotated sample */
+void Raw(const std::array<float, 3> &y, const std::array<float, 3> &bias,
+         const std::array<std::array<float, 3>, 3> &scale_inv,
+         double x[3]) {
+  float v[3];
+  for (std::size_t i = 0; i < 3; i++) {
+    v[i] = rot_[0][i] * y[0] + rot_[1][i] * y[1] + rot_[2][i] * y[2] -
+           bias[i];
+  }
+  for (std::size_t i = 0; i < 3; i++) {
+    x[i] = scale_inv[i][0] * v[0] + scale_inv[i][1] * v[1] +
+           scale_inv[i][2] * v[2];
+  }
+}
+void Reset(Fit * const fit) {
+  fit->state = FitState::COLLECT;
+  fit->step = 0;
+  fit->n = 0;
+  for (auto &row : fit->hth) {row.fill(0);}
+  fit->hty.fill(0);
+  fit->bin_cnt.fill(0);
+}
+/* Adds a sample, normalized to unit magnitude */
+bool Add(const double x[3], Fit * const fit) {
+  double r = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+  if (r < 1e-3) {return false;}
+  std::size_t bin = 0;
+  for (std::size_t i = 0; i < 3; i++) {
+    double u = x[i] / r;
+    bin = 3 * bin + ((u > 0.5) ? 2 : ((u < -0.5) ? 0 : 1));
+  }
+  if (fit->bin_cnt[bin] >= MAX_BIN_SAMPLES_) {return false;}
+  fit->bin_cnt[bin]++;
+  double h[N_] = {x[0] * x[0], x[1] * x[1], x[2] * x[2],
+                  2 * x[0] * x[1], 2 * x[0] * x[2], 2 * x[1] * x[2],
+                  2 * x[0], 2 * x[1], 2 * x[2]};
+  for (std::size_t i = 0; i < N_; i++) {
+    fit->hty[i] += h[i];
+    for (std::size_t j = 0; j <= i; j++) {
+      fit->hth[i][j] += h[i] * h[j];
+    }
+  }
+  fit->n++;
+  return true;
+}
+/* Whether the accelerometer samples cover all six faces */
+bool AccelReady(const Fit &fit) {
+  for (std::size_t bin = 0; bin < NUM_BINS_; bin++) {
+    std::size_t level = (bin / 9 == 1) + ((bin / 3) % 3 == 1) + (bin % 3 == 1);
+    if ((level == 2) && (fit.bin_cnt[bin] < MIN_FACE_SAMPLES_)) {
+      return false;
+    }
+  }
+  return true;
+}
+/* Whether the magnetometer samples cover enough directions */
+bool MagReady(const Fit &fit) {
+  std::size_t bins = 0;
+  for (std::size_t bin = 0; bin < NUM_BINS_; bin++) {
+    if (fit.bin_cnt[bin] >= MIN_BIN_SAMPLES_) {bins++;}
+  }
+  return bins >= MIN_MAG_BINS_;
+}
+/* One Jacobi rotation zeroing a[p][q] */
+void Rotate(const std::size_t p, const std::size_t q, double a[3][3],
+            double v[3][3]) {
+  if (std::fabs(a[p][q]) < 1e-15) {return;}
+  double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+  double t = ((theta >= 0) ? 1.0 : -1.0) /
+             (std::fabs(theta) + std::sqrt(theta * theta + 1));
+  double c = 1 / std::sqrt(t * t + 1);
+  double s = t * c;
+  for (std::size_t k = 0; k < 3; k++) {
+    double akp = a[k][p], akq = a[k][q];
+    a[k][p] = c * akp - s * akq;
+    a[k][q] = s * akp + c * akq;
+  }
+  for (std::size_t k = 0; k < 3; k++) {
+    double apk = a[p][k], aqk = a[q][k];
+    a[p][k] = c * apk - s * aqk;
+    a[q][k] = s * apk + c * aqk;
+  }
+  for (std::size_t k = 0; k < 3; k++) {
+    double vkp = v[k][p], vkq = v[k][q];
+    v[k][p] = c * vkp - s * vkq;
+    v[k][q] = s * vkp + c * vkq;
+  }
+}
+/*
+* Advances a fit by one bounded step. The accelerometer is scaled to a unit
+* radius, the magnetometer to the radius of the sphere with the volume of
+* the fit ellipsoid. Returns true when a calibration is completed.
+*/
+bool Step(const float norm, const bool unit_radius,
+          bool (*ready)(const Fit &), Fit * const fit) {
+  switch (fit->state) {
+    case FitState::COLLECT: {
+      if (ready(*fit)) {
+        fit->state = FitState::FACTOR;
+        fit->step = 0;
+      }
+      return false;
+    }
+    case FitState::FACTOR: {
+      std::size_t j = fit->step;
+      double s = fit->hth[j][j];
+      for (std::size_t k = 0; k < j; k++) {s -= fit->l[j][k] * fit->l[j][k];}
+      if (!(s > 1e-12 * fit->hth[j][j])) {
+        MsgWarning("IMU calibration fit singular, collecting again.\n");
+        Reset(fit);
+        return false;
+      }
+      fit->l[j][j] = std::sqrt(s);
+      for (std::size_t i = j + 1; i < N_; i++) {
+        double t = fit->hth[i][j];
+        for (std::size_t k = 0; k < j; k++) {t -= fit->l[i][k] * fit->l[j][k];}
+        fit->l[i][j] = t / fit->l[j][j];
+      }
+      if (++fit->step == N_) {fit->state = FitState::SOLVE;}
+      return false;
+    }
+    case FitState::SOLVE: {
+      double z[N_];
+      for (std::size_t i = 0; i < N_; i++) {
+        z[i] = fit->hty[i];
+        for (std::size_t k = 0; k < i; k++) {z[i] -= fit->l[i][k] * z[k];}
+        z[i] /= fit->l[i][i];
+      }
+      for (std::size_t i = N_; i-- > 0;) {
+        fit->p[i] = z[i];
+        for (std::size_t k = i + 1; k < N_; k++) {
+          fit->p[i] -= fit->l[k][i] * fit->p[k];
+        }
+        fit->p[i] /= fit->l[i][i];
+      }
+      /* RMS of the fit residual from the normal equations */
+      double sse = fit->n;
+      for (std::size_t i = 0; i < N_; i++) {
+        sse -= 2 * fit->p[i] * fit->hty[i];
+        for (std::size_t j = 0; j < N_; j++) {
+          double h = (j <= i) ? fit->hth[i][j] : fit->hth[j][i];
+          sse += fit->p[i] * h * fit->p[j];
+        }
+      }
+      fit->resid = static_cast<float>(std::sqrt(std::max(sse, 0.0) /
+                                                fit->n));
+      fit->state = FitState::CENTER;
+      return false;
+    }
+    case FitState::CENTER: {
+      const std::array<double, N_> &p = fit->p;
+      double m[3][3] = {{p[0], p[3], p[4]},
+                        {p[3], p[1], p[5]},
+                        {p[4], p[5], p[2]}};
+      double m_inv[3][3];
+      if (!Inv3(m, m_inv)) {
+        MsgWarning("IMU calibration fit singular, collecting again.\n");
+        Reset(fit);
+        return false;
+      }
+      for (std::size_t i = 0; i < 3; i++) {
+        fit->o[i] = -(m_inv[i][0] * p[6] + m_inv[i][1] * p[7] +
+                      m_inv[i][2] * p[8]);
+      }
+      double k = 1;
+      for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+          k += fit->o[i] * m[i][j] * fit->o[j];
+        }
+      }
+      if (!(k > 0)) {
+        MsgWarning("IMU calibration fit is not an ellipsoid, "
+                   "collecting again.\n");
+        Reset(fit);
+        return false;
+      }
+      for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+          fit->a[i][j] = m[i][j] / k;
+          fit->v[i][j] = (i == j) ? 1 : 0;
+        }
+      }
+      fit->step = 0;
+      fit->state = FitState::EIGEN;
+      return false;
+    }
+    case FitState::EIGEN: {
+      static constexpr std::size_t P[3] = {0, 0, 1};
+      static constexpr std::size_t Q[3] = {1, 2, 2};
+      Rotate(P[fit->step % 3], Q[fit->step % 3], fit->a, fit->v);
+      double off = std::fabs(fit->a[0][1]) + std::fabs(fit->a[0][2]) +
+                   std::fabs(fit->a[1][2]);
+      double diag = std::fabs(fit->a[0][0]) + std::fabs(fit->a[1][1]) +
+                    std::fabs(fit->a[2][2]);
+      if ((++fit->step >= 3 * MAX_SWEEPS_) || (off < 1e-12 * diag)) {
+        fit->state = FitState::COMPOSE;
+      }
+      return false;
+    }
+    case FitState::COMPOSE: {
+      double lambda[3];
+      for (std::size_t i = 0; i < 3; i++) {
+        lambda[i] = fit->a[i][i];
+        if (!(lambda[i] > 0)) {
+          MsgWarning("IMU calibration fit is not an ellipsoid, "
+                     "collecting again.\n");
+          Reset(fit);
+          return false;
+        }
+      }
+      double radius = unit_radius ? 1.0 :
+                      std::pow(lambda[0] * lambda[1] * lambda[2], -1.0 / 6.0);
+      /* Scale is the symmetric square root of the ellipsoid matrix */
+      double w[3][3];
+      bool valid = fit->resid < MAX_RESID_;
+      for (std::size_t i = 0; i < 3; i++) {
+        for (std::size_t j = 0; j < 3; j++) {
+          w[i][j] = 0;
+          for (std::size_t k = 0; k < 3; k++) {
+            w[i][j] += fit->v[i][k] * std::sqrt(lambda[k]) * fit->v[j][k];
+          }
+          w[i][j] *= radius;
+        }
+        valid = valid && (w[i][i] >= MIN_SCALE_) && (w[i][i] <= MAX_SCALE_);
+      }
+      if (!valid) {
+        MsgWarning("IMU calibration failed checks, collecting again.\n");
+        Reset(fit);
+        return false;
+      }
+      for (std::size_t i = 0; i < 3; i++) {
+        double b = 0;
+        for (std::size_t j = 0; j < 3; j++) {
+          fit->cal.scale[i][j] = static_cast<float>(w[i][j]);
+          b -= w[i][j] * fit->o[j];
+        }
+        fit->cal.bias[i] = static_cast<float>(b * norm);
+      }
+      fit->state = FitState::DONE;
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+}  // namespace
+
+void ImuCalLoad(bfs::ImuConfig * const cfg) {
+  if (!cfg) {return;}
+  for (std::size_t i = 0; i < STORE_SIZE_; i++) {
+    store_buf_[i] = HalEepromRead(STORE_ADDR_ + i);
+  }
+  uint16_t chk = static_cast<uint16_t>(store_buf_[CHK_IDX_]) << 8 |
+                 static_cast<uint16_t>(store_buf_[CHK_IDX_ + 1]);
+  bool valid = (memcmp(store_buf_, STORE_HEADER_, FLAGS_IDX_) == 0) &&
+               (chk == StoreChecksum());
+  if (!valid) {
+    memset(store_buf_, 0, STORE_SIZE_);
+    memcpy(store_buf_, STORE_HEADER_, FLAGS_IDX_);
+    return;
+  }
+  Cal cal;
+  if (store_buf_[FLAGS_IDX_] & STORE_ACCEL_) {
+    Unpack(store_buf_ + ACCEL_IDX_, &cal);
+    for (std::size_t i = 0; i < 3; i++) {
+      cfg->accel_bias_mps2[i] = cal.bias[i];
+      for (std::size_t j = 0; j < 3; j++) {
+        cfg->accel_scale[i][j] = cal.scale[i][j];
+      }
+    }
+    status_.accel_stored = true;
+    MsgInfo("Using stored accelerometer calibration.\n");
+  }
+  if (store_buf_[FLAGS_IDX_] & STORE_MAG_) {
+    Unpack(store_buf_ + MAG_IDX_, &cal);
+    for (std::size_t i = 0; i < 3; i++) {
+      cfg->mag_bias_ut[i] = cal.bias[i];
+      for (std::size_t j = 0; j < 3; j++) {
+        cfg->mag_scale[i][j] = cal.scale[i][j];
+      }
+    }
+    status_.mag_stored = true;
+    MsgInfo("Using stored magnetometer calibration.\n");
+  }
+}
+void ImuCalInit(const bfs::ImuConfig &cfg) {
+  float accel_scale[3][3], mag_scale[3][3], inv[3][3];
+  for (std::size_t i = 0; i < 3; i++) {
+    accel_bias_[i] = cfg.accel_bias_mps2[i];
+    mag_bias_[i] = cfg.mag_bias_ut[i];
+    for (std::size_t j = 0; j < 3; j++) {
+      rot_[i][j] = cfg.rotation[i][j];
+      accel_scale[i][j] = cfg.accel_scale[i][j];
+      mag_scale[i][j] = cfg.mag_scale[i][j];
+    }
+  }
+  if (!Inv3(accel_scale, inv)) {
+    MsgError("Accelerometer scale factor is singular.");
+  }
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {accel_scale_inv_[i][j] = inv[i][j];}
+  }
+  if (!Inv3(mag_scale, inv)) {
+    MsgError("Magnetometer scale factor is singular.");
+  }
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {mag_scale_inv_[i][j] = inv[i][j];}
+  }
+  Reset(&accel_);
+  Reset(&mag_);
+  *status_buf_.back() = status_;
+  status_buf_.Publish();
+}
+void ImuCalSample(const bfs::ImuData &imu, const bool motors_enabled) {
+  if (!imu.new_imu_data) {return;}
+  CalSample *sample = sample_buf_.back();
+  sample->motors_enabled = motors_enabled;
+  sample->new_mag_data = imu.new_mag_data;
+  for (std::size_t i = 0; i < 3; i++) {
+    sample->accel_mps2[i] = imu.accel_mps2[i];
+    sample->gyro_radps[i] = imu.gyro_radps[i];
+    sample->mag_ut[i] = imu.mag_ut[i];
+  }
+  sample_buf_.Publish();
+}
+void ImuCalRun() {
+  bool updated = false;
+  /* Add the latest sample while on the ground */
+  CalSample sample;
+  if (sample_buf_.Read(&sample) && !sample.motors_enabled) {
+    int64_t t_us = HalMicros();
+    double x[3];
+    if ((accel_.state == FitState::COLLECT) &&
+        (t_us - accel_.sample_us >= SAMPLE_PERIOD_US_)) {
+      float gyro = std::sqrt(sample.gyro_radps[0] * sample.gyro_radps[0] +
+                             sample.gyro_radps[1] * sample.gyro_radps[1] +
+                             sample.gyro_radps[2] * sample.gyro_radps[2]);
+      Raw(sample.accel_mps2, accel_bias_, accel_scale_inv_, x);
+      for (std::size_t i = 0; i < 3; i++) {x[i] /= G_MPS2_;}
+      double err = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]) - 1;
+      if ((gyro < MAX_STATIONARY_GYRO_RADPS_) &&
+          (std::fabs(err) < MAX_STATIONARY_ACCEL_ERR_) && Add(x, &accel_)) {
+        accel_.sample_us = t_us;
+        updated = true;
+      }
+    }
+    if ((mag_.state == FitState::COLLECT) && sample.new_mag_data &&
+        (t_us - mag_.sample_us >= SAMPLE_PERIOD_US_)) {
+      Raw(sample.mag_ut, mag_bias_, mag_scale_inv_, x);
+      for (std::size_t i = 0; i < 3; i++) {x[i] /= MAG_NORM_UT_;}
+      if (Add(x, &mag_)) {
+        mag_.sample_us = t_us;
+        updated = true;
+      }
+    }
+  }
+  /* Advance the fits */
+  if (Step(G_MPS2_, true, AccelReady, &accel_)) {
+    Store(accel_.cal, ACCEL_IDX_, STORE_ACCEL_);
+    status_.accel_stored = true;
+    status_.accel_resid = accel_.resid;
+    MsgInfo("Accelerometer calibration stored, applied on the next boot.\n");
+    updated = true;
+  }
+  if (Step(MAG_NORM_UT_, false, MagReady, &mag_)) {
+    Store(mag_.cal, MAG_IDX_, STORE_MAG_);
+    status_.mag_stored = true;
+    status_.mag_resid = mag_.resid;
+    MsgInfo("Magnetometer calibration stored, applied on the next boot.\n");
+    updated = true;
+  }
+  /* Write the store */
+  if (store_idx_ < STORE_SIZE_) {
+    HalEepromWrite(STORE_ADDR_ + store_idx_, store_buf_[store_idx_]);
+    store_idx_++;
+  }
+  /* Status */
+  if (updated) {
+    status_.accel_samples = static_cast<int16_t>(accel_.n);
+    status_.mag_samples = static_cast<int16_t>(mag_.n);
+    *status_buf_.back() = status_;
+    status_buf_.Publish();
+  }
+}
+void ImuCalRead(ImuCalData * const data) {
+  status_buf_.Read(data);
+}
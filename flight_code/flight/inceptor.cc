@@ -0,0 +1,139 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/inceptor.h"
+#include "flight/global_defs.h"
+#include "flight/double_buffer.h"
+#include "flight/hal.h"
+
+/*
+* SBUS frames are assembled byte by byte in interrupt context as they are
+* received and each complete frame is published to a double buffer with
+* the arrival time of its first byte. The frame then reads the latest
+* frame with a fixed size copy, and the age of that frame tells whether
+* the inceptor input is current, rather than only checking flags when a
+* new frame happens to arrive.
+*
+* A frame is a header byte, 22 bytes of 16 packed 11 bit channels, a flags
+* byte, and a footer byte. Frames are sent back to back within a frame
+* and separated by a gap of several ms, so a gap between bytes
+* resynchronizes the parser on the next header.
+*/
+
+namespace {
+/* Frame with arrival time */
+struct InceptorSample {
+  InceptorData data;
+  int64_t time_us;
+};
+DoubleBuffer<InceptorSample> inceptor_buf_;
+/* SBUS frame */
+static constexpr uint8_t SBUS_HEADER_ = 0x0F;
+static constexpr std::size_t SBUS_FRAME_LEN_ = 25;
+static constexpr std::size_t SBUS_FLAGS_IDX_ = 23;
+static constexpr uint8_t SBUS_CH17_MASK_ = 0x01;
+static constexpr uint8_t SBUS_CH18_MASK_ = 0x02;
+static constexpr uint8_t SBUS_LOST_FRAME_MASK_ = 0x04;
+static constexpr uint8_t SBUS_FAILSAFE_MASK_ = 0x08;
+/* Footers of SBUS and of SBUS2, which cycles the telemetry slot */
+static constexpr uint8_t SBUS_FOOTER_ = 0x00;
+static constexpr uint8_t SBUS2_FOOTER_MASK_ = 0x0F;
+static constexpr uint8_t SBUS2_FOOTER_ = 0x04;
+/* Gap between bytes that starts a new frame, us */
+static constexpr int64_t FRAME_GAP_US_ = 1000;
+/* Frames older than two 14 ms frame periods are stale */
+static constexpr int64_t MAX_FRAME_AGE_US_ = 28000;
+/* Without frames the receiver cannot report failsafe, us */
+static constexpr int64_t FAILSAFE_TIMEOUT_US_ = 100000;
+/* Time to wait for a frame on init, ms */
+static constexpr int32_t INIT_TIMEOUT_MS_ = 1000;
+/* Parser state, only touched from the receive interrupt */
+uint8_t frame_[SBUS_FRAME_LEN_];
+std::size_t frame_idx_ = 0;
+int64_t frame_start_us_ = 0;
+int64_t prev_byte_us_ = 0;
+
+void InceptorRx(const uint8_t byte, const int64_t time_us) {
+  if (time_us - prev_byte_us_ > FRAME_GAP_US_) {frame_idx_ = 0;}
+  prev_byte_us_ = time_us;
+  if (frame_idx_ == 0) {
+    if (byte != SBUS_HEADER_) {return;}
+    frame_start_us_ = time_us;
+  }
+  frame_[frame_idx_++] = byte;
+  if (frame_idx_ < SBUS_FRAME_LEN_) {return;}
+  frame_idx_ = 0;
+  if ((byte != SBUS_FOOTER_) &&
+      ((byte & SBUS2_FOOTER_MASK_) != SBUS2_FOOTER_)) {
+    return;
+  }
+  /* Unpack the channels, least significant bit first */
+  InceptorSample *sample = inceptor_buf_.back();
+  uint32_t bits = 0;
+  int32_t num_bits = 0;
+  std::size_t idx = 1;
+  for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
+    while (num_bits < 11) {
+      bits |= static_cast<uint32_t>(frame_[idx++]) << num_bits;
+      num_bits += 8;
+    }
+    sample->data.ch[i] = static_cast<int16_t>(bits & 0x07FF);
+    bits >>= 11;
+    num_bits -= 11;
+  }
+  uint8_t flags = frame_[SBUS_FLAGS_IDX_];
+  sample->data.new_data = true;
+  sample->data.ch17 = flags & SBUS_CH17_MASK_;
+  sample->data.ch18 = flags & SBUS_CH18_MASK_;
+  sample->data.lost_frame = flags & SBUS_LOST_FRAME_MASK_;
+  sample->data.failsafe = flags & SBUS_FAILSAFE_MASK_;
+  sample->time_us = frame_start_us_;
+  inceptor_buf_.Publish();
+}
+}  // namespace
+
+bool InceptorInit() {
+  if (!HalInceptorBegin(InceptorRx)) {return false;}
+  for (int32_t t_ms = 0; t_ms < INIT_TIMEOUT_MS_; t_ms++) {
+    if (inceptor_buf_.count() > 0) {return true;}
+    HalDelayMs(1);
+  }
+  return false;
+}
+void InceptorRead(SensorData * const data) {
+  if (!data) {return;}
+  InceptorSample sample;
+  bool new_data = inceptor_buf_.Read(&sample);
+  bool received = inceptor_buf_.count() > 0;
+  int64_t age_us = HalMicros() - sample.time_us;
+  data->inceptor = sample.data;
+  data->inceptor.new_data = new_data;
+  if (!received || (age_us > FAILSAFE_TIMEOUT_US_)) {
+    data->inceptor.lost_frame = true;
+    data->inceptor.failsafe = true;
+  }
+  data->inceptor_sample.time_us = sample.time_us;
+  data->inceptor_sample.fresh = received && (age_us <= MAX_FRAME_AGE_US_);
+}
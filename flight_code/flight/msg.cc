@@ -24,33 +24,29 @@
 */
 
 #include "flight/msg.h"
-#include "flight/hardware_defs.h"
-#include "flight/config.h"
+#include "flight/hal.h"
 #include "./version.h"
 
 void MsgBegin() {
-  MSG_BUS.begin(115200);
-  if (DEBUG) {
-    while (!MSG_BUS) {}
-  }
-  MSG_BUS.println("---------Bolder Flight Systems---------");
-  MSG_BUS.println("Flight Software");
-  MSG_BUS.print("Version: ");
-  MSG_BUS.println(PROJECT_VERSION);
-  MSG_BUS.println("---------------------------------------");
+  HalMsgBegin();
+  HalMsgPrint("---------Bolder Flight Systems---------\n");
+  HalMsgPrint("Flight Software\n");
+  HalMsgPrint("Version: ");
+  HalMsgPrint(PROJECT_VERSION);
+  HalMsgPrint("\n---------------------------------------\n");
 }
 
 void MsgInfo(const char * str) {
-  MSG_BUS.print(str);
+  HalMsgPrint(str);
 }
 
 void MsgWarning(const char * str) {
-  MSG_BUS.print("\nWARNING: ");
-  MSG_BUS.print(str);
+  HalMsgPrint("\nWARNING: ");
+  HalMsgPrint(str);
 }
 
 void MsgError(const char * str) {
-  MSG_BUS.print("\nERROR: ");
-  MSG_BUS.print(str);
-  while (1) {}
+  HalMsgPrint("\nERROR: ");
+  HalMsgPrint(str);
+  HalHalt();
 }
@@ -40,6 +40,11 @@ static constexpr int MIN_SAT_ = 12;
 /* Frame period */
 static constexpr float FRAME_PERIOD_S = static_cast<float>(FRAME_PERIOD_MS) /
                                         1000.0f;
+/* IMU sample intervals outside of this range use the frame period */
+static constexpr float MIN_IMU_DT_S = 0.5f * FRAME_PERIOD_S;
+static constexpr float MAX_IMU_DT_S = 2.0f * FRAME_PERIOD_S;
+/* Time of the previous IMU sample */
+int64_t prev_imu_time_us_;
 /* Navigation filter */
 bfs::Ekf15State nav_filter_;
 /* Data */
@@ -68,8 +73,9 @@ bfs::Iir<float> diff_pres_dlpf_;
 float mag_frame_rate_hz_;
 }  // namespace
 void NavInit(const NavConfig &ref) {
-  /* Copy the config */
+  /* Copy the config, the filter initializes again on the next GNSS fix */
   config_ = ref;
+  nav_initialized_ = false;
   /* Set the mag sample rate */
   switch (FRAME_RATE_HZ) {
     case bfs::FRAME_RATE_50HZ: {
@@ -164,19 +170,25 @@ void NavRun(const SensorData &ref, NavData * const ptr) {
       nav_filter_.Initialize(imu_accel_mps2_, imu_gyro_radps_,
                              imu_mag_ut_, gnss_ned_vel_mps_,
                              home_pos_lla_);
+      prev_imu_time_us_ = ref.imu_sample.time_us;
       nav_initialized_ = true;
     }
   } else {
-    /* EKF time update */
+    /* EKF time update, over the interval between IMU samples */
     if (ref.imu.new_imu_data) {
+      float imu_dt_s = static_cast<float>(ref.imu_sample.time_us -
+                                          prev_imu_time_us_) / 1e6f;
+      if ((imu_dt_s < MIN_IMU_DT_S) || (imu_dt_s > MAX_IMU_DT_S)) {
+        imu_dt_s = FRAME_PERIOD_S;
+      }
+      prev_imu_time_us_ = ref.imu_sample.time_us;
       imu_accel_mps2_(0) = ref.imu.accel_mps2[0];
       imu_accel_mps2_(1) = ref.imu.accel_mps2[1];
       imu_accel_mps2_(2) = ref.imu.accel_mps2[2];
       imu_gyro_radps_(0) = ref.imu.gyro_radps[0];
       imu_gyro_radps_(1) = ref.imu.gyro_radps[1];
       imu_gyro_radps_(2) = ref.imu.gyro_radps[2];
-      nav_filter_.TimeUpdate(imu_accel_mps2_, imu_gyro_radps_,
-                             FRAME_PERIOD_S);
+      nav_filter_.TimeUpdate(imu_accel_mps2_, imu_gyro_radps_, imu_dt_s);
     }
     /* EKF measurement update */
     if (ref.gnss.new_data) {
@@ -0,0 +1,114 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/param_store.h"
+#include <cstring>
+#include "flight/global_defs.h"
+#include "flight/msg.h"
+#include "flight/hal.h"
+#include "checksum/checksum.h"
+
+namespace {
+static constexpr uint8_t PARAM_STORE_HEADER[] = {'B', 'F', 'S'};
+static constexpr std::size_t PARAM_DATA_SIZE = sizeof(PARAM_STORE_HEADER) +
+                                               NUM_TELEM_PARAMS *
+                                               sizeof(float);
+static_assert(PARAM_STORE_SIZE == PARAM_DATA_SIZE + sizeof(uint16_t));
+uint8_t param_buf[PARAM_STORE_SIZE];
+/*
+* Parameters updated by the frame and not yet written. The frame sets a
+* flag after updating the buffer and the background loop clears it before
+* writing, so an update made during a write is written again.
+*/
+volatile bool param_pending[NUM_TELEM_PARAMS] = {};
+bfs::Fletcher16 param_checksum;
+uint16_t chk_computed, chk_read;
+/* Computes the checksum of the header and parameters into the buffer */
+void UpdateChecksum() {
+  chk_computed = param_checksum.Compute(param_buf, PARAM_DATA_SIZE);
+  param_buf[PARAM_STORE_SIZE - 2] = static_cast<uint8_t>(chk_computed >> 8);
+  param_buf[PARAM_STORE_SIZE - 1] = static_cast<uint8_t>(chk_computed);
+}
+/* Writes an empty store, with the parameters zeroed */
+void Reset() {
+  memcpy(param_buf, PARAM_STORE_HEADER, sizeof(PARAM_STORE_HEADER));
+  memset(param_buf + sizeof(PARAM_STORE_HEADER), 0,
+         NUM_TELEM_PARAMS * sizeof(float));
+  UpdateChecksum();
+  for (std::size_t i = 0; i < PARAM_STORE_SIZE; i++) {
+    HalEepromWrite(i, param_buf[i]);
+  }
+  MsgInfo("done.\n");
+}
+}  // namespace
+
+bool ParamStoreLoad(std::array<float, NUM_TELEM_PARAMS> * const param) {
+  if (!param) {return false;}
+  for (std::size_t i = 0; i < PARAM_STORE_SIZE; i++) {
+    param_buf[i] = HalEepromRead(i);
+  }
+  /* Check whether the parameter store has been initialized */
+  if (memcmp(param_buf, PARAM_STORE_HEADER, sizeof(PARAM_STORE_HEADER))) {
+    MsgInfo("Parameter storage not initialized, initializing...");
+    Reset();
+    param->fill(0);
+    return false;
+  }
+  /* Check the checksum */
+  chk_computed = param_checksum.Compute(param_buf, PARAM_DATA_SIZE);
+  chk_read = static_cast<uint16_t>(param_buf[PARAM_STORE_SIZE - 2]) << 8 |
+             static_cast<uint16_t>(param_buf[PARAM_STORE_SIZE - 1]);
+  if (chk_computed != chk_read) {
+    MsgWarning("Parameter storage corrupted, resetting...");
+    Reset();
+    param->fill(0);
+    return false;
+  }
+  memcpy(param->data(), param_buf + sizeof(PARAM_STORE_HEADER),
+         NUM_TELEM_PARAMS * sizeof(float));
+  return true;
+}
+void ParamStoreWrite(const int32_t idx, const float val) {
+  if ((idx < 0) || (idx >= static_cast<int32_t>(NUM_TELEM_PARAMS))) {return;}
+  std::size_t addr = sizeof(PARAM_STORE_HEADER) + idx * sizeof(float);
+  memcpy(param_buf + addr, &val, sizeof(float));
+  param_pending[idx] = true;
+}
+void ParamStoreRun() {
+  for (std::size_t idx = 0; idx < NUM_TELEM_PARAMS; idx++) {
+    if (!param_pending[idx]) {continue;}
+    param_pending[idx] = false;
+    /* Write just the parameter and checksum bytes */
+    std::size_t addr = sizeof(PARAM_STORE_HEADER) + idx * sizeof(float);
+    for (std::size_t i = 0; i < sizeof(float); i++) {
+      HalEepromWrite(addr + i, param_buf[addr + i]);
+    }
+    UpdateChecksum();
+    HalEepromWrite(PARAM_STORE_SIZE - 2, param_buf[PARAM_STORE_SIZE - 2]);
+    HalEepromWrite(PARAM_STORE_SIZE - 1, param_buf[PARAM_STORE_SIZE - 1]);
+    /* One parameter per pass */
+    return;
+  }
+}
@@ -0,0 +1,310 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/pres_i2c.h"
+#include <algorithm>
+#include "flight/global_defs.h"
+#include "flight/double_buffer.h"
+#include "flight/msg.h"
+#include "flight/hal.h"
+
+/*
+* Polled state machine for the air data sensor pressure transducers. Each
+* call to PresI2cPoll starts, checks, or completes a non-blocking I2C read,
+* or performs a single bus recovery step, and returns, so it can be
+* serviced from the main loop without holding up anything else there, and
+* neither the frame nor the main loop ever waits on the I2C bus. A read
+* that doesn't complete within its timeout, as with a stretched clock or a
+* stuck slave, is aborted and triggers a bus recovery at once; repeated
+* NACKs trigger one as well. For the recovery, the pins are taken over as
+* GPIO, SCL is clocked until a slave holding SDA low releases it, a STOP
+* is issued, and the I2C peripheral is restarted. The recovery is paced by
+* time, one edge per poll, rather than by delays. The transducer output
+* counts are scaled here, as the bfs AMS5915 driver scales them.
+*/
+
+namespace {
+/* Sample with acquisition time */
+struct PresSample {
+  bfs::PresData data;
+  int64_t time_us;
+};
+/* Completed samples */
+DoubleBuffer<PresSample> static_pres_buf_;
+DoubleBuffer<PresSample> diff_pres_buf_;
+/* Samples older than two frames are stale */
+static constexpr int64_t MAX_SAMPLE_AGE_US_ = 2 * FRAME_PERIOD_MS * 1000;
+/* Transducer address and pressure range */
+struct Transducer {
+  uint8_t addr;
+  float min_pa;
+  float max_pa;
+};
+Transducer static_pres_, diff_pres_;
+/* A read takes about 120 us at 400 kHz */
+static constexpr int64_t READ_TIMEOUT_US_ = 1000;
+/* Bus error handling */
+static constexpr int MAX_CONSECUTIVE_ERRORS_ = 3;
+static constexpr int RECOVERY_CLOCKS_ = 9;
+static constexpr int64_t RECOVERY_HALF_PERIOD_US_ = 5;
+static constexpr int64_t MIN_BACKOFF_US_ = 10000;
+static constexpr int64_t MAX_BACKOFF_US_ = 1000000;
+/* State */
+enum State {
+  IDLE,
+  READ_STATIC,
+  READ_DIFF,
+  RECOVER_START,
+  RECOVER_CLOCK,
+  RECOVER_STOP,
+  RECOVER_RESTART
+};
+State state_ = IDLE;
+bool start_pending_ = false;
+int64_t next_step_us_ = 0;
+int64_t read_timeout_us_ = 0;
+int consecutive_errors_ = 0;
+int recovery_step_ = 0;
+int64_t backoff_us_ = 0;
+
+/* Starts reading a transducer */
+void ReadStart(const Transducer &dev, const int64_t now_us) {
+  HalPresI2cReadStart(dev.addr, AMS5915_READ_LEN);
+  read_timeout_us_ = now_us + READ_TIMEOUT_US_;
+}
+/* Scales the transducer output counts */
+void Scale(const Transducer &dev, const uint8_t * const buf,
+           bfs::PresData * const data) {
+  int32_t pres_cnt = (static_cast<int32_t>(buf[0] & 0x3F) << 8) | buf[1];
+  int32_t temp_cnt = (static_cast<int32_t>(buf[2]) << 3) | (buf[3] >> 5);
+  data->pres_pa = static_cast<float>(pres_cnt - AMS5915_PRES_CNT_MIN) *
+                  (dev.max_pa - dev.min_pa) /
+                  static_cast<float>(AMS5915_PRES_CNT_MAX -
+                                     AMS5915_PRES_CNT_MIN) + dev.min_pa;
+  data->die_temp_c = static_cast<float>(temp_cnt) * AMS5915_TEMP_RANGE_C /
+                     static_cast<float>(AMS5915_TEMP_CNT_RANGE) +
+                     AMS5915_TEMP_MIN_C;
+  data->new_data = true;
+  data->healthy = true;
+}
+/*
+* Polls a read into its back buffer, publishing on success. Returns false
+* while the read is in progress; a timed out read is aborted and flagged.
+*/
+bool ReadPoll(const Transducer &dev, DoubleBuffer<PresSample> * const buf,
+              const int64_t now_us, bool * const timed_out) {
+  uint8_t raw[AMS5915_READ_LEN];
+  switch (HalPresI2cReadPoll(raw)) {
+    case HAL_I2C_BUSY: {
+      if (now_us < read_timeout_us_) {return false;}
+      HalPresI2cAbort();
+      *timed_out = true;
+      consecutive_errors_++;
+      return true;
+    }
+    case HAL_I2C_DONE: {
+      PresSample *sample = buf->back();
+      Scale(dev, raw, &sample->data);
+      sample->time_us = now_us;
+      buf->Publish();
+      consecutive_errors_ = 0;
+      backoff_us_ = 0;
+      return true;
+    }
+    default: {
+      consecutive_errors_++;
+      return true;
+    }
+  }
+}
+/* Copies a sample out, setting new data and freshness */
+void Copy(DoubleBuffer<PresSample> * const buf, const int64_t now_us,
+          bfs::PresData * const data, SampleInfo * const info) {
+  PresSample sample;
+  bool new_data = buf->Read(&sample);
+  info->time_us = sample.time_us;
+  info->fresh = (buf->count() > 0) &&
+                (now_us - sample.time_us <= MAX_SAMPLE_AGE_US_);
+  *data = sample.data;
+  data->new_data = new_data && sample.data.new_data;
+  /* A transducer that stops publishing is not healthy */
+  data->healthy = sample.data.healthy && info->fresh;
+}
+}  // namespace
+
+bool Ams5915Range(const decltype(bfs::PresConfig::transducer) transducer,
+                  float * const min_pa, float * const max_pa) {
+  /* Datasheet ranges, mbar */
+  float min_mbar = 0, max_mbar = 0;
+  switch (transducer) {
+    case bfs::AMS5915_0005_D: {max_mbar = 5; break;}
+    case bfs::AMS5915_0010_D: {max_mbar = 10; break;}
+    case bfs::AMS5915_0005_D_B: {min_mbar = -5; max_mbar = 5; break;}
+    case bfs::AMS5915_0010_D_B: {min_mbar = -10; max_mbar = 10; break;}
+    case bfs::AMS5915_0020_D: {max_mbar = 20; break;}
+    case bfs::AMS5915_0050_D: {max_mbar = 50; break;}
+    case bfs::AMS5915_0100_D: {max_mbar = 100; break;}
+    case bfs::AMS5915_0020_D_B: {min_mbar = -20; max_mbar = 20; break;}
+    case bfs::AMS5915_0050_D_B: {min_mbar = -50; max_mbar = 50; break;}
+    case bfs::AMS5915_0100_D_B: {min_mbar = -100; max_mbar = 100; break;}
+    case bfs::AMS5915_0200_D: {max_mbar = 200; break;}
+    case bfs::AMS5915_0350_D: {max_mbar = 350; break;}
+    case bfs::AMS5915_1000_D: {max_mbar = 1000; break;}
+    case bfs::AMS5915_2000_D: {max_mbar = 2000; break;}
+    case bfs::AMS5915_4000_D: {max_mbar = 4000; break;}
+    case bfs::AMS5915_7000_D: {max_mbar = 7000; break;}
+    case bfs::AMS5915_10000_D: {max_mbar = 10000; break;}
+    case bfs::AMS5915_0200_D_B: {min_mbar = -200; max_mbar = 200; break;}
+    case bfs::AMS5915_0350_D_B: {min_mbar = -350; max_mbar = 350; break;}
+    case bfs::AMS5915_1000_D_B: {min_mbar = -1000; max_mbar = 1000; break;}
+    case bfs::AMS5915_1000_A: {max_mbar = 1000; break;}
+    case bfs::AMS5915_1200_B: {min_mbar = 700; max_mbar = 1200; break;}
+    default: {return false;}
+  }
+  *min_pa = min_mbar * 100.0f;
+  *max_pa = max_mbar * 100.0f;
+  return true;
+}
+void PresI2cInit(const SensorConfig &cfg) {
+  static_pres_.addr = cfg.static_pres.dev;
+  diff_pres_.addr = cfg.diff_pres.dev;
+  if (!Ams5915Range(cfg.static_pres.transducer, &static_pres_.min_pa,
+                    &static_pres_.max_pa) ||
+      !HalStaticPresInit(cfg.static_pres)) {
+    MsgError("Unable to initialize static pressure sensor.");
+  }
+  if (!Ams5915Range(cfg.diff_pres.transducer, &diff_pres_.min_pa,
+                    &diff_pres_.max_pa) ||
+      !HalDiffPresInit(cfg.diff_pres)) {
+    MsgError("Unable to initialize differential pressure sensor.");
+  }
+}
+void PresI2cPoll(bool start) {
+  if (start) {start_pending_ = true;}
+  int64_t now_us = HalMicros();
+  if (now_us < next_step_us_) {return;}
+  switch (state_) {
+    case IDLE: {
+      if (start_pending_) {
+        start_pending_ = false;
+        ReadStart(static_pres_, now_us);
+        state_ = READ_STATIC;
+      }
+      break;
+    }
+    case READ_STATIC: {
+      bool timed_out = false;
+      if (!ReadPoll(static_pres_, &static_pres_buf_, now_us, &timed_out)) {
+        break;
+      }
+      if (timed_out) {
+        state_ = RECOVER_START;
+      } else {
+        ReadStart(diff_pres_, now_us);
+        state_ = READ_DIFF;
+      }
+      break;
+    }
+    case READ_DIFF: {
+      bool timed_out = false;
+      if (!ReadPoll(diff_pres_, &diff_pres_buf_, now_us, &timed_out)) {
+        break;
+      }
+      if (timed_out || (consecutive_errors_ >= MAX_CONSECUTIVE_ERRORS_)) {
+        state_ = RECOVER_START;
+      } else {
+        state_ = IDLE;
+      }
+      break;
+    }
+    case RECOVER_START: {
+      MsgWarning("Air data I2C bus errors, recovering bus.\n");
+      /* Take over the pins, SCL released high */
+      HalPresI2cTakeover();
+      recovery_step_ = 0;
+      next_step_us_ = now_us + RECOVERY_HALF_PERIOD_US_;
+      state_ = RECOVER_CLOCK;
+      break;
+    }
+    case RECOVER_CLOCK: {
+      /* Even steps have SCL high, check whether SDA is released */
+      if (recovery_step_ % 2 == 0) {
+        if ((HalPresI2cSda()) ||
+            (recovery_step_ >= 2 * RECOVERY_CLOCKS_)) {
+          recovery_step_ = 0;
+          state_ = RECOVER_STOP;
+        } else {
+          HalPresI2cScl(false);
+          recovery_step_++;
+        }
+      } else {
+        HalPresI2cScl(true);
+        recovery_step_++;
+      }
+      next_step_us_ = now_us + RECOVERY_HALF_PERIOD_US_;
+      break;
+    }
+    case RECOVER_STOP: {
+      /* STOP condition, SDA rising while SCL is high */
+      switch (recovery_step_) {
+        case 0: {
+          HalPresI2cScl(false);
+          HalPresI2cSda(false);
+          break;
+        }
+        case 1: {
+          HalPresI2cScl(true);
+          break;
+        }
+        default: {
+          HalPresI2cSda(true);
+          state_ = RECOVER_RESTART;
+          break;
+        }
+      }
+      recovery_step_++;
+      next_step_us_ = now_us + RECOVERY_HALF_PERIOD_US_;
+      break;
+    }
+    case RECOVER_RESTART: {
+      /* Hand the pins back to the I2C peripheral */
+      HalPresI2cRestart();
+      consecutive_errors_ = 0;
+      /* Back off if the previous recovery did not fix the bus */
+      next_step_us_ = now_us + backoff_us_;
+      backoff_us_ = std::clamp(2 * backoff_us_, MIN_BACKOFF_US_,
+                               MAX_BACKOFF_US_);
+      state_ = IDLE;
+      break;
+    }
+  }
+}
+void PresI2cRead(SensorData * const data) {
+  if (!data) {return;}
+  int64_t now_us = HalMicros();
+  Copy(&static_pres_buf_, now_us, &data->static_pres,
+       &data->static_pres_sample);
+  Copy(&diff_pres_buf_, now_us, &data->diff_pres, &data->diff_pres_sample);
+}
@@ -0,0 +1,46 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/profile.h"
+#include "flight/global_defs.h"
+#include "flight/hal.h"
+
+namespace {
+/* Stage start times and accumulated durations of the current frame, us */
+std::array<int64_t, NUM_FRAME_STAGES> start_us_ = {};
+std::array<int32_t, NUM_FRAME_STAGES> time_us_ = {};
+}  // namespace
+
+void ProfileStart(const FrameStage stage) {
+  start_us_[stage] = HalMicros();
+}
+void ProfileStop(const FrameStage stage) {
+  time_us_[stage] += static_cast<int32_t>(HalMicros() - start_us_[stage]);
+}
+void ProfileRead(std::array<int32_t, NUM_FRAME_STAGES> * const time_us) {
+  if (!time_us) {return;}
+  *time_us = time_us_;
+  time_us_.fill(0);
+}
@@ -27,6 +27,12 @@
 #include "flight/global_defs.h"
 #include "flight/config.h"
 #include "flight/msg.h"
+#include "flight/hal.h"
+#include "flight/acquire.h"
+#include "flight/vote.h"
+#include "flight/imu_cal.h"
+#include "flight/inceptor.h"
+#include "flight/vibration.h"
 #include "flight/analog.h"
 #if defined(__FMU_R_V2__)
 #include "flight/battery.h"
@@ -35,76 +41,99 @@
 namespace {
 /* Whether pitot static is installed */
 bool pitot_static_installed_;
-/* Sensors */
-bfs::SbusRx inceptor;
-bfs::Mpu9250 imu;
-bfs::Ublox gnss;
-bfs::Bme280 fmu_static_pres;
-bfs::Ams5915 pitot_static_pres;
-bfs::Ams5915 pitot_diff_pres;
+/* Whether the redundant IMU is installed */
+bool redundant_imu_installed_;
+/* Whether the FMU static pressure transducer backs up pitot static */
+bool fmu_static_pres_redundant_ = false;
+/* FMU static pressure transducer, defined by the hardware */
+const bfs::PresConfig FMU_STATIC_PRES_CFG_ = {
+  .dev = PRES_CS,
+  .sampling_period_ms = FRAME_PERIOD_MS,
+  .bus = &PRES_SPI_BUS
+};
+/* Reads the FMU static pressure transducer into a redundant source */
+void FmuStaticPresRead(bfs::PresData * const data,
+                       SampleInfo * const sample) {
+  sample->fresh = HalFmuStaticPresRead(data);
+  sample->time_us = HalMicros();
+}
 }  // namespace
 
 void SensorsInit(const SensorConfig &cfg) {
   pitot_static_installed_ = cfg.pitot_static_installed;
+  redundant_imu_installed_ = cfg.redundant_imu_installed;
   MsgInfo("Intializing sensors...");
-  /* Initialize IMU */
-  if (!imu.Init(cfg.imu)) {
+  /* Initialize IMU, with the stored calibration if available */
+  bfs::ImuConfig imu_cfg = cfg.imu;
+  ImuCalLoad(&imu_cfg);
+  if (!HalImuInit(imu_cfg)) {
     MsgError("Unable to initialize IMU.");
   }
-  /* Initialize GNSS */
-  if (!gnss.Init(cfg.gnss)) {
-    MsgError("Unable to initialize GNSS.");
+  ImuCalInit(imu_cfg);
+  VibrationInit();
+  if (redundant_imu_installed_) {
+    if (!HalRedundantImuInit(cfg.redundant_imu)) {
+      MsgError("Unable to initialize redundant IMU.");
+    }
   }
   /* Initialize pressure transducers */
-  if (pitot_static_installed_) {
-    if (!pitot_static_pres.Init(cfg.static_pres)) {
+  if (!pitot_static_installed_) {
+    if (!HalFmuStaticPresInit(cfg.static_pres)) {
       MsgError("Unable to initialize static pressure sensor.");
     }
-    if (!pitot_diff_pres.Init(cfg.diff_pres)) {
-      MsgError("Unable to initialize differential pressure sensor.");
-    }
   } else {
-    if (!fmu_static_pres.Init(cfg.static_pres)) {
-      MsgError("Unable to initialize static pressure sensor.");
+    fmu_static_pres_redundant_ = HalFmuStaticPresInit(FMU_STATIC_PRES_CFG_);
+    if (!fmu_static_pres_redundant_) {
+      MsgWarning("Unable to initialize FMU static pressure sensor, "
+                 "continuing without a redundant static source.\n");
     }
   }
+  /* Initialize background acquired sensors */
+  AcquireInit(cfg);
+  /* Initialize voting */
+  VoteInit(cfg);
   MsgInfo("done.\n");
   /* Initialize inceptors */
   MsgInfo("Initializing inceptors...");
-  while (!inceptor.Init(&SBUS_UART)) {}
+  while (!InceptorInit()) {}
   MsgInfo("done.\n");
 }
 void SensorsRead(SensorData * const data) {
   if (!data) {return;}
   /* Read inceptors */
-  data->inceptor.new_data = inceptor.Read();
-  if (data->inceptor.new_data) {
-    data->inceptor.ch = inceptor.ch();
-    data->inceptor.ch17 = inceptor.ch17();
-    data->inceptor.ch18 = inceptor.ch18();
-    data->inceptor.lost_frame = inceptor.lost_frame();
-    data->inceptor.failsafe = inceptor.failsafe();
-  }
-  /* Read IMU */
-  if (!imu.Read(&data->imu)) {
+  InceptorRead(data);
+  /* Read IMUs, a failed read leaves the source without new data */
+  RedundancyData &rdnt = data->redundancy;
+  if (!HalImuRead(&rdnt.imu[0])) {
+    rdnt.imu[0].new_imu_data = false;
     MsgWarning("Unable to read IMU data.\n");
   }
-  /* Read GNSS */
-  gnss.Read(&data->gnss);
+  rdnt.imu_sample[0].fresh = rdnt.imu[0].new_imu_data;
+  rdnt.imu_sample[0].time_us = HalImuDrdyTime();
+  if (redundant_imu_installed_) {
+    if (!HalRedundantImuRead(&rdnt.imu[1])) {
+      rdnt.imu[1].new_imu_data = false;
+      MsgWarning("Unable to read redundant IMU data.\n");
+    }
+    rdnt.imu_sample[1].fresh = rdnt.imu[1].new_imu_data;
+    rdnt.imu_sample[1].time_us = HalRedundantImuDrdyTime();
+  }
   /* Set whether pitot static is installed */
   data->pitot_static_installed = pitot_static_installed_;
   /* Read pressure transducers */
-  if (pitot_static_installed_) {
-    if (!pitot_static_pres.Read(&data->static_pres)) {
-      MsgError("Unable to read pitot static pressure data.\n");
-    }
-    if (!pitot_diff_pres.Read(&data->diff_pres)) {
-      MsgError("Unable to read pitot diff pressure data.\n");
-    }
-  } else {
-    if (!fmu_static_pres.Read(&data->static_pres)) {
+  if (!pitot_static_installed_) {
+    FmuStaticPresRead(&rdnt.static_pres[0], &rdnt.static_pres_sample[0]);
+    if (!rdnt.static_pres_sample[0].fresh) {
       MsgError("Unable to read FMU static pressure data.\n");
     }
+  } else if (fmu_static_pres_redundant_) {
+    FmuStaticPresRead(&rdnt.static_pres[1], &rdnt.static_pres_sample[1]);
+  }
+  /* Latest samples from background acquisition */
+  AcquireRead(data);
+  if (pitot_static_installed_) {
+    rdnt.static_pres[0] = data->static_pres;
+    rdnt.static_pres_sample[0] = data->static_pres_sample;
   }
   /* Read analog channels */
   AnalogRead(&data->adc);
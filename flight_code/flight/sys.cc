@@ -26,55 +26,35 @@
 #include "flight/sys.h"
 #include "flight/hardware_defs.h"
 #include "flight/global_defs.h"
+#include "flight/adc_scan.h"
+#include "flight/hal.h"
 
 namespace {
 /* Frame time */
 int64_t frame_start_us_;
 int32_t frame_time_us_ = 0;
+#if defined(__FMU_R_V1__)
+/* System voltages */
+AdcScanData adc_;
+#endif
 }  // namespace
 
 void SysInit() {
-  /* Pullup CS pins */
-  pinMode(IMU_CS, OUTPUT);
-  pinMode(VN_CS, OUTPUT);
-  pinMode(PRES_CS, OUTPUT);
-  digitalWriteFast(IMU_CS, HIGH);
-  digitalWriteFast(VN_CS, HIGH);
-  digitalWriteFast(PRES_CS, HIGH);
-  /* Initialize buses */
-  #if defined(__FMU_R_V2__) || defined(__FMU_R_V2_BETA__)
-  /* I2C */
-  Wire.begin();
-  Wire.setClock(400000);
-  #endif
-  #if defined(__FMU_R_V1__)
-  /* I2C */
-  Wire1.begin();
-  Wire1.setClock(400000);
-  /* BFS */
-  pinMode(BFS_INT1, OUTPUT);
-  pinMode(BFS_INT2, OUTPUT);
-  #endif
-  SPI.begin();
-  /* Setup analog for voltage monitoring */
-  analogReadResolution(ANALOG_RESOLUTION_BITS);
+  HalInit();
 }
 void SysRead(SysData * const ptr) {
   if (!ptr) {return;}
-  frame_start_us_ = micros64();
+  frame_start_us_ = HalMicros();
   ptr->sys_time_us = frame_start_us_;
   ptr->frame_time_us = frame_time_us_;
   #if defined(__FMU_R_V1__)
-  ptr->input_volt = static_cast<float>(analogRead(INPUT_VOLTAGE_PIN)) *
-                    INPUT_VOLTAGE_SCALE;
-  ptr->reg_volt = static_cast<float>(analogRead(REGULATED_VOLTAGE_PIN)) *
-                  REGULATED_VOLTAGE_SCALE;
-  ptr->sbus_volt = static_cast<float>(analogRead(SBUS_VOLTAGE_PIN)) *
-                   SBUS_VOLTAGE_SCALE;
-  ptr->pwm_volt = static_cast<float>(analogRead(PWM_VOLTAGE_PIN)) *
-                  PWM_VOLTAGE_SCALE;
+  AdcScanRead(&adc_);
+  ptr->input_volt = adc_.cnt[ADC_INPUT_VOLTAGE_CH] * INPUT_VOLTAGE_SCALE;
+  ptr->reg_volt = adc_.cnt[ADC_REGULATED_VOLTAGE_CH] * REGULATED_VOLTAGE_SCALE;
+  ptr->sbus_volt = adc_.cnt[ADC_SBUS_VOLTAGE_CH] * SBUS_VOLTAGE_SCALE;
+  ptr->pwm_volt = adc_.cnt[ADC_PWM_VOLTAGE_CH] * PWM_VOLTAGE_SCALE;
   #endif
 }
 void SysFrameEnd() {
-  frame_time_us_ = static_cast<int32_t>(micros64() - frame_start_us_);
+  frame_time_us_ = static_cast<int32_t>(HalMicros() - frame_start_us_);
 }
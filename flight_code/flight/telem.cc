@@ -27,8 +27,8 @@
 #include "flight/global_defs.h"
 #include "flight/hardware_defs.h"
 #include "mavlink/mavlink.h"
-#include "checksum/checksum.h"
 #include "flight/msg.h"
+#include "flight/param_store.h"
 
 
 namespace {
@@ -47,15 +47,6 @@ static constexpr int16_t EXTRA2_STREAM_PERIOD_MS_ = 100;
 static constexpr int16_t FRAME_PERIOD_US = FRAME_PERIOD_MS * 1000;
 /* Parameter */
 int32_t param_idx_;
-static constexpr uint8_t PARAM_STORE_HEADER[] = {'B', 'F', 'S'};
-static constexpr std::size_t PARAM_STORE_SIZE = sizeof(PARAM_STORE_HEADER) +
-                                                NUM_TELEM_PARAMS *
-                                                sizeof(float) +
-                                                sizeof(uint16_t);
-uint8_t param_buf[PARAM_STORE_SIZE];
-bfs::Fletcher16 param_checksum;
-uint16_t chk_computed, chk_read;
-uint8_t chk_buf[2];
 /* Effector */
 std::array<int16_t, 16> effector_;
 int NUM_SBUS = std::min(static_cast<std::size_t>(NUM_SBUS_CH),
@@ -73,77 +64,9 @@ void TelemInit(const AircraftConfig &cfg, TelemData * const ptr) {
   telem_.fence(ptr->fence.data(), ptr->fence.size());
   telem_.rally(ptr->rally.data(), ptr->rally.size());
   /* Load the telemetry parameters from EEPROM */
-  for (std::size_t i = 0; i < PARAM_STORE_SIZE; i++) {
-    param_buf[i] = EEPROM.read(i);
-  }
-  /* Check whether the parameter store has been initialized */
-  /* If it hasn't... */
-  if ((param_buf[0] != PARAM_STORE_HEADER[0]) ||
-      (param_buf[1] != PARAM_STORE_HEADER[1]) ||
-      (param_buf[2] != PARAM_STORE_HEADER[2])) {
-    MsgInfo("Parameter storage not initialized, initializing...");
-    /* Set the header */
-    param_buf[0] = PARAM_STORE_HEADER[0];
-    param_buf[1] = PARAM_STORE_HEADER[1];
-    param_buf[2] = PARAM_STORE_HEADER[2];
-    /* Zero out the parameters */
-    for (std::size_t i = 0; i < NUM_TELEM_PARAMS * sizeof(float); i++) {
-      param_buf[i + 3] = 0;
-    }
-    /* Compute the checksum */
-    chk_computed = param_checksum.Compute(param_buf,
-                                          sizeof(PARAM_STORE_HEADER) +
-                                          NUM_TELEM_PARAMS * sizeof(float));
-    chk_buf[0] = static_cast<uint8_t>(chk_computed >> 8);
-    chk_buf[1] = static_cast<uint8_t>(chk_computed);
-    param_buf[PARAM_STORE_SIZE - 2] = chk_buf[0];
-    param_buf[PARAM_STORE_SIZE - 1] = chk_buf[1];
-    /* Write to EEPROM */
-    for (std::size_t i = 0; i < PARAM_STORE_SIZE; i++) {
-      EEPROM.write(i, param_buf[i]);
-    }
-    MsgInfo("done.\n");
-  /* If it has been initialized */
-  } else {
-    /* Check the checksum */
-    chk_computed = param_checksum.Compute(param_buf,
-                                          sizeof(PARAM_STORE_HEADER) +
-                                          NUM_TELEM_PARAMS * sizeof(float));
-    chk_buf[0] = param_buf[PARAM_STORE_SIZE - 2];
-    chk_buf[1] = param_buf[PARAM_STORE_SIZE - 1];
-    chk_read = static_cast<uint16_t>(chk_buf[0]) << 8 |
-               static_cast<uint16_t>(chk_buf[1]);
-    if (chk_computed != chk_read) {
-      /* Parameter store corrupted, reset and warn */
-      MsgWarning("Parameter storage corrupted, resetting...");
-      /* Set the header */
-      param_buf[0] = PARAM_STORE_HEADER[0];
-      param_buf[1] = PARAM_STORE_HEADER[1];
-      param_buf[2] = PARAM_STORE_HEADER[2];
-      /* Zero out the parameters */
-      for (std::size_t i = 0; i < NUM_TELEM_PARAMS * sizeof(float); i++) {
-        param_buf[i + 3] = 0;
-      }
-      /* Compute the checksum */
-      chk_computed = param_checksum.Compute(param_buf,
-                                            sizeof(PARAM_STORE_HEADER) +
-                                            NUM_TELEM_PARAMS * sizeof(float));
-      chk_buf[0] = static_cast<uint8_t>(chk_computed >> 8);
-      chk_buf[1] = static_cast<uint8_t>(chk_computed);
-      param_buf[PARAM_STORE_SIZE - 2] = chk_buf[0];
-      param_buf[PARAM_STORE_SIZE - 1] = chk_buf[1];
-      /* Write to EEPROM */
-      for (std::size_t i = 0; i < PARAM_STORE_SIZE; i++) {
-        EEPROM.write(i, param_buf[i]);
-      }
-      MsgInfo("done.\n");
-    } else {
-      /* Copy parameter data to global defs */
-      memcpy(ptr->param.data(), param_buf + sizeof(PARAM_STORE_HEADER),
-             NUM_TELEM_PARAMS * sizeof(float));
-      /* Update the parameter values in MAV Link */
-      telem_.params(ptr->param);
-    }
+  if (ParamStoreLoad(&ptr->param)) {
+    /* Update the parameter values in MAV Link */
+    telem_.params(ptr->param);
   }
   /* Begin communication */
   telem_.Begin(cfg.telem.baud);
@@ -271,25 +194,8 @@ void TelemUpdate(const AircraftData &data, TelemData * const ptr) {
   if (param_idx_ >= 0) {
     /* Update the value in global defs */
     ptr->param[param_idx_] = telem_.param(param_idx_);
-    /* Update the parameter buffer value */
-    memcpy(param_buf + sizeof(PARAM_STORE_HEADER) + param_idx_ * sizeof(float),
-           &ptr->param[param_idx_], sizeof(float));
-    /* Compute a new checksum */
-    chk_computed = param_checksum.Compute(param_buf,
-                                          sizeof(PARAM_STORE_HEADER) +
-                                          NUM_TELEM_PARAMS * sizeof(float));
-    chk_buf[0] = static_cast<uint8_t>(chk_computed >> 8);
-    chk_buf[1] = static_cast<uint8_t>(chk_computed);
-    param_buf[PARAM_STORE_SIZE - 2] = chk_buf[0];
-    param_buf[PARAM_STORE_SIZE - 1] = chk_buf[1];
-    /* Write to EEPROM */
-    for (std::size_t i = 0; i < sizeof(float); i++) {
-      std::size_t addr = i + sizeof(PARAM_STORE_HEADER) +
-                         param_idx_ * sizeof(float);
-      EEPROM.write(addr, param_buf[addr]);
-    }
-    EEPROM.write(PARAM_STORE_SIZE - 2, param_buf[PARAM_STORE_SIZE - 2]);
-    EEPROM.write(PARAM_STORE_SIZE - 1, param_buf[PARAM_STORE_SIZE - 1]);
+    /* Store the new value */
+    ParamStoreWrite(param_idx_, ptr->param[param_idx_]);
   }
   /* Flight plan */
   ptr->waypoints_updated = telem_.mission_updated();
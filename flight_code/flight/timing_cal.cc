@@ -0,0 +1,273 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/timing_cal.h"
+#include <array>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include "flight/msg.h"
+#include "flight/hal.h"
+
+namespace {
+/* Kernel inputs and outputs, volatile so they aren't folded away */
+volatile uint32_t vu_ = 3;
+volatile uint32_t vbig_ = 0x7fffffff;
+volatile float vf_ = 1.0001f;
+volatile double vd_ = 1.0001;
+volatile uint32_t su_;
+volatile float sf_;
+volatile double sd_;
+/* Pointer chasing table for loads, and a buffer for stores */
+static constexpr uint32_t BUF_MASK_ = 255;
+constexpr std::array<uint32_t, BUF_MASK_ + 1> ChaseTable() {
+  /* A permutation with a single cycle through the table */
+  std::array<uint32_t, BUF_MASK_ + 1> t = {};
+  for (uint32_t i = 0; i <= BUF_MASK_; i++) {
+    t[i] = (i * 97 + 1) & BUF_MASK_;
+  }
+  return t;
+}
+std::array<uint32_t, BUF_MASK_ + 1> chase_ = ChaseTable();
+std::array<uint32_t, BUF_MASK_ + 1> buf_;
+/* Times each kernel is run, keeping the fastest */
+static constexpr int TIMING_CAL_REPEATS_ = 5;
+/* Called function, kept out of line and opaque to the optimizer */
+__attribute__((noinline)) uint32_t Callee(const uint32_t x) {
+  asm volatile("");
+  return x + 1;
+}
+/*
+* The chains use different operations where they could otherwise be
+* combined into vector instructions on the host
+*/
+void Loop() {
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    asm volatile("");
+  }
+}
+void IntAlu() {
+  uint32_t b = vu_, c = vu_ + 1;
+  uint32_t a0 = b, a1 = c, a2 = b + c, a3 = b ^ c;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    a0 = (a0 + b) ^ c;
+    a1 = (a1 ^ b) + c;
+    a2 = (a2 - b) ^ c;
+    a3 = (a3 ^ c) - b;
+  }
+  su_ = a0 + a1 + a2 + a3;
+}
+void IntMul() {
+  uint32_t b = vu_, c = vu_ + 2;
+  uint32_t a0 = b, a1 = c, a2 = b + c, a3 = b ^ c;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    a0 *= b;
+    a1 *= c;
+    a2 *= c;
+    a3 *= b;
+  }
+  su_ = a0 + a1 + a2 + a3;
+}
+void IntDiv() {
+  uint32_t b = vu_, c = vbig_;
+  uint32_t a0 = b, a1 = b + 1, a2 = b + 2, a3 = b + 3;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    a0 = c / (a0 | 1) + b;
+    a1 = c / (a1 | 2) + b;
+    a2 = c / (a2 | 4) + b;
+    a3 = c / (a3 | 8) + b;
+  }
+  su_ = a0 + a1 + a2 + a3;
+}
+void Load() {
+  uint32_t a0 = vu_, a1 = vu_ + 64, a2 = vu_ + 128, a3 = vu_ + 192;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    a0 = chase_[a0];
+    a1 = chase_[a1];
+    a2 = chase_[a2];
+    a3 = chase_[a3];
+  }
+  su_ = a0 + a1 + a2 + a3;
+}
+void Store() {
+  uint32_t b = vu_;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    uint32_t idx = static_cast<uint32_t>(i) & BUF_MASK_;
+    buf_[idx] = b;
+    buf_[idx ^ 64] = b;
+    buf_[idx ^ 128] = b;
+    buf_[idx ^ 192] = b;
+    /* Keeps the stores from being combined across iterations */
+    asm volatile("" : : : "memory");
+  }
+}
+void Call() {
+  uint32_t a0 = vu_, a1 = vu_, a2 = vu_, a3 = vu_;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    a0 = Callee(a0);
+    a1 = Callee(a1);
+    a2 = Callee(a2);
+    a3 = Callee(a3);
+  }
+  su_ = a0 + a1 + a2 + a3;
+}
+void F32Add() {
+  float y = vf_, z = 2 * vf_;
+  float x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 += y;
+    x1 -= y;
+    x2 += z;
+    x3 -= z;
+  }
+  sf_ = x0 + x1 + x2 + x3;
+}
+void F32Mul() {
+  float y = vf_, z = 1 / vf_;
+  float x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 *= y;
+    x1 *= z;
+    x2 *= z;
+    x3 *= y;
+  }
+  sf_ = x0 + x1 + x2 + x3;
+}
+void F32Div() {
+  float y = vf_, z = 1 / vf_;
+  float x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 /= y;
+    x1 /= z;
+    x2 /= z;
+    x3 /= y;
+  }
+  sf_ = x0 + x1 + x2 + x3;
+}
+void F64Add() {
+  double y = vd_, z = 2 * vd_;
+  double x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 += y;
+    x1 -= y;
+    x2 += z;
+    x3 -= z;
+  }
+  sd_ = x0 + x1 + x2 + x3;
+}
+void F64Mul() {
+  double y = vd_, z = 1 / vd_;
+  double x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 *= y;
+    x1 *= z;
+    x2 *= z;
+    x3 *= y;
+  }
+  sd_ = x0 + x1 + x2 + x3;
+}
+void F64Div() {
+  double y = vd_, z = 1 / vd_;
+  double x0 = y, x1 = z, x2 = y + z, x3 = y - z;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 /= y;
+    x1 /= z;
+    x2 /= z;
+    x3 /= y;
+  }
+  sd_ = x0 + x1 + x2 + x3;
+}
+void F32Libm() {
+  float y = vf_;
+  float x0 = y, x1 = 2 * y, x2 = 3 * y, x3 = 4 * y;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 = std::sin(x0) + y;
+    x1 = std::cos(x1) + y;
+    x2 = std::sin(x2) + y;
+    x3 = std::cos(x3) + y;
+  }
+  sf_ = x0 + x1 + x2 + x3;
+}
+void F64Libm() {
+  double y = vd_;
+  double x0 = y, x1 = 2 * y, x2 = 3 * y, x3 = 4 * y;
+  for (int32_t i = 0; i < TIMING_KERNEL_ITER; i++) {
+    x0 = std::sin(x0) + y;
+    x1 = std::cos(x1) + y;
+    x2 = std::sin(x2) + y;
+    x3 = std::cos(x3) + y;
+  }
+  sd_ = x0 + x1 + x2 + x3;
+}
+struct Kernel {
+  const char *name;
+  void (*run)();
+};
+static constexpr Kernel KERNELS_[NUM_TIMING_KERNELS] = {
+  {"loop", Loop},
+  {"int_alu", IntAlu},
+  {"int_mul", IntMul},
+  {"int_div", IntDiv},
+  {"load", Load},
+  {"store", Store},
+  {"call", Call},
+  {"f32_add", F32Add},
+  {"f32_mul", F32Mul},
+  {"f32_div", F32Div},
+  {"f64_add", F64Add},
+  {"f64_mul", F64Mul},
+  {"f64_div", F64Div},
+  {"f32_libm", F32Libm},
+  {"f64_libm", F64Libm}
+};
+}  // namespace
+
+const char * TimingKernelName(const std::size_t k) {
+  return (k < NUM_TIMING_KERNELS) ? KERNELS_[k].name : "";
+}
+void TimingKernelRun(const std::size_t k) {
+  if (k < NUM_TIMING_KERNELS) {KERNELS_[k].run();}
+}
+void TimingCalRun() {
+  char line[64];
+  MsgInfo("% Timing calibration, cycles of each kernel\n");
+  snprintf(line, sizeof(line), "clock_hz %" PRIu32 "\n", HalCycleHz());
+  MsgInfo(line);
+  snprintf(line, sizeof(line), "iterations %" PRId32 "\n",
+           TIMING_KERNEL_ITER);
+  MsgInfo(line);
+  for (std::size_t k = 0; k < NUM_TIMING_KERNELS; k++) {
+    uint32_t best = UINT32_MAX;
+    for (int r = 0; r < TIMING_CAL_REPEATS_; r++) {
+      uint32_t t0 = HalCycles();
+      TimingKernelRun(k);
+      uint32_t t = HalCycles() - t0;
+      best = (t < best) ? t : best;
+    }
+    snprintf(line, sizeof(line), "kernel %s %" PRIu32 "\n",
+             KERNELS_[k].name, best);
+    MsgInfo(line);
+  }
+}
@@ -0,0 +1,239 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/ubx.h"
+#include <cmath>
+
+namespace {
+static constexpr double DEG2RAD_ = 0.017453292519943295;
+/* GPS - UTC, s */
+static constexpr int64_t LEAP_SECONDS_ = 18;
+static constexpr int64_t SECONDS_PER_WEEK_ = 604800;
+/* Days since 1970-01-01 for a civil date */
+int64_t DaysFromCivil(int64_t y, const int64_t m, const int64_t d) {
+  y -= (m <= 2);
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+}  // namespace
+
+bool UbxParser::Parse(const uint8_t c) {
+  switch (state_) {
+    case SYNC1: {
+      if (c == UBX_SYNC1_) {
+        state_ = SYNC2;
+      }
+      return false;
+    }
+    case SYNC2: {
+      if (c == UBX_SYNC2_) {
+        state_ = CLASS;
+      } else if (c != UBX_SYNC1_) {
+        state_ = SYNC1;
+      }
+      return false;
+    }
+    case CLASS: {
+      cls_ = c;
+      chk_a_ = c;
+      chk_b_ = c;
+      state_ = ID;
+      return false;
+    }
+    case ID: {
+      id_ = c;
+      state_ = LEN1;
+      break;
+    }
+    case LEN1: {
+      len_ = c;
+      state_ = LEN2;
+      break;
+    }
+    case LEN2: {
+      len_ |= static_cast<uint16_t>(c) << 8;
+      idx_ = 0;
+      state_ = (len_ > 0) ? PAYLOAD : CHK_A;
+      break;
+    }
+    case PAYLOAD: {
+      if (idx_ < MAX_PAYLOAD_LEN_) {
+        payload_[idx_] = c;
+      }
+      if (++idx_ == len_) {
+        state_ = CHK_A;
+      }
+      break;
+    }
+    case CHK_A: {
+      if (c != chk_a_) {
+        checksum_errors_++;
+        state_ = (c == UBX_SYNC1_) ? SYNC2 : SYNC1;
+        return false;
+      }
+      state_ = CHK_B;
+      return false;
+    }
+    case CHK_B: {
+      state_ = SYNC1;
+      if (c != chk_b_) {
+        checksum_errors_++;
+        return false;
+      }
+      return Handle();
+    }
+  }
+  /* 8-bit Fletcher checksum over class, id, length, and payload */
+  chk_a_ += c;
+  chk_b_ += chk_a_;
+  return false;
+}
+
+bool UbxParser::Handle() {
+  if (cls_ != UBX_NAV_CLASS_) {return false;}
+  switch (id_) {
+    case UBX_NAV_PVT_ID_: {
+      if (len_ == UBX_NAV_PVT_LEN_) {
+        ParsePvt();
+      }
+      return false;
+    }
+    case UBX_NAV_DOP_ID_: {
+      if (len_ == UBX_NAV_DOP_LEN_) {
+        ParseDop();
+      }
+      return false;
+    }
+    case UBX_NAV_HPPOSLLH_ID_: {
+      if (len_ == UBX_NAV_HPPOSLLH_LEN_) {
+        ParseHpposllh();
+      }
+      return false;
+    }
+    case UBX_NAV_EOE_ID_: {
+      if (len_ != UBX_NAV_EOE_LEN_) {return false;}
+      uint32_t tow_ms = U4(0);
+      if (!pvt_valid_ || (pvt_tow_ms_ != tow_ms)) {
+        pvt_valid_ = false;
+        hp_valid_ = false;
+        return false;
+      }
+      data_ = epoch_;
+      /* High precision position, if it is from this epoch */
+      if (hp_valid_ && (hp_tow_ms_ == tow_ms)) {
+        data_.lat_rad = epoch_hp_lat_rad_;
+        data_.lon_rad = epoch_hp_lon_rad_;
+        data_.alt_wgs84_m = epoch_hp_alt_wgs84_m_;
+        data_.alt_msl_m = epoch_hp_alt_msl_m_;
+        data_.horz_acc_m = epoch_hp_horz_acc_m_;
+        data_.vert_acc_m = epoch_hp_vert_acc_m_;
+      }
+      pvt_valid_ = false;
+      hp_valid_ = false;
+      num_epochs_++;
+      return true;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+void UbxParser::ParsePvt() {
+  pvt_tow_ms_ = U4(0);
+  epoch_.tow_ms = static_cast<int32_t>(pvt_tow_ms_);
+  /* GPS week from the UTC date and time, if valid */
+  uint8_t valid = U1(11);
+  if ((valid & 0x03) == 0x03) {
+    int64_t days = DaysFromCivil(U2(4), U1(6), U1(7)) -
+                   DaysFromCivil(1980, 1, 6);
+    int64_t gps_s = days * 86400 + U1(8) * 3600 + U1(9) * 60 + U1(10) +
+                    LEAP_SECONDS_;
+    epoch_.week = static_cast<int16_t>(gps_s / SECONDS_PER_WEEK_);
+  }
+  /* Fix */
+  uint8_t fix_type = U1(20);
+  uint8_t flags = U1(21);
+  bool fix_ok = flags & 0x01;
+  bool diff_soln = flags & 0x02;
+  uint8_t carr_soln = (flags >> 6) & 0x03;
+  if (!fix_ok || (fix_type < 2) || (fix_type > 4)) {
+    epoch_.fix = 1;
+  } else if (fix_type == 2) {
+    epoch_.fix = 2;
+  } else if (carr_soln == 2) {
+    epoch_.fix = 6;
+  } else if (carr_soln == 1) {
+    epoch_.fix = 5;
+  } else if (diff_soln) {
+    epoch_.fix = 4;
+  } else {
+    epoch_.fix = 3;
+  }
+  epoch_.num_sats = static_cast<int8_t>(U1(23));
+  /* Position */
+  epoch_.lon_rad = static_cast<double>(I4(24)) * 1e-7 * DEG2RAD_;
+  epoch_.lat_rad = static_cast<double>(I4(28)) * 1e-7 * DEG2RAD_;
+  epoch_.alt_wgs84_m = static_cast<float>(I4(32)) * 1e-3f;
+  epoch_.alt_msl_m = static_cast<float>(I4(36)) * 1e-3f;
+  epoch_.horz_acc_m = static_cast<float>(U4(40)) * 1e-3f;
+  epoch_.vert_acc_m = static_cast<float>(U4(44)) * 1e-3f;
+  /* Velocity */
+  epoch_.ned_vel_mps[0] = static_cast<float>(I4(48)) * 1e-3f;
+  epoch_.ned_vel_mps[1] = static_cast<float>(I4(52)) * 1e-3f;
+  epoch_.ned_vel_mps[2] = static_cast<float>(I4(56)) * 1e-3f;
+  epoch_.spd_mps = static_cast<float>(I4(60)) * 1e-3f;
+  epoch_.track_rad = static_cast<float>(static_cast<double>(I4(64)) * 1e-5 *
+                                        DEG2RAD_);
+  epoch_.vel_acc_mps = static_cast<float>(U4(68)) * 1e-3f;
+  epoch_.track_acc_rad = static_cast<float>(static_cast<double>(U4(72)) *
+                                            1e-5 * DEG2RAD_);
+  pvt_valid_ = true;
+}
+
+void UbxParser::ParseDop() {
+  epoch_.vdop = static_cast<float>(U2(10)) * 0.01f;
+  epoch_.hdop = static_cast<float>(U2(12)) * 0.01f;
+}
+
+void UbxParser::ParseHpposllh() {
+  /* Invalid lat, lon, and height */
+  if (U1(3) & 0x01) {return;}
+  hp_tow_ms_ = U4(4);
+  epoch_hp_lon_rad_ = (static_cast<double>(I4(8)) * 1e-7 +
+                       static_cast<double>(I1(24)) * 1e-9) * DEG2RAD_;
+  epoch_hp_lat_rad_ = (static_cast<double>(I4(12)) * 1e-7 +
+                       static_cast<double>(I1(25)) * 1e-9) * DEG2RAD_;
+  epoch_hp_alt_wgs84_m_ = static_cast<float>(
+    static_cast<double>(I4(16)) * 1e-3 + static_cast<double>(I1(26)) * 1e-4);
+  epoch_hp_alt_msl_m_ = static_cast<float>(
+    static_cast<double>(I4(20)) * 1e-3 + static_cast<double>(I1(27)) * 1e-4);
+  epoch_hp_horz_acc_m_ = static_cast<float>(U4(28)) * 1e-4f;
+  epoch_hp_vert_acc_m_ = static_cast<float>(U4(32)) * 1e-4f;
+  hp_valid_ = true;
+}
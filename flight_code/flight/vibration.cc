@@ -0,0 +1,212 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/vibration.h"
+#include <atomic>
+#include <cmath>
+#include <utility>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+#include "flight/double_buffer.h"
+
+/*
+* Spectra of the IMU accelerometer and gyro axes, for placing notch
+* filters and choosing the navigation filter cutoff frequencies from
+* flight data. The frame adds each IMU sample to a ring buffer and marks
+* the end of a window every half window, so windows overlap by half. The
+* main loop processes a completed window one axis per pass: the mean is
+* removed, a Hann window is applied, and a real FFT is computed as a half
+* length complex FFT followed by a split into the one sided spectrum. The
+* RMS about the mean, the dominant frequency and its amplitude, and the
+* RMS in equal width bands are published once all axes are processed.
+*
+* The IMU is sampled at the frame rate, so the spectra only extend to half
+* the frame rate, published as nyquist_hz. Motor and propeller vibration is
+* usually above it; what passes the IMU low pass filter aliases, folding
+* to |f - k * frame rate|, and shows up in the bands at the wrong
+* frequency. Spectra above the frame rate need the IMU FIFO read at the
+* IMU internal rate, which the IMU driver doesn't support.
+*/
+
+namespace {
+/* Window length and the half length complex FFT */
+static constexpr std::size_t N_ = 128;
+static constexpr std::size_t M_ = N_ / 2;
+/* Samples between windows */
+static constexpr std::size_t HOP_ = N_ / 2;
+/* Samples held, so a window survives a hop while it is processed */
+static constexpr std::size_t RING_LEN_ = 2 * N_;
+static constexpr std::size_t BINS_PER_BAND_ = M_ / NUM_VIBE_BANDS;
+/* Hann window coherent and power gains */
+static constexpr float HANN_GAIN_ = 0.5f;
+static constexpr float HANN_POWER_GAIN_ = 0.375f;
+static constexpr float PI_ = 3.14159265358979f;
+static constexpr float SAMPLE_RATE_HZ_ = 1000.0f / FRAME_PERIOD_MS;
+/* Sample ring and count, written by the frame */
+float ring_[NUM_VIBE_AXES][RING_LEN_];
+uint32_t num_samples_ = 0;
+/* Sample count at the end of the latest window */
+std::atomic<uint32_t> window_end_{0};
+/* Window being processed and its next axis */
+uint32_t processed_end_ = 0;
+std::size_t axis_ = NUM_VIBE_AXES;
+/* Window and twiddle factors, exp(-2 pi i k / N) = cos - i sin */
+float hann_[N_];
+float cos_[M_], sin_[M_];
+/* FFT work and power spectrum */
+float re_[M_], im_[M_];
+float power_[M_];
+VibrationData spectra_ = {};
+DoubleBuffer<VibrationData> spectra_buf_;
+
+/* In place complex FFT of length M_ */
+void Fft(float * const re, float * const im) {
+  for (std::size_t i = 1, j = 0; i < M_; i++) {
+    std::size_t bit = M_ >> 1;
+    for (; j & bit; bit >>= 1) {j ^= bit;}
+    j ^= bit;
+    if (i < j) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+  for (std::size_t len = 2; len <= M_; len <<= 1) {
+    std::size_t half = len / 2;
+    std::size_t stride = N_ / len;
+    for (std::size_t i = 0; i < M_; i += len) {
+      for (std::size_t j = 0; j < half; j++) {
+        float wr = cos_[j * stride];
+        float wi = -sin_[j * stride];
+        std::size_t a = i + j, b = i + j + half;
+        float vr = re[b] * wr - im[b] * wi;
+        float vi = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - vr;
+        im[b] = im[a] - vi;
+        re[a] += vr;
+        im[a] += vi;
+      }
+    }
+  }
+}
+/* Spectrum of one axis of the window ending at processed_end_ */
+void Spectrum(const std::size_t axis) {
+  const float * const x = ring_[axis];
+  uint32_t start = processed_end_ - N_;
+  float mean = 0;
+  for (std::size_t n = 0; n < N_; n++) {
+    mean += x[(start + n) % RING_LEN_];
+  }
+  mean /= N_;
+  /* Even and odd samples packed as complex */
+  float var = 0;
+  for (std::size_t m = 0; m < M_; m++) {
+    float a = x[(start + 2 * m) % RING_LEN_] - mean;
+    float b = x[(start + 2 * m + 1) % RING_LEN_] - mean;
+    var += a * a + b * b;
+    re_[m] = hann_[2 * m] * a;
+    im_[m] = hann_[2 * m + 1] * b;
+  }
+  spectra_.rms[axis] = std::sqrt(var / N_);
+  Fft(re_, im_);
+  /* Split into the spectrum of the real sequence */
+  power_[0] = (re_[0] + im_[0]) * (re_[0] + im_[0]);
+  for (std::size_t k = 1; k < M_; k++) {
+    float zr = re_[k], zi = im_[k];
+    float cr = re_[M_ - k], ci = -im_[M_ - k];
+    float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+    float odr = 0.5f * (zi - ci), odi = -0.5f * (zr - cr);
+    float xr = er + cos_[k] * odr + sin_[k] * odi;
+    float xi = ei + cos_[k] * odi - sin_[k] * odr;
+    power_[k] = xr * xr + xi * xi;
+  }
+  /* Dominant frequency, interpolated between bins */
+  std::size_t peak = 1;
+  for (std::size_t k = 2; k < M_; k++) {
+    if (power_[k] > power_[peak]) {peak = k;}
+  }
+  float a = std::sqrt(power_[peak - 1]);
+  float b = std::sqrt(power_[peak]);
+  float c = (peak + 1 < M_) ? std::sqrt(power_[peak + 1]) : 0;
+  float den = a - 2 * b + c;
+  float delta = (den < 0) ? 0.5f * (a - c) / den : 0;
+  spectra_.peak_hz[axis] = (peak + delta) * SAMPLE_RATE_HZ_ / N_;
+  spectra_.peak_amp[axis] = b / (HANN_GAIN_ * M_);
+  /* Band RMS, the one sided power corrected for the window */
+  for (std::size_t i = 0; i < NUM_VIBE_BANDS; i++) {
+    float sum = 0;
+    for (std::size_t k = i * BINS_PER_BAND_; k < (i + 1) * BINS_PER_BAND_;
+         k++) {
+      sum += power_[k];
+    }
+    spectra_.band_rms[axis][i] = std::sqrt(2 * sum /
+                                           (N_ * N_ * HANN_POWER_GAIN_));
+  }
+}
+}  // namespace
+
+void VibrationInit() {
+  spectra_.nyquist_hz = SAMPLE_RATE_HZ_ / 2;
+  for (std::size_t n = 0; n < N_; n++) {
+    hann_[n] = 0.5f - 0.5f * std::cos(2 * PI_ * n / N_);
+  }
+  for (std::size_t k = 0; k < M_; k++) {
+    cos_[k] = std::cos(2 * PI_ * k / N_);
+    sin_[k] = std::sin(2 * PI_ * k / N_);
+  }
+}
+void VibrationSample(const bfs::ImuData &imu) {
+  if (!imu.new_imu_data) {return;}
+  std::size_t idx = num_samples_ % RING_LEN_;
+  for (std::size_t i = 0; i < 3; i++) {
+    ring_[i][idx] = imu.accel_mps2[i];
+    ring_[3 + i][idx] = imu.gyro_radps[i];
+  }
+  num_samples_++;
+  if ((num_samples_ >= N_) && (num_samples_ % HOP_ == 0)) {
+    window_end_.store(num_samples_, std::memory_order_release);
+  }
+}
+void VibrationRun() {
+  uint32_t end = window_end_.load(std::memory_order_acquire);
+  if (axis_ == NUM_VIBE_AXES) {
+    if (end == processed_end_) {return;}
+    processed_end_ = end;
+    axis_ = 0;
+  }
+  /* Two hops later the frame is overwriting the window, start over */
+  if (end - processed_end_ >= 2 * HOP_) {
+    processed_end_ = end;
+    axis_ = 0;
+  }
+  Spectrum(axis_);
+  if (++axis_ == NUM_VIBE_AXES) {
+    *spectra_buf_.back() = spectra_;
+    spectra_buf_.Publish();
+  }
+}
+void VibrationRead(VibrationData * const data) {
+  if (!data) {return;}
+  data->new_data = spectra_buf_.Read(data);
+}
@@ -24,30 +24,104 @@
 */
 
 #include "flight/vms.h"
+#include <algorithm>
+#include <array>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+#include "flight/hal.h"
+#include "flight/msg.h"
+#include "flight/vms_telem.h"
 #ifdef __AUTOCODE__
   #include "./autocode.h"
-#else
-  #include "control/control.h"
-  #include "excitation/excitation.h"
+#elif defined(__NATIVE_CONTROL__)
+  #include "flight/config.h"
+  #include "flight/control.h"
 #endif
 
 namespace {
 #ifdef __AUTOCODE__
 /* Autocode instance */
 bfs::Autocode autocode;
+static constexpr int8_t NUM_SUBRATES_ = VmsNumSubrates<bfs::Autocode>();
+#ifndef rtmStepTask
+static_assert(NUM_SUBRATES_ == 0,
+              "Multitasking autocode must define rtmStepTask");
 #endif
+#endif
+/* Rate groups released by the frame and waiting on the main loop */
+std::array<volatile bool, MAX_VMS_SUBRATES + 1> released_ = {};
+volatile int32_t overruns_ = 0;
+/* Telemetry view */
+VmsTelemData telem_view_ = {};
+/*
+* Execution time of the VMS step. The frame profile already logs the VMS
+* stage; this keeps the peak so an overrun of the budget is reported even
+* if it happens between datalog reviews.
+*/
+int32_t time_us_ = 0;
+volatile int32_t peak_us_ = 0;
+bool budget_warned_ = false;
 }  // namespace
 
 void VmsInit() {
 #ifdef __AUTOCODE__
   autocode.initialize();
+#elif defined(__NATIVE_CONTROL__)
+  ControlInit(config.control);
 #endif
 }
 void VmsRun(const SysData &sys, const SensorData &sensor,
             const NavData &nav, const TelemData &telem,
             VmsData *vms) {
   if (!vms) {return;}
+  int64_t t0_us = HalMicros();
 #ifdef __AUTOCODE__
-  autocode.Run(sys, sensor, nav, telem, vms);
+  /*
+  * Rate groups due this frame are released before the base rate step,
+  * which advances the task counters of the autocode
+  */
+#ifdef rtmStepTask
+  for (int8_t tid = 1; tid <= NUM_SUBRATES_; tid++) {
+    if (rtmStepTask(autocode.getRTM(), tid)) {
+      if (released_[tid]) {overruns_ = overruns_ + 1;}
+      released_[tid] = true;
+    }
+  }
 #endif
+  VmsAutocodeRun(&autocode, sys, sensor, nav, telem, &telem_view_, vms);
+#elif defined(__NATIVE_CONTROL__)
+  VmsTelemUpdate(telem, &telem_view_);
+  ControlRun(sys, sensor, nav, telem_view_, vms);
+#endif
+  time_us_ = static_cast<int32_t>(HalMicros() - t0_us);
+  peak_us_ = std::max(time_us_, static_cast<int32_t>(peak_us_));
+}
+void VmsBackground() {
+#ifdef __AUTOCODE__
+  for (int8_t tid = 1; tid <= NUM_SUBRATES_; tid++) {
+    if (released_[tid]) {
+      /*
+      * Cleared before the step, so a release by a frame that preempts it
+      * runs the group again rather than being lost
+      */
+      released_[tid] = false;
+      VmsAutocodeStep(&autocode, tid);
+      break;
+    }
+  }
+#endif
+}
+void VmsBudgetCheck() {
+  if (budget_warned_ || (peak_us_ <= VMS_BUDGET_US)) {return;}
+  budget_warned_ = true;
+  MsgWarning("VMS execution time exceeded its frame budget.\n");
+}
+int32_t VmsTimeUs() {
+  return time_us_;
+}
+int32_t VmsPeakTimeUs() {
+  return peak_us_;
+}
+int32_t VmsOverruns() {
+  return overruns_;
 }
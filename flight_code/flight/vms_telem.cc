@@ -0,0 +1,103 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/vms_telem.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "flight/global_defs.h"
+
+/*
+* The autocode interface copies its inputs into its own bus structs each
+* frame. The full TelemData carries every flight plan, fence, and rally
+* item, tens of kB, while the VMS flies one leg at a time, so the view
+* carries just that leg and is only rebuilt when it changes.
+*/
+
+namespace {
+/* WGS84 */
+static constexpr double WGS84_A_M_ = 6378137.0;
+static constexpr double WGS84_E2_ = 6.69437999014e-3;
+static constexpr double DEG2RAD_ = std::numbers::pi / 180.0;
+/* Waypoint lat and lon are scaled by 1e7, 360 deg of longitude */
+static constexpr int64_t LON_TURN_ = 3600000000;
+}  // namespace
+
+void VmsTelemUpdate(const TelemData &telem, VmsTelemData * const view) {
+  if (!view) {return;}
+  bool rebuild = telem.waypoints_updated ||
+                 (telem.current_waypoint != view->current_waypoint) ||
+                 (telem.num_waypoints != view->num_waypoints);
+  view->waypoints_updated = telem.waypoints_updated;
+  view->fence_updated = telem.fence_updated;
+  view->rally_points_updated = telem.rally_points_updated;
+  view->current_waypoint = telem.current_waypoint;
+  view->num_waypoints = telem.num_waypoints;
+  view->num_fence_items = telem.num_fence_items;
+  view->num_rally_points = telem.num_rally_points;
+  view->param = telem.param;
+  if (!rebuild) {return;}
+  int16_t last = std::min<int16_t>(telem.num_waypoints,
+                                   telem.flight_plan.size()) - 1;
+  if (last < 0) {
+    view->waypoint = {};
+    view->next_waypoint = {};
+    view->leg_ned_m = {0, 0, 0};
+    view->leg_dist_m = 0;
+    view->leg_course_rad = 0;
+    return;
+  }
+  int16_t cur = std::clamp<int16_t>(telem.current_waypoint, 0, last);
+  int16_t next = std::min<int16_t>(cur + 1, last);
+  view->waypoint = telem.flight_plan[cur];
+  view->next_waypoint = telem.flight_plan[next];
+  /* Flat earth leg at the active waypoint */
+  double lat = static_cast<double>(view->waypoint.x) * 1e-7 * DEG2RAD_;
+  /*
+  * Differences in 64 bits, the 32 bit difference overflows, with the
+  * longitude wrapped to +/-180 deg across the antimeridian
+  */
+  int64_t dlat_e7 = static_cast<int64_t>(view->next_waypoint.x) -
+                    static_cast<int64_t>(view->waypoint.x);
+  int64_t dlon_e7 = static_cast<int64_t>(view->next_waypoint.y) -
+                    static_cast<int64_t>(view->waypoint.y);
+  dlon_e7 %= LON_TURN_;
+  if (dlon_e7 > LON_TURN_ / 2) {
+    dlon_e7 -= LON_TURN_;
+  } else if (dlon_e7 < -LON_TURN_ / 2) {
+    dlon_e7 += LON_TURN_;
+  }
+  double dlat = static_cast<double>(dlat_e7) * 1e-7 * DEG2RAD_;
+  double dlon = static_cast<double>(dlon_e7) * 1e-7 * DEG2RAD_;
+  double s = std::sin(lat);
+  double den = 1.0 - WGS84_E2_ * s * s;
+  double rn = WGS84_A_M_ / std::sqrt(den);
+  double rm = WGS84_A_M_ * (1.0 - WGS84_E2_) / (den * std::sqrt(den));
+  view->leg_ned_m[0] = static_cast<float>(dlat * rm);
+  view->leg_ned_m[1] = static_cast<float>(dlon * rn * std::cos(lat));
+  view->leg_ned_m[2] = view->waypoint.z - view->next_waypoint.z;
+  view->leg_dist_m = std::hypot(view->leg_ned_m[0], view->leg_ned_m[1]);
+  view->leg_course_rad = std::atan2(view->leg_ned_m[1], view->leg_ned_m[0]);
+}
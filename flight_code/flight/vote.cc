@@ -0,0 +1,241 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/vote.h"
+#include <cmath>
+#include <algorithm>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+#include "flight/msg.h"
+
+/*
+* Each redundant sensor has a primary source (0) and a secondary source (1):
+* the FMU IMU and the redundant IMU, and the air data sensor and FMU static
+* pressure transducers. Every frame each source is health scored on its own
+* checks, such as a failed read, unhealthy or stale data, values out of
+* range, or a stuck output. A failed check costs more score than a passed
+* check earns back, so a failing source drops out within a few frames and
+* must pass for a while before it is usable again.
+*
+* The sources are also compared against each other. Their difference is
+* tracked slowly, absorbing installation and bias offsets, and a residual
+* beyond tolerance for several frames flags a miscompare. Two sources
+* cannot isolate which of them failed, so a miscompare is reported but
+* selection is left to the health scores.
+*
+* The selected source switches when its score drops below usable and the
+* other source is usable. The tracked difference is added to the new source
+* and decays to zero, so nav sees no step at the switch. The cost is a
+* fixed number of operations per channel, regardless of the data.
+*/
+
+namespace {
+/* Health scores */
+constexpr int16_t HEALTH_MAX_ = 100;
+constexpr int16_t HEALTH_USABLE_ = 50;
+constexpr int16_t HEALTH_PASS_ = 1;
+constexpr int16_t HEALTH_FAIL_ = 20;
+/* Frames beyond tolerance to flag a miscompare */
+constexpr int16_t MISCOMPARE_FRAMES_ = 5;
+/* Frames of identical output to consider a source stuck */
+constexpr int16_t STUCK_FRAMES_ = 10;
+/* Time constants of the tracked difference and of the switch transition */
+constexpr float DIFF_TAU_S_ = 10;
+constexpr float TRANSITION_TAU_S_ = 1;
+/* IMU tolerances: accel, gyro, and mag */
+constexpr float ACCEL_TOL_MPS2_ = 2;
+constexpr float GYRO_TOL_RADPS_ = 0.17f;
+constexpr float MAG_TOL_UT_ = 15;
+/* Static pressure tolerance and plausible range */
+constexpr float STATIC_PRES_TOL_PA_ = 250;
+constexpr float MIN_STATIC_PRES_PA_ = 15000;
+constexpr float MAX_STATIC_PRES_PA_ = 115000;
+/* Channels voted */
+constexpr std::size_t NUM_IMU_CH_ = 9;
+constexpr std::size_t NUM_STATIC_PRES_CH_ = 1;
+/* Voting state of a redundant sensor */
+template<std::size_t N>
+struct Voter {
+  VoteData vote;
+  bool diff_init;
+  int16_t miscompare_cnt;
+  /* Tracked secondary minus primary difference */
+  std::array<float, N> diff;
+  /* Offset added to the selected source after a switch */
+  std::array<float, N> transition;
+  std::array<float, N> tol;
+};
+Voter<NUM_IMU_CH_> imu_voter_;
+Voter<NUM_STATIC_PRES_CH_> static_pres_voter_;
+/* Stuck output detection */
+std::array<std::array<float, 3>, NUM_REDUNDANT_SRC> prev_gyro_radps_;
+std::array<int16_t, NUM_REDUNDANT_SRC> gyro_stuck_cnt_;
+/* Filter gains, set from the frame period */
+float diff_gain_;
+float transition_decay_;
+/* Selected source data */
+std::array<float, NUM_IMU_CH_> imu_ch_;
+std::array<float, NUM_STATIC_PRES_CH_> static_pres_ch_;
+
+/* Updates a health score from whether the source passed its checks */
+void Score(const bool pass, int16_t * const health) {
+  if (pass) {
+    *health = std::min<int16_t>(*health + HEALTH_PASS_, HEALTH_MAX_);
+  } else {
+    *health = std::max<int16_t>(*health - HEALTH_FAIL_, 0);
+  }
+}
+/* Whether the gyro output has repeated exactly for too many frames */
+bool Stuck(const std::array<float, NUM_IMU_CH_> &ch,
+           std::array<float, 3> * const prev, int16_t * const cnt) {
+  bool same = true;
+  for (std::size_t i = 0; i < 3; i++) {
+    same = same && (ch[i + 3] == (*prev)[i]);
+    (*prev)[i] = ch[i + 3];
+  }
+  *cnt = same ? std::min<int16_t>(*cnt + 1, STUCK_FRAMES_) : 0;
+  return *cnt >= STUCK_FRAMES_;
+}
+template<std::size_t N>
+bool Finite(const std::array<float, N> &val) {
+  bool finite = true;
+  for (std::size_t i = 0; i < N; i++) {
+    finite = finite && std::isfinite(val[i]);
+  }
+  return finite;
+}
+/* Votes the sources, given whether each passed, and outputs the selected */
+template<std::size_t N>
+void Vote(const std::array<std::array<float, N>, NUM_REDUNDANT_SRC> &src,
+          const std::array<bool, NUM_REDUNDANT_SRC> &pass,
+          Voter<N> * const voter, std::array<float, N> * const out) {
+  VoteData * const vote = &voter->vote;
+  /* Health scores */
+  for (std::size_t k = 0; k < NUM_REDUNDANT_SRC; k++) {
+    Score(pass[k], &vote->health[k]);
+  }
+  /* Consistency between the sources */
+  if (pass[0] && pass[1]) {
+    bool consistent = true;
+    for (std::size_t i = 0; i < N; i++) {
+      float diff = src[1][i] - src[0][i];
+      if (!voter->diff_init) {voter->diff[i] = diff;}
+      consistent = consistent &&
+                   (std::fabs(diff - voter->diff[i]) <= voter->tol[i]);
+    }
+    voter->diff_init = true;
+    /* Only consistent data updates the tracked difference */
+    if (consistent) {
+      for (std::size_t i = 0; i < N; i++) {
+        voter->diff[i] += diff_gain_ * (src[1][i] - src[0][i] - voter->diff[i]);
+      }
+      voter->miscompare_cnt = 0;
+    } else {
+      voter->miscompare_cnt = std::min<int16_t>(voter->miscompare_cnt + 1,
+                                                MISCOMPARE_FRAMES_);
+    }
+  } else {
+    voter->miscompare_cnt = 0;
+  }
+  vote->miscompare = (voter->miscompare_cnt >= MISCOMPARE_FRAMES_);
+  /* Switch sources, starting the new source where the old one was */
+  int8_t other = (vote->source == 0) ? 1 : 0;
+  if ((vote->health[vote->source] < HEALTH_USABLE_) &&
+      (vote->health[other] >= HEALTH_USABLE_)) {
+    if (voter->diff_init) {
+      float sign = (other == 1) ? -1.0f : 1.0f;
+      for (std::size_t i = 0; i < N; i++) {
+        voter->transition[i] += sign * voter->diff[i];
+      }
+    }
+    vote->source = other;
+    vote->switch_cnt++;
+  }
+  /* Selected source, with the switch transition decaying to zero */
+  for (std::size_t i = 0; i < N; i++) {
+    (*out)[i] = src[vote->source][i] + voter->transition[i];
+    voter->transition[i] *= transition_decay_;
+  }
+}
+}  // namespace
+
+void VoteInit(const SensorConfig &cfg) {
+  float dt_s = static_cast<float>(FRAME_PERIOD_MS) / 1000.0f;
+  diff_gain_ = 1.0f - std::exp(-dt_s / DIFF_TAU_S_);
+  transition_decay_ = std::exp(-dt_s / TRANSITION_TAU_S_);
+  for (std::size_t i = 0; i < 3; i++) {
+    imu_voter_.tol[i] = ACCEL_TOL_MPS2_;
+    imu_voter_.tol[i + 3] = GYRO_TOL_RADPS_;
+    imu_voter_.tol[i + 6] = MAG_TOL_UT_;
+  }
+  static_pres_voter_.tol[0] = STATIC_PRES_TOL_PA_;
+  /* Sources start usable, a missing source drops out in a few frames */
+  imu_voter_.vote.health.fill(HEALTH_MAX_);
+  static_pres_voter_.vote.health.fill(HEALTH_MAX_);
+  if (cfg.redundant_imu_installed) {
+    MsgInfo("Voting redundant IMUs.\n");
+  }
+}
+void VoteRun(SensorData * const data) {
+  if (!data) {return;}
+  RedundancyData &rdnt = data->redundancy;
+  /* IMU */
+  std::array<std::array<float, NUM_IMU_CH_>, NUM_REDUNDANT_SRC> imu;
+  std::array<bool, NUM_REDUNDANT_SRC> pass;
+  for (std::size_t k = 0; k < NUM_REDUNDANT_SRC; k++) {
+    const bfs::ImuData &src = rdnt.imu[k];
+    for (std::size_t i = 0; i < 3; i++) {
+      imu[k][i] = src.accel_mps2[i];
+      imu[k][i + 3] = src.gyro_radps[i];
+      imu[k][i + 6] = src.mag_ut[i];
+    }
+    bool stuck = Stuck(imu[k], &prev_gyro_radps_[k], &gyro_stuck_cnt_[k]);
+    pass[k] = src.new_imu_data && src.imu_healthy && Finite(imu[k]) && !stuck;
+  }
+  Vote(imu, pass, &imu_voter_, &imu_ch_);
+  rdnt.imu_vote = imu_voter_.vote;
+  data->imu = rdnt.imu[rdnt.imu_vote.source];
+  data->imu_sample = rdnt.imu_sample[rdnt.imu_vote.source];
+  for (std::size_t i = 0; i < 3; i++) {
+    data->imu.accel_mps2[i] = imu_ch_[i];
+    data->imu.gyro_radps[i] = imu_ch_[i + 3];
+    data->imu.mag_ut[i] = imu_ch_[i + 6];
+  }
+  /* Static pressure */
+  std::array<std::array<float, NUM_STATIC_PRES_CH_>, NUM_REDUNDANT_SRC> pres;
+  for (std::size_t k = 0; k < NUM_REDUNDANT_SRC; k++) {
+    const bfs::PresData &src = rdnt.static_pres[k];
+    pres[k][0] = src.pres_pa;
+    pass[k] = rdnt.static_pres_sample[k].fresh && src.healthy &&
+              Finite(pres[k]) && (src.pres_pa >= MIN_STATIC_PRES_PA_) &&
+              (src.pres_pa <= MAX_STATIC_PRES_PA_);
+  }
+  Vote(pres, pass, &static_pres_voter_, &static_pres_ch_);
+  rdnt.static_pres_vote = static_pres_voter_.vote;
+  int8_t src = rdnt.static_pres_vote.source;
+  data->static_pres = rdnt.static_pres[src];
+  data->static_pres.pres_pa = static_pres_ch_[0];
+  data->static_pres_sample = rdnt.static_pres_sample[src];
+}
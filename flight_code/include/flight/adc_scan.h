@@ -0,0 +1,65 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_ADC_SCAN_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_ADC_SCAN_H_
+
+#include "flight/global_defs.h"
+
+/* Scan order, analog inputs followed by board specific channels */
+inline constexpr std::size_t ADC_AIN_CH = 0;
+#if defined(__FMU_R_V2__)
+inline constexpr std::size_t ADC_BATTERY_VOLTAGE_CH = NUM_AIN_PINS;
+inline constexpr std::size_t ADC_BATTERY_CURRENT_CH = NUM_AIN_PINS + 1;
+inline constexpr std::size_t NUM_ADC_CH = NUM_AIN_PINS + 2;
+#elif defined(__FMU_R_V2_BETA__)
+inline constexpr std::size_t NUM_ADC_CH = NUM_AIN_PINS;
+#else
+inline constexpr std::size_t ADC_INPUT_VOLTAGE_CH = NUM_AIN_PINS;
+inline constexpr std::size_t ADC_REGULATED_VOLTAGE_CH = NUM_AIN_PINS + 1;
+inline constexpr std::size_t ADC_SBUS_VOLTAGE_CH = NUM_AIN_PINS + 2;
+inline constexpr std::size_t ADC_PWM_VOLTAGE_CH = NUM_AIN_PINS + 3;
+inline constexpr std::size_t NUM_ADC_CH = NUM_AIN_PINS + 4;
+#endif
+/* Conversions averaged per published sample */
+inline constexpr int ADC_OVERSAMPLING = 16;
+
+/* Averaged conversions and statistics per channel */
+struct AdcScanData {
+  std::array<float, NUM_ADC_CH> cnt;
+  /* Standard deviation of the averaged conversions, counts */
+  std::array<float, NUM_ADC_CH> noise_cnt;
+  /* Conversion rate, Hz */
+  std::array<float, NUM_ADC_CH> rate_hz;
+};
+
+/* Initializes the ADC scan */
+void AdcScanInit();
+/* Performs the next conversion of the scan, called from the main loop */
+void AdcScanPoll();
+/* Copies the latest averaged conversions */
+void AdcScanRead(AdcScanData * const data);
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_ADC_SCAN_H_
@@ -0,0 +1,201 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_ALLOCATION_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_ALLOCATION_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+
+/*
+* Control allocation from NV virtual commands, such as thrust and roll,
+* pitch, and yaw, to NE effectors through a mixer matrix, with priority
+* based saturation handling. Virtual commands are allocated a priority
+* level at a time, highest first, each scaled back as far as needed to keep
+* every effector within its limits, so lower priority commands give way
+* first. An offset command, such as multirotor thrust, can be shifted to
+* make room for the commands ranked above it: a roll command at idle
+* raises the thrust rather than being clipped at the motor minimum, and at
+* full thrust lowers it. The scale and shift are solved in closed form, so
+* the cost is bounded by the sizes alone.
+*/
+
+/* Effector output channels: the PWM channels, then the SBUS channels */
+inline constexpr std::size_t NUM_EFFECTOR_CH = NUM_PWM_PINS + NUM_SBUS_CH;
+
+template <typename T, std::size_t NV, std::size_t NE>
+class EffectorAllocator {
+ public:
+  struct Config {
+    /* Effector command per unit of each virtual command */
+    std::array<std::array<T, NV>, NE> mix;
+    /* Effector command with no virtual commands, and the limits */
+    std::array<T, NE> trim;
+    std::array<T, NE> min;
+    std::array<T, NE> max;
+    /* Priority level of each virtual command, 0 highest to NV - 1 */
+    std::array<int8_t, NV> priority;
+    /* Virtual command shifted for those ranked above it, -1 for none */
+    int8_t offset;
+    /* Output channel of each effector, and the counts at zero and per unit */
+    std::array<int8_t, NE> ch;
+    std::array<T, NE> cnt_zero;
+    std::array<T, NE> cnt_scale;
+  };
+  constexpr explicit EffectorAllocator(const Config &cfg) : cfg_(cfg) {
+    for (std::size_t i = 0; i < NE; i++) {
+      cfg_.trim[i] = std::clamp(cfg_.trim[i], cfg_.min[i], cfg_.max[i]);
+      off_[i] = (cfg_.offset >= 0) ? cfg_.mix[i][cfg_.offset] : 0;
+      inv_off_[i] = (off_[i] != 0) ? 1 / off_[i] : 0;
+    }
+  }
+  /* Effector commands for the virtual commands */
+  std::array<T, NE> Run(const std::array<T, NV> &v) {
+    std::array<T, NE> u = cfg_.trim;
+    std::array<T, NE> delta;
+    T shift = 0;
+    bool shifting = (cfg_.offset >= 0);
+    for (int8_t level = 0; level < static_cast<int8_t>(NV); level++) {
+      /* Commands at this level, the offset less the shift so far */
+      bool any = false;
+      bool offset_level = false;
+      delta.fill(0);
+      for (std::size_t j = 0; j < NV; j++) {
+        if (cfg_.priority[j] != level) {continue;}
+        any = true;
+        T vj = v[j];
+        if (static_cast<int8_t>(j) == cfg_.offset) {
+          offset_level = true;
+          vj -= shift;
+        }
+        for (std::size_t i = 0; i < NE; i++) {delta[i] += cfg_.mix[i][j] * vj;}
+      }
+      if (!any) {continue;}
+      /* Shifting stops at the level of the offset command */
+      if (offset_level) {shifting = false;}
+      T s = MaxScale(u, delta, shifting);
+      T t = 0;
+      for (std::size_t i = 0; i < NE; i++) {u[i] += s * delta[i];}
+      if (shifting) {
+        t = Shift(u);
+        for (std::size_t i = 0; i < NE; i++) {u[i] += t * off_[i];}
+        shift += t;
+      }
+      for (std::size_t j = 0; j < NV; j++) {
+        if (cfg_.priority[j] != level) {continue;}
+        achieved_[j] = (static_cast<int8_t>(j) == cfg_.offset) ?
+                       shift + s * (v[j] - shift) : s * v[j];
+      }
+    }
+    for (std::size_t i = 0; i < NE; i++) {
+      u[i] = std::clamp(u[i], cfg_.min[i], cfg_.max[i]);
+    }
+    return u;
+  }
+  /* Virtual commands achieved by the last allocation */
+  const std::array<T, NV> & achieved() const {return achieved_;}
+  /* Writes the effector commands and counts to their output channels */
+  void Write(const std::array<T, NE> &u, PwmCmd * const pwm,
+             SbusCmd * const sbus) const {
+    for (std::size_t i = 0; i < NE; i++) {
+      std::size_t ch = static_cast<std::size_t>(cfg_.ch[i]);
+      int16_t cnt = static_cast<int16_t>(std::lround(cfg_.cnt_zero[i] +
+                                                     cfg_.cnt_scale[i] *
+                                                     u[i]));
+      if (ch < NUM_PWM_PINS) {
+        if (!pwm) {continue;}
+        pwm->cmd[ch] = u[i];
+        pwm->cnt[ch] = cnt;
+      } else if (ch < NUM_EFFECTOR_CH) {
+        if (!sbus) {continue;}
+        sbus->cmd[ch - NUM_PWM_PINS] = u[i];
+        sbus->cnt[ch - NUM_PWM_PINS] = cnt;
+      }
+    }
+  }
+
+ private:
+  /*
+  * Largest scale, 0 to 1, of delta that keeps the effectors within limits,
+  * with the offset shifted if allowed. An effector that doesn't move with
+  * the offset bounds the scale directly. One that does bounds the shift to
+  * an interval, p - s q to r - s q, and a shift exists while every lower
+  * bound is below every upper bound, which bounds the scale pairwise.
+  */
+  T MaxScale(const std::array<T, NE> &u, const std::array<T, NE> &delta,
+             const bool shifting) const {
+    T s = 1;
+    std::array<T, NE> p, q, r;
+    std::array<bool, NE> moves;
+    for (std::size_t i = 0; i < NE; i++) {
+      moves[i] = shifting && (off_[i] != 0);
+      if (moves[i]) {
+        T a = (cfg_.min[i] - u[i]) * inv_off_[i];
+        T b = (cfg_.max[i] - u[i]) * inv_off_[i];
+        p[i] = std::min(a, b);
+        r[i] = std::max(a, b);
+        q[i] = delta[i] * inv_off_[i];
+      } else if (delta[i] > 0) {
+        s = std::min(s, (cfg_.max[i] - u[i]) / delta[i]);
+      } else if (delta[i] < 0) {
+        s = std::min(s, (cfg_.min[i] - u[i]) / delta[i]);
+      }
+    }
+    for (std::size_t i = 0; i < NE; i++) {
+      if (!moves[i]) {continue;}
+      for (std::size_t k = 0; k < NE; k++) {
+        if (!moves[k]) {continue;}
+        T dq = q[k] - q[i];
+        if (dq > 0) {s = std::min(s, (r[k] - p[i]) / dq);}
+      }
+    }
+    return std::max(s, T(0));
+  }
+  /* Smallest shift of the offset that brings u within the limits */
+  T Shift(const std::array<T, NE> &u) const {
+    T lo = -std::numeric_limits<T>::infinity();
+    T hi = std::numeric_limits<T>::infinity();
+    for (std::size_t i = 0; i < NE; i++) {
+      if (off_[i] == 0) {continue;}
+      T a = (cfg_.min[i] - u[i]) * inv_off_[i];
+      T b = (cfg_.max[i] - u[i]) * inv_off_[i];
+      lo = std::max(lo, std::min(a, b));
+      hi = std::min(hi, std::max(a, b));
+    }
+    /* At the edge of the scale rounding can cross the bounds over */
+    return (lo <= hi) ? std::clamp(T(0), lo, hi) : (lo + hi) / 2;
+  }
+  Config cfg_;
+  std::array<T, NE> off_ = {}, inv_off_ = {};
+  std::array<T, NV> achieved_ = {};
+};
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_ALLOCATION_H_
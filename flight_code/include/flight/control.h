@@ -0,0 +1,41 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
+
+#include "flight/global_defs.h"
+
+/*
+* Native C++ control law, run as the VMS when built with NATIVE_CONTROL and
+* no autocode. It is passed the VMS telemetry view, as autocode generated
+* with that bus is. Halts if the config channels are out of range.
+*/
+void ControlInit(const ControlConfig &cfg);
+void ControlRun(const SysData &sys, const SensorData &sensor,
+                const NavData &nav, const VmsTelemData &telem,
+                VmsData *vms);
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
@@ -0,0 +1,130 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_BLOCKS_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_BLOCKS_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+
+/*
+* Building blocks for native C++ control laws. Sizes are template
+* parameters and configs are literal types, so a control law is composed
+* at compile time: constexpr configs live in flash, the loops over inputs
+* and outputs have fixed trip counts the compiler unrolls, and there is no
+* heap or virtual dispatch. Gain schedules are in gain_table.h and effector
+* allocation is in allocation.h.
+*/
+
+/*
+* PID with the error rate given, i.e. from a rate gyro, rather than
+* differentiated. Gains can be scaled, such as from a gain schedule, and
+* the integrator is held while the output is saturated in the direction of
+* the error.
+*/
+template <typename T>
+class CtrlPid {
+ public:
+  struct Config {
+    T kp;
+    T ki;
+    T kd;
+    T dt_s;
+    T min;
+    T max;
+  };
+  constexpr CtrlPid() = default;
+  constexpr explicit CtrlPid(const Config &cfg) : cfg_(cfg) {}
+  T Run(const T err, const T err_rate, const T scale = 1) {
+    T p = scale * cfg_.kp * err;
+    T d = scale * cfg_.kd * err_rate;
+    T i = iterm_ + scale * cfg_.ki * err * cfg_.dt_s;
+    T out = p + i + d;
+    if (((out > cfg_.max) && (err > 0)) || ((out < cfg_.min) && (err < 0))) {
+      out = p + iterm_ + d;
+    } else {
+      iterm_ = i;
+    }
+    return std::clamp(out, cfg_.min, cfg_.max);
+  }
+  void Reset() {iterm_ = 0;}
+
+ private:
+  Config cfg_ = {};
+  T iterm_ = 0;
+};
+
+/*
+* IIR filter of order N, direct form II transposed. Coefficients are
+* normalized so that a[0] is 1.
+*/
+template <typename T, std::size_t N>
+class CtrlFilter {
+ public:
+  constexpr CtrlFilter() = default;
+  constexpr CtrlFilter(const std::array<T, N + 1> &b,
+                       const std::array<T, N + 1> &a) {
+    for (std::size_t i = 0; i <= N; i++) {
+      b_[i] = b[i] / a[0];
+      a_[i] = a[i] / a[0];
+    }
+  }
+  T Run(const T x) {
+    T y = b_[0] * x + z_[0];
+    for (std::size_t i = 1; i < N; i++) {
+      z_[i - 1] = b_[i] * x - a_[i] * y + z_[i];
+    }
+    z_[N - 1] = b_[N] * x - a_[N] * y;
+    return y;
+  }
+  /* Sets the states to the steady state of a constant input */
+  void Reset(const T x = 0) {
+    T b_sum = 0, a_sum = 0;
+    for (std::size_t i = 0; i <= N; i++) {
+      b_sum += b_[i];
+      a_sum += a_[i];
+    }
+    T y = (a_sum != 0) ? x * b_sum / a_sum : 0;
+    for (std::size_t i = N; i > 0; i--) {
+      z_[i - 1] = b_[i] * x - a_[i] * y + ((i < N) ? z_[i] : 0);
+    }
+  }
+
+ private:
+  static_assert(N > 0, "Filter order must be at least 1");
+  std::array<T, N + 1> b_ = {1}, a_ = {1};
+  std::array<T, N> z_ = {};
+};
+/* First order low pass filter, bilinear transform with prewarping */
+template <typename T>
+CtrlFilter<T, 1> CtrlLowPass1(const T cutoff_hz, const T dt_s) {
+  T wc = std::tan(std::numbers::pi_v<T> * cutoff_hz * dt_s);
+  return CtrlFilter<T, 1>({wc, wc}, {1 + wc, wc - 1});
+}
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_BLOCKS_H_
@@ -0,0 +1,71 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_DOUBLE_BUFFER_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_DOUBLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+/*
+* Single producer, single consumer double buffer for handing data from
+* background acquisition (the main loop or a peripheral interrupt) to the
+* frame ISR. The producer fills back() and calls Publish(); the consumer
+* copies the latest published value with Read(). A sequence count detects
+* the producer publishing during the copy, in which case the copy is
+* retried, so the consumer always gets a consistent value. When the
+* producer runs at a lower priority than the consumer, the copy can never
+* be interrupted and Read() completes in a single pass.
+*/
+template<typename T>
+class DoubleBuffer {
+ public:
+  /* Buffer for the producer to fill, valid until the next Publish */
+  T * back() {return &buf_[(seq_.load(std::memory_order_relaxed) + 1) & 1];}
+  /* Makes the back buffer the latest value */
+  void Publish() {seq_.fetch_add(1, std::memory_order_release);}
+  /* Copies the latest value, returns true if it is new since the last Read */
+  bool Read(T * const val) {
+    if (!val) {return false;}
+    uint32_t seq;
+    do {
+      seq = seq_.load(std::memory_order_acquire);
+      *val = buf_[seq & 1];
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while (seq != seq_.load(std::memory_order_relaxed));
+    bool new_data = (seq != read_seq_);
+    read_seq_ = seq;
+    return new_data;
+  }
+  /* Number of values published */
+  uint32_t count() const {return seq_.load(std::memory_order_relaxed);}
+
+ private:
+  std::atomic<uint32_t> seq_{0};
+  uint32_t read_seq_ = 0;
+  T buf_[2] = {};
+};
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_DOUBLE_BUFFER_H_
@@ -0,0 +1,199 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_EXCITE_TABLE_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_EXCITE_TABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+
+/*
+* System identification excitations with a per frame cost that doesn't
+* depend on the number of harmonics. A multisine is periodic in a whole
+* number of frames, so one period is built into a table up front and each
+* frame is a table read. A chirp isn't periodic, so its sine is advanced by
+* rotating a phasor, a few multiplies per frame.
+*/
+
+/*
+* Orthogonal multisine on NCH channels with a period of N frames. The
+* harmonics of the fundamental, 1 / (N * frame period), from the first
+* harmonic given on, are dealt to the channels in turn, so each channel
+* has its own frequencies and the channels are uncorrelated over a period.
+* Phases follow Schroeder to keep the peak factor low, and each channel is
+* scaled to its peak amplitude. The table is built with the sine of a
+* multiple of the fundamental read from a one period sine table by
+* integer index, so it is exact to float precision and needs only N + NCH
+* * NH sine evaluations.
+*/
+template <std::size_t NCH, std::size_t N>
+class MultisineTable {
+ public:
+  /*
+  * Builds the table with NH harmonics per channel; returns false if the
+  * highest harmonic would reach the Nyquist frequency
+  */
+  bool Build(const std::array<float, NCH> &amp, const std::size_t first,
+             const std::size_t nh) {
+    if ((first < 1) || (nh < 1) || (first + nh * NCH > N / 2)) {return false;}
+    for (std::size_t j = 0; j < N; j++) {
+      sine_[j] = std::sin(2 * PI_ * static_cast<float>(j) / N);
+    }
+    for (auto &row : table_) {row.fill(0);}
+    std::array<std::size_t, NCH> count = {};
+    for (std::size_t h = 0; h < nh * NCH; h++) {
+      std::size_t ch = h % NCH;
+      std::size_t k = first + h;
+      float i = static_cast<float>(++count[ch]);
+      float phase = -PI_ * i * i / static_cast<float>(nh);
+      float c = std::cos(phase), s = std::sin(phase);
+      for (std::size_t n = 0; n < N; n++) {
+        std::size_t idx = (k * n) % N;
+        table_[n][ch] += c * sine_[idx] + s * sine_[(idx + N / 4) % N];
+      }
+    }
+    for (std::size_t ch = 0; ch < NCH; ch++) {
+      float peak = 0;
+      for (std::size_t n = 0; n < N; n++) {
+        peak = std::max(peak, std::abs(table_[n][ch]));
+      }
+      float scale = (peak > 0) ? amp[ch] / peak : 0;
+      for (std::size_t n = 0; n < N; n++) {table_[n][ch] *= scale;}
+    }
+    first_ = first;
+    built_ = true;
+    return true;
+  }
+  /* Starts the excitation for a number of periods */
+  void Start(const std::size_t periods) {
+    idx_ = 0;
+    remaining_ = built_ ? periods * N : 0;
+  }
+  void Stop() {remaining_ = 0;}
+  bool active() const {return remaining_ > 0;}
+  /* Excitation of the frame, zero when not active */
+  std::array<float, NCH> Run() {
+    if (remaining_ == 0) {return {};}
+    remaining_--;
+    const std::array<float, NCH> &out = table_[idx_];
+    idx_ = (idx_ + 1 < N) ? idx_ + 1 : 0;
+    return out;
+  }
+  /* Harmonic of the fundamental of the h-th frequency, dealt in turn */
+  std::size_t harmonic(const std::size_t h) const {return first_ + h;}
+  /* One period, for checking against a direct evaluation */
+  const std::array<std::array<float, NCH>, N> & table() const {
+    return table_;
+  }
+
+ private:
+  static_assert(N % 4 == 0, "Period must be a multiple of 4 frames");
+  static constexpr float PI_ = std::numbers::pi_v<float>;
+  std::array<float, N> sine_ = {};
+  std::array<std::array<float, NCH>, N> table_ = {};
+  std::size_t first_ = 0;
+  std::size_t idx_ = 0;
+  std::size_t remaining_ = 0;
+  bool built_ = false;
+};
+
+/*
+* Linear chirp from f0 to f1 over a duration. The phase of a linear chirp
+* advances by a step that grows by a constant each frame, so the sine and
+* the step are both carried as unit phasors and rotated. Rounding slowly
+* drifts the phase, so every RESYNC_ frames the phasors are set from the
+* exact phase, in double precision, which costs a sine and cosine pair
+* spread over those frames.
+*/
+class ChirpPhasor {
+ public:
+  void Start(const float amp, const float f0_hz, const float f1_hz,
+             const float duration_s, const float dt_s) {
+    amp_ = amp;
+    remaining_ = static_cast<int32_t>(std::lround(duration_s / dt_s));
+    double rate = (duration_s > 0) ?
+                  (static_cast<double>(f1_hz) - f0_hz) / duration_s : 0;
+    /* Cycles at frame n: a n + b n^2 */
+    a_ = static_cast<double>(f0_hz) * dt_s;
+    b_ = 0.5 * rate * dt_s * dt_s;
+    float dw = static_cast<float>(2 * PI_ * 2 * b_);
+    rot_re_ = std::cos(dw);
+    rot_im_ = std::sin(dw);
+    n_ = 0;
+  }
+  void Stop() {remaining_ = 0;}
+  bool active() const {return remaining_ > 0;}
+  /* Excitation of the frame, zero when not active */
+  float Run() {
+    if (remaining_ <= 0) {return 0;}
+    remaining_--;
+    if (n_ % RESYNC_ == 0) {
+      Resync();
+    } else {
+      Rotate(step_re_, step_im_, &re_, &im_);
+      Rotate(rot_re_, rot_im_, &step_re_, &step_im_);
+    }
+    n_++;
+    return amp_ * im_;
+  }
+
+ private:
+  static constexpr double PI_ = std::numbers::pi;
+  static constexpr int32_t RESYNC_ = 64;
+  /* Sets the phasor of frame n_ and the step to the next frame */
+  void Resync() {
+    double n = static_cast<double>(n_);
+    double cyc = a_ * n + b_ * n * n;
+    double step = a_ + b_ * (2 * n + 1);
+    double w = 2 * PI_ * (cyc - std::floor(cyc));
+    double dw = 2 * PI_ * (step - std::floor(step));
+    re_ = static_cast<float>(std::cos(w));
+    im_ = static_cast<float>(std::sin(w));
+    step_re_ = static_cast<float>(std::cos(dw));
+    step_im_ = static_cast<float>(std::sin(dw));
+  }
+  /* Multiplies by a phasor and pulls the result back to unit magnitude */
+  static void Rotate(const float c, const float s, float * const re,
+                     float * const im) {
+    float r = *re * c - *im * s;
+    float i = *re * s + *im * c;
+    float g = 0.5f * (3 - (r * r + i * i));
+    *re = r * g;
+    *im = i * g;
+  }
+  float amp_ = 0;
+  int32_t remaining_ = 0;
+  int32_t n_ = 0;
+  double a_ = 0, b_ = 0;
+  float re_ = 1, im_ = 0;
+  float step_re_ = 1, step_im_ = 0;
+  float rot_re_ = 1, rot_im_ = 0;
+};
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_EXCITE_TABLE_H_
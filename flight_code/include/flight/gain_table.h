@@ -0,0 +1,205 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_GAIN_TABLE_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_GAIN_TABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Gain tables for scheduling many gains at once, such as over indicated
+* airspeed and altitude. Each axis is either uniform, where the interval is
+* computed directly, or has arbitrary breakpoints, where the search starts
+* from the interval of the last lookup, so it is constant time while the
+* schedule variable moves slowly. The gains of a cell are stored together
+* and interpolated in one pass, which the compiler can vectorize.
+*/
+
+/* Interval of x in n increasing breakpoints, searched from interval i */
+template <typename T>
+inline std::size_t GainInterval(const T * const bp, const std::size_t n,
+                                const T x, std::size_t i) {
+  i = std::min(i, n - 2);
+  while ((i > 0) && (x < bp[i])) {i--;}
+  while ((i < n - 2) && (x >= bp[i + 1])) {i++;}
+  return i;
+}
+/* Linear or bilinear interpolation of m gains between cells */
+template <typename T>
+inline void GainInterp(const T * const v0, const T * const v1,
+                       const std::size_t m, const T f, T * const out) {
+  for (std::size_t k = 0; k < m; k++) {
+    out[k] = v0[k] + f * (v1[k] - v0[k]);
+  }
+}
+template <typename T>
+inline void GainInterp(const T * const v00, const T * const v01,
+                       const T * const v10, const T * const v11,
+                       const std::size_t m, const T fx, const T fy,
+                       T * const out) {
+  T w00 = (1 - fx) * (1 - fy), w01 = (1 - fx) * fy;
+  T w10 = fx * (1 - fy), w11 = fx * fy;
+  for (std::size_t k = 0; k < m; k++) {
+    out[k] = w00 * v00[k] + w01 * v01[k] + w10 * v10[k] + w11 * v11[k];
+  }
+}
+
+/*
+* True if all n parameters are finite and positive, such as gain scales
+* loaded from the ground station, where a zero, negative, or NaN entry
+* would disable or reverse a loop
+*/
+template <typename T>
+inline bool GainParamsPositive(const T * const param, const std::size_t n) {
+  if (!param) {return false;}
+  return std::all_of(param, param + n,
+                     [](const T v) {return std::isfinite(v) && (v > 0);});
+}
+
+/* Table axis of N increasing breakpoints, lookups are held at the ends */
+template <typename T, std::size_t N>
+class GainAxis {
+ public:
+  constexpr explicit GainAxis(const std::array<T, N> &bp) : bp_(bp) {
+    for (std::size_t i = 0; i + 1 < N; i++) {
+      inv_dx_[i] = 1 / (bp_[i + 1] - bp_[i]);
+    }
+  }
+  /* N breakpoints evenly spaced from min to max */
+  static constexpr GainAxis Uniform(const T min, const T max) {
+    std::array<T, N> bp = {};
+    for (std::size_t i = 0; i < N; i++) {
+      bp[i] = (N > 1) ? min + (max - min) * i / (N - 1) : min;
+    }
+    GainAxis axis(bp);
+    axis.uniform_ = true;
+    return axis;
+  }
+  /*
+  * Interval of x and its fraction along the interval. A NaN x holds the
+  * interval of the last lookup, at its lower breakpoint.
+  */
+  void Find(const T x, std::size_t * const i, T * const frac) {
+    if constexpr (N == 1) {
+      *i = 0;
+      *frac = 0;
+      return;
+    } else {
+      if (std::isnan(x)) {
+        *i = last_;
+        *frac = 0;
+        return;
+      }
+      if (uniform_) {
+        /* Clamped before the cast, written so a NaN position gives 0 */
+        T pos = (x - bp_[0]) * inv_dx_[0];
+        pos = (pos > 0) ? std::min(pos, T(N - 2)) : T(0);
+        last_ = static_cast<std::size_t>(pos);
+      } else {
+        last_ = GainInterval(bp_.data(), N, x, last_);
+      }
+      *i = last_;
+      *frac = std::clamp((x - bp_[last_]) * inv_dx_[last_], T(0), T(1));
+    }
+  }
+
+ private:
+  std::array<T, N> bp_;
+  std::array<T, (N > 1) ? N - 1 : 1> inv_dx_ = {};
+  bool uniform_ = false;
+  std::size_t last_ = 0;
+};
+
+/*
+* Table of M gains over an NX by NY grid, NY of 1 for a schedule over a
+* single variable. Values are indexed [x][y][gain].
+*/
+template <typename T, std::size_t NX, std::size_t NY, std::size_t M>
+class GainTable {
+ public:
+  using Values = std::array<std::array<std::array<T, M>, NY>, NX>;
+  constexpr GainTable(const GainAxis<T, NX> &x, const GainAxis<T, NY> &y,
+                      const Values &val) : x_(x), y_(y), val_(val) {}
+  std::array<T, M> Lookup(const T x, const T y = 0) {
+    std::size_t i, j;
+    T fx, fy;
+    x_.Find(x, &i, &fx);
+    y_.Find(y, &j, &fy);
+    std::array<T, M> out;
+    if constexpr ((NX == 1) && (NY == 1)) {
+      out = val_[0][0];
+    } else if constexpr (NY == 1) {
+      GainInterp(val_[i][0].data(), val_[i + 1][0].data(), M, fx,
+                 out.data());
+    } else if constexpr (NX == 1) {
+      GainInterp(val_[0][j].data(), val_[0][j + 1].data(), M, fy,
+                 out.data());
+    } else {
+      GainInterp(val_[i][j].data(), val_[i][j + 1].data(),
+                 val_[i + 1][j].data(), val_[i + 1][j + 1].data(), M, fx, fy,
+                 out.data());
+    }
+    return out;
+  }
+  /*
+  * Loads the values from n parameters, in the order they are indexed.
+  * Returns false, keeping the current values, if there are too few.
+  */
+  bool Load(const T * const param, const std::size_t n) {
+    if (!param || (n < size())) {return false;}
+    std::size_t k = 0;
+    for (auto &row : val_) {
+      for (auto &cell : row) {
+        for (T &v : cell) {v = param[k++];}
+      }
+    }
+    return true;
+  }
+  /* Number of values */
+  static constexpr std::size_t size() {return NX * NY * M;}
+
+ private:
+  GainAxis<T, NX> x_;
+  GainAxis<T, NY> y_;
+  Values val_;
+};
+
+/*
+* Lookup for autocode, i.e. called through coder.ceval, on tables sized at
+* run time: m gains over nx by ny breakpoints, ny of 1 for a single
+* variable, with values indexed [x][y][gain]. The intervals of the last
+* lookup are kept in idx, two entries, between calls.
+*/
+void GainTableLookup(const float * x_bp, const int32_t nx,
+                     const float * y_bp, const int32_t ny,
+                     const float * val, const int32_t m,
+                     const float x, const float y, int32_t * idx,
+                     float * gains);
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_GAIN_TABLE_H_
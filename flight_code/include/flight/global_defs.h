@@ -31,16 +31,12 @@
 #include "gnss/gnss.h"
 #include "pres/pres.h"
 #include "global_defs/global_defs.h"
-#include "mpu9250/mpu9250.h"
-#include "ublox/ublox.h"
 #include "ams5915/ams5915.h"
-#include "bme280/bme280.h"
-#include "sbus/sbus.h"
-#include "pwm/pwm.h"
 #include "units/units.h"
 
 /* Control sizes */
 inline constexpr std::size_t NUM_AUX_VAR = 24;
+inline constexpr std::size_t NUM_CONTROL_EFFECTORS = 5;
 /* Telem sizes */
 inline constexpr std::size_t NUM_TELEM_PARAMS = 24;
 #if defined(__FMU_R_V2__) || defined(__FMU_R_V2_BETA__)
@@ -60,6 +56,8 @@ struct SensorConfig {
   bfs::GnssConfig gnss;
   bfs::PresConfig static_pres;
   bfs::PresConfig diff_pres;
+  bool redundant_imu_installed;
+  bfs::ImuConfig redundant_imu;
 };
 /* Nav config */
 struct NavConfig {
@@ -75,15 +73,49 @@ struct TelemConfig {
   HardwareSerial *bus;
   int32_t baud;
 };
+/*
+* Native control law config, used only when built with NATIVE_CONTROL.
+* Inceptor channels are 0-based SBUS channels. Effectors are the motor,
+* left aileron, right aileron, elevator, and rudder, each given its output
+* channel, PWM 0 to 7 then SBUS, and its counts at zero and per unit command.
+*/
+struct ControlConfig {
+  int8_t throttle_ch;
+  int8_t roll_ch;
+  int8_t pitch_ch;
+  int8_t yaw_ch;
+  int8_t motor_arm_ch;
+  int8_t mode_ch;
+  int8_t excite_ch;
+  std::array<int8_t, NUM_CONTROL_EFFECTORS> effector_ch;
+  std::array<float, NUM_CONTROL_EFFECTORS> cnt_zero;
+  std::array<float, NUM_CONTROL_EFFECTORS> cnt_scale;
+};
 /* Aircraft config */
 struct AircraftConfig {
   SensorConfig sensor;
   NavConfig nav;
   TelemConfig telem;
+  ControlConfig control;
+};
+/* Frame stages timed by the frame profiler */
+enum FrameStage : int8_t {
+  FRAME_STAGE_SENSORS = 0,
+  FRAME_STAGE_VOTE,
+  FRAME_STAGE_NAV,
+  FRAME_STAGE_VMS,
+  FRAME_STAGE_EFFECTORS,
+  FRAME_STAGE_DATALOG,
+  FRAME_STAGE_TELEM,
+  NUM_FRAME_STAGES
 };
 /* System data */
 struct SysData {
   int32_t frame_time_us;
+  /* Time spent in each stage of the previous frame, us */
+  std::array<int32_t, NUM_FRAME_STAGES> stage_time_us;
+  /* VMS rate group releases before the group had run, since init */
+  int32_t vms_overruns;
   #if defined(__FMU_R_V1__)
   float input_volt;
   float reg_volt;
@@ -95,6 +127,10 @@ struct SysData {
 /* Analog data */
 struct AdcData {
   std::array<float, NUM_AIN_PINS> volt;
+  /* Standard deviation of the oversampled conversions, V */
+  std::array<float, NUM_AIN_PINS> noise_v;
+  /* Conversion rate, Hz */
+  std::array<float, NUM_AIN_PINS> rate_hz;
 };
 /* Power module data */
 #if defined(__FMU_R_V2__)
@@ -110,9 +146,58 @@ struct InceptorData {
   bool failsafe;
   bool ch17;
   bool ch18;
-  std::array<int16_t, bfs::SbusRx::NUM_CH> ch;
+  std::array<int16_t, NUM_SBUS_CH> ch;
+};
+/* Sample timing */
+struct SampleInfo {
+  bool fresh;
+  int64_t time_us;
+};
+/* IMU calibration status */
+struct ImuCalData {
+  bool accel_stored;
+  bool mag_stored;
+  int16_t accel_samples;
+  int16_t mag_samples;
+  /* RMS fit residual, normalized to the field magnitude */
+  float accel_resid;
+  float mag_resid;
 };
-/* Sensor data */
+/* Vibration spectra, accel x y z then gyro x y z */
+inline constexpr std::size_t NUM_VIBE_AXES = 6;
+inline constexpr std::size_t NUM_VIBE_BANDS = 8;
+struct VibrationData {
+  bool new_data;
+  std::array<float, NUM_VIBE_AXES> rms;
+  std::array<float, NUM_VIBE_AXES> peak_hz;
+  std::array<float, NUM_VIBE_AXES> peak_amp;
+  /*
+  * Highest frequency resolved, half the IMU sample rate. Vibration above
+  * it that passes the IMU low pass filter aliases into the spectra.
+  */
+  float nyquist_hz;
+  /* Equal width bands from 0 Hz to the Nyquist frequency */
+  std::array<std::array<float, NUM_VIBE_BANDS>, NUM_VIBE_AXES> band_rms;
+};
+/* Redundant sources of a sensor */
+inline constexpr std::size_t NUM_REDUNDANT_SRC = 2;
+/* Vote result of a redundant sensor */
+struct VoteData {
+  bool miscompare;
+  int8_t source;
+  uint16_t switch_cnt;
+  std::array<int16_t, NUM_REDUNDANT_SRC> health;
+};
+/* Redundant sensor sources, as acquired, and their vote results */
+struct RedundancyData {
+  std::array<bfs::ImuData, NUM_REDUNDANT_SRC> imu;
+  std::array<SampleInfo, NUM_REDUNDANT_SRC> imu_sample;
+  std::array<bfs::PresData, NUM_REDUNDANT_SRC> static_pres;
+  std::array<SampleInfo, NUM_REDUNDANT_SRC> static_pres_sample;
+  VoteData imu_vote;
+  VoteData static_pres_vote;
+};
+/* Sensor data, the IMU and static pressure are the voted sources */
 struct SensorData {
   bool pitot_static_installed;
   InceptorData inceptor;
@@ -120,10 +205,18 @@ struct SensorData {
   bfs::GnssData gnss;
   bfs::PresData static_pres;
   bfs::PresData diff_pres;
+  SampleInfo inceptor_sample;
+  SampleInfo imu_sample;
+  SampleInfo gnss_sample;
+  SampleInfo static_pres_sample;
+  SampleInfo diff_pres_sample;
   AdcData adc;
   #if defined(__FMU_R_V2__)
   PowerModuleData power_module;
   #endif
+  RedundancyData redundancy;
+  ImuCalData imu_cal;
+  VibrationData vibration;
 };
 /* Nav data */
 struct NavData {
@@ -208,6 +301,27 @@ struct TelemData {
   std::array<bfs::MissionItem, NUM_FENCE_POINTS> fence;
   std::array<bfs::MissionItem, NUM_RALLY_POINTS> rally;
 };
+/*
+* Telemetry view passed to the VMS, with the active leg of the flight plan
+* in place of the mission arrays
+*/
+struct VmsTelemData {
+  bool waypoints_updated;
+  bool fence_updated;
+  bool rally_points_updated;
+  int16_t current_waypoint;
+  int16_t num_waypoints;
+  int16_t num_fence_items;
+  int16_t num_rally_points;
+  std::array<float, NUM_TELEM_PARAMS> param;
+  /* Active waypoint and the one after it, the last waypoint repeats */
+  bfs::MissionItem waypoint;
+  bfs::MissionItem next_waypoint;
+  /* Leg from the active to the next waypoint, NED and length m, course rad */
+  std::array<float, 3> leg_ned_m;
+  float leg_dist_m;
+  float leg_course_rad;
+};
 /* Aircraft data */
 struct AircraftData {
   SysData sys;
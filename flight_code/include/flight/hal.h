@@ -0,0 +1,128 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_HAL_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_HAL_H_
+
+#include "flight/global_defs.h"
+
+/*
+* Hardware abstraction layer. Each device class is a set of free functions
+* implemented once for the FMU, in hal_fmu.cc, and once for the host, in
+* host/hal, where devices are fed from recorded logs or a simulation model.
+* The implementation is selected at link time, so the flight code above
+* this layer builds unchanged for either and pays nothing for the
+* indirection.
+*/
+
+/* System: buses and converters */
+void HalInit();
+/* System time, us */
+int64_t HalMicros();
+/* Waits, ms */
+void HalDelayMs(const int32_t ms);
+/* Stops after an unrecoverable error */
+[[noreturn]] void HalHalt();
+/* Attaches the frame ISR to the IMU data ready edge */
+void HalAttachFrame(void (*isr)());
+/* Processor cycle counter, which wraps, and its rate, Hz */
+uint32_t HalCycles();
+uint32_t HalCycleHz();
+
+/* Messages */
+void HalMsgBegin();
+void HalMsgPrint(const char * str);
+
+/* IMU */
+bool HalImuInit(const bfs::ImuConfig &cfg);
+bool HalImuRead(bfs::ImuData * const data);
+/* Time of the latest IMU data ready edge, us */
+int64_t HalImuDrdyTime();
+/* Redundant IMU, on the VectorNav chip select */
+bool HalRedundantImuInit(const bfs::ImuConfig &cfg);
+bool HalRedundantImuRead(bfs::ImuData * const data);
+int64_t HalRedundantImuDrdyTime();
+
+/* FMU static pressure transducer */
+bool HalFmuStaticPresInit(const bfs::PresConfig &cfg);
+bool HalFmuStaticPresRead(bfs::PresData * const data);
+
+/* Air data pressure transducers, init probes them with blocking reads */
+bool HalStaticPresInit(const bfs::PresConfig &cfg);
+bool HalDiffPresInit(const bfs::PresConfig &cfg);
+/*
+* Non-blocking reads on the air data I2C bus. A read is started and then
+* polled, each poll returning without waiting on the bus; the caller
+* times the read out and aborts it.
+*/
+enum HalI2cStatus : int8_t {
+  HAL_I2C_BUSY,
+  HAL_I2C_DONE,
+  HAL_I2C_ERROR
+};
+inline constexpr std::size_t HAL_I2C_MAX_READ = 8;
+void HalPresI2cReadStart(const uint8_t addr, const std::size_t len);
+/* Advances the read, the bytes are copied to buf once done */
+HalI2cStatus HalPresI2cReadPoll(uint8_t * const buf);
+void HalPresI2cAbort();
+/* Air data I2C bus lines as GPIO, for bus recovery */
+void HalPresI2cTakeover();
+bool HalPresI2cSda();
+void HalPresI2cSda(const bool high);
+void HalPresI2cScl(const bool high);
+/* Hands the lines back to the I2C peripheral */
+void HalPresI2cRestart();
+
+/* GNSS receiver serial port */
+bool HalGnssBegin(const bfs::GnssConfig &cfg);
+/* Reads up to len available bytes without waiting, returns the count */
+std::size_t HalGnssRead(uint8_t * const buf, const std::size_t len);
+
+/*
+* Inceptor serial port. Received bytes are handed to rx from interrupt
+* context, in order, each with its arrival time, us
+*/
+bool HalInceptorBegin(void (*rx)(const uint8_t byte, const int64_t time_us));
+
+/* ADC, counts */
+int32_t HalAnalogRead(const int8_t pin);
+
+/* Effectors, commands are latched and sent on write */
+void HalEffectorsInit();
+void HalSbusCmd(const SbusCmd &cmd);
+void HalPwmCmd(const PwmCmd &cmd);
+void HalEffectorsWrite();
+
+/* Non-volatile parameter storage */
+uint8_t HalEepromRead(const std::size_t addr);
+void HalEepromWrite(const std::size_t addr, const uint8_t val);
+
+/* Datalog storage, returns the file number or -1 on error */
+int HalStorageInit(const char * name);
+void HalStorageWrite(const uint8_t * const data, const std::size_t len);
+void HalStorageFlush();
+void HalStorageClose();
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_HAL_H_
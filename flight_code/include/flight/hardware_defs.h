@@ -56,6 +56,9 @@ inline constexpr int8_t VN_CS = 34;
 inline constexpr int8_t VN_DRDY = 33;
 /* Pressure transducers */
 inline constexpr TwoWire &PRES_I2C_BUS = Wire;
+inline constexpr int32_t PRES_I2C_CLOCK_HZ = 400000;
+inline constexpr int8_t PRES_I2C_SDA = 18;
+inline constexpr int8_t PRES_I2C_SCL = 19;
 inline constexpr SPIClass &PRES_SPI_BUS = SPI;
 inline constexpr int8_t PRES_CS = 32;
 /* Analog */
@@ -95,6 +98,9 @@ inline constexpr int8_t VN_CS = 34;
 inline constexpr int8_t VN_DRDY = 33;
 /* Pressure transducers */
 inline constexpr TwoWire &PRES_I2C_BUS = Wire;
+inline constexpr int32_t PRES_I2C_CLOCK_HZ = 400000;
+inline constexpr int8_t PRES_I2C_SDA = 18;
+inline constexpr int8_t PRES_I2C_SCL = 19;
 inline constexpr SPIClass &PRES_SPI_BUS = SPI;
 inline constexpr int8_t PRES_CS = 32;
 /* Analog */
@@ -137,6 +143,9 @@ inline constexpr int8_t VN_CS = 25;
 inline constexpr int8_t VN_DRDY = 28;
 /* Pressure transducers */
 inline constexpr TwoWire &PRES_I2C_BUS = Wire1;
+inline constexpr int32_t PRES_I2C_CLOCK_HZ = 400000;
+inline constexpr int8_t PRES_I2C_SDA = 38;
+inline constexpr int8_t PRES_I2C_SCL = 37;
 inline constexpr SPIClass &PRES_SPI_BUS = SPI;
 inline constexpr int8_t PRES_CS = 26;
 /* Voltage */
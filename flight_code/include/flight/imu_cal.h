@@ -0,0 +1,42 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_IMU_CAL_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_IMU_CAL_H_
+
+#include "flight/global_defs.h"
+
+/* Replaces the configured IMU calibration with the stored one, if valid */
+void ImuCalLoad(bfs::ImuConfig * const cfg);
+/* Initializes the estimator with the calibration applied to the IMU */
+void ImuCalInit(const bfs::ImuConfig &cfg);
+/* Offers a primary IMU sample to the estimator, called from the frame */
+void ImuCalSample(const bfs::ImuData &imu, const bool motors_enabled);
+/* Advances the estimator by one bounded step, called from the main loop */
+void ImuCalRun();
+/* Copies the calibration status, called from the frame */
+void ImuCalRead(ImuCalData * const data);
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_IMU_CAL_H_
@@ -0,0 +1,54 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_PARAM_STORE_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_PARAM_STORE_H_
+
+#include <array>
+#include <cstdint>
+#include "flight/global_defs.h"
+
+/* EEPROM bytes used: a header, the parameters, and a checksum */
+inline constexpr std::size_t PARAM_STORE_SIZE = 3 + NUM_TELEM_PARAMS *
+                                                sizeof(float) +
+                                                sizeof(uint16_t);
+/*
+* Telemetry parameters kept in EEPROM, with a header and checksum. Returns
+* true and the stored values if the store is valid, otherwise initializes
+* it with the parameters zeroed.
+*/
+bool ParamStoreLoad(std::array<float, NUM_TELEM_PARAMS> * const param);
+/*
+* Stores a parameter value updated from the ground station. Called from
+* the frame; the EEPROM write is deferred to ParamStoreRun.
+*/
+void ParamStoreWrite(const int32_t idx, const float val);
+/*
+* Writes a pending parameter to EEPROM, from the background loop, so the
+* EEPROM is only ever written from the one context
+*/
+void ParamStoreRun();
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_PARAM_STORE_H_
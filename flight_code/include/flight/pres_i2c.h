@@ -0,0 +1,48 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_PRES_I2C_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_PRES_I2C_H_
+
+#include "flight/global_defs.h"
+
+/* AMS5915 output: pressure and temperature counts, 4 bytes */
+inline constexpr std::size_t AMS5915_READ_LEN = 4;
+inline constexpr int32_t AMS5915_PRES_CNT_MIN = 1638;
+inline constexpr int32_t AMS5915_PRES_CNT_MAX = 14745;
+inline constexpr int32_t AMS5915_TEMP_CNT_RANGE = 2048;
+inline constexpr float AMS5915_TEMP_MIN_C = -50.0f;
+inline constexpr float AMS5915_TEMP_RANGE_C = 200.0f;
+/* Pressure range of an AMS5915 transducer, Pa, false if unknown */
+bool Ams5915Range(const decltype(bfs::PresConfig::transducer) transducer,
+                  float * const min_pa, float * const max_pa);
+/* Initializes the air data sensor pressure transducers */
+void PresI2cInit(const SensorConfig &cfg);
+/* Advances the I2C state machine, start requests a new sample */
+void PresI2cPoll(bool start);
+/* Copies the latest samples, their times, and freshness */
+void PresI2cRead(SensorData * const data);
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_PRES_I2C_H_
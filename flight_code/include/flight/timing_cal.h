@@ -0,0 +1,49 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_TIMING_CAL_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_TIMING_CAL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Timing calibration kernels. Each kernel repeats one kind of operation,
+* such as a single precision multiply, a load, or a call to sinf, in four
+* independent chains. Timed on the FMU with the cycle counter, they give
+* the target cycles that the host timing model fits its per operation
+* costs to, from the operation counts of the same kernels on the host.
+*/
+inline constexpr std::size_t NUM_TIMING_KERNELS = 15;
+inline constexpr int32_t TIMING_KERNEL_ITER = 1000;
+
+/* Name of a kernel */
+const char * TimingKernelName(const std::size_t k);
+/* Runs a kernel for TIMING_KERNEL_ITER iterations */
+void TimingKernelRun(const std::size_t k);
+/* Times each kernel and prints the cycles, for the host timing model */
+void TimingCalRun();
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_TIMING_CAL_H_
@@ -0,0 +1,138 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_UBX_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_UBX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+/* Navigation solution from a UBX epoch */
+struct UbxNavData {
+  int8_t fix;
+  int8_t num_sats;
+  int16_t week;
+  int32_t tow_ms;
+  float alt_wgs84_m;
+  float alt_msl_m;
+  float hdop;
+  float vdop;
+  float track_rad;
+  float spd_mps;
+  float horz_acc_m;
+  float vert_acc_m;
+  float vel_acc_mps;
+  float track_acc_rad;
+  std::array<float, 3> ned_vel_mps;
+  double lat_rad;
+  double lon_rad;
+};
+
+/*
+* Incremental UBX parser for UBX-NAV-PVT, UBX-NAV-DOP, UBX-NAV-EOE and,
+* optionally, UBX-NAV-HPPOSLLH. Bytes are parsed one at a time at a
+* constant cost per byte, so the parser can be fed in small slices as bytes
+* arrive. An epoch completes on UBX-NAV-EOE. This has no hardware
+* dependencies and is shared by the flight code and the host tools.
+*/
+class UbxParser {
+ public:
+  /* Parses a byte, returns true when a navigation epoch completes */
+  bool Parse(const uint8_t c);
+  /* Navigation solution from the last completed epoch */
+  inline const UbxNavData & data() const {return data_;}
+  /* Number of messages with checksum errors */
+  inline uint32_t checksum_errors() const {return checksum_errors_;}
+  /* Number of completed epochs */
+  inline uint32_t num_epochs() const {return num_epochs_;}
+
+ private:
+  /* UBX framing */
+  static constexpr uint8_t UBX_SYNC1_ = 0xB5;
+  static constexpr uint8_t UBX_SYNC2_ = 0x62;
+  static constexpr uint8_t UBX_NAV_CLASS_ = 0x01;
+  static constexpr uint8_t UBX_NAV_DOP_ID_ = 0x04;
+  static constexpr uint8_t UBX_NAV_PVT_ID_ = 0x07;
+  static constexpr uint8_t UBX_NAV_HPPOSLLH_ID_ = 0x14;
+  static constexpr uint8_t UBX_NAV_EOE_ID_ = 0x61;
+  static constexpr std::size_t UBX_NAV_DOP_LEN_ = 18;
+  static constexpr std::size_t UBX_NAV_PVT_LEN_ = 92;
+  static constexpr std::size_t UBX_NAV_HPPOSLLH_LEN_ = 36;
+  static constexpr std::size_t UBX_NAV_EOE_LEN_ = 4;
+  /* Longest payload stored, other messages are checked and skipped */
+  static constexpr std::size_t MAX_PAYLOAD_LEN_ = UBX_NAV_PVT_LEN_;
+  /* Parser state */
+  enum State {
+    SYNC1,
+    SYNC2,
+    CLASS,
+    ID,
+    LEN1,
+    LEN2,
+    PAYLOAD,
+    CHK_A,
+    CHK_B
+  };
+  State state_ = SYNC1;
+  uint8_t cls_, id_;
+  uint16_t len_, idx_;
+  uint8_t chk_a_, chk_b_;
+  std::array<uint8_t, MAX_PAYLOAD_LEN_> payload_;
+  uint32_t checksum_errors_ = 0;
+  uint32_t num_epochs_ = 0;
+  /* Epoch being assembled */
+  bool pvt_valid_ = false;
+  bool hp_valid_ = false;
+  uint32_t pvt_tow_ms_, hp_tow_ms_;
+  UbxNavData epoch_ = {}, data_ = {};
+  /* High precision position */
+  double epoch_hp_lat_rad_, epoch_hp_lon_rad_;
+  float epoch_hp_alt_wgs84_m_, epoch_hp_alt_msl_m_;
+  float epoch_hp_horz_acc_m_, epoch_hp_vert_acc_m_;
+  /* Handles a complete message, returns true on the end of an epoch */
+  bool Handle();
+  void ParsePvt();
+  void ParseDop();
+  void ParseHpposllh();
+  /* Little endian payload fields */
+  inline uint8_t U1(const std::size_t i) const {return payload_[i];}
+  inline int8_t I1(const std::size_t i) const {
+    return static_cast<int8_t>(payload_[i]);
+  }
+  inline uint16_t U2(const std::size_t i) const {
+    return static_cast<uint16_t>(payload_[i + 1]) << 8 | payload_[i];
+  }
+  inline uint32_t U4(const std::size_t i) const {
+    return static_cast<uint32_t>(payload_[i + 3]) << 24 |
+           static_cast<uint32_t>(payload_[i + 2]) << 16 |
+           static_cast<uint32_t>(payload_[i + 1]) << 8 | payload_[i];
+  }
+  inline int32_t I4(const std::size_t i) const {
+    return static_cast<int32_t>(U4(i));
+  }
+};
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_UBX_H_
@@ -23,14 +23,73 @@
 * IN THE SOFTWARE.
 */
 
-#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
-#define FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_VMS_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_VMS_H_
 
 #include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+
+/* Fraction of the frame period budgeted to the VMS */
+inline constexpr float VMS_BUDGET_FRAC = 0.5f;
+inline constexpr int32_t VMS_BUDGET_US = static_cast<int32_t>(
+  VMS_BUDGET_FRAC * FRAME_PERIOD_MS * 1000);
+/*
+* Fraction of the frame period kept for the rest of the background loop:
+* navigation, IMU calibration, vibration, parameter writes and the datalog
+* flush; VMS rate groups get only what is left after it
+*/
+inline constexpr float VMS_BACKGROUND_FRAC = 0.2f;
+
+/*
+* Multitasking autocode has an entry point for each rate group below the
+* frame rate, step1 to step3, fastest first
+*/
+inline constexpr int8_t MAX_VMS_SUBRATES = 3;
+template <typename T>
+constexpr int8_t VmsNumSubrates() {
+  if constexpr (requires(T a) {a.step3();}) {
+    return 3;
+  } else if constexpr (requires(T a) {a.step2();}) {
+    return 2;
+  } else if constexpr (requires(T a) {a.step1();}) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+/* Runs the entry point of a rate group, 1-based */
+template <typename T>
+void VmsAutocodeStep(T * const autocode, const int8_t tid) {
+  if constexpr (VmsNumSubrates<T>() >= 1) {
+    if (tid == 1) {autocode->step1();}
+  }
+  if constexpr (VmsNumSubrates<T>() >= 2) {
+    if (tid == 2) {autocode->step2();}
+  }
+  if constexpr (VmsNumSubrates<T>() >= 3) {
+    if (tid == 3) {autocode->step3();}
+  }
+}
 
 void VmsInit();
 void VmsRun(const SysData &sys, const SensorData &sensor,
             const NavData &nav, const TelemData &telem,
             VmsData *vms);
+/*
+* Runs a rate group released by the frame, from the main loop, so the
+* frame preempts it as the base rate preempts the slower tasks of
+* multitasking autocode. One group runs per call, fastest first.
+*/
+void VmsBackground();
+/* Warns, from the main loop, the first time the VMS overruns its budget */
+void VmsBudgetCheck();
+/* VMS execution time of the last frame and the peak since init, us */
+int32_t VmsTimeUs();
+int32_t VmsPeakTimeUs();
+/*
+* Rate group releases before the group had run since init, logged with the
+* system data so each overrun is counted, not only the first
+*/
+int32_t VmsOverruns();
 
-#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_CONTROL_H_
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_VMS_H_
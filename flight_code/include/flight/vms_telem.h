@@ -0,0 +1,63 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef FLIGHT_CODE_INCLUDE_FLIGHT_VMS_TELEM_H_
+#define FLIGHT_CODE_INCLUDE_FLIGHT_VMS_TELEM_H_
+
+#include "flight/global_defs.h"
+
+/*
+* Autocode generated with the VmsTelemData bus on its telemetry input is
+* passed the slim view; otherwise it is passed the full TelemData.
+*/
+template <typename T>
+concept VmsTelemViewInput = requires(T autocode, const SysData &sys,
+                                     const SensorData &sensor,
+                                     const NavData &nav,
+                                     const VmsTelemData &telem,
+                                     VmsData *vms) {
+  autocode.Run(sys, sensor, nav, telem, vms);
+};
+
+/*
+* Updates the VMS telemetry view. The waypoints and leg are only rebuilt
+* when the flight plan or the active waypoint change.
+*/
+void VmsTelemUpdate(const TelemData &telem, VmsTelemData * const view);
+/* Runs an autocode step with the telemetry input its interface takes */
+template <typename T>
+void VmsAutocodeRun(T * const autocode, const SysData &sys,
+                    const SensorData &sensor, const NavData &nav,
+                    const TelemData &telem, VmsTelemData * const view,
+                    VmsData * const vms) {
+  if constexpr (VmsTelemViewInput<T>) {
+    VmsTelemUpdate(telem, view);
+    autocode->Run(sys, sensor, nav, *view, vms);
+  } else {
+    autocode->Run(sys, sensor, nav, telem, vms);
+  }
+}
+
+#endif  // FLIGHT_CODE_INCLUDE_FLIGHT_VMS_TELEM_H_
@@ -0,0 +1,260 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Checks the effector allocator on a quadrotor and a flying wing and times
+* it. The checks cover unsaturated allocation, thrust shifted to keep roll
+* authority at idle and full thrust, lower priority commands giving way
+* first, the mapping to PWM and SBUS channels, and, over random commands,
+* that the effectors stay within their limits, that commands at a level
+* are scaled together, and that the effector commands are the mix of the
+* achieved virtual commands. The allocation is then timed per call on
+* unsaturated and saturated commands. The run fails if any check fails.
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+#include "flight/allocation.h"
+#include "hal/host_tool.h"
+
+namespace {
+static constexpr float TOL_ = 1e-3f;
+/* Quadrotor X: thrust, roll, pitch, and yaw to four motors, PWM 1 to 4 */
+using Quad = EffectorAllocator<float, 4, 4>;
+static constexpr Quad::Config QUAD_ = {
+  .mix = {{
+    {1, -0.5f, 0.5f, 0.5f},
+    {1, 0.5f, -0.5f, 0.5f},
+    {1, 0.5f, 0.5f, -0.5f},
+    {1, -0.5f, -0.5f, -0.5f}
+  }},
+  .trim = {0, 0, 0, 0},
+  .min = {0, 0, 0, 0},
+  .max = {1, 1, 1, 1},
+  .priority = {2, 0, 0, 1},
+  .offset = 0,
+  .ch = {0, 1, 2, 3},
+  .cnt_zero = {1000, 1000, 1000, 1000},
+  .cnt_scale = {1000, 1000, 1000, 1000}
+};
+/*
+* Flying wing: throttle, roll, pitch, and yaw, deg, to the motor on PWM 1
+* and elevons on SBUS 1 and 2; pitch has priority over roll
+*/
+using Wing = EffectorAllocator<float, 4, 3>;
+static constexpr Wing::Config WING_ = {
+  .mix = {{
+    {1, 0, 0, 0},
+    {0, 1, -1, 0},
+    {0, -1, -1, 0}
+  }},
+  .trim = {0, 0, 0},
+  .min = {0, -25, -25},
+  .max = {1, 25, 25},
+  .priority = {2, 1, 0, 3},
+  .offset = -1,
+  .ch = {0, NUM_PWM_PINS, NUM_PWM_PINS + 1},
+  .cnt_zero = {1000, 992, 992},
+  .cnt_scale = {1000, 32, 32}
+};
+/* Run settings */
+struct Options {
+  std::size_t trials = 100000;
+  uint64_t seed = 0;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "trials") {
+    opt->trials = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->trials == 0) {return false;}
+  } else if (key == "seed") {
+    opt->seed = std::strtoull(val.c_str(), nullptr, 10);
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Check results */
+HostChecks checks;
+bool Near(const float a, const float b) {
+  return std::abs(a - b) <= TOL_ * std::max(1.0f, std::abs(b));
+}
+/* Effectors within limits and equal to the mix of the achieved commands */
+template <std::size_t NV, std::size_t NE>
+bool Consistent(const typename EffectorAllocator<float, NV, NE>::Config &cfg,
+                const EffectorAllocator<float, NV, NE> &alloc,
+                const std::array<float, NE> &u) {
+  for (std::size_t i = 0; i < NE; i++) {
+    if ((u[i] < cfg.min[i] - TOL_) || (u[i] > cfg.max[i] + TOL_)) {
+      return false;
+    }
+    float mix = cfg.trim[i];
+    for (std::size_t j = 0; j < NV; j++) {
+      mix += cfg.mix[i][j] * alloc.achieved()[j];
+    }
+    if (!Near(u[i], mix)) {return false;}
+  }
+  return true;
+}
+/* Commands at the same level achieved in the same ratio, none exceeded */
+template <std::size_t NV, std::size_t NE>
+bool Scaled(const typename EffectorAllocator<float, NV, NE>::Config &cfg,
+            const EffectorAllocator<float, NV, NE> &alloc,
+            const std::array<float, NV> &v) {
+  std::array<float, NV> ratio;
+  for (std::size_t j = 0; j < NV; j++) {
+    if (static_cast<int8_t>(j) == cfg.offset) {continue;}
+    if (std::abs(alloc.achieved()[j]) > std::abs(v[j]) + TOL_) {return false;}
+    ratio[j] = (std::abs(v[j]) > 0.05f) ? alloc.achieved()[j] / v[j] : -1;
+    for (std::size_t k = 0; k < j; k++) {
+      if ((cfg.priority[k] == cfg.priority[j]) && (ratio[k] >= 0) &&
+          (ratio[j] >= 0) && (static_cast<int8_t>(k) != cfg.offset) &&
+          (std::abs(ratio[k] - ratio[j]) > 0.01f)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+/* Allocations timed, kept at file scope so the calls can't be elided */
+std::array<float, 4> quad_out;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " [--trials=100000] [--seed=0]"
+              << std::endl;
+    return -1;
+  }
+  Quad quad(QUAD_);
+  Wing wing(WING_);
+  /* Unsaturated, the mix of the commands */
+  std::array<float, 4> v = {0.5f, 0.1f, 0.1f, 0.05f};
+  std::array<float, 4> u = quad.Run(v);
+  bool pass = Consistent<4, 4>(QUAD_, quad, u);
+  for (std::size_t j = 0; j < v.size(); j++) {
+    pass = pass && Near(quad.achieved()[j], v[j]);
+  }
+  checks.Check(pass, "unsaturated commands achieved");
+  /* Roll at idle raises the thrust */
+  v = {0, 0.2f, 0, 0};
+  u = quad.Run(v);
+  checks.Check(Consistent<4, 4>(QUAD_, quad, u) &&
+               Near(quad.achieved()[1], 0.2f) &&
+               Near(quad.achieved()[0], 0.1f) &&
+               Near(*std::min_element(u.begin(), u.end()), 0),
+               "roll at idle thrust");
+  /* Roll at full thrust lowers it */
+  v = {1, 0.2f, 0, 0};
+  u = quad.Run(v);
+  checks.Check(Consistent<4, 4>(QUAD_, quad, u) &&
+               Near(quad.achieved()[1], 0.2f) &&
+               Near(quad.achieved()[0], 0.9f), "roll at full thrust");
+  /* Yaw gives way to roll */
+  v = {0.5f, 0.6f, 0, 0.6f};
+  u = quad.Run(v);
+  checks.Check(Consistent<4, 4>(QUAD_, quad, u) &&
+               Near(quad.achieved()[1], 0.6f) && (quad.achieved()[3] > 0) &&
+               (quad.achieved()[3] < 0.6f - TOL_),
+               "yaw gives way to roll");
+  /* Roll and pitch beyond the motor range scale together */
+  v = {0.5f, 0.8f, 0.8f, 0};
+  u = quad.Run(v);
+  checks.Check(Consistent<4, 4>(QUAD_, quad, u) &&
+               Near(quad.achieved()[1], 0.5f) && Near(quad.achieved()[2], 0.5f),
+               "roll and pitch scaled together");
+  /* Flying wing: roll gives way to pitch on the elevons */
+  std::array<float, 4> w = {0.5f, 20, 20, 0};
+  std::array<float, 3> e = wing.Run(w);
+  checks.Check(Consistent<4, 3>(WING_, wing, e) &&
+               Near(wing.achieved()[2], 20) && Near(wing.achieved()[1], 5),
+               "roll gives way to pitch");
+  /* Output channels and counts */
+  PwmCmd pwm = {};
+  SbusCmd sbus = {};
+  wing.Write(e, &pwm, &sbus);
+  checks.Check(Near(pwm.cmd[0], 0.5f) && (pwm.cnt[0] == 1500) &&
+               Near(sbus.cmd[0], e[1]) && Near(sbus.cmd[1], e[2]) &&
+               (sbus.cnt[1] ==
+                static_cast<int16_t>(std::lround(992 + 32 * e[2]))),
+               "PWM and SBUS channels");
+  /* Random commands */
+  std::mt19937_64 rng(opt.seed);
+  std::uniform_real_distribution<float> thrust(0, 1), moment(-1, 1);
+  std::uniform_real_distribution<float> deflect(-40, 40);
+  bool quad_ok = true, wing_ok = true;
+  std::vector<std::array<float, 4>> quad_cmds(opt.trials);
+  for (std::size_t n = 0; n < opt.trials; n++) {
+    v = {thrust(rng), moment(rng), moment(rng), moment(rng)};
+    quad_cmds[n] = v;
+    u = quad.Run(v);
+    quad_ok = quad_ok && Consistent<4, 4>(QUAD_, quad, u) &&
+              Scaled<4, 4>(QUAD_, quad, v);
+    w = {thrust(rng), deflect(rng), deflect(rng), 0};
+    e = wing.Run(w);
+    wing_ok = wing_ok && Consistent<4, 3>(WING_, wing, e) &&
+              Scaled<4, 3>(WING_, wing, w);
+  }
+  checks.Check(quad_ok, "random quadrotor commands");
+  checks.Check(wing_ok, "random flying wing commands");
+  /* Time per allocation, unsaturated and saturated */
+  using Clock = std::chrono::steady_clock;
+  std::vector<std::array<float, 4>> small(opt.trials);
+  for (auto &c : small) {
+    c = {0.3f + 0.4f * thrust(rng), 0.1f * moment(rng), 0.1f * moment(rng),
+         0.1f * moment(rng)};
+  }
+  auto time_ns = [&quad](const std::vector<std::array<float, 4>> &cmds) {
+    auto t0 = Clock::now();
+    for (const auto &c : cmds) {
+      quad_out = quad.Run(c);
+      asm volatile("" : : "r"(&quad_out) : "memory");
+    }
+    auto t1 = Clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+           static_cast<double>(cmds.size());
+  };
+  double small_ns = time_ns(small);
+  double random_ns = time_ns(quad_cmds);
+  std::cout << std::fixed << std::setprecision(1)
+            << "Checks: " << checks.num() - checks.failed() << " of "
+            << checks.num()
+            << " passed, " << opt.trials << " random commands" << std::endl
+            << "Quadrotor allocation, ns per call: unsaturated " << small_ns
+            << ", random " << random_ns << std::endl;
+  return checks.Result();
+}
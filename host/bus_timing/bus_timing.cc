@@ -0,0 +1,247 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Simulates the bus and compute timeline of the flight software frame,
+* comparing the frame ISR duration with every sensor sampled synchronously
+* in the frame against the pipelined acquisition, where devices on slow
+* buses are serviced from the main loop and the frame only consumes their
+* completed samples. Bus times are computed from the bus clocks and
+* transfer sizes; compute times are estimates and should be updated from
+* measured frame_time_us data.
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+/* Frame and processor */
+#if defined(__FMU_R_V2__) || defined(__FMU_R_V2_BETA__)
+static constexpr double FRAME_PERIOD_US = 10000;
+/* Compute time relative to the 600 MHz Cortex M7 */
+static constexpr double CPU_SCALE = 1;
+static constexpr double ADC_CONV_US = 12;
+#else
+static constexpr double FRAME_PERIOD_US = 20000;
+/* Compute time relative to the 600 MHz Cortex M7 */
+static constexpr double CPU_SCALE = 4;
+static constexpr double ADC_CONV_US = 20;
+#endif
+/* Number of analog conversions per frame */
+#if defined(__FMU_R_V2__)
+/* 8 analog inputs + battery voltage and current */
+static constexpr int NUM_ADC_CONV = 10;
+#elif defined(__FMU_R_V2_BETA__)
+/* 8 analog inputs */
+static constexpr int NUM_ADC_CONV = 8;
+#else
+/* 2 analog inputs + input, regulated, SBUS, and PWM voltages */
+static constexpr int NUM_ADC_CONV = 6;
+#endif
+/* Bus clocks */
+static constexpr double IMU_SPI_HZ = 20e6;
+static constexpr double PRES_SPI_HZ = 10e6;
+static constexpr double I2C_HZ = 400e3;
+static constexpr double GNSS_BAUD = 921600;
+static constexpr double SBUS_BAUD = 100000;
+/* Time to select a device and start a transfer, us */
+static constexpr double TRANSFER_OVERHEAD_US = 2;
+/* Time to copy a completed sample out of its double buffer, us */
+static constexpr double BUFFER_COPY_US = 0.5;
+/* Parse cost per received byte, us */
+static constexpr double UBX_BYTE_US = 0.25 * CPU_SCALE;
+static constexpr double SBUS_BYTE_US = 0.3 * CPU_SCALE;
+/* UBX-NAV-PVT, UBX-NAV-DOP, and UBX-NAV-EOE */
+static constexpr int GNSS_SOLUTION_BYTES = (92 + 8) + (18 + 8) + (4 + 8);
+static constexpr double GNSS_PERIOD_US = 100000;
+static constexpr int SBUS_FRAME_BYTES = 25;
+static constexpr double SBUS_PERIOD_US = 7000;
+/* Frame compute estimates, us */
+static constexpr double SYS_US = 2 * CPU_SCALE;
+static constexpr double NAV_US = 180 * CPU_SCALE;
+static constexpr double VMS_US = 150 * CPU_SCALE;
+static constexpr double EFFECTORS_US = 5 * CPU_SCALE;
+static constexpr double DATALOG_US = 60 * CPU_SCALE;
+static constexpr double TELEM_US = 80 * CPU_SCALE;
+
+/* SPI transfer time, us */
+double SpiUs(int bytes, double hz) {
+  return TRANSFER_OVERHEAD_US + static_cast<double>(bytes) * 8.0 / hz * 1e6;
+}
+/* I2C read time, address byte + data bytes with ACK bits, us */
+double I2cUs(int bytes) {
+  return TRANSFER_OVERHEAD_US +
+         static_cast<double>(bytes + 1) * 9.0 / I2C_HZ * 1e6 +
+         2.0 / I2C_HZ * 1e6;
+}
+
+/* A device serviced every frame */
+struct Device {
+  std::string name;
+  /* Serviced from the main loop in the pipelined configuration */
+  bool background;
+  /* Transfer and processing time per frame, us */
+  double fixed_us;
+  /* Received byte stream, parsed when serviced */
+  double byte_us;
+  int burst_bytes;
+  double burst_period_us;
+  double baud;
+  double phase_us;
+};
+
+/* Bytes of a bursty stream that have arrived by time t_us */
+double BytesArrived(const Device &dev, double t_us) {
+  if (dev.burst_bytes <= 0) {return 0;}
+  double t = t_us - dev.phase_us;
+  if (t < 0) {return 0;}
+  double bursts = std::floor(t / dev.burst_period_us);
+  double burst_us = static_cast<double>(dev.burst_bytes) * 10.0 /
+                    dev.baud * 1e6;
+  double in_burst = std::min(t - bursts * dev.burst_period_us, burst_us) /
+                    burst_us;
+  return (bursts + in_burst) * static_cast<double>(dev.burst_bytes);
+}
+
+/* Cost of servicing a device over (t0_us, t1_us] */
+double ServiceUs(const Device &dev, double t0_us, double t1_us) {
+  double bytes = std::floor(BytesArrived(dev, t1_us)) -
+                 std::floor(BytesArrived(dev, t0_us));
+  return dev.fixed_us + bytes * dev.byte_us;
+}
+
+struct Stats {
+  double mean = 0;
+  double max = 0;
+  void Add(double val, std::size_t n) {
+    mean += val / static_cast<double>(n);
+    max = std::max(max, val);
+  }
+};
+
+struct Result {
+  Stats isr_us;
+  Stats background_us;
+  /* Frames where background work did not finish before the next frame */
+  std::size_t late_frames = 0;
+};
+
+Result Simulate(const std::vector<Device> &devices, bool pipelined,
+                std::size_t num_frames) {
+  Result res;
+  double compute_us = SYS_US + NAV_US + VMS_US + EFFECTORS_US + DATALOG_US +
+                      TELEM_US;
+  for (std::size_t k = 1; k <= num_frames; k++) {
+    double t0 = static_cast<double>(k - 1) * FRAME_PERIOD_US;
+    double t1 = static_cast<double>(k) * FRAME_PERIOD_US;
+    double isr = compute_us;
+    double background = 0;
+    for (const auto &dev : devices) {
+      double cost = ServiceUs(dev, t0, t1);
+      if (pipelined && dev.background) {
+        background += cost;
+        isr += BUFFER_COPY_US;
+      } else {
+        isr += cost;
+      }
+    }
+    if (isr + background > FRAME_PERIOD_US) {
+      res.late_frames++;
+    }
+    res.isr_us.Add(isr, num_frames);
+    res.background_us.Add(background, num_frames);
+  }
+  return res;
+}
+
+void Print(const std::string &name, const Result &res) {
+  std::cout << std::left << std::setw(12) << name << std::right
+            << std::fixed << std::setprecision(1)
+            << " ISR mean " << std::setw(8) << res.isr_us.mean << " us"
+            << "  max " << std::setw(8) << res.isr_us.max << " us"
+            << "  background mean " << std::setw(8)
+            << res.background_us.mean << " us"
+            << "  max " << std::setw(8) << res.background_us.max << " us"
+            << "  late frames " << res.late_frames << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t num_frames = 10000;
+  if (argc > 2) {
+    std::cerr << "Usage:  " << argv[0] << " <NUMBER OF FRAMES>" << std::endl;
+    return -1;
+  }
+  if (argc == 2) {
+    num_frames = std::strtoul(argv[1], nullptr, 10);
+    if (num_frames == 0) {
+      std::cerr << "ERROR: Number of frames must be positive." << std::endl;
+      return -1;
+    }
+  }
+  /* Stream phases relative to the frame are arbitrary */
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> phase(0, FRAME_PERIOD_US);
+  /* Devices, IMU is the frame trigger and always read in the frame */
+  std::vector<Device> devices = {
+    {"imu", false, SpiUs(22, IMU_SPI_HZ) + 5 * CPU_SCALE, 0, 0, 0, 0, 0},
+    {"static_pres", true, I2cUs(4) + 2 * CPU_SCALE, 0, 0, 0, 0, 0},
+    {"diff_pres", true, I2cUs(4) + 2 * CPU_SCALE, 0, 0, 0, 0, 0},
+    {"gnss", true, 1 * CPU_SCALE, UBX_BYTE_US, GNSS_SOLUTION_BYTES,
+     GNSS_PERIOD_US, GNSS_BAUD, phase(gen)},
+    {"inceptor", false, 1 * CPU_SCALE, SBUS_BYTE_US, SBUS_FRAME_BYTES,
+     SBUS_PERIOD_US, SBUS_BAUD, phase(gen)},
+    {"adc", true, NUM_ADC_CONV * ADC_CONV_US, 0, 0, 0, 0, 0}
+  };
+  std::cout << "Frame period: " << FRAME_PERIOD_US << " us, "
+            << num_frames << " frames" << std::endl;
+  std::cout << "Background:";
+  for (const auto &dev : devices) {
+    if (dev.background) {
+      std::cout << " " << dev.name;
+    }
+  }
+  std::cout << std::endl;
+  Result sync = Simulate(devices, false, num_frames);
+  Result pipe = Simulate(devices, true, num_frames);
+  Print("synchronous", sync);
+  Print("pipelined", pipe);
+  std::cout << std::fixed << std::setprecision(1)
+            << "Mean ISR reduction: "
+            << sync.isr_us.mean - pipe.isr_us.mean << " us ("
+            << 100.0 * (sync.isr_us.mean - pipe.isr_us.mean) /
+               sync.isr_us.mean << "%), max ISR reduction: "
+            << sync.isr_us.max - pipe.isr_us.max << " us" << std::endl;
+  std::cout << "Background samples are consumed one frame after they are "
+            << "acquired." << std::endl;
+  return 0;
+}
@@ -0,0 +1,267 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Checks the precomputed excitations against a direct evaluation, in
+* double precision, and compares their per frame cost. The multisine table
+* is checked sample by sample over a period, and for orthogonality: the
+* amplitude of each channel at the frequencies dealt to the other channels
+* must be negligible. The phasor chirp is checked over its duration. Each
+* excitation is then timed per frame against evaluating its sines
+* directly. The run fails if either excitation is outside the tolerance.
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <vector>
+#include "flight/hardware_defs.h"
+#include "flight/excite_table.h"
+#include "hal/host_tool.h"
+
+namespace {
+static constexpr double PI_ = std::numbers::pi;
+static constexpr double DT_S_ = FRAME_PERIOD_MS / 1000.0;
+/* Three axis multisine with a ten second period */
+static constexpr std::size_t NUM_CH_ = 3;
+static constexpr std::size_t PERIOD_ = 10000 / FRAME_PERIOD_MS;
+using Multisine = MultisineTable<NUM_CH_, PERIOD_>;
+/* Run settings */
+struct Options {
+  std::size_t first = 2;
+  std::size_t harmonics = 10;
+  double amp = 1;
+  double f0_hz = 0.1;
+  double f1_hz = 5;
+  double chirp_s = 60;
+  double tol = 1e-4;
+  std::size_t frames = 1000000;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "first") {
+    opt->first = std::strtoul(val.c_str(), nullptr, 10);
+  } else if (key == "harmonics") {
+    opt->harmonics = std::strtoul(val.c_str(), nullptr, 10);
+  } else if (key == "amp") {
+    opt->amp = std::strtod(val.c_str(), nullptr);
+    if (opt->amp <= 0) {return false;}
+  } else if (key == "f0") {
+    opt->f0_hz = std::strtod(val.c_str(), nullptr);
+  } else if (key == "f1") {
+    opt->f1_hz = std::strtod(val.c_str(), nullptr);
+  } else if (key == "chirp-s") {
+    opt->chirp_s = std::strtod(val.c_str(), nullptr);
+    if (opt->chirp_s <= 0) {return false;}
+  } else if (key == "tol") {
+    opt->tol = std::strtod(val.c_str(), nullptr);
+    if (opt->tol <= 0) {return false;}
+  } else if (key == "frames") {
+    opt->frames = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->frames == 0) {return false;}
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Keeps the compiler from eliding or hoisting the stores to an object */
+template <typename T>
+inline void KeepStores(const T &obj) {
+  asm volatile("" : : "r"(&obj) : "memory");
+}
+/* Direct multisine, unscaled, of channel ch at frame n */
+double DirectMultisine(const Options &opt, const std::size_t ch,
+                       const std::size_t n) {
+  double sum = 0;
+  for (std::size_t i = 1; i <= opt.harmonics; i++) {
+    std::size_t k = opt.first + (i - 1) * NUM_CH_ + ch;
+    double phase = -PI_ * static_cast<double>(i * i) /
+                   static_cast<double>(opt.harmonics);
+    sum += std::sin(2 * PI_ * static_cast<double>(k * n) / PERIOD_ + phase);
+  }
+  return sum;
+}
+/* Amplitude of a signal over one period at a harmonic of the fundamental */
+double Amplitude(const std::vector<double> &x, const std::size_t k) {
+  double re = 0, im = 0;
+  for (std::size_t n = 0; n < x.size(); n++) {
+    double a = 2 * PI_ * static_cast<double>(k * n) / x.size();
+    re += x[n] * std::cos(a);
+    im += x[n] * std::sin(a);
+  }
+  return 2 * std::hypot(re, im) / x.size();
+}
+/* Outputs, kept at file scope so the timed loops can't be optimized out */
+std::array<float, NUM_CH_> ms_out;
+float chirp_out;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " [--first=2] [--harmonics=10] "
+              << "[--amp=1] [--f0=0.1] [--f1=5] [--chirp-s=60] "
+              << "[--tol=1e-4] [--frames=1000000]" << std::endl;
+    return -1;
+  }
+  /* Multisine table against the direct evaluation, scaled to its peak */
+  auto ms = std::make_unique<Multisine>();
+  std::array<float, NUM_CH_> amp;
+  amp.fill(static_cast<float>(opt.amp));
+  if (!ms->Build(amp, opt.first, opt.harmonics)) {
+    std::cerr << "ERROR: Highest harmonic reaches the Nyquist frequency"
+              << std::endl;
+    return -1;
+  }
+  std::array<std::vector<double>, NUM_CH_> ref;
+  double ms_err = 0;
+  for (std::size_t ch = 0; ch < NUM_CH_; ch++) {
+    ref[ch].resize(PERIOD_);
+    double peak = 0;
+    for (std::size_t n = 0; n < PERIOD_; n++) {
+      ref[ch][n] = DirectMultisine(opt, ch, n);
+      peak = std::max(peak, std::abs(ref[ch][n]));
+    }
+    for (std::size_t n = 0; n < PERIOD_; n++) {
+      ref[ch][n] *= opt.amp / peak;
+      ms_err = std::max(ms_err, std::abs(ms->table()[n][ch] - ref[ch][n]));
+    }
+  }
+  /* Amplitude at the channel's own frequencies and leakage into others */
+  double own_min = opt.amp, leak_max = 0;
+  for (std::size_t ch = 0; ch < NUM_CH_; ch++) {
+    std::vector<double> x(PERIOD_);
+    for (std::size_t n = 0; n < PERIOD_; n++) {x[n] = ms->table()[n][ch];}
+    for (std::size_t h = 0; h < opt.harmonics * NUM_CH_; h++) {
+      double a = Amplitude(x, ms->harmonic(h));
+      if (h % NUM_CH_ == ch) {
+        own_min = std::min(own_min, a);
+      } else {
+        leak_max = std::max(leak_max, a);
+      }
+    }
+  }
+  /* Phasor chirp against the direct evaluation */
+  ChirpPhasor chirp;
+  chirp.Start(static_cast<float>(opt.amp), static_cast<float>(opt.f0_hz),
+              static_cast<float>(opt.f1_hz), static_cast<float>(opt.chirp_s),
+              static_cast<float>(DT_S_));
+  /* Reference from the same single precision settings */
+  double f0 = static_cast<float>(opt.f0_hz);
+  double f1 = static_cast<float>(opt.f1_hz);
+  double dt = static_cast<float>(DT_S_);
+  double rate = (f1 - f0) / static_cast<float>(opt.chirp_s);
+  double chirp_err = 0;
+  std::size_t chirp_frames = 0;
+  while (chirp.active()) {
+    double t = static_cast<double>(chirp_frames++) * dt;
+    double y = opt.amp * std::sin(2 * PI_ * (f0 * t + 0.5 * rate * t * t));
+    chirp_err = std::max(chirp_err, std::abs(chirp.Run() - y));
+  }
+  /* Per frame cost against evaluating the sines directly */
+  using Clock = std::chrono::steady_clock;
+  auto ns_per_frame = [&opt](const Clock::time_point t0,
+                             const Clock::time_point t1) {
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+           static_cast<double>(opt.frames);
+  };
+  ms->Start(opt.frames / PERIOD_ + 1);
+  auto t0 = Clock::now();
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    ms_out = ms->Run();
+    KeepStores(ms_out);
+  }
+  auto t1 = Clock::now();
+  std::vector<float> phase(opt.harmonics);
+  for (std::size_t i = 0; i < opt.harmonics; i++) {
+    phase[i] = static_cast<float>(-PI_ * static_cast<double>((i + 1) *
+               (i + 1)) / static_cast<double>(opt.harmonics));
+  }
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    float t = static_cast<float>(f % PERIOD_) * static_cast<float>(DT_S_);
+    for (std::size_t ch = 0; ch < NUM_CH_; ch++) {
+      float sum = 0;
+      for (std::size_t i = 0; i < opt.harmonics; i++) {
+        float hz = static_cast<float>(opt.first + i * NUM_CH_ + ch) /
+                   static_cast<float>(PERIOD_ * DT_S_);
+        sum += std::sin(2 * std::numbers::pi_v<float> * hz * t + phase[i]);
+      }
+      ms_out[ch] = sum;
+    }
+    KeepStores(ms_out);
+  }
+  auto t2 = Clock::now();
+  chirp.Start(static_cast<float>(opt.amp), static_cast<float>(opt.f0_hz),
+              static_cast<float>(opt.f1_hz), static_cast<float>(opt.frames *
+              DT_S_), static_cast<float>(DT_S_));
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    chirp_out = chirp.Run();
+    KeepStores(chirp_out);
+  }
+  auto t3 = Clock::now();
+  float frate = static_cast<float>((opt.f1_hz - opt.f0_hz) /
+                                   (opt.frames * DT_S_));
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    float t = static_cast<float>(f) * static_cast<float>(DT_S_);
+    chirp_out = static_cast<float>(opt.amp) * std::sin(
+      2 * std::numbers::pi_v<float> * (static_cast<float>(opt.f0_hz) * t +
+                                       0.5f * frate * t * t));
+    KeepStores(chirp_out);
+  }
+  auto t4 = Clock::now();
+  /* Report */
+  bool pass = (ms_err <= opt.tol * opt.amp) &&
+              (leak_max <= opt.tol * opt.amp) &&
+              (chirp_err <= opt.tol * opt.amp);
+  std::cout << std::scientific << std::setprecision(2)
+            << "Multisine: " << NUM_CH_ << " channels, " << opt.harmonics
+            << " harmonics each, " << PERIOD_ << " frame period, table "
+            << sizeof(ms->table()) << " B" << std::endl
+            << "  max error " << ms_err << ", min own amplitude " << own_min
+            << ", max cross channel amplitude " << leak_max << std::endl
+            << "Chirp: " << opt.f0_hz << " to " << opt.f1_hz << " Hz over "
+            << chirp_frames << " frames, max error " << chirp_err
+            << std::endl
+            << std::fixed << std::setprecision(1)
+            << "Per frame, ns: multisine table " << ns_per_frame(t0, t1)
+            << ", direct " << ns_per_frame(t1, t2) << "; chirp phasor "
+            << ns_per_frame(t2, t3) << ", direct " << ns_per_frame(t3, t4)
+            << std::endl;
+  if (!pass) {
+    std::cout << "FAIL: excitation outside the tolerance" << std::endl;
+    return 1;
+  }
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
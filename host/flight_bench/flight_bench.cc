@@ -0,0 +1,386 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Microbenchmarks of the per frame flight software modules on the host,
+* over the inputs of a recorded flight. The datalog is first replayed
+* through the full frame, as flight_replay does, and the system, sensor,
+* nav, and VMS data of each frame are kept. Each module is then run on its
+* own over the recorded frames several times: the nav filter on the
+* sensor data, split into steady state frames and frames with a new GNSS
+* fix; the datalog encoding and framing; the effector commands; the VMS;
+* stores of parameters set from the ground station; and the rebuild of the
+* VMS telemetry view from an uploaded flight plan. Telemetry itself isn't
+* benchmarked: the host links a stand-in without the MAVLink library, so
+* its time comes from the telemetry stage of the FMU frame profile.
+* Each call is timed with the host clock, less the timer overhead, and
+* keeps its fastest time over the repeats, so host preemption isn't
+* counted. Results are written as JSON, so they can be tracked across
+* releases.
+*
+* Built with OP_COUNT, the flight software is instrumented to count the
+* basic blocks each benchmark executes, along with the timing calibration
+* kernels, and --ops writes the counts for the target timing model. The
+* times of an instrumented build aren't representative.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numbers>
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+#include "flight/config.h"
+#include "flight/frame.h"
+#include "flight/nav.h"
+#include "flight/effectors.h"
+#include "flight/datalog.h"
+#include "flight/param_store.h"
+#include "flight/vms.h"
+#include "flight/vms_telem.h"
+#include "flight/timing_cal.h"
+#include "flight/hal.h"
+#include "hal/hal_host.h"
+#include "hal/log_source.h"
+#include "hal/host_tool.h"
+#include "./version.h"
+#if defined(FLIGHT_BENCH_OPS)
+#include "timing_model/op_count.h"
+#endif
+
+namespace {
+static constexpr int64_t FRAME_PERIOD_US = FRAME_PERIOD_MS * 1000;
+/* Main loop time step while replaying, us */
+static constexpr int64_t BACKGROUND_STEP_US_ = 50;
+/* The datalog written while benchmarking is discarded */
+static constexpr char NULL_DEVICE_[] = "/dev/null";
+/* Uploaded flight plan, a circuit about home, m */
+static constexpr double PLAN_RADIUS_M_ = 500;
+static constexpr float PLAN_ALT_M_ = 100;
+/* Run settings */
+struct Options {
+  std::size_t frames = 20000;
+  std::size_t repeats = 5;
+  std::string json = "flight_bench.json";
+  std::string ops;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "frames") {
+    opt->frames = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->frames == 0) {return false;}
+  } else if (key == "repeats") {
+    opt->repeats = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->repeats == 0) {return false;}
+  } else if (key == "json") {
+    opt->json = val;
+  } else if (key == "ops") {
+    opt->ops = val;
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Module inputs and outputs of a recorded frame */
+struct Frame {
+  SysData sys;
+  SensorData sensor;
+  NavData nav;
+  VmsData vms;
+};
+/* Fastest time of each call over the repeats, ns */
+struct Result {
+  std::string name;
+  std::vector<double> time_ns;
+};
+/* Keeps the compiler from eliding or hoisting the stores to an object */
+template <typename T>
+inline void KeepStores(const T &obj) {
+  asm volatile("" : : "r"(&obj) : "memory");
+}
+/* Times a call, less the timer overhead, keeping the fastest */
+double timer_ns = 0;
+template <typename F>
+void Time(const std::size_t i, F &&f, Result * const res) {
+  #if defined(FLIGHT_BENCH_OPS)
+  OpCountBegin(res->name.c_str());
+  #endif
+  auto t0 = std::chrono::steady_clock::now();
+  f();
+  auto t1 = std::chrono::steady_clock::now();
+  #if defined(FLIGHT_BENCH_OPS)
+  OpCountEnd();
+  #endif
+  double t = std::max(0.0, std::chrono::duration<double, std::nano>(
+                             t1 - t0).count() - timer_ns);
+  if (i < res->time_ns.size()) {
+    res->time_ns[i] = std::min(res->time_ns[i], t);
+  } else {
+    res->time_ns.push_back(t);
+  }
+}
+/* Median time of an empty timed region, ns */
+double TimerOverhead() {
+  std::vector<double> t(10000);
+  for (double &v : t) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto t1 = std::chrono::steady_clock::now();
+    v = std::chrono::duration<double, std::nano>(t1 - t0).count();
+  }
+  std::nth_element(t.begin(), t.begin() + t.size() / 2, t.end());
+  return t[t.size() / 2];
+}
+/* Statistics of the call times */
+struct Stats {
+  std::size_t calls;
+  double mean, median, p99, max;
+};
+Stats Summarize(const std::vector<double> &t) {
+  Stats s = {};
+  s.calls = t.size();
+  if (t.empty()) {return s;}
+  std::vector<double> sorted = t;
+  std::sort(sorted.begin(), sorted.end());
+  for (double v : sorted) {s.mean += v;}
+  s.mean /= static_cast<double>(sorted.size());
+  s.median = sorted[(sorted.size() - 1) / 2];
+  s.p99 = sorted[static_cast<std::size_t>(0.99 * (sorted.size() - 1))];
+  s.max = sorted.back();
+  return s;
+}
+/* Flight plan of the largest upload, about the recorded home */
+void FlightPlan(const NavData &home, TelemData * const telem) {
+  static constexpr double RAD2DEG = 180.0 / std::numbers::pi;
+  static constexpr double EARTH_RADIUS_M = 6378137.0;
+  double dlat = PLAN_RADIUS_M_ / EARTH_RADIUS_M;
+  double dlon = dlat / std::cos(home.home_lat_rad);
+  std::size_t n = telem->flight_plan.size();
+  for (std::size_t i = 0; i < n; i++) {
+    double a = 2 * std::numbers::pi * static_cast<double>(i) /
+               static_cast<double>(n);
+    bfs::MissionItem &item = telem->flight_plan[i];
+    item = {};
+    item.autocontinue = true;
+    item.x = static_cast<int32_t>(std::lround(
+      (home.home_lat_rad + dlat * std::cos(a)) * RAD2DEG * 1e7));
+    item.y = static_cast<int32_t>(std::lround(
+      (home.home_lon_rad + dlon * std::sin(a)) * RAD2DEG * 1e7));
+    item.z = PLAN_ALT_M_;
+  }
+  telem->num_waypoints = static_cast<int16_t>(n);
+}
+/* Aircraft data, large, so kept off the stack */
+AircraftData data;
+TelemData plan;
+VmsTelemData view;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (argc < 2) {
+    std::cerr << "Usage:  " << argv[0] << " <FLIGHT DATA FILE> "
+              << "[--frames=20000] [--repeats=5] [--json=flight_bench.json] "
+              << "[--ops=flight_bench.ops]" << std::endl;
+    return -1;
+  }
+  if (!HostParseArgs(argc, argv, 2, ParseOption, &opt)) {
+    return -1;
+  }
+  #if !defined(FLIGHT_BENCH_OPS)
+  if (!opt.ops.empty()) {
+    std::cerr << "ERROR: Operation counts need a build with OP_COUNT"
+              << std::endl;
+    return -1;
+  }
+  #endif
+  LogSource log;
+  if (!log.Open(argv[1])) {
+    std::cerr << "ERROR: Unable to open input file, maybe the path is "
+              << "incorrect." << std::endl;
+    return -1;
+  }
+  if (!log.Next()) {
+    std::cerr << "ERROR: Input file has no datalog messages." << std::endl;
+    return -1;
+  }
+  /* Replay the log through the frame, keeping the module data */
+  HalHostSource(&log);
+  HalHostStoragePath(NULL_DEVICE_);
+  HalHostTime(log.time_us() - FRAME_PERIOD_US);
+  FrameInit(&data);
+  int64_t offset_us = std::max<int64_t>(0, HalMicros() - log.time_us() +
+                                           FRAME_PERIOD_US);
+  std::vector<Frame> frames;
+  frames.reserve(opt.frames);
+  do {
+    int64_t t_us = log.time_us() + offset_us;
+    while (HalMicros() + BACKGROUND_STEP_US_ < t_us) {
+      HalHostTime(HalMicros() + BACKGROUND_STEP_US_);
+      FrameBackground();
+    }
+    HalHostTime(t_us);
+    FrameRun(&data);
+    EffectorsWrite();
+    frames.push_back({data.sys, data.sensor, data.nav, data.vms});
+  } while ((frames.size() < opt.frames) && log.Next());
+  HalHostSource(nullptr);
+  std::cout << std::endl << "Recorded frames: " << frames.size()
+            << std::endl;
+  /* Home of the uploaded flight plan */
+  auto home = std::find_if(frames.begin(), frames.end(),
+                           [](const Frame &f) {
+                             return f.nav.nav_initialized;
+                           });
+  FlightPlan((home != frames.end()) ? home->nav : frames.front().nav, &plan);
+  /* Benchmarks */
+  timer_ns = TimerOverhead();
+  Result nav_steady = {"nav_run", {}}, nav_gnss = {"nav_run_gnss", {}};
+  Result datalog = {"datalog_add", {}}, effectors = {"effectors_cmd", {}};
+  Result param = {"param_update", {}}, vms = {"vms_run", {}};
+  Result plan_view = {"vms_telem_plan", {}};
+  for (std::size_t rep = 0; rep < opt.repeats; rep++) {
+    /* Nav filter, from initialization on the recorded sensor data */
+    NavInit(config.nav);
+    std::size_t n_steady = 0, n_gnss = 0;
+    for (const Frame &f : frames) {
+      /* Frames before the filter initializes aren't counted */
+      if (!f.nav.nav_initialized) {
+        NavRun(f.sensor, &data.nav);
+      } else if (f.sensor.gnss.new_data) {
+        Time(n_gnss++, [&f]() {NavRun(f.sensor, &data.nav);}, &nav_gnss);
+      } else {
+        Time(n_steady++, [&f]() {NavRun(f.sensor, &data.nav);}, &nav_steady);
+      }
+      KeepStores(data.nav);
+    }
+    /*
+    * VMS, datalog, and effectors on the recorded frame data,
+    * the VMS running on from its state at the end of the replay
+    */
+    for (std::size_t i = 0; i < frames.size(); i++) {
+      data.sys = frames[i].sys;
+      data.sensor = frames[i].sensor;
+      data.nav = frames[i].nav;
+      Time(i, []() {
+        VmsRun(data.sys, data.sensor, data.nav, data.telem, &data.vms);
+      }, &vms);
+      KeepStores(data.vms);
+      data.vms = frames[i].vms;
+      Time(i, []() {DatalogAdd(data);}, &datalog);
+      Time(i, [&]() {EffectorsCmd(frames[i].vms);}, &effectors);
+    }
+    DatalogFlush();
+    /* Parameter stores, the recorded airspeed set to each in turn */
+    for (std::size_t i = 0; i < frames.size(); i++) {
+      int32_t idx = static_cast<int32_t>(i % NUM_TELEM_PARAMS);
+      float val = frames[i].nav.ias_mps;
+      Time(i, [idx, val]() {ParamStoreWrite(idx, val);}, &param);
+    }
+    /*
+    * VMS telemetry view after a flight plan upload: the completed plan is
+    * copied into the telemetry data and the view rebuilt at the active
+    * waypoint. The MAVLink mission protocol itself isn't timed.
+    */
+    for (std::size_t i = 0; i < frames.size(); i++) {
+      plan.waypoints_updated = true;
+      plan.current_waypoint = static_cast<int16_t>(
+        i % plan.flight_plan.size());
+      Time(i, []() {
+        data.telem.flight_plan = plan.flight_plan;
+        data.telem.num_waypoints = plan.num_waypoints;
+        data.telem.current_waypoint = plan.current_waypoint;
+        data.telem.waypoints_updated = plan.waypoints_updated;
+        VmsTelemUpdate(data.telem, &view);
+      }, &plan_view);
+      KeepStores(view);
+    }
+  }
+  DatalogClose();
+  #if defined(FLIGHT_BENCH_OPS)
+  /* Timing calibration kernels, counted once each */
+  for (std::size_t k = 0; k < NUM_TIMING_KERNELS; k++) {
+    std::string name = std::string("kernel:") + TimingKernelName(k);
+    OpCountBegin(name.c_str());
+    TimingKernelRun(k);
+    OpCountEnd();
+  }
+  #endif
+  /* Report */
+  std::vector<const Result *> results = {&nav_steady, &nav_gnss, &vms,
+                                         &datalog, &effectors, &param,
+                                         &plan_view};
+  std::cout << "Repeats: " << opt.repeats << ", timer overhead: "
+            << std::fixed << std::setprecision(1) << timer_ns << " ns"
+            << std::endl;
+  std::cout << std::left << std::setw(16) << "Benchmark" << std::right
+            << std::setw(8) << "Calls" << std::setw(12) << "Mean ns"
+            << std::setw(12) << "Median ns" << std::setw(12) << "99% ns"
+            << std::setw(12) << "Max ns" << std::endl;
+  std::ofstream json(opt.json);
+  if (!json) {
+    std::cerr << "ERROR: Unable to write " << opt.json << std::endl;
+    return -1;
+  }
+  json << std::fixed << std::setprecision(1) << "{\n"
+       << "  \"context\": {\n"
+       << "    \"version\": \"" << PROJECT_VERSION << "\",\n"
+       << "    \"frame_period_ms\": " << FRAME_PERIOD_MS << ",\n"
+       << "    \"frames\": " << frames.size() << ",\n"
+       << "    \"repeats\": " << opt.repeats << ",\n"
+       << "    \"timer_overhead_ns\": " << timer_ns << "\n"
+       << "  },\n"
+       << "  \"benchmarks\": [\n";
+  for (std::size_t i = 0; i < results.size(); i++) {
+    Stats s = Summarize(results[i]->time_ns);
+    std::cout << std::left << std::setw(16) << results[i]->name
+              << std::right << std::setw(8) << s.calls << std::setw(12)
+              << s.mean << std::setw(12) << s.median << std::setw(12)
+              << s.p99 << std::setw(12) << s.max << std::endl;
+    json << "    {\"name\": \"" << results[i]->name << "\", \"calls\": "
+         << s.calls << ", \"mean_ns\": " << s.mean << ", \"median_ns\": "
+         << s.median << ", \"p99_ns\": " << s.p99 << ", \"max_ns\": "
+         << s.max << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+  }
+  json << "  ]\n}\n";
+  std::cout << "Wrote " << opt.json << std::endl;
+  #if defined(FLIGHT_BENCH_OPS)
+  if (!opt.ops.empty()) {
+    if (!OpCountWrite(opt.ops, FRAME_PERIOD_MS, VMS_BUDGET_FRAC)) {
+      std::cerr << "ERROR: Unable to write " << opt.ops << std::endl;
+      return -1;
+    }
+    std::cout << "Wrote " << opt.ops << std::endl;
+  }
+  #endif
+  return 0;
+}
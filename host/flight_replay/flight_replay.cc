@@ -0,0 +1,296 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Runs the flight software frame on the host against a recorded flight
+* datalog. Devices return the logged sensor data through the host
+* hardware abstraction layer; nav, VMS, effector commands, and the datalog
+* run as they do on the FMU, and a new datalog is written for comparison
+* with the original. Frames run as fast as the host allows, the main loop
+* is serviced between frames in fixed time steps, and the host time spent
+* in each frame is reported. Optionally, every output of each frame - nav,
+* VMS, and the effector commands written - is traced to a CSV file for the
+* replay regression suite. Telemetry on the host is a stand-in without the
+* MAVLink library, so it isn't traced.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "flight/global_defs.h"
+#include "flight/frame.h"
+#include "flight/effectors.h"
+#include "flight/datalog.h"
+#include "flight/hal.h"
+#include "hal/hal_host.h"
+#include "hal/log_source.h"
+#include "hal/host_tool.h"
+
+namespace {
+static constexpr int64_t FRAME_PERIOD_US = FRAME_PERIOD_MS * 1000;
+/* Replay settings */
+struct Options {
+  std::string output = "replay.bfs";
+  std::string trace;
+  int64_t background_step_us = 50;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "out") {
+    opt->output = val;
+  } else if (key == "trace") {
+    opt->trace = val;
+  } else if (key == "background-us") {
+    opt->background_step_us = std::strtoll(val.c_str(), nullptr, 10);
+    if (opt->background_step_us <= 0) {return false;}
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Logged device data, keeping the effector commands written each frame */
+class ReplaySource : public LogSource {
+ public:
+  void Effectors(const SbusCmd &sbus, const PwmCmd &pwm) override {
+    sbus_ = sbus;
+    pwm_ = pwm;
+  }
+  inline const SbusCmd & sbus() const {return sbus_;}
+  inline const PwmCmd & pwm() const {return pwm_;}
+
+ private:
+  SbusCmd sbus_ = {};
+  PwmCmd pwm_ = {};
+};
+/*
+* A row of the frame trace. Values are printed with enough digits to
+* round trip, so equal text means bit equal outputs; the column names are
+* collected as the first row is built and written as the header.
+*/
+class TraceRow {
+ public:
+  void Add(const char *name, const double val) {
+    Print(name, "%.17g", val);
+  }
+  void Add(const char *name, const float val) {
+    Print(name, "%.9g", static_cast<double>(val));
+  }
+  void Add(const char *name, const int64_t val) {
+    Print(name, "%lld", static_cast<long long>(val));
+  }
+  template<typename T, std::size_t N>
+  void Add(const char *name, const std::array<T, N> &val) {
+    for (std::size_t i = 0; i < N; i++) {
+      std::snprintf(elem_, sizeof(elem_), "%s[%zu]", name, i);
+      if constexpr (std::is_floating_point_v<T>) {
+        Add(elem_, val[i]);
+      } else {
+        Add(elem_, static_cast<int64_t>(val[i]));
+      }
+    }
+  }
+  /* Writes the row, preceded by the header on the first, and starts over */
+  void Write(FILE *file) {
+    if (!header_done_) {
+      std::fprintf(file, "%s\n", header_.c_str());
+      header_done_ = true;
+    }
+    std::fprintf(file, "%s\n", row_.c_str());
+    row_.clear();
+  }
+
+ private:
+  bool header_done_ = false;
+  std::string header_, row_;
+  char elem_[64], val_[32];
+  void Print(const char *name, const char *fmt, const double val) {
+    std::snprintf(val_, sizeof(val_), fmt, val);
+    Append(name);
+  }
+  void Print(const char *name, const char *fmt, const long long val) {
+    std::snprintf(val_, sizeof(val_), fmt, val);
+    Append(name);
+  }
+  void Append(const char *name) {
+    if (!header_done_) {
+      if (!header_.empty()) {header_ += ',';}
+      header_ += name;
+    }
+    if (!row_.empty()) {row_ += ',';}
+    row_ += val_;
+  }
+};
+/* Traces the outputs of a frame */
+void Trace(const int64_t t_us, const AircraftData &d, const ReplaySource &src,
+           TraceRow * const row) {
+  row->Add("time_us", t_us);
+  /* Nav */
+  const NavData &nav = d.nav;
+  row->Add("nav.nav_initialized", static_cast<int64_t>(nav.nav_initialized));
+  row->Add("nav.pitch_rad", nav.pitch_rad);
+  row->Add("nav.roll_rad", nav.roll_rad);
+  row->Add("nav.heading_rad", nav.heading_rad);
+  row->Add("nav.alt_wgs84_m", nav.alt_wgs84_m);
+  row->Add("nav.home_alt_wgs84_m", nav.home_alt_wgs84_m);
+  row->Add("nav.alt_msl_m", nav.alt_msl_m);
+  row->Add("nav.alt_rel_m", nav.alt_rel_m);
+  row->Add("nav.static_pres_pa", nav.static_pres_pa);
+  row->Add("nav.diff_pres_pa", nav.diff_pres_pa);
+  row->Add("nav.alt_pres_m", nav.alt_pres_m);
+  row->Add("nav.ias_mps", nav.ias_mps);
+  row->Add("nav.gnd_spd_mps", nav.gnd_spd_mps);
+  row->Add("nav.gnd_track_rad", nav.gnd_track_rad);
+  row->Add("nav.flight_path_rad", nav.flight_path_rad);
+  row->Add("nav.accel_bias_mps2", nav.accel_bias_mps2);
+  row->Add("nav.gyro_bias_radps", nav.gyro_bias_radps);
+  row->Add("nav.accel_mps2", nav.accel_mps2);
+  row->Add("nav.gyro_radps", nav.gyro_radps);
+  row->Add("nav.mag_ut", nav.mag_ut);
+  row->Add("nav.ned_pos_m", nav.ned_pos_m);
+  row->Add("nav.ned_vel_mps", nav.ned_vel_mps);
+  row->Add("nav.lat_rad", nav.lat_rad);
+  row->Add("nav.lon_rad", nav.lon_rad);
+  row->Add("nav.home_lat_rad", nav.home_lat_rad);
+  row->Add("nav.home_lon_rad", nav.home_lon_rad);
+  /* VMS */
+  const VmsData &vms = d.vms;
+  row->Add("vms.motors_enabled", static_cast<int64_t>(vms.motors_enabled));
+  row->Add("vms.waypoint_reached",
+           static_cast<int64_t>(vms.waypoint_reached));
+  row->Add("vms.mode", static_cast<int64_t>(vms.mode));
+  row->Add("vms.throttle_cmd_prcnt", vms.throttle_cmd_prcnt);
+  row->Add("vms.aux", vms.aux);
+  row->Add("vms.sbus.ch17", static_cast<int64_t>(vms.sbus.ch17));
+  row->Add("vms.sbus.ch18", static_cast<int64_t>(vms.sbus.ch18));
+  row->Add("vms.sbus.cnt", vms.sbus.cnt);
+  row->Add("vms.sbus.cmd", vms.sbus.cmd);
+  row->Add("vms.pwm.cnt", vms.pwm.cnt);
+  row->Add("vms.pwm.cmd", vms.pwm.cmd);
+  row->Add("vms.analog.val", vms.analog.val);
+  #if defined(__FMU_R_V2__)
+  row->Add("vms.battery.voltage_v", vms.battery.voltage_v);
+  row->Add("vms.battery.current_ma", vms.battery.current_ma);
+  row->Add("vms.battery.consumed_mah", vms.battery.consumed_mah);
+  row->Add("vms.battery.remaining_prcnt", vms.battery.remaining_prcnt);
+  row->Add("vms.battery.remaining_time_s", vms.battery.remaining_time_s);
+  #endif
+  /* Effector commands written */
+  row->Add("eff.sbus.ch17", static_cast<int64_t>(src.sbus().ch17));
+  row->Add("eff.sbus.ch18", static_cast<int64_t>(src.sbus().ch18));
+  row->Add("eff.sbus.cnt", src.sbus().cnt);
+  row->Add("eff.pwm.cnt", src.pwm().cnt);
+}
+/* Aircraft data */
+AircraftData data;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (argc < 2) {
+    std::cerr << "Usage:  " << argv[0] << " <FLIGHT DATA FILE> "
+              << "[--out=replay.bfs] [--trace=file.csv] [--background-us=50]"
+              << std::endl;
+    return -1;
+  }
+  if (!HostParseArgs(argc, argv, 2, ParseOption, &opt)) {
+    return -1;
+  }
+  ReplaySource log;
+  if (!log.Open(argv[1])) {
+    std::cerr << "ERROR: Unable to open input file, maybe the path is "
+              << "incorrect." << std::endl;
+    return -1;
+  }
+  if (!log.Next()) {
+    std::cerr << "ERROR: Input file has no datalog messages." << std::endl;
+    return -1;
+  }
+  FILE *trace = nullptr;
+  TraceRow row;
+  if (!opt.trace.empty()) {
+    trace = std::fopen(opt.trace.c_str(), "w");
+    if (!trace) {
+      std::cerr << "ERROR: Unable to open " << opt.trace << std::endl;
+      return -1;
+    }
+  }
+  /* Init the flight software one frame before the first logged frame */
+  HalHostSource(&log);
+  HalHostStoragePath(opt.output);
+  HalHostTime(log.time_us() - FRAME_PERIOD_US);
+  FrameInit(&data);
+  /* Init may have waited on devices, shift the log to follow it */
+  int64_t offset_us = std::max<int64_t>(0, HalMicros() - log.time_us() +
+                                           FRAME_PERIOD_US);
+  /* Frames */
+  std::size_t num_frames = 0;
+  double frame_sum_us = 0, frame_max_us = 0;
+  int64_t t0_us = log.time_us() + offset_us;
+  int64_t t_us = t0_us;
+  auto start = std::chrono::steady_clock::now();
+  do {
+    t_us = log.time_us() + offset_us;
+    /* Main loop until the frame */
+    while (HalMicros() + opt.background_step_us < t_us) {
+      HalHostTime(HalMicros() + opt.background_step_us);
+      FrameBackground();
+    }
+    HalHostTime(t_us);
+    auto frame_start = std::chrono::steady_clock::now();
+    FrameRun(&data);
+    EffectorsWrite();
+    double frame_us = std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - frame_start).count();
+    frame_sum_us += frame_us;
+    frame_max_us = std::max(frame_max_us, frame_us);
+    if (trace) {
+      Trace(t_us, data, log, &row);
+      row.Write(trace);
+    }
+    num_frames++;
+  } while (log.Next());
+  FrameBackground();
+  DatalogClose();
+  if (trace) {std::fclose(trace);}
+  double wall_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  double sim_s = static_cast<double>(t_us - t0_us) / 1e6;
+  std::cout << std::endl << "Frames: " << num_frames << std::endl
+            << "Flight time: " << sim_s << " s, host time: " << wall_s
+            << " s (" << (wall_s > 0 ? sim_s / wall_s : 0)
+            << "x real time)" << std::endl
+            << "Host frame time: mean " << frame_sum_us / num_frames
+            << " us, max " << frame_max_us << " us" << std::endl
+            << "Wrote " << opt.output << std::endl;
+  if (trace) {std::cout << "Wrote " << opt.trace << std::endl;}
+  return 0;
+}
@@ -0,0 +1,270 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Software in the loop: runs the flight software frame on the host
+* against a simulation model, closing the loop through the effector
+* commands. Devices return simulated sensor data through the host
+* hardware abstraction layer; nav, VMS, effector commands, and the
+* datalog run as they do on the FMU. The aircraft is a six degree of
+* freedom model loaded from an exported aircraft data file, flying in
+* steady wind and turbulence, or sits on the ground at home when none is
+* given. A flight plan can be uploaded as if from a ground station, and
+* the run is scored against it in an optional summary. Time is simulated,
+* so the run is as fast as the host allows and repeatable for a given
+* seed.
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+#include "flight/frame.h"
+#include "flight/effectors.h"
+#include "flight/datalog.h"
+#include "flight/hal.h"
+#include "hal/hal_host.h"
+#include "hal/host_tool.h"
+#include "sil/aircraft_params.h"
+#include "sil/aircraft_model.h"
+#include "sil/ground_model.h"
+#include "sil/mission.h"
+#include "sil/sim_source.h"
+#include "sil/wind.h"
+
+namespace {
+static constexpr int64_t FRAME_PERIOD_US = FRAME_PERIOD_MS * 1000;
+static constexpr double DEG2RAD = std::numbers::pi / 180.0;
+/* Run settings */
+struct Options {
+  std::string output = "sil.bfs";
+  int64_t background_step_us = 50;
+  double duration_s = 60;
+  uint32_t seed = 0;
+  /* Aircraft data file, the aircraft sits on the ground if not given */
+  std::string aircraft;
+  /* Mass scale factor and CG offset, body axes, m */
+  double mass_scale = 1;
+  Vec3 cg_offset_m = {0, 0, 0};
+  WindConfig wind;
+  /* Flight plan and run summary, not used if empty */
+  std::string mission;
+  std::string summary;
+  /* Home, defaults to the simulation config target */
+  SimHome home = {35.691544 * DEG2RAD, -105.944183 * DEG2RAD, 100};
+  /* Inceptor channel settings, channel and count */
+  std::array<int16_t, NUM_SBUS_CH> ch = {};
+  std::array<bool, NUM_SBUS_CH> ch_set = {};
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "out") {
+    opt->output = val;
+  } else if (key == "background-us") {
+    opt->background_step_us = std::strtoll(val.c_str(), nullptr, 10);
+    if (opt->background_step_us <= 0) {return false;}
+  } else if (key == "duration-s") {
+    opt->duration_s = std::strtod(val.c_str(), nullptr);
+    if (opt->duration_s <= 0) {return false;}
+  } else if (key == "seed") {
+    opt->seed = static_cast<uint32_t>(std::strtoul(val.c_str(), nullptr,
+                                                   10));
+  } else if (key == "lat") {
+    opt->home.lat_rad = std::strtod(val.c_str(), nullptr) * DEG2RAD;
+  } else if (key == "lon") {
+    opt->home.lon_rad = std::strtod(val.c_str(), nullptr) * DEG2RAD;
+  } else if (key == "alt") {
+    opt->home.alt_m = std::strtod(val.c_str(), nullptr);
+  } else if (key == "heading") {
+    opt->home.heading_rad = std::strtod(val.c_str(), nullptr) * DEG2RAD;
+  } else if (key == "aircraft") {
+    opt->aircraft = val;
+  } else if (key == "mass-scale") {
+    opt->mass_scale = std::strtod(val.c_str(), nullptr);
+    if (opt->mass_scale <= 0) {return false;}
+  } else if (key == "cg-x") {
+    opt->cg_offset_m[0] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "cg-y") {
+    opt->cg_offset_m[1] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "cg-z") {
+    opt->cg_offset_m[2] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "mission") {
+    opt->mission = val;
+  } else if (key == "summary") {
+    opt->summary = val;
+  } else if (key == "wind-n") {
+    opt->wind.ned_mps[0] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "wind-e") {
+    opt->wind.ned_mps[1] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "wind-d") {
+    opt->wind.ned_mps[2] = std::strtod(val.c_str(), nullptr);
+  } else if (key == "turb") {
+    opt->wind.turb_sigma_mps = std::strtod(val.c_str(), nullptr);
+    if (opt->wind.turb_sigma_mps < 0) {return false;}
+  } else if (key == "ch") {
+    /* Channel number, 1-based, and count, i.e. --ch=5:1811 */
+    std::size_t colon = val.find(':');
+    if (colon == std::string::npos) {return false;}
+    long ch = std::strtol(val.substr(0, colon).c_str(), nullptr, 10);
+    if ((ch < 1) || (ch > static_cast<long>(NUM_SBUS_CH))) {return false;}
+    opt->ch[ch - 1] = static_cast<int16_t>(
+      std::strtol(val.substr(colon + 1).c_str(), nullptr, 10));
+    opt->ch_set[ch - 1] = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+/*
+* Disperses the mass properties: mass and inertia scale together and the
+* CG moves, which moves the motors relative to it.
+*/
+void Disperse(const Options &opt, AircraftParams * const p) {
+  p->Set("Mass.mass_kg", 0, 0, opt.mass_scale * p->Get("Mass.mass_kg"));
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {
+      p->Set("Mass.inertia_kgm2", i, j,
+             opt.mass_scale * p->Get("Mass.inertia_kgm2", i, j));
+    }
+    p->Set("Mass.cg_m", 0, i, p->Get("Mass.cg_m", 0, i) + opt.cg_offset_m[i]);
+    for (std::size_t m = 0; m < p->rows("Motor.pos_m"); m++) {
+      p->Set("Motor.pos_m", m, i,
+             p->Get("Motor.pos_m", m, i) - opt.cg_offset_m[i]);
+    }
+  }
+}
+/* Aircraft data */
+AircraftData data;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " [--duration-s=60] "
+              << "[--out=sil.bfs] [--seed=0] [--aircraft=file.dat] "
+              << "[--lat=deg] [--lon=deg] [--alt=m] [--heading=deg] "
+              << "[--wind-n=mps] [--wind-e=mps] [--wind-d=mps] "
+              << "[--turb=mps] [--mass-scale=1] [--cg-x=m] [--cg-y=m] "
+              << "[--cg-z=m] [--mission=file] [--summary=file.csv] "
+              << "[--ch=N:COUNT] [--background-us=50]" << std::endl;
+    return -1;
+  }
+  /* Aircraft model */
+  GroundModel ground;
+  AircraftModel aircraft;
+  SimModel *model = &ground;
+  SimSensorConfig sensor_cfg;
+  if (!opt.aircraft.empty()) {
+    AircraftParams params;
+    if (!params.Load(opt.aircraft)) {
+      std::cerr << "ERROR: Unable to load aircraft data " << opt.aircraft
+                << std::endl;
+      return -1;
+    }
+    Disperse(opt, &params);
+    if (!aircraft.Config(params, opt.wind, opt.seed)) {
+      std::cerr << "ERROR: Aircraft is not supported by the host models."
+                << std::endl;
+      return -1;
+    }
+    model = &aircraft;
+    /* Power module gains, when given */
+    if (params.Has("Battery.voltage_gain")) {
+      sensor_cfg.pwr_mod_volt_scale = 1 / params.Get("Battery.voltage_gain");
+    }
+    if (params.Has("Battery.current_to_voltage_gain_vpma")) {
+      sensor_cfg.pwr_mod_curr_scale = 1000 /
+        params.Get("Battery.current_to_voltage_gain_vpma");
+    }
+  }
+  SimSource sim(model, opt.home, sensor_cfg, opt.seed);
+  for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
+    if (opt.ch_set[i]) {sim.inceptor_ch(i, opt.ch[i]);}
+  }
+  HalHostSource(&sim);
+  HalHostStoragePath(opt.output);
+  /* Flight plan */
+  std::vector<bfs::MissionItem> plan;
+  if (!opt.mission.empty() && !MissionLoad(opt.mission, &plan)) {
+    std::cerr << "ERROR: Unable to load flight plan " << opt.mission
+              << std::endl;
+    return -1;
+  }
+  HalHostFlightPlan(plan);
+  MissionTracker tracker;
+  tracker.Init(opt.home, plan);
+  HalHostTime(0);
+  FrameInit(&data);
+  /* Frames */
+  std::size_t num_frames = 0;
+  int64_t t0_us = HalMicros() + FRAME_PERIOD_US;
+  int64_t t_end_us = t0_us + static_cast<int64_t>(opt.duration_s * 1e6);
+  int64_t t_us = t0_us;
+  auto start = std::chrono::steady_clock::now();
+  for (; t_us < t_end_us; t_us += FRAME_PERIOD_US) {
+    /* Main loop until the frame */
+    while (HalMicros() + opt.background_step_us < t_us) {
+      HalHostTime(HalMicros() + opt.background_step_us);
+      FrameBackground();
+    }
+    HalHostTime(t_us);
+    FrameRun(&data);
+    EffectorsWrite();
+    tracker.Update(FRAME_PERIOD_US / 1e6, sim.state(),
+                   data.vms.waypoint_reached);
+    num_frames++;
+  }
+  FrameBackground();
+  DatalogClose();
+  double wall_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  double sim_s = static_cast<double>(t_us - t0_us) / 1e6;
+  const SimState &s = sim.state();
+  std::cout << std::endl << "Frames: " << num_frames << std::endl
+            << "Simulated time: " << sim_s << " s, host time: " << wall_s
+            << " s (" << (wall_s > 0 ? sim_s / wall_s : 0)
+            << "x real time)" << std::endl
+            << "Final NED position: " << s.ned_pos_m[0] << ", "
+            << s.ned_pos_m[1] << ", " << s.ned_pos_m[2] << " m" << std::endl
+            << "Wrote " << opt.output << std::endl;
+  if (!opt.summary.empty()) {
+    std::ofstream summary(opt.summary);
+    summary << MissionStatsHeader() << std::endl
+            << MissionStatsRow(tracker.stats()) << std::endl;
+    if (!summary) {
+      std::cerr << "ERROR: Unable to write summary " << opt.summary
+                << std::endl;
+      return -1;
+    }
+    std::cout << "Wrote " << opt.summary << std::endl;
+  }
+  return 0;
+}
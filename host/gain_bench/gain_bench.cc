@@ -0,0 +1,294 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Checks the gain tables and times them. The checks cover values at the
+* breakpoints, linear and bilinear interpolation against a direct double
+* precision evaluation over random points on uniform and arbitrary axes,
+* held lookups beyond the ends and on a NaN input, the run time lookup for
+* autocode against the templated table, loading values from parameters,
+* and the parameter check the control law runs before loading a schedule
+* from the ground station. Each lookup is then timed per call. The run fails if any check
+* fails.
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "flight/gain_table.h"
+#include "hal/host_tool.h"
+
+namespace {
+static constexpr float TOL_ = 1e-5f;
+/* The size of the baseline control law schedule, and a larger table */
+static constexpr std::size_t NX_ = 4, NY_ = 2, M_ = 2;
+static constexpr std::size_t BIG_NX_ = 12, BIG_NY_ = 8, BIG_M_ = 16;
+using Small = GainTable<float, NX_, NY_, M_>;
+using Big = GainTable<float, BIG_NX_, BIG_NY_, BIG_M_>;
+/* Run settings */
+struct Options {
+  std::size_t trials = 100000;
+  uint64_t seed = 0;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "trials") {
+    opt->trials = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->trials == 0) {return false;}
+  } else if (key == "seed") {
+    opt->seed = std::strtoull(val.c_str(), nullptr, 10);
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Check results */
+HostChecks checks;
+bool Near(const double a, const double b) {
+  return std::abs(a - b) <= TOL_ * std::max(1.0, std::abs(b));
+}
+/* Direct evaluation: interval and fraction of x, held at the ends */
+template <std::size_t N>
+void Locate(const std::array<float, N> &bp, const double x,
+            std::size_t * const i, double * const f) {
+  *i = 0;
+  *f = 0;
+  if (N < 2) {return;}
+  while ((*i < N - 2) && (x >= bp[*i + 1])) {(*i)++;}
+  *f = std::clamp((x - bp[*i]) / (static_cast<double>(bp[*i + 1]) -
+                                  bp[*i]), 0.0, 1.0);
+}
+template <std::size_t NX, std::size_t NY, std::size_t M>
+std::array<double, M> Reference(
+    const std::array<float, NX> &xb, const std::array<float, NY> &yb,
+    const typename GainTable<float, NX, NY, M>::Values &val,
+    const double x, const double y) {
+  std::size_t i, j;
+  double fx, fy;
+  Locate(xb, x, &i, &fx);
+  Locate(yb, y, &j, &fy);
+  std::size_t ix = std::min(i + 1, NX - 1), jy = std::min(j + 1, NY - 1);
+  std::array<double, M> out;
+  for (std::size_t k = 0; k < M; k++) {
+    out[k] = (1 - fx) * (1 - fy) * val[i][j][k] +
+             (1 - fx) * fy * val[i][jy][k] + fx * (1 - fy) * val[ix][j][k] +
+             fx * fy * val[ix][jy][k];
+  }
+  return out;
+}
+/* Increasing breakpoints with random spacing */
+template <std::size_t N>
+std::array<float, N> Breakpoints(std::mt19937_64 * const rng,
+                                 const float min) {
+  std::uniform_real_distribution<float> dx(0.5f, 5);
+  std::array<float, N> bp;
+  bp[0] = min;
+  for (std::size_t i = 1; i < N; i++) {bp[i] = bp[i - 1] + dx(*rng);}
+  return bp;
+}
+/* Table values, flattened in the order they are indexed */
+template <std::size_t NX, std::size_t NY, std::size_t M>
+void Flatten(const typename GainTable<float, NX, NY, M>::Values &val,
+             std::vector<float> * const flat) {
+  flat->clear();
+  for (const auto &row : val) {
+    for (const auto &cell : row) {
+      flat->insert(flat->end(), cell.begin(), cell.end());
+    }
+  }
+}
+/* Lookups timed, kept at file scope so the calls can't be elided */
+std::array<float, M_> small_out;
+std::array<float, BIG_M_> big_out;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " [--trials=100000] [--seed=0]"
+              << std::endl;
+    return -1;
+  }
+  std::mt19937_64 rng(opt.seed);
+  std::uniform_real_distribution<float> gain(0.1f, 3);
+  /* Small table on a uniform and an arbitrary axis */
+  auto small_x = GainAxis<float, NX_>::Uniform(10, 25);
+  std::array<float, NX_> small_xb = {10, 15, 20, 25};
+  std::array<float, NY_> small_yb = {0, 300};
+  Small::Values small_val;
+  for (auto &row : small_val) {
+    for (auto &cell : row) {
+      for (float &v : cell) {v = gain(rng);}
+    }
+  }
+  Small small(small_x, GainAxis<float, NY_>(small_yb), small_val);
+  /* Values at the breakpoints */
+  bool pass = true;
+  for (std::size_t i = 0; i < NX_; i++) {
+    for (std::size_t j = 0; j < NY_; j++) {
+      std::array<float, M_> g = small.Lookup(small_xb[i], small_yb[j]);
+      for (std::size_t k = 0; k < M_; k++) {
+        pass = pass && Near(g[k], small_val[i][j][k]);
+      }
+    }
+  }
+  checks.Check(pass, "values at the breakpoints");
+  /* Held beyond the ends */
+  std::array<float, M_> lo = small.Lookup(-100, -100);
+  std::array<float, M_> hi = small.Lookup(100, 1000);
+  checks.Check(Near(lo[0], small_val[0][0][0]) &&
+               Near(lo[1], small_val[0][0][1]) &&
+               Near(hi[0], small_val[NX_ - 1][NY_ - 1][0]) &&
+               Near(hi[1], small_val[NX_ - 1][NY_ - 1][1]), "held at the ends");
+  /* NaN holds the last interval at its lower breakpoint */
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> small_flat;
+  Flatten<NX_, NY_, M_>(small_val, &small_flat);
+  std::array<int32_t, 2> small_idx = {};
+  std::array<float, M_> small_rt;
+  small.Lookup(small_xb[1] + 1, small_yb[0] + 1);
+  std::array<float, M_> held = small.Lookup(nan, nan);
+  GainTableLookup(small_xb.data(), NX_, small_yb.data(), NY_,
+                  small_flat.data(), M_, small_xb[1] + 1, small_yb[0] + 1,
+                  small_idx.data(), small_rt.data());
+  GainTableLookup(small_xb.data(), NX_, small_yb.data(), NY_,
+                  small_flat.data(), M_, nan, nan, small_idx.data(),
+                  small_rt.data());
+  checks.Check(Near(held[0], small_val[1][0][0]) &&
+               Near(held[1], small_val[1][0][1]) &&
+               Near(small_rt[0], small_val[1][0][0]) &&
+               Near(small_rt[1], small_val[1][0][1]), "NaN held");
+  /* Single variable schedule, linear between breakpoints */
+  GainTable<float, NX_, 1, 1> line(small_x, GainAxis<float, 1>({0}),
+                                   {{{{{1}}}, {{{2}}}, {{{4}}}, {{{8}}}}});
+  checks.Check(Near(line.Lookup(12.5f)[0], 1.5f) &&
+               Near(line.Lookup(22.5f)[0], 6), "linear interpolation");
+  /*
+  * Large table on arbitrary axes over random points, which move both ways
+  * so the search from the last interval is exercised
+  */
+  std::array<float, BIG_NX_> big_xb = Breakpoints<BIG_NX_>(&rng, 5);
+  std::array<float, BIG_NY_> big_yb = Breakpoints<BIG_NY_>(&rng, -20);
+  Big::Values big_val;
+  for (auto &row : big_val) {
+    for (auto &cell : row) {
+      for (float &v : cell) {v = gain(rng);}
+    }
+  }
+  Big big(GainAxis<float, BIG_NX_>(big_xb), GainAxis<float, BIG_NY_>(big_yb),
+          big_val);
+  std::vector<float> big_flat;
+  Flatten<BIG_NX_, BIG_NY_, BIG_M_>(big_val, &big_flat);
+  std::uniform_real_distribution<float> px(big_xb.front() - 5,
+                                           big_xb.back() + 5);
+  std::uniform_real_distribution<float> py(big_yb.front() - 5,
+                                           big_yb.back() + 5);
+  std::vector<std::array<float, 2>> pts(opt.trials);
+  for (auto &p : pts) {p = {px(rng), py(rng)};}
+  bool table_ok = true, runtime_ok = true;
+  std::array<int32_t, 2> idx = {};
+  std::array<float, BIG_M_> rt;
+  for (const auto &p : pts) {
+    std::array<float, BIG_M_> g = big.Lookup(p[0], p[1]);
+    std::array<double, BIG_M_> ref = Reference<BIG_NX_, BIG_NY_, BIG_M_>(
+      big_xb, big_yb, big_val, p[0], p[1]);
+    GainTableLookup(big_xb.data(), BIG_NX_, big_yb.data(), BIG_NY_,
+                    big_flat.data(), BIG_M_, p[0], p[1], idx.data(),
+                    rt.data());
+    for (std::size_t k = 0; k < BIG_M_; k++) {
+      table_ok = table_ok && Near(g[k], ref[k]);
+      runtime_ok = runtime_ok && Near(rt[k], g[k]);
+    }
+  }
+  checks.Check(table_ok, "random bilinear lookups");
+  checks.Check(runtime_ok, "run time lookup matches the table");
+  /* Loading from parameters, in the order the values are indexed */
+  std::vector<float> param;
+  Flatten<NX_, NY_, M_>(small_val, &param);
+  std::reverse(param.begin(), param.end());
+  Small loaded = small;
+  checks.Check(!loaded.Load(param.data(), param.size() - 1) &&
+               Near(loaded.Lookup(10, 0)[0], small_val[0][0][0]),
+               "short parameters rejected");
+  checks.Check(loaded.Load(param.data(), param.size()) &&
+               Near(loaded.Lookup(10, 0)[0], param[0]) &&
+               Near(loaded.Lookup(25, 300)[1], param.back()),
+               "parameters loaded in table order");
+  /* Parameter check before a schedule is loaded */
+  checks.Check(GainParamsPositive(param.data(), param.size()),
+               "positive parameters accepted");
+  pass = true;
+  for (float bad : {0.0f, -1.0f, std::numeric_limits<float>::quiet_NaN(),
+                    std::numeric_limits<float>::infinity()}) {
+    std::vector<float> p = param;
+    p[p.size() / 2] = bad;
+    pass = pass && !GainParamsPositive(p.data(), p.size());
+  }
+  pass = pass && !GainParamsPositive<float>(nullptr, param.size());
+  checks.Check(pass, "zero, negative, and non-finite parameters rejected");
+  /* Time per lookup */
+  using Clock = std::chrono::steady_clock;
+  auto t0 = Clock::now();
+  for (const auto &p : pts) {
+    small_out = small.Lookup(p[0], p[1]);
+    asm volatile("" : : "r"(&small_out) : "memory");
+  }
+  auto t1 = Clock::now();
+  for (const auto &p : pts) {
+    big_out = big.Lookup(p[0], p[1]);
+    asm volatile("" : : "r"(&big_out) : "memory");
+  }
+  auto t2 = Clock::now();
+  for (const auto &p : pts) {
+    GainTableLookup(big_xb.data(), BIG_NX_, big_yb.data(), BIG_NY_,
+                    big_flat.data(), BIG_M_, p[0], p[1], idx.data(),
+                    big_out.data());
+    asm volatile("" : : "r"(&big_out) : "memory");
+  }
+  auto t3 = Clock::now();
+  auto ns = [&pts](const Clock::time_point a, const Clock::time_point b) {
+    return std::chrono::duration<double, std::nano>(b - a).count() /
+           static_cast<double>(pts.size());
+  };
+  std::cout << std::fixed << std::setprecision(1)
+            << "Checks: " << checks.num() - checks.failed() << " of "
+            << checks.num()
+            << " passed, " << opt.trials << " random lookups" << std::endl
+            << "Lookup, ns per call: " << NX_ << "x" << NY_ << "x" << M_
+            << " " << ns(t0, t1) << ", " << BIG_NX_ << "x" << BIG_NY_ << "x"
+            << BIG_M_ << " " << ns(t1, t2) << ", run time " << ns(t2, t3)
+            << std::endl;
+  return checks.Result();
+}
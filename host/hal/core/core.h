@@ -0,0 +1,82 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_HAL_CORE_CORE_H_
+#define HOST_HAL_CORE_CORE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+/*
+* Host stand-in for the Teensy core. The flight code configs and hardware
+* definitions refer to buses and pins by the names of the core objects;
+* on the host these are inert placeholders, all device I/O goes through
+* the hardware abstraction layer.
+*/
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define OUTPUT_OPENDRAIN 4
+#define A21 66
+#define A22 67
+
+class Stream {
+ public:
+  inline int available() {return 0;}
+  inline int read() {return -1;}
+  inline std::size_t write(const uint8_t) {return 1;}
+  inline std::size_t write(const uint8_t *, const std::size_t len) {
+    return len;
+  }
+  inline int availableForWrite() {return 0;}
+  inline void begin(const uint32_t) {}
+  inline void end() {}
+  inline void flush() {}
+  inline explicit operator bool() const {return true;}
+};
+class HardwareSerial : public Stream {};
+class usb_serial_class : public Stream {};
+class SPIClass {
+ public:
+  inline void begin() {}
+};
+class TwoWire {
+ public:
+  inline void begin() {}
+  inline void setClock(const uint32_t) {}
+};
+
+extern usb_serial_class Serial;
+extern HardwareSerial Serial1, Serial2, Serial3, Serial4, Serial5, Serial6,
+                      Serial7, Serial8;
+extern SPIClass SPI, SPI1;
+extern TwoWire Wire, Wire1, Wire2;
+
+#endif  // HOST_HAL_CORE_CORE_H_
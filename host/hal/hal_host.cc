@@ -0,0 +1,298 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "hal/hal_host.h"
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "flight/hal.h"
+#include "flight/global_defs.h"
+#include "flight/pres_i2c.h"
+#include "hal/ubx_encode.h"
+#include "hal/sbus_encode.h"
+
+/*
+* Host implementation of the hardware abstraction layer. Time is set by
+* the harness rather than read from a clock, so runs are deterministic and
+* can be faster than real time. Device reads are answered by a HalSource;
+* GNSS solutions are encoded as UBX and fed through the same byte stream
+* interface as the FMU receiver, so the flight code UBX parser is
+* exercised too. Inceptor data is likewise encoded as SBUS frames and
+* handed to the flight code receive callback, one byte at a time, each
+* time the harness advances time.
+*/
+
+/* Bus objects referenced by the configs */
+usb_serial_class Serial;
+HardwareSerial Serial1, Serial2, Serial3, Serial4, Serial5, Serial6, Serial7,
+               Serial8;
+SPIClass SPI, SPI1;
+TwoWire Wire, Wire1, Wire2;
+
+namespace {
+HalSource *src_ = nullptr;
+int64_t time_us_ = 0;
+/* GNSS receiver bytes not yet read */
+bool gnss_open_ = false;
+std::deque<uint8_t> gnss_rx_;
+std::vector<uint8_t> gnss_epoch_;
+/* Inceptor receive callback and SBUS byte time, us */
+void (*inceptor_rx_)(const uint8_t, const int64_t) = nullptr;
+std::vector<uint8_t> inceptor_frame_;
+static constexpr int64_t SBUS_BYTE_US_ = 120;
+/*
+* Air data transducers, answering I2C reads with their output counts, so
+* the flight code scaling is exercised too
+*/
+struct PresDev {
+  bool init = false;
+  uint8_t addr = 0;
+  float min_pa = 0, max_pa = 0;
+  bool (HalSource::*read)(bfs::PresData * const) = nullptr;
+};
+PresDev static_pres_, diff_pres_;
+bool pres_i2c_ok_ = false;
+std::size_t pres_i2c_len_ = 0;
+uint8_t pres_i2c_buf_[HAL_I2C_MAX_READ] = {};
+/* Air data bus lines, released high */
+bool sda_ = true;
+/* Latched effector commands */
+SbusCmd sbus_ = {};
+PwmCmd pwm_ = {};
+/* Parameter storage, erased */
+std::array<uint8_t, 4096> eeprom_ = {};
+/* Datalog */
+std::string storage_path_;
+FILE *storage_ = nullptr;
+bool PresInit(const bfs::PresConfig &cfg,
+              bool (HalSource::*read)(bfs::PresData * const),
+              PresDev * const dev) {
+  dev->addr = cfg.dev;
+  dev->read = read;
+  dev->init = src_ && Ams5915Range(cfg.transducer, &dev->min_pa,
+                                   &dev->max_pa);
+  return dev->init;
+}
+/* AMS5915 output counts of a pressure and temperature, clamped to range */
+void PresEncode(const PresDev &dev, const bfs::PresData &data,
+                uint8_t * const buf) {
+  double pres_cnt = (static_cast<double>(data.pres_pa) - dev.min_pa) *
+                    (AMS5915_PRES_CNT_MAX - AMS5915_PRES_CNT_MIN) /
+                    (dev.max_pa - dev.min_pa) + AMS5915_PRES_CNT_MIN;
+  double temp_cnt = (static_cast<double>(data.die_temp_c) -
+                     AMS5915_TEMP_MIN_C) * AMS5915_TEMP_CNT_RANGE /
+                    AMS5915_TEMP_RANGE_C;
+  auto p = static_cast<uint16_t>(std::clamp<long>(std::lround(pres_cnt), 0,
+                                                  0x3FFF));
+  auto t = static_cast<uint16_t>(std::clamp<long>(std::lround(temp_cnt), 0,
+                                                  0x7FF));
+  buf[0] = static_cast<uint8_t>(p >> 8);
+  buf[1] = static_cast<uint8_t>(p);
+  buf[2] = static_cast<uint8_t>(t >> 3);
+  buf[3] = static_cast<uint8_t>(t << 5);
+}
+/* Delivers a new inceptor frame, received by the current time */
+void InceptorReceive() {
+  InceptorData data;
+  if (!inceptor_rx_ || !src_ || !src_->Inceptor(&data)) {return;}
+  inceptor_frame_.clear();
+  SbusEncodeFrame(data, &inceptor_frame_);
+  std::size_t n = inceptor_frame_.size();
+  for (std::size_t i = 0; i < n; i++) {
+    inceptor_rx_(inceptor_frame_[i],
+                 time_us_ - static_cast<int64_t>(n - 1 - i) * SBUS_BYTE_US_);
+  }
+}
+}  // namespace
+
+void HalHostSource(HalSource * const src) {
+  src_ = src;
+}
+void HalHostTime(const int64_t t_us) {
+  time_us_ = t_us;
+  InceptorReceive();
+}
+void HalHostStoragePath(const std::string &path) {
+  storage_path_ = path;
+}
+void HalInit() {}
+int64_t HalMicros() {
+  return time_us_;
+}
+void HalDelayMs(const int32_t ms) {
+  time_us_ += static_cast<int64_t>(ms) * 1000;
+  InceptorReceive();
+}
+void HalHalt() {
+  std::cout << std::endl;
+  HalStorageClose();
+  std::exit(EXIT_FAILURE);
+}
+void HalAttachFrame(void (*)()) {}
+uint32_t HalCycles() {
+  /* The host clock, ns, so kernels timed on the host give host costs */
+  return static_cast<uint32_t>(std::chrono::duration_cast<
+    std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+uint32_t HalCycleHz() {
+  return 1000000000;
+}
+void HalMsgBegin() {}
+void HalMsgPrint(const char * str) {
+  std::cout << str << std::flush;
+}
+bool HalImuInit(const bfs::ImuConfig &) {
+  return src_;
+}
+bool HalImuRead(bfs::ImuData * const data) {
+  return src_ && src_->Imu(data);
+}
+int64_t HalImuDrdyTime() {
+  return time_us_;
+}
+bool HalRedundantImuInit(const bfs::ImuConfig &) {
+  bfs::ImuData data;
+  return src_ && src_->RedundantImu(&data);
+}
+bool HalRedundantImuRead(bfs::ImuData * const data) {
+  return src_ && src_->RedundantImu(data);
+}
+int64_t HalRedundantImuDrdyTime() {
+  return time_us_;
+}
+bool HalFmuStaticPresInit(const bfs::PresConfig &) {
+  return src_;
+}
+bool HalFmuStaticPresRead(bfs::PresData * const data) {
+  return src_ && src_->FmuStaticPres(data);
+}
+bool HalStaticPresInit(const bfs::PresConfig &cfg) {
+  return PresInit(cfg, &HalSource::StaticPres, &static_pres_);
+}
+bool HalDiffPresInit(const bfs::PresConfig &cfg) {
+  return PresInit(cfg, &HalSource::DiffPres, &diff_pres_);
+}
+void HalPresI2cReadStart(const uint8_t addr, const std::size_t len) {
+  /* Transfers complete at once; an unhealthy transducer doesn't ACK */
+  pres_i2c_ok_ = false;
+  pres_i2c_len_ = std::min(len, AMS5915_READ_LEN);
+  for (const PresDev *dev : {&static_pres_, &diff_pres_}) {
+    if (!dev->init || (dev->addr != addr) || !sda_) {continue;}
+    bfs::PresData data = {};
+    (src_->*dev->read)(&data);
+    if (!data.healthy) {return;}
+    PresEncode(*dev, data, pres_i2c_buf_);
+    pres_i2c_ok_ = true;
+    return;
+  }
+}
+HalI2cStatus HalPresI2cReadPoll(uint8_t * const buf) {
+  if (!pres_i2c_ok_) {return HAL_I2C_ERROR;}
+  std::copy_n(pres_i2c_buf_, pres_i2c_len_, buf);
+  return HAL_I2C_DONE;
+}
+void HalPresI2cAbort() {}
+void HalPresI2cTakeover() {
+  sda_ = true;
+}
+bool HalPresI2cSda() {
+  return sda_;
+}
+void HalPresI2cSda(const bool high) {
+  sda_ = high;
+}
+void HalPresI2cScl(const bool) {}
+void HalPresI2cRestart() {
+  sda_ = true;
+}
+bool HalGnssBegin(const bfs::GnssConfig &cfg) {
+  gnss_open_ = src_ && cfg.bus;
+  return gnss_open_;
+}
+std::size_t HalGnssRead(uint8_t * const buf, const std::size_t len) {
+  if (!gnss_open_) {return 0;}
+  /* The receiver sends each new solution as it becomes available */
+  bfs::GnssData gnss;
+  if (src_->Gnss(&gnss)) {
+    gnss_epoch_.clear();
+    UbxEncodeEpoch(gnss, &gnss_epoch_);
+    gnss_rx_.insert(gnss_rx_.end(), gnss_epoch_.begin(), gnss_epoch_.end());
+  }
+  std::size_t n = std::min(len, gnss_rx_.size());
+  std::copy_n(gnss_rx_.begin(), n, buf);
+  gnss_rx_.erase(gnss_rx_.begin(), gnss_rx_.begin() + n);
+  return n;
+}
+bool HalInceptorBegin(void (*rx)(const uint8_t byte, const int64_t time_us)) {
+  inceptor_rx_ = rx;
+  return src_ && rx;
+}
+int32_t HalAnalogRead(const int8_t pin) {
+  if (!src_) {return 0;}
+  float cnt = std::clamp(src_->AnalogCounts(pin), 0.0f, ANALOG_COUNT_RANGE);
+  return static_cast<int32_t>(std::lround(cnt));
+}
+void HalEffectorsInit() {}
+void HalSbusCmd(const SbusCmd &cmd) {
+  sbus_ = cmd;
+}
+void HalPwmCmd(const PwmCmd &cmd) {
+  pwm_ = cmd;
+}
+void HalEffectorsWrite() {
+  if (src_) {src_->Effectors(sbus_, pwm_);}
+}
+uint8_t HalEepromRead(const std::size_t addr) {
+  return (addr < eeprom_.size()) ? eeprom_[addr] : 0;
+}
+void HalEepromWrite(const std::size_t addr, const uint8_t val) {
+  if (addr < eeprom_.size()) {eeprom_[addr] = val;}
+}
+int HalStorageInit(const char * name) {
+  std::string path = storage_path_.empty() ?
+                     std::string(name) + "0.bfs" : storage_path_;
+  storage_ = std::fopen(path.c_str(), "wb");
+  return storage_ ? 0 : -1;
+}
+void HalStorageWrite(const uint8_t * const data, const std::size_t len) {
+  if (storage_) {std::fwrite(data, 1, len, storage_);}
+}
+void HalStorageFlush() {
+  if (storage_) {std::fflush(storage_);}
+}
+void HalStorageClose() {
+  if (storage_) {
+    std::fclose(storage_);
+    storage_ = nullptr;
+  }
+}
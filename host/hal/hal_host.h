@@ -0,0 +1,66 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_HAL_HAL_HOST_H_
+#define HOST_HAL_HAL_HOST_H_
+
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+
+/*
+* Source of the device data seen by the flight software on the host, such
+* as a recorded datalog or a simulation model. Reads return whether the
+* device delivered data, as the corresponding FMU driver would.
+*/
+class HalSource {
+ public:
+  virtual ~HalSource() = default;
+  virtual bool Imu(bfs::ImuData * const data) = 0;
+  /* Sources without a redundant IMU leave it uninstalled */
+  virtual bool RedundantImu(bfs::ImuData * const) {return false;}
+  virtual bool FmuStaticPres(bfs::PresData * const data) = 0;
+  virtual bool StaticPres(bfs::PresData * const data) = 0;
+  virtual bool DiffPres(bfs::PresData * const data) = 0;
+  /* Returns true once for each new GNSS solution */
+  virtual bool Gnss(bfs::GnssData * const data) = 0;
+  /* Returns true once for each new inceptor frame */
+  virtual bool Inceptor(InceptorData * const data) = 0;
+  /* ADC counts on a pin */
+  virtual float AnalogCounts(const int8_t pin) = 0;
+  /* Effector commands sent by the flight software */
+  virtual void Effectors(const SbusCmd &, const PwmCmd &) {}
+};
+
+/* Sets the source of device data */
+void HalHostSource(HalSource * const src);
+/* Sets the system time, us */
+void HalHostTime(const int64_t t_us);
+/* Sets the datalog path, defaults to the datalog name in the working dir */
+void HalHostStoragePath(const std::string &path);
+/* Sets the flight plan, uploaded as if from a ground station at init */
+void HalHostFlightPlan(const std::vector<bfs::MissionItem> &plan);
+
+#endif  // HOST_HAL_HAL_HOST_H_
@@ -0,0 +1,58 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "hal/host_tool.h"
+#include <iostream>
+#include <string>
+
+bool HostOptionSplit(const std::string &arg, std::string * const key,
+                     std::string * const val, const bool flag) {
+  if (!key || !val || (arg.rfind("--", 0) != 0)) {return false;}
+  std::size_t eq = arg.find('=');
+  if (eq == std::string::npos) {
+    if (!flag || (arg.size() == 2)) {return false;}
+    *key = arg.substr(2);
+    val->clear();
+    return true;
+  }
+  *key = arg.substr(2, eq - 2);
+  *val = arg.substr(eq + 1);
+  return true;
+}
+void HostChecks::Check(const bool pass, const std::string &name) {
+  num_++;
+  if (!pass) {
+    failed_++;
+    std::cout << "FAIL: " << name << std::endl;
+  }
+}
+int HostChecks::Result() const {
+  if (failed_ > 0) {
+    std::cout << "FAIL" << std::endl;
+    return 1;
+  }
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
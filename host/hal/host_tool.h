@@ -0,0 +1,77 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_HAL_HOST_TOOL_H_
+#define HOST_HAL_HOST_TOOL_H_
+
+#include <iostream>
+#include <string>
+
+/*
+* Command line handling and checks shared by the host tools. Options are
+* given as --key=val, and each tool parses its own keys from the split
+* option; checks are counted so a tool can report how many passed and
+* return a non-zero exit code, for CTest and the CI, if any failed.
+*/
+
+/*
+* Splits an option of the form --key=val, returns false if arg isn't one.
+* A bare --flag is split with an empty val if flag is true.
+*/
+bool HostOptionSplit(const std::string &arg, std::string * const key,
+                     std::string * const val, const bool flag = false);
+/*
+* Parses argv from first with the tool's ParseOption, printing the
+* unknown option on failure so the tool can follow it with its usage
+*/
+template <typename T>
+bool HostParseArgs(const int argc, char ** const argv, const int first,
+                   bool (*parse)(const std::string &, T * const),
+                   T * const opt) {
+  for (int i = first; i < argc; i++) {
+    if (!parse(argv[i], opt)) {
+      std::cerr << "ERROR: Unknown option " << argv[i] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Named pass or fail checks of a tool run */
+class HostChecks {
+ public:
+  /* Counts a check, printing its name if it failed */
+  void Check(const bool pass, const std::string &name);
+  inline int num() const {return num_;}
+  inline int failed() const {return failed_;}
+  /* Prints PASS or FAIL, returns the exit code: non-zero on a failure */
+  int Result() const;
+
+ private:
+  int num_ = 0;
+  int failed_ = 0;
+};
+
+#endif  // HOST_HAL_HOST_TOOL_H_
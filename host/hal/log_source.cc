@@ -0,0 +1,173 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "hal/log_source.h"
+#include <cmath>
+#include "./pb_decode.h"
+
+LogSource::~LogSource() {
+  if (file_) {std::fclose(file_);}
+}
+bool LogSource::Open(const std::string &path) {
+  file_ = std::fopen(path.c_str(), "rb");
+  return file_;
+}
+bool LogSource::Next() {
+  if (!file_) {return false;}
+  int c;
+  while ((c = std::fgetc(file_)) != EOF) {
+    if (!decoder_.Found(static_cast<uint8_t>(c))) {continue;}
+    pb_istream_t stream = pb_istream_from_buffer(decoder_.Data(),
+                                                 decoder_.Size());
+    msg_ = DatalogMessage_init_zero;
+    if (!pb_decode(&stream, DatalogMessage_fields, &msg_)) {continue;}
+    time_us_ = std::llround(msg_.sys_time_s * 1e6);
+    /* The first frame carries the solution found during GNSS init */
+    gnss_pending_ = gnss_pending_ || first_ || msg_.gnss_new_data;
+    /* Likewise the frame found during inceptor init */
+    incept_pending_ = incept_pending_ || first_ || msg_.incept_new_data;
+    first_ = false;
+    return true;
+  }
+  return false;
+}
+bool LogSource::Imu(bfs::ImuData * const data) {
+  data->new_imu_data = msg_.imu_new_data;
+  data->new_mag_data = msg_.imu_new_mag_data;
+  data->imu_healthy = msg_.imu_healthy;
+  data->mag_healthy = msg_.imu_mag_healthy;
+  data->die_temp_c = msg_.imu_die_temp_c;
+  for (std::size_t i = 0; i < 3; i++) {
+    data->accel_mps2[i] = msg_.imu_accel_mps2[i];
+    data->gyro_radps[i] = msg_.imu_gyro_radps[i];
+    data->mag_ut[i] = msg_.imu_mag_ut[i];
+  }
+  return msg_.imu_new_data;
+}
+bool LogSource::RedundantImu(bfs::ImuData * const data) {
+  data->new_imu_data = msg_.rdnt_imu_new_data;
+  data->new_mag_data = msg_.rdnt_imu_new_mag_data;
+  data->imu_healthy = msg_.rdnt_imu_healthy;
+  data->mag_healthy = msg_.rdnt_imu_mag_healthy;
+  data->die_temp_c = msg_.rdnt_imu_die_temp_c;
+  for (std::size_t i = 0; i < 3; i++) {
+    data->accel_mps2[i] = msg_.rdnt_imu_accel_mps2[i];
+    data->gyro_radps[i] = msg_.rdnt_imu_gyro_radps[i];
+    data->mag_ut[i] = msg_.rdnt_imu_mag_ut[i];
+  }
+  return msg_.rdnt_imu_new_data;
+}
+bool LogSource::FmuStaticPres(bfs::PresData * const data) {
+  /* A redundant source when pitot static is installed */
+  if (!msg_.pitot_static_installed) {return StaticPres(data);}
+  data->new_data = msg_.rdnt_pres_static_new_data;
+  data->healthy = msg_.rdnt_pres_static_healthy;
+  data->pres_pa = msg_.rdnt_pres_static_pres_pa;
+  data->die_temp_c = msg_.rdnt_pres_static_die_temp_c;
+  return msg_.rdnt_pres_static_new_data;
+}
+bool LogSource::StaticPres(bfs::PresData * const data) {
+  data->new_data = msg_.pres_static_new_data;
+  data->healthy = msg_.pres_static_healthy;
+  data->pres_pa = msg_.pres_static_pres_pa;
+  data->die_temp_c = msg_.pres_static_die_temp_c;
+  return msg_.pres_static_new_data;
+}
+bool LogSource::DiffPres(bfs::PresData * const data) {
+  data->new_data = msg_.pres_diff_new_data;
+  data->healthy = msg_.pres_diff_healthy;
+  data->pres_pa = msg_.pres_diff_pres_pa;
+  data->die_temp_c = msg_.pres_diff_die_temp_c;
+  return msg_.pres_diff_new_data;
+}
+bool LogSource::Gnss(bfs::GnssData * const data) {
+  if (!gnss_pending_) {return false;}
+  gnss_pending_ = false;
+  data->new_data = true;
+  data->healthy = msg_.gnss_healthy;
+  data->fix = static_cast<int8_t>(msg_.gnss_fix);
+  data->num_sats = static_cast<int8_t>(msg_.gnss_num_sats);
+  data->week = static_cast<int16_t>(msg_.gnss_week);
+  data->tow_ms = msg_.gnss_tow_ms;
+  data->alt_wgs84_m = msg_.gnss_alt_wgs84_m;
+  data->alt_msl_m = msg_.gnss_alt_msl_m;
+  data->hdop = msg_.gnss_hdop;
+  data->vdop = msg_.gnss_vdop;
+  data->track_rad = msg_.gnss_track_rad;
+  data->spd_mps = msg_.gnss_spd_mps;
+  data->horz_acc_m = msg_.gnss_horz_acc_m;
+  data->vert_acc_m = msg_.gnss_vert_acc_m;
+  data->vel_acc_mps = msg_.gnss_vel_acc_mps;
+  data->track_acc_rad = msg_.gnss_track_acc_rad;
+  for (std::size_t i = 0; i < 3; i++) {
+    data->ned_vel_mps[i] = msg_.gnss_ned_vel_mps[i];
+  }
+  data->lat_rad = msg_.gnss_lat_rad;
+  data->lon_rad = msg_.gnss_lon_rad;
+  return true;
+}
+bool LogSource::Inceptor(InceptorData * const data) {
+  if (!incept_pending_) {return false;}
+  incept_pending_ = false;
+  data->new_data = true;
+  data->lost_frame = msg_.incept_lost_frame;
+  data->failsafe = msg_.incept_failsafe;
+  data->ch17 = msg_.incept_ch17;
+  data->ch18 = msg_.incept_ch18;
+  for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
+    data->ch[i] = static_cast<int16_t>(msg_.incept_ch[i]);
+  }
+  return true;
+}
+float LogSource::AnalogCounts(const int8_t pin) {
+  for (std::size_t i = 0; i < NUM_AIN_PINS; i++) {
+    if (pin == AIN_PINS[i]) {
+      return msg_.adc_volt[i] / AIN_VOLTAGE_SCALE;
+    }
+  }
+  #if defined(__FMU_R_V2__)
+  if (pin == BATTERY_VOLTAGE_PIN) {
+    return msg_.pwr_mod_volt_v / AIN_VOLTAGE_SCALE;
+  }
+  if (pin == BATTERY_CURRENT_PIN) {
+    return msg_.pwr_mod_curr_v / AIN_VOLTAGE_SCALE;
+  }
+  #endif
+  #if defined(__FMU_R_V1__)
+  if (pin == INPUT_VOLTAGE_PIN) {
+    return msg_.sys_input_volt / INPUT_VOLTAGE_SCALE;
+  }
+  if (pin == REGULATED_VOLTAGE_PIN) {
+    return msg_.sys_reg_volt / REGULATED_VOLTAGE_SCALE;
+  }
+  if (pin == SBUS_VOLTAGE_PIN) {
+    return msg_.sys_sbus_volt / SBUS_VOLTAGE_SCALE;
+  }
+  if (pin == PWM_VOLTAGE_PIN) {
+    return msg_.sys_pwm_volt / PWM_VOLTAGE_SCALE;
+  }
+  #endif
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_HAL_LOG_SOURCE_H_
+#define HOST_HAL_LOG_SOURCE_H_
+
+#include <cstdio>
+#include <string>
+#include "hal/hal_host.h"
+#include "framing/framing.h"
+#include "./pb.h"
+#if defined(__FMU_R_V2__)
+#include "./datalog_fmu_v2.pb.h"
+#endif
+#if defined(__FMU_R_V2_BETA__)
+#include "./datalog_fmu_v2_beta.pb.h"
+#endif
+#if defined(__FMU_R_V1__)
+#include "./datalog_fmu_v1.pb.h"
+#endif
+
+/*
+* Device data from a recorded flight datalog. Each call to Next advances
+* one frame; devices then return the data logged in that frame, as it
+* was acquired before the frame ran.
+*/
+class LogSource : public HalSource {
+ public:
+  ~LogSource();
+  /* Opens a datalog, returns false on failure */
+  bool Open(const std::string &path);
+  /* Advances to the next frame, returns false at the end of the log */
+  bool Next();
+  /* System time of the current frame, us */
+  inline int64_t time_us() const {return time_us_;}
+  /* Logged data of the current frame */
+  inline const DatalogMessage & msg() const {return msg_;}
+  /* Devices */
+  bool Imu(bfs::ImuData * const data) override;
+  bool RedundantImu(bfs::ImuData * const data) override;
+  bool FmuStaticPres(bfs::PresData * const data) override;
+  bool StaticPres(bfs::PresData * const data) override;
+  bool DiffPres(bfs::PresData * const data) override;
+  bool Gnss(bfs::GnssData * const data) override;
+  bool Inceptor(InceptorData * const data) override;
+  float AnalogCounts(const int8_t pin) override;
+
+ private:
+  FILE *file_ = nullptr;
+  bfs::Decoder<DatalogMessage_size> decoder_;
+  DatalogMessage msg_ = DatalogMessage_init_zero;
+  int64_t time_us_ = 0;
+  bool first_ = true;
+  bool gnss_pending_ = false;
+  bool incept_pending_ = false;
+};
+
+#endif  // HOST_HAL_LOG_SOURCE_H_
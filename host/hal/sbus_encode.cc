@@ -0,0 +1,48 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "hal/sbus_encode.h"
+
+void SbusEncodeFrame(const InceptorData &data,
+                     std::vector<uint8_t> * const out) {
+  if (!out) {return;}
+  out->push_back(0x0F);
+  /* Channels packed 11 bits each, least significant bit first */
+  uint32_t bits = 0;
+  int32_t num_bits = 0;
+  for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
+    bits |= (static_cast<uint32_t>(data.ch[i]) & 0x07FF) << num_bits;
+    num_bits += 11;
+    while (num_bits >= 8) {
+      out->push_back(static_cast<uint8_t>(bits));
+      bits >>= 8;
+      num_bits -= 8;
+    }
+  }
+  uint8_t flags = (data.ch17 ? 0x01 : 0) | (data.ch18 ? 0x02 : 0) |
+                  (data.lost_frame ? 0x04 : 0) | (data.failsafe ? 0x08 : 0);
+  out->push_back(flags);
+  out->push_back(0x00);
+}
@@ -0,0 +1,76 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "flight/telem.h"
+#include <algorithm>
+#include <vector>
+#include "flight/global_defs.h"
+#include "flight/param_store.h"
+#include "hal/hal_host.h"
+
+/*
+* Host stand-in for telemetry. The MAVLink library drives its radio serial
+* port directly, below the hardware abstraction layer, so on the host
+* telemetry behaves as if no ground station were connected: parameters
+* are loaded from the parameter store as on the FMU. A flight plan set by
+* the harness is uploaded at init and advanced as the VMS reaches each
+* waypoint.
+*/
+
+namespace {
+std::vector<bfs::MissionItem> plan_;
+bool plan_read_ = false;
+}  // namespace
+
+void HalHostFlightPlan(const std::vector<bfs::MissionItem> &plan) {
+  plan_ = plan;
+}
+
+void TelemInit(const AircraftConfig &, TelemData * const ptr) {
+  if (!ptr) {return;}
+  ParamStoreLoad(&ptr->param);
+  ptr->waypoints_updated = false;
+  ptr->fence_updated = false;
+  ptr->rally_points_updated = false;
+  ptr->current_waypoint = 0;
+  std::size_t n = std::min(plan_.size(), ptr->flight_plan.size());
+  std::copy_n(plan_.begin(), n, ptr->flight_plan.begin());
+  ptr->num_waypoints = static_cast<int16_t>(n);
+  ptr->num_fence_items = 0;
+  ptr->num_rally_points = 0;
+  plan_read_ = false;
+}
+void TelemUpdate(const AircraftData &data, TelemData * const ptr) {
+  if (!ptr) {return;}
+  /* The flight plan reads as updated on the first update after upload */
+  ptr->waypoints_updated = !plan_read_ && (ptr->num_waypoints > 0);
+  plan_read_ = true;
+  if (data.vms.waypoint_reached &&
+      (ptr->current_waypoint < ptr->num_waypoints - 1)) {
+    ptr->current_waypoint++;
+  }
+  ptr->fence_updated = false;
+  ptr->rally_points_updated = false;
+}
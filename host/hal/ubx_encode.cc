@@ -0,0 +1,177 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "hal/ubx_encode.h"
+#include <cmath>
+#include <array>
+
+namespace {
+static constexpr double RAD2DEG_ = 57.29577951308232;
+/* GPS - UTC, s */
+static constexpr int64_t LEAP_SECONDS_ = 18;
+static constexpr int64_t SECONDS_PER_WEEK_ = 604800;
+/* Days from 1970-01-01 to the GPS epoch, 1980-01-06 */
+static constexpr int64_t GPS_EPOCH_DAYS_ = 3657;
+/* Civil date for a number of days since 1970-01-01 */
+void CivilFromDays(int64_t z, int64_t * const y, int64_t * const m,
+                   int64_t * const d) {
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const int64_t doe = z - era * 146097;
+  const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int64_t mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = yoe + era * 400 + (*m <= 2);
+}
+/* Splits a value into a main part and a high precision part */
+void Split(const double val, const double hp_per_main, int32_t * const main,
+           int8_t * const hp) {
+  double m = std::trunc(val);
+  double h = std::round((val - m) * hp_per_main);
+  if (std::abs(h) >= hp_per_main) {
+    m += std::copysign(1.0, h);
+    h -= std::copysign(hp_per_main, h);
+  }
+  *main = static_cast<int32_t>(m);
+  *hp = static_cast<int8_t>(h);
+}
+/* Little endian payload fields */
+template<std::size_t N>
+void Put(std::array<uint8_t, N> * const buf, const std::size_t i,
+         const uint32_t val, const std::size_t len) {
+  for (std::size_t j = 0; j < len; j++) {
+    (*buf)[i + j] = static_cast<uint8_t>(val >> (8 * j));
+  }
+}
+/* Frames a UBX-NAV message */
+template<std::size_t N>
+void Frame(const uint8_t id, const std::array<uint8_t, N> &payload,
+           std::vector<uint8_t> * const out) {
+  std::size_t start = out->size();
+  out->push_back(0xB5);
+  out->push_back(0x62);
+  out->push_back(0x01);
+  out->push_back(id);
+  out->push_back(static_cast<uint8_t>(N));
+  out->push_back(static_cast<uint8_t>(N >> 8));
+  out->insert(out->end(), payload.begin(), payload.end());
+  uint8_t chk_a = 0, chk_b = 0;
+  for (std::size_t i = start + 2; i < out->size(); i++) {
+    chk_a += (*out)[i];
+    chk_b += chk_a;
+  }
+  out->push_back(chk_a);
+  out->push_back(chk_b);
+}
+}  // namespace
+
+void UbxEncodeEpoch(const bfs::GnssData &gnss,
+                    std::vector<uint8_t> * const out) {
+  if (!out) {return;}
+  uint32_t tow_ms = static_cast<uint32_t>(gnss.tow_ms);
+  /* UTC date and time from the GPS week and time of week */
+  int64_t utc_s = gnss.week * SECONDS_PER_WEEK_ + tow_ms / 1000 -
+                  LEAP_SECONDS_;
+  int64_t y, m, d;
+  CivilFromDays(utc_s / 86400 + GPS_EPOCH_DAYS_, &y, &m, &d);
+  int64_t sec_of_day = utc_s % 86400;
+  /* Position */
+  int32_t lat, lon, alt_wgs84, alt_msl;
+  int8_t lat_hp, lon_hp, alt_wgs84_hp, alt_msl_hp;
+  Split(gnss.lat_rad * RAD2DEG_ * 1e7, 100, &lat, &lat_hp);
+  Split(gnss.lon_rad * RAD2DEG_ * 1e7, 100, &lon, &lon_hp);
+  Split(static_cast<double>(gnss.alt_wgs84_m) * 1e3, 10, &alt_wgs84,
+        &alt_wgs84_hp);
+  Split(static_cast<double>(gnss.alt_msl_m) * 1e3, 10, &alt_msl,
+        &alt_msl_hp);
+  /* Fix type and flags */
+  uint8_t fix_type = 0, flags = 0;
+  if (gnss.fix >= 2) {
+    fix_type = (gnss.fix == 2) ? 2 : 3;
+    flags = 0x01;
+    if (gnss.fix == 4) {flags |= 0x02;}
+    if (gnss.fix == 5) {flags |= 0x40;}
+    if (gnss.fix == 6) {flags |= 0x80;}
+  }
+  /* UBX-NAV-PVT */
+  std::array<uint8_t, 92> pvt = {};
+  Put(&pvt, 0, tow_ms, 4);
+  Put(&pvt, 4, static_cast<uint32_t>(y), 2);
+  Put(&pvt, 6, static_cast<uint32_t>(m), 1);
+  Put(&pvt, 7, static_cast<uint32_t>(d), 1);
+  Put(&pvt, 8, static_cast<uint32_t>(sec_of_day / 3600), 1);
+  Put(&pvt, 9, static_cast<uint32_t>(sec_of_day / 60 % 60), 1);
+  Put(&pvt, 10, static_cast<uint32_t>(sec_of_day % 60), 1);
+  Put(&pvt, 11, 0x03, 1);
+  Put(&pvt, 20, fix_type, 1);
+  Put(&pvt, 21, flags, 1);
+  Put(&pvt, 23, static_cast<uint32_t>(gnss.num_sats), 1);
+  Put(&pvt, 24, static_cast<uint32_t>(lon), 4);
+  Put(&pvt, 28, static_cast<uint32_t>(lat), 4);
+  Put(&pvt, 32, static_cast<uint32_t>(alt_wgs84), 4);
+  Put(&pvt, 36, static_cast<uint32_t>(alt_msl), 4);
+  Put(&pvt, 40, static_cast<uint32_t>(std::lround(gnss.horz_acc_m * 1e3f)),
+      4);
+  Put(&pvt, 44, static_cast<uint32_t>(std::lround(gnss.vert_acc_m * 1e3f)),
+      4);
+  for (std::size_t i = 0; i < 3; i++) {
+    Put(&pvt, 48 + 4 * i,
+        static_cast<uint32_t>(std::lround(gnss.ned_vel_mps[i] * 1e3f)), 4);
+  }
+  Put(&pvt, 60, static_cast<uint32_t>(std::lround(gnss.spd_mps * 1e3f)), 4);
+  Put(&pvt, 64, static_cast<uint32_t>(std::lround(gnss.track_rad * RAD2DEG_ *
+                                                  1e5)), 4);
+  Put(&pvt, 68, static_cast<uint32_t>(std::lround(gnss.vel_acc_mps * 1e3f)),
+      4);
+  Put(&pvt, 72, static_cast<uint32_t>(std::lround(gnss.track_acc_rad *
+                                                  RAD2DEG_ * 1e5)), 4);
+  Frame(0x07, pvt, out);
+  /* UBX-NAV-HPPOSLLH */
+  std::array<uint8_t, 36> hp = {};
+  Put(&hp, 4, tow_ms, 4);
+  Put(&hp, 8, static_cast<uint32_t>(lon), 4);
+  Put(&hp, 12, static_cast<uint32_t>(lat), 4);
+  Put(&hp, 16, static_cast<uint32_t>(alt_wgs84), 4);
+  Put(&hp, 20, static_cast<uint32_t>(alt_msl), 4);
+  Put(&hp, 24, static_cast<uint8_t>(lon_hp), 1);
+  Put(&hp, 25, static_cast<uint8_t>(lat_hp), 1);
+  Put(&hp, 26, static_cast<uint8_t>(alt_wgs84_hp), 1);
+  Put(&hp, 27, static_cast<uint8_t>(alt_msl_hp), 1);
+  Put(&hp, 28, static_cast<uint32_t>(std::lround(gnss.horz_acc_m * 1e4f)), 4);
+  Put(&hp, 32, static_cast<uint32_t>(std::lround(gnss.vert_acc_m * 1e4f)), 4);
+  Frame(0x14, hp, out);
+  /* UBX-NAV-DOP */
+  std::array<uint8_t, 18> dop = {};
+  Put(&dop, 0, tow_ms, 4);
+  Put(&dop, 10, static_cast<uint32_t>(std::lround(gnss.vdop * 100.0f)), 2);
+  Put(&dop, 12, static_cast<uint32_t>(std::lround(gnss.hdop * 100.0f)), 2);
+  Frame(0x04, dop, out);
+  /* UBX-NAV-EOE */
+  std::array<uint8_t, 4> eoe = {};
+  Put(&eoe, 0, tow_ms, 4);
+  Frame(0x61, eoe, out);
+}
@@ -0,0 +1,42 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_HAL_UBX_ENCODE_H_
+#define HOST_HAL_UBX_ENCODE_H_
+
+#include <cstdint>
+#include <vector>
+#include "gnss/gnss.h"
+
+/*
+* Encodes a GNSS solution as the UBX-NAV-PVT, UBX-NAV-HPPOSLLH,
+* UBX-NAV-DOP, and UBX-NAV-EOE messages of one epoch, appending them to
+* out. This is the inverse of UbxParser, used to feed the flight code GNSS
+* byte stream on the host.
+*/
+void UbxEncodeEpoch(const bfs::GnssData &gnss,
+                    std::vector<uint8_t> * const out);
+
+#endif  // HOST_HAL_UBX_ENCODE_H_
@@ -0,0 +1,358 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Performance regression gate. Benchmark results, the JSON written by
+* flight_bench and by mat_converter, are compared with a stored baseline.
+* Several runs are given of each, so run to run noise can be accounted
+* for: each benchmark is compared by the median of its run medians, with a
+* bootstrap confidence interval on the ratio of the new median to the
+* baseline. A benchmark regresses when the whole interval is slower than
+* the threshold, so a noisy run doesn't fail the gate but a real slowdown
+* does. A report is printed and the exit code is non-zero on any
+* regression. With --save, the runs given are stored as the new baseline.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "hal/host_tool.h"
+
+namespace {
+/* Gate settings */
+struct Options {
+  std::string baseline = "perf_baseline.json";
+  double threshold = 0.05;
+  double confidence = 0.95;
+  std::size_t resamples = 2000;
+  bool save = false;
+  std::vector<std::string> runs;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  if (arg == "--save") {
+    opt->save = true;
+    return true;
+  }
+  if (arg.rfind("--", 0) != 0) {
+    opt->runs.push_back(arg);
+    return true;
+  }
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "baseline") {
+    opt->baseline = val;
+  } else if (key == "threshold") {
+    opt->threshold = std::strtod(val.c_str(), nullptr);
+    if (opt->threshold < 0) {return false;}
+  } else if (key == "confidence") {
+    opt->confidence = std::strtod(val.c_str(), nullptr);
+    if ((opt->confidence <= 0) || (opt->confidence >= 1)) {return false;}
+  } else if (key == "resamples") {
+    opt->resamples = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->resamples == 0) {return false;}
+  } else {
+    return false;
+  }
+  return true;
+}
+/*
+* Reader for the benchmark JSON. Only the benchmark names and their
+* median_ns, a number in a run or an array of run medians in a baseline,
+* are kept; everything else is parsed and skipped.
+*/
+class Reader {
+ public:
+  explicit Reader(const std::string &text) : s_(text) {}
+  /* Appends the run medians of each benchmark, returns false on error */
+  bool Read(std::map<std::string, std::vector<double>> * const med) {
+    med_ = med;
+    return Value(0) && (Skip(), i_ == s_.size());
+  }
+
+ private:
+  const std::string &s_;
+  std::size_t i_ = 0;
+  std::map<std::string, std::vector<double>> *med_ = nullptr;
+  void Skip() {
+    while ((i_ < s_.size()) && std::isspace(static_cast<unsigned char>(
+                                                s_[i_]))) {i_++;}
+  }
+  bool Expect(const char c) {
+    Skip();
+    if ((i_ < s_.size()) && (s_[i_] == c)) {
+      i_++;
+      return true;
+    }
+    return false;
+  }
+  bool String(std::string * const str) {
+    if (!Expect('"')) {return false;}
+    str->clear();
+    while ((i_ < s_.size()) && (s_[i_] != '"')) {
+      if ((s_[i_] == '\\') && (i_ + 1 < s_.size())) {i_++;}
+      str->push_back(s_[i_++]);
+    }
+    return Expect('"');
+  }
+  bool Number(double * const val) {
+    Skip();
+    const char *start = s_.c_str() + i_;
+    char *end;
+    *val = std::strtod(start, &end);
+    if (end == start) {return false;}
+    i_ += static_cast<std::size_t>(end - start);
+    return true;
+  }
+  /* Numbers of an array, or a single number */
+  bool Numbers(std::vector<double> * const vals) {
+    double v;
+    if (Expect('[')) {
+      if (Expect(']')) {return true;}
+      do {
+        if (!Number(&v)) {return false;}
+        vals->push_back(v);
+      } while (Expect(','));
+      return Expect(']');
+    }
+    if (!Number(&v)) {return false;}
+    vals->push_back(v);
+    return true;
+  }
+  /* Any value; objects in the benchmarks array are benchmarks */
+  bool Value(const int depth, const bool bench = false) {
+    Skip();
+    if (i_ >= s_.size()) {return false;}
+    char c = s_[i_];
+    if (c == '{') {
+      i_++;
+      std::string name;
+      std::vector<double> vals;
+      if (!Expect('}')) {
+        do {
+          std::string key;
+          if (!String(&key) || !Expect(':')) {return false;}
+          if (bench && (key == "name")) {
+            if (!String(&name)) {return false;}
+          } else if (bench && (key == "median_ns")) {
+            if (!Numbers(&vals)) {return false;}
+          } else if (!Value(depth + 1, (depth == 0) &&
+                                       (key == "benchmarks"))) {
+            return false;
+          }
+        } while (Expect(','));
+        if (!Expect('}')) {return false;}
+      }
+      if (bench && !name.empty()) {
+        std::vector<double> &m = (*med_)[name];
+        m.insert(m.end(), vals.begin(), vals.end());
+      }
+      return true;
+    }
+    if (c == '[') {
+      i_++;
+      if (Expect(']')) {return true;}
+      do {
+        if (!Value(depth + 1, bench)) {return false;}
+      } while (Expect(','));
+      return Expect(']');
+    }
+    if (c == '"') {
+      std::string str;
+      return String(&str);
+    }
+    for (const char *lit : {"true", "false", "null"}) {
+      std::string l(lit);
+      if (s_.compare(i_, l.size(), l) == 0) {
+        i_ += l.size();
+        return true;
+      }
+    }
+    double v;
+    return Number(&v);
+  }
+};
+bool ReadFile(const std::string &path,
+              std::map<std::string, std::vector<double>> * const med) {
+  std::ifstream file(path);
+  if (!file) {return false;}
+  std::stringstream ss;
+  ss << file.rdbuf();
+  std::string text = ss.str();
+  return Reader(text).Read(med);
+}
+double Median(std::vector<double> v) {
+  if (v.empty()) {return 0;}
+  std::size_t n = v.size() / 2;
+  std::nth_element(v.begin(), v.begin() + n, v.end());
+  if (v.size() % 2) {return v[n];}
+  double hi = v[n];
+  return 0.5 * (hi + *std::max_element(v.begin(), v.begin() + n));
+}
+/* Bootstrap interval of the ratio of the new median to the baseline */
+void RatioInterval(const std::vector<double> &base,
+                   const std::vector<double> &run, const Options &opt,
+                   double * const lo, double * const hi) {
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<std::size_t> pick_base(0, base.size() - 1);
+  std::uniform_int_distribution<std::size_t> pick_run(0, run.size() - 1);
+  std::vector<double> ratio(opt.resamples);
+  std::vector<double> b(base.size()), r(run.size());
+  for (double &q : ratio) {
+    for (double &v : b) {v = base[pick_base(rng)];}
+    for (double &v : r) {v = run[pick_run(rng)];}
+    double mb = Median(b);
+    q = (mb > 0) ? Median(r) / mb : 1;
+  }
+  std::sort(ratio.begin(), ratio.end());
+  double tail = 0.5 * (1 - opt.confidence);
+  auto at = [&ratio](const double p) {
+    return ratio[static_cast<std::size_t>(std::lround(
+      p * static_cast<double>(ratio.size() - 1)))];
+  };
+  *lo = at(tail);
+  *hi = at(1 - tail);
+}
+std::string Percent(const double ratio) {
+  std::ostringstream ss;
+  ss << std::showpos << std::fixed << std::setprecision(1)
+     << 100 * (ratio - 1) << "%";
+  return ss.str();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    return -1;
+  }
+  if (opt.runs.empty()) {
+    std::cerr << "Usage:  " << argv[0] << " <RESULT JSON>... "
+              << "[--baseline=perf_baseline.json] [--threshold=0.05] "
+              << "[--confidence=0.95] [--resamples=2000] [--save]"
+              << std::endl;
+    return -1;
+  }
+  /* Run medians of each benchmark over the runs given */
+  std::map<std::string, std::vector<double>> run;
+  for (const std::string &path : opt.runs) {
+    if (!ReadFile(path, &run)) {
+      std::cerr << "ERROR: Unable to read benchmark results " << path
+                << std::endl;
+      return -1;
+    }
+  }
+  if (opt.save) {
+    std::ofstream out(opt.baseline);
+    if (!out) {
+      std::cerr << "ERROR: Unable to write " << opt.baseline << std::endl;
+      return -1;
+    }
+    out << std::fixed << std::setprecision(1) << "{\n"
+        << "  \"runs\": " << opt.runs.size() << ",\n"
+        << "  \"benchmarks\": [\n";
+    std::size_t n = 0;
+    for (const auto &[name, med] : run) {
+      out << "    {\"name\": \"" << name << "\", \"median_ns\": [";
+      for (std::size_t i = 0; i < med.size(); i++) {
+        out << (i ? ", " : "") << med[i];
+      }
+      out << "]}" << ((++n < run.size()) ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    std::cout << "Saved " << run.size() << " benchmarks from "
+              << opt.runs.size() << " runs as " << opt.baseline
+              << std::endl;
+    return 0;
+  }
+  std::map<std::string, std::vector<double>> base;
+  if (!ReadFile(opt.baseline, &base)) {
+    std::cerr << "ERROR: Unable to read baseline " << opt.baseline
+              << ", save one with --save" << std::endl;
+    return -1;
+  }
+  /* Report */
+  std::cout << "Baseline: " << opt.baseline << ", result files: "
+            << opt.runs.size() << ", threshold: " << Percent(1 + opt.threshold) << " at "
+            << 100 * opt.confidence << "% confidence" << std::endl;
+  std::cout << std::left << std::setw(18) << "Benchmark" << std::right
+            << std::setw(14) << "Baseline ns" << std::setw(14) << "New ns"
+            << std::setw(10) << "Change" << std::setw(22) << "Interval"
+            << "  Result" << std::endl;
+  std::size_t num_regressed = 0;
+  for (const auto &[name, b] : base) {
+    auto it = run.find(name);
+    std::cout << std::left << std::setw(18) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(14)
+              << Median(b);
+    if ((it == run.end()) || it->second.empty() || b.empty()) {
+      std::cout << std::setw(14) << "-" << std::setw(10) << "-"
+                << std::setw(22) << "-" << "  missing" << std::endl;
+      continue;
+    }
+    const std::vector<double> &r = it->second;
+    double ratio = (Median(b) > 0) ? Median(r) / Median(b) : 1;
+    double lo, hi;
+    RatioInterval(b, r, opt, &lo, &hi);
+    std::string result = "ok";
+    if (lo > 1 + opt.threshold) {
+      result = "REGRESSED";
+      num_regressed++;
+    } else if (ratio > 1 + opt.threshold) {
+      result = "noisy, not significant";
+    } else if (hi < 1 - opt.threshold) {
+      result = "improved";
+    }
+    std::cout << std::setw(14) << Median(r) << std::setw(10)
+              << Percent(ratio) << std::setw(22)
+              << "[" + Percent(lo) + ", " + Percent(hi) + "]" << "  "
+              << result << std::endl;
+  }
+  for (const auto &[name, r] : run) {
+    if (base.count(name)) {continue;}
+    std::cout << std::left << std::setw(18) << name << std::right
+              << std::setw(14) << "-" << std::setw(14) << Median(r)
+              << std::setw(10) << "-" << std::setw(22) << "-"
+              << "  new, not in baseline" << std::endl;
+  }
+  if (num_regressed > 0) {
+    std::cout << "FAIL: " << num_regressed << " benchmark"
+              << ((num_regressed > 1) ? "s" : "") << " slower than the "
+              << "baseline by more than " << Percent(1 + opt.threshold)
+              << std::endl;
+    return 1;
+  }
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
@@ -0,0 +1,381 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+/*
+* Deterministic replay regression suite. Every recorded flight datalog in
+* the corpus is replayed through the host build of the flight software by
+* flight_replay, each an independent process, since the flight software
+* modules hold their state in file scope, launched from a pool of worker
+* threads, one per core by default. Each replay traces every frame output,
+* nav, VMS, and the effector commands written, and writes a new datalog;
+* both are compared exactly with the golden files of the flight, so any
+* change in output, down to the last bit of a float or byte of the encoded
+* log, fails the flight. Golden files are written with --update and are
+* only valid for the host compiler and platform that wrote them.
+*/
+
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "hal/host_tool.h"
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+/* Suite settings */
+struct Options {
+  std::string replay;
+  std::string golden = "golden";
+  std::string work_dir = "replay_suite";
+  std::size_t jobs = 0;
+  bool update = false;
+  double max_s = 60;
+  /* Flight datalogs and directories of them */
+  std::vector<std::string> corpus;
+};
+/* Result of replaying a flight */
+struct Result {
+  bool pass = false;
+  std::string msg;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  if (arg == "--update") {
+    opt->update = true;
+    return true;
+  }
+  if (arg.rfind("--", 0) != 0) {
+    opt->corpus.push_back(arg);
+    return true;
+  }
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "replay") {
+    opt->replay = val;
+  } else if (key == "golden") {
+    opt->golden = val;
+  } else if (key == "work-dir") {
+    opt->work_dir = val;
+  } else if (key == "jobs") {
+    opt->jobs = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->jobs == 0) {return false;}
+  } else if (key == "max-s") {
+    opt->max_s = std::strtod(val.c_str(), nullptr);
+  } else {
+    return false;
+  }
+  return true;
+}
+/* Flight datalogs of the corpus, sorted so the report order is stable */
+std::vector<fs::path> Flights(const std::vector<std::string> &corpus) {
+  std::vector<fs::path> flights;
+  for (const std::string &entry : corpus) {
+    if (fs::is_directory(entry)) {
+      for (const fs::directory_entry &f : fs::directory_iterator(entry)) {
+        if (f.is_regular_file() && (f.path().extension() == ".bfs")) {
+          flights.push_back(f.path());
+        }
+      }
+    } else {
+      flights.push_back(entry);
+    }
+  }
+  std::sort(flights.begin(), flights.end());
+  return flights;
+}
+/* Runs flight_replay, returns its exit status or -1 if it didn't run */
+int Launch(const Options &opt, const fs::path &flight, const fs::path &out) {
+  std::vector<std::string> args = {
+    opt.replay, flight.string(),
+    "--out=" + out.string() + ".bfs",
+    "--trace=" + out.string() + ".csv"
+  };
+  std::vector<char *> argv;
+  for (std::string &a : args) {argv.push_back(a.data());}
+  argv.push_back(nullptr);
+  /* Console output goes to a log per flight */
+  std::string log = out.string() + ".txt";
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  pid_t pid;
+  int err = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(),
+                        environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0) {return -1;}
+  int status;
+  if (waitpid(pid, &status, 0) != pid) {return -1;}
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+bool ReadFile(const fs::path &path, std::string * const data) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {return false;}
+  data->assign(std::istreambuf_iterator<char>(file),
+               std::istreambuf_iterator<char>());
+  return true;
+}
+/* Splits a line of the trace into its fields */
+void Split(std::string_view line, std::vector<std::string_view> * const f) {
+  f->clear();
+  for (std::size_t pos = 0;;) {
+    std::size_t end = line.find(',', pos);
+    f->push_back(line.substr(pos, end - pos));
+    if (end == std::string_view::npos) {return;}
+    pos = end + 1;
+  }
+}
+/*
+* Compares a trace with its golden trace, field by field. Returns an
+* empty string if they match, otherwise the first difference, the number
+* of frames and values that differ, and the fields that differ.
+*/
+std::string CompareTrace(const std::string &golden, const std::string &trace) {
+  std::istringstream g(golden), t(trace);
+  std::string g_line, t_line;
+  std::getline(g, g_line);
+  std::getline(t, t_line);
+  if (g_line != t_line) {return "trace fields differ from the golden";}
+  std::vector<std::string_view> names, g_val, t_val;
+  Split(g_line, &names);
+  std::vector<std::size_t> field_diffs(names.size(), 0);
+  std::size_t frame = 0, num_frames = 0, num_values = 0;
+  std::ostringstream first;
+  while (true) {
+    bool g_more = static_cast<bool>(std::getline(g, g_line));
+    bool t_more = static_cast<bool>(std::getline(t, t_line));
+    if (!g_more || !t_more) {
+      if (g_more || t_more) {
+        std::ostringstream ss;
+        ss << "frame count differs from the golden, first at frame " << frame;
+        if (num_frames == 0) {return ss.str();}
+        first << "; " << ss.str();
+      }
+      break;
+    }
+    if (g_line != t_line) {
+      Split(g_line, &g_val);
+      Split(t_line, &t_val);
+      if (g_val.size() != t_val.size()) {
+        first << "frame " << frame << " is malformed";
+        return first.str();
+      }
+      for (std::size_t i = 0; i < g_val.size(); i++) {
+        if (g_val[i] == t_val[i]) {continue;}
+        if (num_values == 0) {
+          first << "frame " << frame << " " << names[i] << ": golden "
+                << g_val[i] << ", replay " << t_val[i];
+        }
+        field_diffs[i]++;
+        num_values++;
+      }
+      num_frames++;
+    }
+    frame++;
+  }
+  if (first.str().empty()) {return "";}
+  std::ostringstream ss;
+  ss << first.str();
+  if (num_frames > 0) {
+    ss << " (" << num_frames << " frames, " << num_values
+       << " values differ in";
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < names.size(); i++) {
+      if (field_diffs[i] == 0) {continue;}
+      if (n++ == 5) {
+        ss << " ...";
+        break;
+      }
+      ss << " " << names[i];
+    }
+    ss << ")";
+  }
+  return ss.str();
+}
+/* Compares a datalog with its golden datalog, byte by byte */
+std::string CompareLog(const std::string &golden, const std::string &log) {
+  auto diff = std::mismatch(golden.begin(), golden.end(), log.begin(),
+                            log.end());
+  if ((diff.first == golden.end()) && (diff.second == log.end())) {
+    return "";
+  }
+  std::ostringstream ss;
+  ss << "datalog differs from the golden at byte "
+     << (diff.first - golden.begin()) << " (golden " << golden.size()
+     << " bytes, replay " << log.size() << " bytes)";
+  return ss.str();
+}
+/* Replays a flight and checks it against, or saves, its golden files */
+Result Check(const Options &opt, const fs::path &flight) {
+  Result res;
+  std::string name = flight.stem().string();
+  fs::path out = fs::path(opt.work_dir) / name;
+  fs::path golden = fs::path(opt.golden) / name;
+  int status = Launch(opt, flight, out);
+  if (status < 0) {
+    res.msg = "unable to run " + opt.replay;
+    return res;
+  }
+  if (status != 0) {
+    res.msg = "flight_replay exited with status " + std::to_string(status) +
+              ", see " + out.string() + ".txt";
+    return res;
+  }
+  if (opt.update) {
+    std::error_code ec;
+    for (const char *ext : {".csv", ".bfs"}) {
+      fs::copy_file(out.string() + ext, golden.string() + ext,
+                    fs::copy_options::overwrite_existing, ec);
+      if (ec) {
+        res.msg = "unable to write " + golden.string() + ext;
+        return res;
+      }
+    }
+    res.pass = true;
+    res.msg = "golden updated";
+    return res;
+  }
+  std::string g_trace, trace, g_log, log;
+  if (!ReadFile(golden.string() + ".csv", &g_trace) ||
+      !ReadFile(golden.string() + ".bfs", &g_log)) {
+    res.msg = "no golden files in " + opt.golden;
+    return res;
+  }
+  if (!ReadFile(out.string() + ".csv", &trace) ||
+      !ReadFile(out.string() + ".bfs", &log)) {
+    res.msg = "flight_replay wrote no output";
+    return res;
+  }
+  res.msg = CompareTrace(g_trace, trace);
+  std::string log_msg = CompareLog(g_log, log);
+  if (!log_msg.empty()) {
+    res.msg += (res.msg.empty() ? "" : "; ") + log_msg;
+  }
+  res.pass = res.msg.empty();
+  return res;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    return -1;
+  }
+  if (opt.corpus.empty()) {
+    std::cerr << "Usage:  " << argv[0] << " <FLIGHT DATA FILES OR DIRS> "
+              << "[--golden=golden] [--update] [--jobs=cores] "
+              << "[--work-dir=replay_suite] [--replay=flight_replay] "
+              << "[--max-s=60]" << std::endl;
+    return -1;
+  }
+  if (opt.replay.empty()) {
+    opt.replay = (fs::absolute(argv[0]).parent_path() /
+                  "flight_replay").string();
+  }
+  if (opt.jobs == 0) {
+    opt.jobs = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  std::vector<fs::path> flights = Flights(opt.corpus);
+  if (flights.empty()) {
+    std::cerr << "ERROR: No flight datalogs found" << std::endl;
+    return -1;
+  }
+  /* Outputs and golden files are named by flight */
+  for (std::size_t i = 1; i < flights.size(); i++) {
+    for (std::size_t j = 0; j < i; j++) {
+      if (flights[i].stem() == flights[j].stem()) {
+        std::cerr << "ERROR: " << flights[i] << " and " << flights[j]
+                  << " have the same name" << std::endl;
+        return -1;
+      }
+    }
+  }
+  std::error_code ec;
+  fs::create_directories(opt.work_dir, ec);
+  if (!ec && opt.update) {fs::create_directories(opt.golden, ec);}
+  if (ec) {
+    std::cerr << "ERROR: Unable to create " << opt.work_dir << " or "
+              << opt.golden << std::endl;
+    return -1;
+  }
+  std::vector<Result> results(flights.size());
+  std::mutex mtx;
+  std::size_t num_done = 0;
+  std::atomic<std::size_t> next = 0;
+  auto worker = [&]() {
+    for (std::size_t i = next++; i < flights.size(); i = next++) {
+      results[i] = Check(opt, flights[i]);
+      std::lock_guard<std::mutex> lock(mtx);
+      num_done++;
+      std::cout << "\rCompleted " << num_done << " of " << flights.size()
+                << std::flush;
+    }
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t i = 0; i < std::min(opt.jobs, flights.size()); i++) {
+    pool.emplace_back(worker);
+  }
+  for (std::thread &t : pool) {t.join();}
+  double wall_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  std::cout << std::endl;
+  std::size_t num_pass = 0;
+  for (std::size_t i = 0; i < flights.size(); i++) {
+    const Result &res = results[i];
+    if (res.pass) {num_pass++;}
+    std::cout << (res.pass ? "PASS " : "FAIL ")
+              << flights[i].filename().string();
+    if (!res.msg.empty()) {std::cout << ": " << res.msg;}
+    std::cout << std::endl;
+  }
+  bool slow = (opt.max_s > 0) && (wall_s > opt.max_s);
+  std::cout << "Flights: " << flights.size() << " on " << pool.size()
+            << " jobs in " << wall_s << " s" << std::endl
+            << "Passed: " << num_pass << " of " << flights.size()
+            << std::endl;
+  if (slow) {
+    std::cout << "FAIL: suite took longer than " << opt.max_s << " s"
+              << std::endl;
+  }
+  return ((num_pass == flights.size()) && !slow) ? 0 : 1;
+}
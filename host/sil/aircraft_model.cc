@@ -0,0 +1,240 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/aircraft_model.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include "sil/atmosphere.h"
+
+namespace {
+static constexpr double DEG2RAD_ = std::numbers::pi / 180.0;
+/* Below this airspeed the aerodynamic forces are neglected, m/s */
+static constexpr double MIN_AIRSPEED_MPS_ = 0.1;
+}  // namespace
+
+bool AircraftModel::Config(const AircraftParams &p, const WindConfig &wind,
+                           const uint32_t seed) {
+  mass_kg_ = p.Get("Mass.mass_kg");
+  if ((mass_kg_ <= 0) || (p.rows("Mass.inertia_kgm2") != 3) ||
+      (p.cols("Mass.inertia_kgm2") != 3)) {
+    return false;
+  }
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {
+      inertia_kgm2_[i][j] = p.Get("Mass.inertia_kgm2", i, j);
+    }
+  }
+  if (!prop_.Init(p)) {return false;}
+  fixed_wing_ = p.Has("Aero.CX.zero");
+  if (fixed_wing_) {
+    c_m_ = p.Get("Geom.c_m");
+    b_m_ = p.Get("Geom.b_m");
+    s_m2_ = p.Get("Geom.s_m2");
+    for (std::size_t i = 0; i < 3; i++) {
+      cp_cg_m_[i] = p.Get("Geom.cp_m", 0, i) - p.Get("Mass.cg_m", 0, i);
+    }
+    axis_ = static_cast<int>(p.Get("Aero.axis", 1));
+    alpha_bp_rad_ = p.Values("Aero.CntrlEff.alpha");
+    for (double &a : alpha_bp_rad_) {a *= DEG2RAD_;}
+    std::size_t n = static_cast<std::size_t>(p.Get("Surf.nSurf"));
+    std::vector<double> map = p.Values("Surf.map");
+    if ((alpha_bp_rad_.empty()) || (map.size() < n) || (s_m2_ <= 0)) {
+      return false;
+    }
+    surf_ch_.clear();
+    for (std::size_t i = 0; i < n; i++) {
+      if ((map[i] < 1) || (map[i] > NUM_SIM_EFFECTORS)) {return false;}
+      surf_ch_.push_back(static_cast<std::size_t>(map[i]) - 1);
+    }
+    surf_rate_dps_ = p.Values("Surf.Limit.rate_dps");
+    surf_pos_deg_ = p.Values("Surf.Limit.pos_deg");
+    surf_neg_deg_ = p.Values("Surf.Limit.neg_deg");
+    if ((surf_rate_dps_.size() < n) || (surf_pos_deg_.size() < n) ||
+        (surf_neg_deg_.size() < n)) {
+      return false;
+    }
+    surf_deg_.assign(n, 0);
+    LoadCoef(p, "CX", &cx_);
+    LoadCoef(p, "CY", &cy_);
+    LoadCoef(p, "CZ", &cz_);
+    LoadCoef(p, "Cl", &cl_);
+    LoadCoef(p, "Cm", &cm_);
+    LoadCoef(p, "Cn", &cn_);
+  } else {
+    cd_ = p.Get("Aero.Cd");
+    front_area_m2_ = p.Values("Geo.front_area_m2");
+    surf_ch_.clear();
+    surf_deg_.clear();
+  }
+  double cells = p.Get("Battery.nCell");
+  battery_volt_ = p.Get("Battery.voltage");
+  battery_res_ohm_ = p.Get("Battery.res_ohm", cells * CELL_RES_OHM_);
+  if (battery_volt_ <= 0) {return false;}
+  wind_cfg_ = wind;
+  seed_ = seed;
+  return true;
+}
+void AircraftModel::LoadCoef(const AircraftParams &p, const std::string &name,
+                             Coef * const c) const {
+  std::string pre = "Aero." + name + ".";
+  c->zero = p.Get(pre + "zero");
+  c->alpha = p.Get(pre + "alpha");
+  c->beta = p.Get(pre + "beta");
+  c->p = p.Get(pre + "p");
+  c->q = p.Get(pre + "q");
+  c->r = p.Get(pre + "r");
+  c->surf.assign(alpha_bp_rad_.size(),
+                 std::vector<double>(surf_ch_.size(), 0));
+  for (std::size_t i = 0; i < alpha_bp_rad_.size(); i++) {
+    for (std::size_t j = 0; j < surf_ch_.size(); j++) {
+      c->surf[i][j] = p.Get(pre + "surf", i, j);
+    }
+  }
+}
+double AircraftModel::Eval(const Coef &c, const double alpha,
+                           const double beta, const double phat,
+                           const double qhat, const double rhat) const {
+  double val = c.zero + c.alpha * alpha + c.beta * beta + c.p * phat +
+               c.q * qhat + c.r * rhat;
+  /* Surface effectiveness, interpolated in alpha and held at the ends */
+  std::size_t n = alpha_bp_rad_.size();
+  std::size_t i = 0;
+  double w = 0;
+  if (n > 1) {
+    double a = std::clamp(alpha, alpha_bp_rad_.front(), alpha_bp_rad_.back());
+    while ((i + 2 < n) && (a > alpha_bp_rad_[i + 1])) {i++;}
+    w = (a - alpha_bp_rad_[i]) / (alpha_bp_rad_[i + 1] - alpha_bp_rad_[i]);
+  }
+  for (std::size_t j = 0; j < surf_deg_.size(); j++) {
+    double eff = c.surf[i][j];
+    if (n > 1) {eff += w * (c.surf[i + 1][j] - c.surf[i][j]);}
+    val += eff * surf_deg_[j] * DEG2RAD_;
+  }
+  return val;
+}
+void AircraftModel::Aero(const Vec3 &air_vel_mps, const Vec3 &rate_radps,
+                         const double density_kgpm3, Vec3 * const force_n,
+                         Vec3 * const moment_nm) const {
+  *force_n = {0, 0, 0};
+  *moment_nm = {0, 0, 0};
+  double spd = Norm(air_vel_mps);
+  if (spd < MIN_AIRSPEED_MPS_) {return;}
+  double qbar = 0.5 * density_kgpm3 * spd * spd;
+  if (!fixed_wing_) {
+    /* Frontal area at the relative wind azimuth, evenly spaced over 360 */
+    double area = 0;
+    std::size_t n = front_area_m2_.size();
+    if (n > 1) {
+      double az = std::atan2(air_vel_mps[1], air_vel_mps[0]) / DEG2RAD_;
+      if (az < 0) {az += 360;}
+      double x = az / 360 * static_cast<double>(n - 1);
+      std::size_t i = std::min(static_cast<std::size_t>(x), n - 2);
+      area = front_area_m2_[i] + (x - static_cast<double>(i)) *
+             (front_area_m2_[i + 1] - front_area_m2_[i]);
+    } else if (n == 1) {
+      area = front_area_m2_[0];
+    }
+    *force_n = (-qbar * cd_ * area / spd) * air_vel_mps;
+    return;
+  }
+  double alpha = std::atan2(air_vel_mps[2], air_vel_mps[0]);
+  double beta = std::asin(std::clamp(air_vel_mps[1] / spd, -1.0, 1.0));
+  double phat = rate_radps[0] * b_m_ / (2 * spd);
+  double qhat = rate_radps[1] * c_m_ / (2 * spd);
+  double rhat = rate_radps[2] * b_m_ / (2 * spd);
+  double cx = Eval(cx_, alpha, beta, phat, qhat, rhat);
+  double cy = Eval(cy_, alpha, beta, phat, qhat, rhat);
+  double cz = Eval(cz_, alpha, beta, phat, qhat, rhat);
+  double ca = std::cos(alpha), sa = std::sin(alpha);
+  double cb = std::cos(beta), sb = std::sin(beta);
+  double qs = qbar * s_m2_;
+  if (axis_ == 3) {
+    /* Body axes */
+    *force_n = {qs * cx, qs * cy, qs * cz};
+  } else {
+    /* Drag, side force, and lift, in wind or stability axes */
+    Vec3 f = {-qs * cx, qs * cy, -qs * cz};
+    Mat3 c_bw;
+    if (axis_ == 2) {
+      c_bw = {{{ca, 0, -sa}, {0, 1, 0}, {sa, 0, ca}}};
+    } else {
+      c_bw = {{{ca * cb, -ca * sb, -sa},
+               {sb, cb, 0},
+               {sa * cb, -sa * sb, ca}}};
+    }
+    *force_n = c_bw * f;
+  }
+  *moment_nm = {qs * b_m_ * Eval(cl_, alpha, beta, phat, qhat, rhat),
+                qs * c_m_ * Eval(cm_, alpha, beta, phat, qhat, rhat),
+                qs * b_m_ * Eval(cn_, alpha, beta, phat, qhat, rhat)};
+  /* Transfer from the center of pressure to the c.g. */
+  *moment_nm = *moment_nm + Cross(cp_cg_m_, *force_n);
+}
+void AircraftModel::Init(const SimHome &home, SimState * const state) {
+  home_ = home;
+  wind_.Init(wind_cfg_, seed_);
+  wind_mps_ = wind_.ned_mps();
+  std::fill(surf_deg_.begin(), surf_deg_.end(), 0);
+  prop_.Reset();
+  body_.Init(mass_kg_, inertia_kgm2_, 0, home.heading_rad, state);
+  state->tas_mps = 0;
+  Step(0, {}, state);
+}
+void AircraftModel::Step(const double dt_s,
+                         const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+                         SimState * const state) {
+  if (!state) {return;}
+  Atmosphere atm = StdAtmosphere(home_.alt_m - state->ned_pos_m[2]);
+  wind_mps_ = wind_.Step(dt_s, state->tas_mps);
+  Mat3 c_nb = Transpose(QuatToDcm(state->quat));
+  Vec3 air_vel = c_nb * (state->ned_vel_mps - wind_mps_);
+  /* Control surfaces */
+  for (std::size_t i = 0; i < surf_deg_.size(); i++) {
+    double target = std::clamp(static_cast<double>(cmd[surf_ch_[i]]),
+                               surf_neg_deg_[i], surf_pos_deg_[i]);
+    double step = surf_rate_dps_[i] * dt_s;
+    surf_deg_[i] += std::clamp(target - surf_deg_[i], -step, step);
+  }
+  Vec3 aero_f, aero_m, prop_f, prop_m;
+  double current = 0;
+  Aero(air_vel, state->gyro_radps, atm.density_kgpm3, &aero_f, &aero_m);
+  prop_.Step(dt_s, cmd, battery_volt_, battery_res_ohm_, air_vel,
+             atm.density_kgpm3, &prop_f, &prop_m, &current);
+  if (dt_s > 0) {
+    body_.Step(dt_s, aero_f + prop_f, aero_m + prop_m, state);
+  }
+  /* Air data and battery at the end of the step */
+  atm = StdAtmosphere(home_.alt_m - state->ned_pos_m[2]);
+  c_nb = Transpose(QuatToDcm(state->quat));
+  air_vel = c_nb * (state->ned_vel_mps - wind_mps_);
+  state->tas_mps = Norm(air_vel);
+  state->static_pres_pa = atm.pres_pa;
+  state->air_temp_c = atm.temp_c;
+  state->diff_pres_pa = ImpactPres(std::max(air_vel[0], 0.0), atm);
+  state->battery_current_a = current + AVIONICS_A_;
+  state->battery_volt = battery_volt_ -
+                        state->battery_current_a * battery_res_ohm_;
+}
@@ -0,0 +1,108 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_AIRCRAFT_MODEL_H_
+#define HOST_SIL_AIRCRAFT_MODEL_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "sil/sim_model.h"
+#include "sil/sim_math.h"
+#include "sil/aircraft_params.h"
+#include "sil/rigid_body.h"
+#include "sil/propulsion.h"
+#include "sil/wind.h"
+
+/*
+* Six degree of freedom model of a fixed-wing or multirotor aircraft from
+* its exported simulation parameters. Fixed-wing aircraft use the
+* aerodynamic coefficient build up of the aircraft file (Aero.CX ... Cn),
+* with control surfaces moving at their rate limit toward the commanded
+* deflection, in degrees, within their position limits. Multirotors use a
+* bluff body drag (Aero.Cd) on the frontal area seen by the relative
+* wind. Both fly in the wind model with the propulsion model, on a
+* battery that sags with the current drawn.
+*/
+class AircraftModel : public SimModel {
+ public:
+  /* Configures the model, returns false if the aircraft is not supported */
+  bool Config(const AircraftParams &p, const WindConfig &wind,
+              const uint32_t seed);
+  void Init(const SimHome &home, SimState * const state) override;
+  void Step(const double dt_s,
+            const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+            SimState * const state) override;
+  inline bool fixed_wing() const {return fixed_wing_;}
+  /* Control surface deflections, deg */
+  inline const std::vector<double> & surf_deg() const {return surf_deg_;}
+  /* Wind at the last step, NED, m/s */
+  inline const Vec3 & wind_mps() const {return wind_mps_;}
+
+ private:
+  /* Aerodynamic coefficient and its derivatives */
+  struct Coef {
+    double zero, alpha, beta, p, q, r;
+    /* Surface effectiveness, per rad, at each alpha breakpoint */
+    std::vector<std::vector<double>> surf;
+  };
+  void LoadCoef(const AircraftParams &p, const std::string &name,
+                Coef * const c) const;
+  double Eval(const Coef &c, const double alpha, const double beta,
+              const double phat, const double qhat, const double rhat) const;
+  void Aero(const Vec3 &air_vel_mps, const Vec3 &rate_radps,
+            const double density_kgpm3, Vec3 * const force_n,
+            Vec3 * const moment_nm) const;
+  /* Battery internal resistance per cell, ohm, and avionics current, A */
+  static constexpr double CELL_RES_OHM_ = 0.01;
+  static constexpr double AVIONICS_A_ = 0.5;
+  double mass_kg_;
+  Mat3 inertia_kgm2_;
+  bool fixed_wing_;
+  /* Fixed-wing geometry and coefficients */
+  double c_m_, b_m_, s_m2_;
+  Vec3 cp_cg_m_;
+  int axis_;
+  std::vector<double> alpha_bp_rad_;
+  Coef cx_, cy_, cz_, cl_, cm_, cn_;
+  /* Control surfaces */
+  std::vector<std::size_t> surf_ch_;
+  std::vector<double> surf_rate_dps_, surf_pos_deg_, surf_neg_deg_;
+  std::vector<double> surf_deg_;
+  /* Multirotor drag and frontal area with relative wind azimuth */
+  double cd_;
+  std::vector<double> front_area_m2_;
+  /* Battery */
+  double battery_volt_, battery_res_ohm_;
+  SimHome home_;
+  WindConfig wind_cfg_;
+  uint32_t seed_;
+  Wind wind_;
+  Vec3 wind_mps_ = {0, 0, 0};
+  RigidBody body_;
+  Propulsion prop_;
+};
+
+#endif  // HOST_SIL_AIRCRAFT_MODEL_H_
@@ -0,0 +1,85 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/aircraft_params.h"
+#include <fstream>
+#include <sstream>
+
+bool AircraftParams::Load(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {return false;}
+  params_.clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || (line[0] == '%')) {continue;}
+    std::istringstream ss(line);
+    std::string name;
+    Param p;
+    if (!(ss >> name >> p.rows >> p.cols)) {return false;}
+    p.val.resize(p.rows * p.cols);
+    for (double &v : p.val) {
+      if (!(ss >> v)) {return false;}
+    }
+    params_[name] = p;
+  }
+  return true;
+}
+bool AircraftParams::Has(const std::string &name) const {
+  return params_.count(name);
+}
+double AircraftParams::Get(const std::string &name, const double def) const {
+  return Get(name, 0, 0, def);
+}
+double AircraftParams::Get(const std::string &name, const std::size_t row,
+                           const std::size_t col, const double def) const {
+  auto p = params_.find(name);
+  if ((p == params_.end()) || (row >= p->second.rows) ||
+      (col >= p->second.cols)) {
+    return def;
+  }
+  return p->second.val[row * p->second.cols + col];
+}
+bool AircraftParams::Set(const std::string &name, const std::size_t row,
+                         const std::size_t col, const double val) {
+  auto p = params_.find(name);
+  if ((p == params_.end()) || (row >= p->second.rows) ||
+      (col >= p->second.cols)) {
+    return false;
+  }
+  p->second.val[row * p->second.cols + col] = val;
+  return true;
+}
+std::vector<double> AircraftParams::Values(const std::string &name) const {
+  auto p = params_.find(name);
+  return (p == params_.end()) ? std::vector<double>() : p->second.val;
+}
+std::size_t AircraftParams::rows(const std::string &name) const {
+  auto p = params_.find(name);
+  return (p == params_.end()) ? 0 : p->second.rows;
+}
+std::size_t AircraftParams::cols(const std::string &name) const {
+  auto p = params_.find(name);
+  return (p == params_.end()) ? 0 : p->second.cols;
+}
@@ -0,0 +1,67 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_AIRCRAFT_PARAMS_H_
+#define HOST_SIL_AIRCRAFT_PARAMS_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* Aircraft parameters exported from the simulation aircraft configuration
+* scripts by simulation/matlab/export_aircraft.m. Parameters are named
+* relative to the Aircraft struct, i.e. "Mass.mass_kg", and hold a matrix
+* stored in row order.
+*/
+class AircraftParams {
+ public:
+  /* Loads a data file, returns false on failure */
+  bool Load(const std::string &path);
+  bool Has(const std::string &name) const;
+  /* First value of a parameter, or the default if it is missing */
+  double Get(const std::string &name, const double def = 0) const;
+  /* Value at a row and column, 0-based, or the default if missing */
+  double Get(const std::string &name, const std::size_t row,
+             const std::size_t col, const double def = 0) const;
+  /* Sets a value of an existing parameter, returns false if missing */
+  bool Set(const std::string &name, const std::size_t row,
+           const std::size_t col, const double val);
+  /* All values, in row order, empty if missing */
+  std::vector<double> Values(const std::string &name) const;
+  std::size_t rows(const std::string &name) const;
+  std::size_t cols(const std::string &name) const;
+
+ private:
+  struct Param {
+    std::size_t rows;
+    std::size_t cols;
+    std::vector<double> val;
+  };
+  std::map<std::string, Param> params_;
+};
+
+#endif  // HOST_SIL_AIRCRAFT_PARAMS_H_
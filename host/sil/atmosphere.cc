@@ -0,0 +1,53 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/atmosphere.h"
+#include <cmath>
+
+namespace {
+static constexpr double P0_PA_ = 101325;
+static constexpr double T0_K_ = 288.15;
+static constexpr double LAPSE_KPM_ = 0.0065;
+static constexpr double R_JPKGK_ = 287.05;
+static constexpr double GAMMA_ = 1.4;
+static constexpr double G_MPS2_ = 9.80665;
+static constexpr double C_TO_K_ = 273.15;
+}  // namespace
+
+Atmosphere StdAtmosphere(const double alt_m, const double temp_offset_c) {
+  Atmosphere atm;
+  double t_std_k = T0_K_ - LAPSE_KPM_ * alt_m;
+  double t_k = t_std_k + temp_offset_c;
+  atm.pres_pa = P0_PA_ * std::pow(t_std_k / T0_K_,
+                                  G_MPS2_ / (LAPSE_KPM_ * R_JPKGK_));
+  atm.temp_c = t_k - C_TO_K_;
+  atm.density_kgpm3 = atm.pres_pa / (R_JPKGK_ * t_k);
+  atm.sound_mps = std::sqrt(GAMMA_ * R_JPKGK_ * t_k);
+  return atm;
+}
+double ImpactPres(const double tas_mps, const Atmosphere &atm) {
+  double mach = tas_mps / atm.sound_mps;
+  return atm.pres_pa * (std::pow(1 + 0.2 * mach * mach, 3.5) - 1);
+}
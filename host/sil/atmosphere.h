@@ -0,0 +1,45 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_ATMOSPHERE_H_
+#define HOST_SIL_ATMOSPHERE_H_
+
+/* Standard atmosphere properties */
+struct Atmosphere {
+  double pres_pa;
+  double temp_c;
+  double density_kgpm3;
+  double sound_mps;
+};
+/*
+* 1976 standard atmosphere in the troposphere, at an altitude in m. A
+* temperature offset from standard changes the density and speed of sound
+* but not the pressure.
+*/
+Atmosphere StdAtmosphere(const double alt_m, const double temp_offset_c = 0);
+/* Pitot differential pressure at a true airspeed, Pa */
+double ImpactPres(const double tas_mps, const Atmosphere &atm);
+
+#endif  // HOST_SIL_ATMOSPHERE_H_
@@ -0,0 +1,54 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/ground_model.h"
+#include "sil/atmosphere.h"
+
+namespace {
+/* Nominal 3 cell battery */
+static constexpr double BATTERY_VOLT_ = 11.1;
+static constexpr double BATTERY_CURRENT_A_ = 0.5;
+}  // namespace
+
+void GroundModel::Init(const SimHome &home, SimState * const state) {
+  home_ = home;
+  body_.Init(mass_kg_, inertia_kgm2_, 0, home.heading_rad, state);
+  Step(0, {}, state);
+}
+void GroundModel::Step(const double dt_s,
+                       const std::array<float, NUM_SIM_EFFECTORS> &,
+                       SimState * const state) {
+  if (!state) {return;}
+  if (dt_s > 0) {
+    body_.Step(dt_s, {0, 0, 0}, {0, 0, 0}, state);
+  }
+  Atmosphere atm = StdAtmosphere(home_.alt_m - state->ned_pos_m[2]);
+  state->static_pres_pa = atm.pres_pa;
+  state->air_temp_c = atm.temp_c;
+  state->tas_mps = 0;
+  state->diff_pres_pa = 0;
+  state->battery_volt = BATTERY_VOLT_;
+  state->battery_current_a = BATTERY_CURRENT_A_;
+}
@@ -0,0 +1,60 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_GROUND_MODEL_H_
+#define HOST_SIL_GROUND_MODEL_H_
+
+#include <array>
+#include "sil/sim_model.h"
+#include "sil/sim_math.h"
+#include "sil/rigid_body.h"
+
+/*
+* An aircraft sitting on the ground at home with no aerodynamics or
+* propulsion: effector commands are ignored. Used to exercise the flight
+* software on the bench, such as nav alignment, inceptor handling, and
+* the datalog, before an aircraft model is chosen.
+*/
+class GroundModel : public SimModel {
+ public:
+  /* Defaults are the Ultra Stick 25e mass properties */
+  GroundModel(const double mass_kg = 1.959,
+              const Mat3 &inertia_kgm2 = {{{0.07151, 0, -0.014},
+                                           {0, 0.08636, 0},
+                                           {-0.014, 0, 0.15364}}})
+    : mass_kg_(mass_kg), inertia_kgm2_(inertia_kgm2) {}
+  void Init(const SimHome &home, SimState * const state) override;
+  void Step(const double dt_s,
+            const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+            SimState * const state) override;
+
+ private:
+  double mass_kg_;
+  Mat3 inertia_kgm2_;
+  SimHome home_;
+  RigidBody body_;
+};
+
+#endif  // HOST_SIL_GROUND_MODEL_H_
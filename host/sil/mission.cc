@@ -0,0 +1,161 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/mission.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numbers>
+#include <sstream>
+
+namespace {
+static constexpr double DEG2RAD = std::numbers::pi / 180.0;
+static constexpr double RAD2DEG = 180.0 / std::numbers::pi;
+/* MAVLink waypoint command, with altitude relative to home */
+static constexpr uint16_t MAV_CMD_NAV_WAYPOINT_ = 16;
+static constexpr uint8_t MAV_FRAME_GLOBAL_RELATIVE_ALT_INT_ = 6;
+}  // namespace
+
+bool MissionLoad(const std::string &path,
+                 std::vector<bfs::MissionItem> * const plan) {
+  std::ifstream file(path);
+  if (!file) {return false;}
+  plan->clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || (line[0] == '%')) {continue;}
+    std::istringstream ss(line);
+    double lat_deg, lon_deg, alt_m;
+    if (!(ss >> lat_deg >> lon_deg >> alt_m)) {return false;}
+    bfs::MissionItem item = {};
+    item.autocontinue = true;
+    item.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT_INT_;
+    item.cmd = MAV_CMD_NAV_WAYPOINT_;
+    item.x = static_cast<int32_t>(std::lround(lat_deg * 1e7));
+    item.y = static_cast<int32_t>(std::lround(lon_deg * 1e7));
+    item.z = static_cast<float>(alt_m);
+    plan->push_back(item);
+  }
+  return true;
+}
+
+std::string MissionStatsHeader() {
+  return "airborne_s,waypoints_reached,xtrack_rms_m,xtrack_max_m,"
+         "alt_err_rms_m,alt_err_max_m,max_roll_deg,max_pitch_deg,"
+         "max_tas_mps,min_battery_volt,touchdown_mps";
+}
+
+std::string MissionStatsRow(const MissionStats &s) {
+  std::ostringstream ss;
+  ss << s.airborne_s << "," << s.waypoints_reached << ","
+     << s.xtrack_rms_m << "," << s.xtrack_max_m << ","
+     << s.alt_err_rms_m << "," << s.alt_err_max_m << ","
+     << s.max_roll_deg << "," << s.max_pitch_deg << ","
+     << s.max_tas_mps << "," << s.min_battery_volt << ","
+     << s.touchdown_mps;
+  return ss.str();
+}
+
+void MissionTracker::Init(const SimHome &home,
+                          const std::vector<bfs::MissionItem> &plan) {
+  double rm, rn;
+  EarthRadii(home.lat_rad, &rm, &rn);
+  wp_ned_m_.clear();
+  for (const bfs::MissionItem &item : plan) {
+    double lat_rad = static_cast<double>(item.x) * 1e-7 * DEG2RAD;
+    double lon_rad = static_cast<double>(item.y) * 1e-7 * DEG2RAD;
+    wp_ned_m_.push_back({(lat_rad - home.lat_rad) * rm,
+                         (lon_rad - home.lon_rad) * rn *
+                         std::cos(home.lat_rad),
+                         -static_cast<double>(item.z)});
+  }
+  stats_ = {};
+  stats_.min_battery_volt = std::numeric_limits<double>::max();
+  on_ground_ = true;
+  waypoint_reached_ = false;
+  prev_down_mps_ = 0;
+  xtrack_sq_sum_ = 0;
+  alt_err_sq_sum_ = 0;
+}
+
+void MissionTracker::Update(const double dt_s, const SimState &state,
+                            const bool waypoint_reached) {
+  if (waypoint_reached && !waypoint_reached_) {stats_.waypoints_reached++;}
+  waypoint_reached_ = waypoint_reached;
+  stats_.min_battery_volt = std::min(stats_.min_battery_volt,
+                                     state.battery_volt);
+  if (state.on_ground) {
+    if (!on_ground_) {
+      stats_.touchdown_mps = std::max(stats_.touchdown_mps, prev_down_mps_);
+    }
+    on_ground_ = true;
+    return;
+  }
+  on_ground_ = false;
+  prev_down_mps_ = state.ned_vel_mps[2];
+  stats_.airborne_s += dt_s;
+  stats_.max_roll_deg = std::max(stats_.max_roll_deg,
+                                 std::abs(state.roll_rad) * RAD2DEG);
+  stats_.max_pitch_deg = std::max(stats_.max_pitch_deg,
+                                  std::abs(state.pitch_rad) * RAD2DEG);
+  stats_.max_tas_mps = std::max(stats_.max_tas_mps, state.tas_mps);
+  if (wp_ned_m_.empty()) {return;}
+  /* Nearest point on the path, horizontally */
+  double xtrack = std::numeric_limits<double>::max();
+  double alt_err = 0;
+  Vec3 p = state.ned_pos_m;
+  std::size_t num_legs = std::max<std::size_t>(wp_ned_m_.size() - 1, 1);
+  for (std::size_t i = 0; i < num_legs; i++) {
+    const Vec3 &a = wp_ned_m_[i];
+    const Vec3 &b = wp_ned_m_[std::min(i + 1, wp_ned_m_.size() - 1)];
+    Vec3 leg = {b[0] - a[0], b[1] - a[1], 0};
+    Vec3 rel = {p[0] - a[0], p[1] - a[1], 0};
+    double len_sq = Dot(leg, leg);
+    double t = (len_sq > 0) ? std::clamp(Dot(rel, leg) / len_sq, 0.0, 1.0) :
+               0.0;
+    double d = Norm(rel - t * leg);
+    if (d < xtrack) {
+      xtrack = d;
+      alt_err = std::abs(p[2] - (a[2] + t * (b[2] - a[2])));
+    }
+  }
+  xtrack_sq_sum_ += xtrack * xtrack * dt_s;
+  alt_err_sq_sum_ += alt_err * alt_err * dt_s;
+  stats_.xtrack_max_m = std::max(stats_.xtrack_max_m, xtrack);
+  stats_.alt_err_max_m = std::max(stats_.alt_err_max_m, alt_err);
+}
+
+MissionStats MissionTracker::stats() const {
+  MissionStats s = stats_;
+  if (s.airborne_s > 0) {
+    s.xtrack_rms_m = std::sqrt(xtrack_sq_sum_ / s.airborne_s);
+    s.alt_err_rms_m = std::sqrt(alt_err_sq_sum_ / s.airborne_s);
+  }
+  if (s.min_battery_volt == std::numeric_limits<double>::max()) {
+    s.min_battery_volt = 0;
+  }
+  return s;
+}
@@ -0,0 +1,89 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_MISSION_H_
+#define HOST_SIL_MISSION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+#include "sil/sim_model.h"
+#include "sil/sim_math.h"
+
+/*
+* Loads a flight plan for the SIL harness. The file has a waypoint per
+* line: latitude and longitude, deg, and altitude relative to home, m, as
+* a ground station would upload them. Lines starting with '%' are
+* comments. Returns false if the file can't be read or a line is bad.
+*/
+bool MissionLoad(const std::string &path,
+                 std::vector<bfs::MissionItem> * const plan);
+
+/* Metrics of a run, accumulated while airborne */
+struct MissionStats {
+  double airborne_s;
+  int32_t waypoints_reached;
+  /* Horizontal distance from the flight plan path, m */
+  double xtrack_rms_m;
+  double xtrack_max_m;
+  /* Altitude error at the closest point on the path, m */
+  double alt_err_rms_m;
+  double alt_err_max_m;
+  double max_roll_deg;
+  double max_pitch_deg;
+  double max_tas_mps;
+  double min_battery_volt;
+  /* Largest descent rate on touching down, m/s */
+  double touchdown_mps;
+};
+
+/* CSV column names and values of the run metrics */
+std::string MissionStatsHeader();
+std::string MissionStatsRow(const MissionStats &s);
+
+/*
+* Tracks the simulated aircraft against the flight plan. Tracking error
+* is taken to the nearest leg of the path, so it doesn't depend on the
+* VMS waypoint logic; with no flight plan the tracking errors are zero.
+*/
+class MissionTracker {
+ public:
+  void Init(const SimHome &home, const std::vector<bfs::MissionItem> &plan);
+  void Update(const double dt_s, const SimState &state,
+              const bool waypoint_reached);
+  MissionStats stats() const;
+
+ private:
+  /* Waypoints relative to home, NED, m */
+  std::vector<Vec3> wp_ned_m_;
+  MissionStats stats_;
+  bool on_ground_;
+  bool waypoint_reached_;
+  double prev_down_mps_;
+  double xtrack_sq_sum_, alt_err_sq_sum_;
+};
+
+#endif  // HOST_SIL_MISSION_H_
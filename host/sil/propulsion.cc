@@ -0,0 +1,137 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/propulsion.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace {
+static constexpr double IN2M_ = 0.0254;
+static constexpr double TWO_PI_ = 2 * std::numbers::pi;
+}  // namespace
+
+double PolyVal(const std::vector<double> &c, const double x) {
+  double y = 0;
+  for (double v : c) {y = y * x + v;}
+  return y;
+}
+bool Propulsion::Init(const AircraftParams &p) {
+  motors_.clear();
+  std::size_t n = static_cast<std::size_t>(p.Get("Motor.nMotor"));
+  std::vector<double> map = p.Values("Motor.map");
+  if ((n == 0) || (map.size() < n)) {return false;}
+  prop_curves_ = p.Has("prop.ct") && p.Has("prop.cp");
+  if (!prop_curves_ && !p.Has("Prop.poly_thrust")) {return false;}
+  for (std::size_t i = 0; i < n; i++) {
+    if ((map[i] < 1) || (map[i] > NUM_SIM_EFFECTORS)) {return false;}
+    Motor m;
+    m.ch = static_cast<std::size_t>(map[i]) - 1;
+    for (std::size_t j = 0; j < 3; j++) {
+      m.pos_m[j] = p.Get("Motor.pos_m", i, j);
+      m.align[j] = p.Get("Motor.align", i, j);
+    }
+    /*
+    * Rotors spin right handed about -dir times the thrust axis, i.e. about
+    * z for dir of 1 on a multirotor. Without a direction, propellers turn
+    * clockwise seen from behind.
+    */
+    m.dir = p.Get("Motor.dir", i, 0, -1);
+    m.state = 0;
+    motors_.push_back(m);
+  }
+  kv_radpspv_ = p.Get("Motor.kv") * TWO_PI_ / 60;
+  r_ohm_ = p.Get("Motor.r");
+  io_a_ = p.Get("Motor.io");
+  kq_nmpa_ = p.Get("Motor.kq", (kv_radpspv_ > 0) ? 1 / kv_radpspv_ : 0);
+  tau_s_ = p.Get("Motor.tau_s", TAU_S_);
+  imax_a_ = p.Get("Motor.imax_a", IMAX_A_);
+  dia_m_ = p.Get("Prop.dia_in") * IN2M_;
+  inertia_kgm2_ = p.Get("Prop.Jmp_kgm2");
+  ct_ = p.Values("prop.ct");
+  cp_ = p.Values("prop.cp");
+  thrust_poly_ = p.Values("Prop.poly_thrust");
+  torque_poly_ = p.Values("Prop.poly_torque");
+  if (prop_curves_ && ((kv_radpspv_ <= 0) || (r_ohm_ <= 0) ||
+                       (dia_m_ <= 0) || (inertia_kgm2_ <= 0))) {
+    return false;
+  }
+  return true;
+}
+void Propulsion::Reset() {
+  for (Motor &m : motors_) {m.state = 0;}
+}
+void Propulsion::Step(const double dt_s,
+                      const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+                      const double battery_volt, const double battery_ohm,
+                      const Vec3 &air_vel_mps,
+                      const double density_kgpm3, Vec3 * const force_n,
+                      Vec3 * const moment_nm, double * const current_a) {
+  *force_n = {0, 0, 0};
+  *moment_nm = {0, 0, 0};
+  *current_a = 0;
+  for (Motor &m : motors_) {
+    double throttle = std::clamp(static_cast<double>(cmd[m.ch]), 0.0, 1.0);
+    double thrust, torque;
+    if (prop_curves_) {
+      /*
+      * DC motor on the ESC average voltage, no regeneration. The battery
+      * resistance, shared by the motors, is seen through the ESC duty.
+      */
+      double volt = throttle * battery_volt;
+      double ohm = r_ohm_ + throttle * throttle * battery_ohm *
+                   static_cast<double>(motors_.size());
+      double amps = std::clamp((volt - m.state / kv_radpspv_) / ohm, 0.0,
+                               imax_a_);
+      double motor_torque = std::max(amps - io_a_, 0.0) / kv_radpspv_;
+      /* Propeller at the current advance ratio */
+      double rev_ps = m.state / TWO_PI_;
+      double axial = std::max(Dot(air_vel_mps, m.align), 0.0);
+      double j = (rev_ps > 0) ? axial / (rev_ps * dia_m_) : 0;
+      double ct = std::max(PolyVal(ct_, j), 0.0);
+      double cp = std::max(PolyVal(cp_, j), 0.0);
+      thrust = ct * density_kgpm3 * rev_ps * rev_ps * std::pow(dia_m_, 4);
+      torque = cp * density_kgpm3 * rev_ps * rev_ps * std::pow(dia_m_, 5) /
+               TWO_PI_;
+      m.state = std::max(m.state + dt_s * (motor_torque - torque) /
+                         inertia_kgm2_, 0.0);
+      *current_a += amps * throttle;
+    } else {
+      m.state += (tau_s_ > 0) ? (throttle - m.state) *
+                 std::min(dt_s / tau_s_, 1.0) : throttle - m.state;
+      thrust = (m.state > 0) ? std::max(PolyVal(thrust_poly_, m.state), 0.0) :
+               0;
+      torque = (m.state > 0) ? std::max(PolyVal(torque_poly_, m.state), 0.0) :
+               0;
+      if ((thrust > 0) && (kq_nmpa_ > 0)) {
+        *current_a += torque / kq_nmpa_ + io_a_;
+      }
+    }
+    Vec3 f = thrust * m.align;
+    /* The rotor drag torque acts on the body opposite its spin */
+    *force_n = *force_n + f;
+    *moment_nm = *moment_nm + Cross(m.pos_m, f) + (m.dir * torque) * m.align;
+  }
+}
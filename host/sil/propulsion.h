@@ -0,0 +1,91 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_PROPULSION_H_
+#define HOST_SIL_PROPULSION_H_
+
+#include <array>
+#include <vector>
+#include "sil/sim_model.h"
+#include "sil/sim_math.h"
+#include "sil/aircraft_params.h"
+
+/*
+* Electric motors and propellers of an aircraft, commanded by their
+* effector channels with a power lever command from 0 to 1. Aircraft with
+* propeller thrust and power curves (prop.ct, prop.cp) are modeled with a
+* DC motor (Motor.kv, Motor.r, Motor.io) driving the propeller inertia,
+* so thrust varies with advance ratio and battery voltage, with the ESC
+* limiting the current to Motor.imax_a. Aircraft with
+* static thrust and torque polynomials of the command (Prop.poly_thrust,
+* Prop.poly_torque), as used by the multirotors, follow the command with
+* a first order lag, Motor.tau_s.
+*/
+class Propulsion {
+ public:
+  /* Configures the motors, returns false if the parameters are missing */
+  bool Init(const AircraftParams &p);
+  /* Stops the motors */
+  void Reset();
+  /*
+  * Advances the motors by dt, given the battery open circuit voltage and
+  * internal resistance and the air velocity in body axes, m/s. Returns
+  * the force and moment about the c.g., body axes, and the current
+  * drawn from the battery.
+  */
+  void Step(const double dt_s,
+            const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+            const double battery_volt, const double battery_ohm,
+            const Vec3 &air_vel_mps,
+            const double density_kgpm3, Vec3 * const force_n,
+            Vec3 * const moment_nm, double * const current_a);
+  inline std::size_t num_motors() const {return motors_.size();}
+
+ private:
+  /* Default motor time constant for the polynomial model, s */
+  static constexpr double TAU_S_ = 0.05;
+  /* Default ESC current limit, A */
+  static constexpr double IMAX_A_ = 60;
+  struct Motor {
+    std::size_t ch;
+    Vec3 pos_m;
+    Vec3 align;
+    double dir;
+    /* Rotor speed, rad/s, or lagged command for the polynomial model */
+    double state;
+  };
+  std::vector<Motor> motors_;
+  bool prop_curves_ = false;
+  /* Motor constants */
+  double kv_radpspv_, r_ohm_, io_a_, kq_nmpa_, tau_s_, imax_a_;
+  /* Propeller */
+  double dia_m_, inertia_kgm2_;
+  std::vector<double> ct_, cp_, thrust_poly_, torque_poly_;
+};
+
+/* Evaluates a polynomial, coefficients from the highest order down */
+double PolyVal(const std::vector<double> &c, const double x);
+
+#endif  // HOST_SIL_PROPULSION_H_
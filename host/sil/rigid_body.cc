@@ -0,0 +1,169 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/rigid_body.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+static constexpr double G_MPS2_ = 9.80665;
+/* Ground friction coefficients */
+static constexpr double MU_ROLL_ = 0.04;
+static constexpr double MU_STATIC_ = 0.3;
+/* Below this ground speed the aircraft is held by static friction, m/s */
+static constexpr double STATIC_SPD_MPS_ = 0.05;
+}  // namespace
+
+void RigidBody::Init(const double mass_kg, const Mat3 &inertia_kgm2,
+                     const double ground_pitch_rad, const double heading_rad,
+                     SimState * const state) {
+  mass_kg_ = mass_kg;
+  inertia_kgm2_ = inertia_kgm2;
+  inertia_inv_ = Inverse(inertia_kgm2);
+  ground_pitch_rad_ = ground_pitch_rad;
+  if (!state) {return;}
+  state->on_ground = true;
+  state->ned_pos_m = {0, 0, 0};
+  state->ned_vel_mps = {0, 0, 0};
+  state->quat = EulerToQuat(0, ground_pitch_rad, heading_rad);
+  state->roll_rad = 0;
+  state->pitch_rad = ground_pitch_rad;
+  state->heading_rad = heading_rad;
+  state->gyro_radps = {0, 0, 0};
+  state->accel_mps2 = Transpose(QuatToDcm(state->quat)) *
+                      Vec3{0, 0, -G_MPS2_};
+}
+RigidBody::Deriv RigidBody::Derivs(const Vec3 &vel, const Quat &quat,
+                                   const Vec3 &rate, const Vec3 &force_ned,
+                                   const Vec3 &moment_nm) const {
+  Deriv d;
+  d.pos = vel;
+  d.vel = (1 / mass_kg_) * force_ned;
+  d.quat = {0.5 * (-quat[1] * rate[0] - quat[2] * rate[1] -
+                   quat[3] * rate[2]),
+            0.5 * (quat[0] * rate[0] + quat[2] * rate[2] -
+                   quat[3] * rate[1]),
+            0.5 * (quat[0] * rate[1] + quat[3] * rate[0] -
+                   quat[1] * rate[2]),
+            0.5 * (quat[0] * rate[2] + quat[1] * rate[1] -
+                   quat[2] * rate[0])};
+  d.rate = inertia_inv_ * (moment_nm - Cross(rate, inertia_kgm2_ * rate));
+  return d;
+}
+void RigidBody::Step(const double dt_s, const Vec3 &force_n,
+                     const Vec3 &moment_nm, SimState * const state) {
+  if (!state) {return;}
+  Mat3 c_bn = QuatToDcm(state->quat);
+  Vec3 force_ned = c_bn * force_n;
+  force_ned[2] += mass_kg_ * G_MPS2_;
+  /* Ground reaction, from the forces at the start of the step */
+  Vec3 ground_ned = {0, 0, 0};
+  if (state->on_ground) {
+    if (force_ned[2] > 0) {
+      double normal = force_ned[2];
+      ground_ned[2] = -normal;
+      double spd = std::hypot(state->ned_vel_mps[0], state->ned_vel_mps[1]);
+      double horz = std::hypot(force_ned[0], force_ned[1]);
+      if ((spd < STATIC_SPD_MPS_) && (horz <= MU_STATIC_ * normal)) {
+        ground_ned[0] = -force_ned[0];
+        ground_ned[1] = -force_ned[1];
+        state->ned_vel_mps[0] = 0;
+        state->ned_vel_mps[1] = 0;
+      } else if (spd >= STATIC_SPD_MPS_) {
+        ground_ned[0] = -MU_ROLL_ * normal * state->ned_vel_mps[0] / spd;
+        ground_ned[1] = -MU_ROLL_ * normal * state->ned_vel_mps[1] / spd;
+      }
+    } else {
+      state->on_ground = false;
+    }
+  }
+  force_ned = force_ned + ground_ned;
+  /* The gear reacts rolling moments on the ground */
+  Vec3 moment = moment_nm;
+  if (state->on_ground) {moment[0] = 0;}
+  /* Fourth order Runge-Kutta */
+  auto add = [](const SimState &s, const Deriv &d, const double h,
+                Vec3 *pos, Vec3 *vel, Quat *quat, Vec3 *rate) {
+    *pos = s.ned_pos_m + h * d.pos;
+    *vel = s.ned_vel_mps + h * d.vel;
+    for (std::size_t i = 0; i < 4; i++) {
+      (*quat)[i] = s.quat[i] + h * d.quat[i];
+    }
+    *rate = s.gyro_radps + h * d.rate;
+  };
+  Vec3 pos, vel, rate;
+  Quat quat;
+  Deriv k1 = Derivs(state->ned_vel_mps, state->quat, state->gyro_radps,
+                    force_ned, moment);
+  add(*state, k1, dt_s / 2, &pos, &vel, &quat, &rate);
+  Deriv k2 = Derivs(vel, quat, rate, force_ned, moment);
+  add(*state, k2, dt_s / 2, &pos, &vel, &quat, &rate);
+  Deriv k3 = Derivs(vel, quat, rate, force_ned, moment);
+  add(*state, k3, dt_s, &pos, &vel, &quat, &rate);
+  Deriv k4 = Derivs(vel, quat, rate, force_ned, moment);
+  Deriv k;
+  k.pos = (1.0 / 6) * (k1.pos + 2 * k2.pos + 2 * k3.pos + k4.pos);
+  k.vel = (1.0 / 6) * (k1.vel + 2 * k2.vel + 2 * k3.vel + k4.vel);
+  k.rate = (1.0 / 6) * (k1.rate + 2 * k2.rate + 2 * k3.rate + k4.rate);
+  for (std::size_t i = 0; i < 4; i++) {
+    k.quat[i] = (k1.quat[i] + 2 * k2.quat[i] + 2 * k3.quat[i] +
+                 k4.quat[i]) / 6;
+  }
+  add(*state, k, dt_s, &state->ned_pos_m, &state->ned_vel_mps, &state->quat,
+      &state->gyro_radps);
+  double q_norm = std::sqrt(state->quat[0] * state->quat[0] +
+                            state->quat[1] * state->quat[1] +
+                            state->quat[2] * state->quat[2] +
+                            state->quat[3] * state->quat[3]);
+  for (std::size_t i = 0; i < 4; i++) {state->quat[i] /= q_norm;}
+  /* Touchdown */
+  if (state->ned_pos_m[2] >= 0) {
+    state->ned_pos_m[2] = 0;
+    state->ned_vel_mps[2] = std::min(state->ned_vel_mps[2], 0.0);
+    state->on_ground = true;
+  }
+  Vec3 euler = QuatToEuler(state->quat);
+  if (state->on_ground) {
+    /* Level in roll, pitching up from the ground attitude only */
+    euler[0] = 0;
+    state->gyro_radps[0] = 0;
+    if (euler[1] <= ground_pitch_rad_) {
+      euler[1] = ground_pitch_rad_;
+      state->gyro_radps[1] = std::max(state->gyro_radps[1], 0.0);
+    }
+    state->quat = EulerToQuat(euler[0], euler[1], euler[2]);
+    /* The wheels do not side slip */
+    double along = state->ned_vel_mps[0] * std::cos(euler[2]) +
+                   state->ned_vel_mps[1] * std::sin(euler[2]);
+    state->ned_vel_mps[0] = along * std::cos(euler[2]);
+    state->ned_vel_mps[1] = along * std::sin(euler[2]);
+  }
+  state->roll_rad = euler[0];
+  state->pitch_rad = euler[1];
+  state->heading_rad = euler[2];
+  /* Specific force, the non-gravitational forces in body axes */
+  Vec3 ground_b = Transpose(QuatToDcm(state->quat)) * ground_ned;
+  state->accel_mps2 = (1 / mass_kg_) * (force_n + ground_b);
+}
@@ -0,0 +1,66 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_RIGID_BODY_H_
+#define HOST_SIL_RIGID_BODY_H_
+
+#include "sil/sim_model.h"
+#include "sil/sim_math.h"
+
+/*
+* Flat earth rigid body equations of motion in NED, integrated with fourth
+* order Runge-Kutta. External forces and moments act at the c.g. in body
+* axes and are held over a step; gravity is added here. The ground is the
+* plane through home: it supports the aircraft with rolling friction,
+* holds it level in roll, and lets it pitch up from its ground attitude,
+* so a takeoff roll and rotation can be flown.
+*/
+class RigidBody {
+ public:
+  /* Mass, kg, inertia about the c.g., kg*m^2, and ground pitch, rad */
+  void Init(const double mass_kg, const Mat3 &inertia_kgm2,
+            const double ground_pitch_rad, const double heading_rad,
+            SimState * const state);
+  /* Advances the state by dt */
+  void Step(const double dt_s, const Vec3 &force_n, const Vec3 &moment_nm,
+            SimState * const state);
+
+ private:
+  /* State derivatives */
+  struct Deriv {
+    Vec3 pos;
+    Vec3 vel;
+    Quat quat;
+    Vec3 rate;
+  };
+  Deriv Derivs(const Vec3 &vel, const Quat &quat, const Vec3 &rate,
+               const Vec3 &force_ned, const Vec3 &moment_nm) const;
+  double mass_kg_;
+  Mat3 inertia_kgm2_;
+  Mat3 inertia_inv_;
+  double ground_pitch_rad_;
+};
+
+#endif  // HOST_SIL_RIGID_BODY_H_
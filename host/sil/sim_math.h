@@ -0,0 +1,126 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_SIM_MATH_H_
+#define HOST_SIL_SIM_MATH_H_
+
+#include <array>
+#include <cmath>
+
+/* Small vector and attitude helpers for the simulation models */
+using Vec3 = std::array<double, 3>;
+using Mat3 = std::array<Vec3, 3>;
+using Quat = std::array<double, 4>;
+
+inline Vec3 operator+(const Vec3 &a, const Vec3 &b) {
+  return {a[0] + b[0], a[1] + b[1], a[2] + b[2]};
+}
+inline Vec3 operator-(const Vec3 &a, const Vec3 &b) {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+inline Vec3 operator*(const double s, const Vec3 &a) {
+  return {s * a[0], s * a[1], s * a[2]};
+}
+inline double Dot(const Vec3 &a, const Vec3 &b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+inline Vec3 Cross(const Vec3 &a, const Vec3 &b) {
+  return {a[1] * b[2] - a[2] * b[1],
+          a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+inline double Norm(const Vec3 &a) {
+  return std::sqrt(Dot(a, a));
+}
+inline Vec3 operator*(const Mat3 &m, const Vec3 &a) {
+  return {Dot(m[0], a), Dot(m[1], a), Dot(m[2], a)};
+}
+inline Mat3 Transpose(const Mat3 &m) {
+  return {{{m[0][0], m[1][0], m[2][0]},
+           {m[0][1], m[1][1], m[2][1]},
+           {m[0][2], m[1][2], m[2][2]}}};
+}
+/* Inverse of a 3x3 matrix, which must not be singular */
+inline Mat3 Inverse(const Mat3 &m) {
+  Mat3 inv;
+  double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+  for (std::size_t i = 0; i < 3; i++) {
+    for (std::size_t j = 0; j < 3; j++) {
+      std::size_t r0 = (j + 1) % 3, r1 = (j + 2) % 3;
+      std::size_t c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+      inv[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+    }
+  }
+  return inv;
+}
+/* Body to NED rotation of a body to NED quaternion, scalar first */
+inline Mat3 QuatToDcm(const Quat &q) {
+  return {{{1 - 2 * (q[2] * q[2] + q[3] * q[3]),
+            2 * (q[1] * q[2] - q[0] * q[3]),
+            2 * (q[1] * q[3] + q[0] * q[2])},
+           {2 * (q[1] * q[2] + q[0] * q[3]),
+            1 - 2 * (q[1] * q[1] + q[3] * q[3]),
+            2 * (q[2] * q[3] - q[0] * q[1])},
+           {2 * (q[1] * q[3] - q[0] * q[2]),
+            2 * (q[2] * q[3] + q[0] * q[1]),
+            1 - 2 * (q[1] * q[1] + q[2] * q[2])}}};
+}
+/* Quaternion of 3-2-1 Euler angles */
+inline Quat EulerToQuat(const double roll, const double pitch,
+                        const double yaw) {
+  double cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+  double cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+  double cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+  return {cr * cp * cy + sr * sp * sy,
+          sr * cp * cy - cr * sp * sy,
+          cr * sp * cy + sr * cp * sy,
+          cr * cp * sy - sr * sp * cy};
+}
+/* 3-2-1 Euler angles of a quaternion, yaw in [0, 2 pi) */
+inline Vec3 QuatToEuler(const Quat &q) {
+  double roll = std::atan2(2 * (q[0] * q[1] + q[2] * q[3]),
+                           1 - 2 * (q[1] * q[1] + q[2] * q[2]));
+  double s = 2 * (q[0] * q[2] - q[3] * q[1]);
+  double pitch = std::asin(s > 1 ? 1 : (s < -1 ? -1 : s));
+  double yaw = std::atan2(2 * (q[0] * q[3] + q[1] * q[2]),
+                          1 - 2 * (q[2] * q[2] + q[3] * q[3]));
+  if (yaw < 0) {yaw += 2 * M_PI;}
+  return {roll, pitch, yaw};
+}
+
+/* WGS84 meridian and prime vertical radii of curvature at a latitude, m */
+inline void EarthRadii(const double lat_rad, double * const rm_m,
+                       double * const rn_m) {
+  static constexpr double A_M = 6378137.0;
+  static constexpr double E2 = 6.69437999014e-3;
+  double s = std::sin(lat_rad);
+  double den = 1.0 - E2 * s * s;
+  *rn_m = A_M / std::sqrt(den);
+  *rm_m = A_M * (1.0 - E2) / (den * std::sqrt(den));
+}
+
+#endif  // HOST_SIL_SIM_MATH_H_
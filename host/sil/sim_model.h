@@ -0,0 +1,81 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_SIM_MODEL_H_
+#define HOST_SIL_SIM_MODEL_H_
+
+#include <array>
+#include <cstddef>
+#include "flight/global_defs.h"
+
+/* Effector channels, the PWM channels then the SBUS channels */
+inline constexpr std::size_t NUM_SIM_EFFECTORS = NUM_PWM_PINS + NUM_SBUS_CH;
+/* Home location, rad and m above the WGS84 ellipsoid, and heading, rad */
+struct SimHome {
+  double lat_rad;
+  double lon_rad;
+  double alt_m;
+  double heading_rad = 0;
+};
+/* Truth state of the simulated aircraft */
+struct SimState {
+  bool on_ground;
+  /* Position relative to home and velocity, NED, m and m/s */
+  std::array<double, 3> ned_pos_m;
+  std::array<double, 3> ned_vel_mps;
+  /* Attitude, body to NED quaternion, scalar first, and Euler angles */
+  std::array<double, 4> quat;
+  double roll_rad;
+  double pitch_rad;
+  double heading_rad;
+  /* Body rates and specific force, as seen by the IMU */
+  std::array<double, 3> gyro_radps;
+  std::array<double, 3> accel_mps2;
+  /* Air data */
+  double static_pres_pa;
+  double diff_pres_pa;
+  double air_temp_c;
+  double tas_mps;
+  /* Battery */
+  double battery_volt;
+  double battery_current_a;
+};
+/*
+* Aircraft dynamics for the SIL harness. Effector commands are the angle
+* or power lever commands sent by the flight software, in engineering
+* units, for each channel.
+*/
+class SimModel {
+ public:
+  virtual ~SimModel() = default;
+  /* Initial state, at rest on the ground at home */
+  virtual void Init(const SimHome &home, SimState * const state) = 0;
+  /* Advances the state by dt */
+  virtual void Step(const double dt_s,
+                    const std::array<float, NUM_SIM_EFFECTORS> &cmd,
+                    SimState * const state) = 0;
+};
+
+#endif  // HOST_SIL_SIM_MODEL_H_
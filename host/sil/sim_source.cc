@@ -0,0 +1,193 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/sim_source.h"
+#include <cmath>
+#include "flight/hal.h"
+#include "flight/hardware_defs.h"
+#include "sil/sim_math.h"
+
+namespace {
+/* GPS week at the start of the run */
+static constexpr int16_t GNSS_WEEK_ = 2200;
+/* Sensor die temperature, C */
+static constexpr float DIE_TEMP_C_ = 25;
+/* SBUS channel center count */
+static constexpr int16_t SBUS_CENTER_ = 992;
+/* FMU-R-V1 regulated and servo rail voltages */
+static constexpr double REG_VOLT_ = 5.0;
+static constexpr double RAIL_VOLT_ = 5.0;
+}  // namespace
+
+SimSource::SimSource(SimModel * const model, const SimHome &home,
+                     const SimSensorConfig &cfg, const uint32_t seed)
+  : model_(model), home_(home), cfg_(cfg), gen_(seed), dist_(0, 1) {
+  incept_ch_.fill(SBUS_CENTER_);
+}
+double SimSource::Noise(const double sigma) {
+  return sigma * dist_(gen_);
+}
+void SimSource::Update() {
+  if (!model_) {return;}
+  if (!started_) {
+    model_->Init(home_, &state_);
+    time_us_ = HalMicros();
+    started_ = true;
+    return;
+  }
+  while (time_us_ + STEP_US_ <= HalMicros()) {
+    model_->Step(static_cast<double>(STEP_US_) / 1e6, cmd_, &state_);
+    time_us_ += STEP_US_;
+  }
+}
+bool SimSource::Imu(bfs::ImuData * const data) {
+  Update();
+  Mat3 c_nb = Transpose(QuatToDcm(state_.quat));
+  Vec3 mag = c_nb * Vec3(cfg_.mag_ned_ut);
+  data->new_imu_data = true;
+  data->new_mag_data = true;
+  data->imu_healthy = true;
+  data->mag_healthy = true;
+  data->die_temp_c = DIE_TEMP_C_;
+  for (std::size_t i = 0; i < 3; i++) {
+    data->accel_mps2[i] = static_cast<float>(state_.accel_mps2[i] +
+                                             Noise(cfg_.accel_noise_mps2));
+    data->gyro_radps[i] = static_cast<float>(state_.gyro_radps[i] +
+                                             Noise(cfg_.gyro_noise_radps));
+    data->mag_ut[i] = static_cast<float>(mag[i] + Noise(cfg_.mag_noise_ut));
+  }
+  return true;
+}
+bool SimSource::FmuStaticPres(bfs::PresData * const data) {
+  return StaticPres(data);
+}
+bool SimSource::StaticPres(bfs::PresData * const data) {
+  Update();
+  data->new_data = true;
+  data->healthy = true;
+  data->pres_pa = static_cast<float>(state_.static_pres_pa +
+                                     Noise(cfg_.static_noise_pa));
+  data->die_temp_c = static_cast<float>(state_.air_temp_c);
+  return true;
+}
+bool SimSource::DiffPres(bfs::PresData * const data) {
+  Update();
+  data->new_data = true;
+  data->healthy = true;
+  data->pres_pa = static_cast<float>(state_.diff_pres_pa +
+                                     Noise(cfg_.diff_noise_pa));
+  data->die_temp_c = static_cast<float>(state_.air_temp_c);
+  return true;
+}
+bool SimSource::Gnss(bfs::GnssData * const data) {
+  Update();
+  if (!started_) {return false;}
+  int64_t epoch = time_us_ / cfg_.gnss_period_us;
+  if (epoch == gnss_epoch_) {return false;}
+  gnss_epoch_ = epoch;
+  /* Flat earth position relative to home */
+  double alt_m = home_.alt_m - state_.ned_pos_m[2];
+  double rm, rn;
+  EarthRadii(home_.lat_rad, &rm, &rn);
+  data->lat_rad = home_.lat_rad + state_.ned_pos_m[0] / (rm + alt_m);
+  data->lon_rad = home_.lon_rad + state_.ned_pos_m[1] /
+                  ((rn + alt_m) * std::cos(home_.lat_rad));
+  data->alt_wgs84_m = static_cast<float>(alt_m);
+  data->alt_msl_m = static_cast<float>(alt_m);
+  for (std::size_t i = 0; i < 3; i++) {
+    data->ned_vel_mps[i] = static_cast<float>(state_.ned_vel_mps[i]);
+  }
+  data->spd_mps = static_cast<float>(std::hypot(state_.ned_vel_mps[0],
+                                                state_.ned_vel_mps[1]));
+  data->track_rad = static_cast<float>(std::atan2(state_.ned_vel_mps[1],
+                                                  state_.ned_vel_mps[0]));
+  data->new_data = true;
+  data->healthy = true;
+  data->fix = 3;
+  data->num_sats = 16;
+  data->week = GNSS_WEEK_;
+  data->tow_ms = static_cast<int32_t>((epoch * cfg_.gnss_period_us / 1000) %
+                                      (7 * 24 * 3600 * 1000LL));
+  data->hdop = 0.7f;
+  data->vdop = 0.7f;
+  data->horz_acc_m = 1.5f;
+  data->vert_acc_m = 5.5f;
+  data->vel_acc_mps = 0.05f;
+  data->track_acc_rad = 0.035f;
+  return true;
+}
+bool SimSource::Inceptor(InceptorData * const data) {
+  Update();
+  if (!started_) {return false;}
+  int64_t frame = time_us_ / cfg_.inceptor_period_us;
+  if (frame == incept_frame_) {return false;}
+  incept_frame_ = frame;
+  data->new_data = true;
+  data->lost_frame = false;
+  data->failsafe = false;
+  data->ch17 = false;
+  data->ch18 = false;
+  data->ch = incept_ch_;
+  return true;
+}
+float SimSource::AnalogCounts(const int8_t pin) {
+  Update();
+  #if defined(__FMU_R_V2__)
+  if (pin == BATTERY_VOLTAGE_PIN) {
+    return static_cast<float>(state_.battery_volt * cfg_.pwr_mod_volt_scale /
+                              AIN_VOLTAGE_SCALE);
+  }
+  if (pin == BATTERY_CURRENT_PIN) {
+    return static_cast<float>(state_.battery_current_a *
+                              cfg_.pwr_mod_curr_scale / AIN_VOLTAGE_SCALE);
+  }
+  #endif
+  #if defined(__FMU_R_V1__)
+  if (pin == INPUT_VOLTAGE_PIN) {
+    return static_cast<float>(state_.battery_volt / INPUT_VOLTAGE_SCALE);
+  }
+  if (pin == REGULATED_VOLTAGE_PIN) {
+    return static_cast<float>(REG_VOLT_ / REGULATED_VOLTAGE_SCALE);
+  }
+  if (pin == SBUS_VOLTAGE_PIN) {
+    return static_cast<float>(RAIL_VOLT_ / SBUS_VOLTAGE_SCALE);
+  }
+  if (pin == PWM_VOLTAGE_PIN) {
+    return static_cast<float>(RAIL_VOLT_ / PWM_VOLTAGE_SCALE);
+  }
+  #endif
+  (void)pin;
+  return 0;
+}
+void SimSource::Effectors(const SbusCmd &sbus, const PwmCmd &pwm) {
+  /* Advance to the command time before applying the new commands */
+  Update();
+  for (std::size_t i = 0; i < NUM_PWM_PINS; i++) {
+    cmd_[i] = pwm.cmd[i];
+  }
+  for (std::size_t i = 0; i < NUM_SBUS_CH; i++) {
+    cmd_[NUM_PWM_PINS + i] = sbus.cmd[i];
+  }
+}
@@ -0,0 +1,99 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_SIM_SOURCE_H_
+#define HOST_SIL_SIM_SOURCE_H_
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include "hal/hal_host.h"
+#include "sil/sim_model.h"
+
+/* Sensor errors, 1-sigma white noise, and the local magnetic field */
+struct SimSensorConfig {
+  double accel_noise_mps2 = 0.0785;
+  double gyro_noise_radps = 0.00175;
+  double mag_noise_ut = 0.6;
+  double static_noise_pa = 10;
+  double diff_noise_pa = 2;
+  std::array<double, 3> mag_ned_ut = {22.9, 0, 42.5};
+  /* GNSS solution period, us */
+  int64_t gnss_period_us = 200000;
+  /* Inceptor frame period, us */
+  int64_t inceptor_period_us = 14000;
+  /* Analog power module output, V per V of battery and V per A */
+  double pwr_mod_volt_scale = 0.1;
+  double pwr_mod_curr_scale = 0.05;
+};
+/*
+* Device data from a simulation model. The model is advanced in fixed
+* steps up to the host time each time a device is read, using the most
+* recent effector commands, so the flight software closes the loop around
+* it at whatever rate the host runs the frames. Noise is drawn from a
+* seeded generator, so a run is repeatable for a given seed.
+*/
+class SimSource : public HalSource {
+ public:
+  SimSource(SimModel * const model, const SimHome &home,
+            const SimSensorConfig &cfg, const uint32_t seed);
+  /* Sets the inceptor channel counts */
+  inline void inceptor_ch(const std::size_t ch, const int16_t cnt) {
+    if (ch < incept_ch_.size()) {incept_ch_[ch] = cnt;}
+  }
+  /* Truth state at the last model step */
+  inline const SimState & state() const {return state_;}
+  inline int64_t time_us() const {return time_us_;}
+  /* Devices */
+  bool Imu(bfs::ImuData * const data) override;
+  bool FmuStaticPres(bfs::PresData * const data) override;
+  bool StaticPres(bfs::PresData * const data) override;
+  bool DiffPres(bfs::PresData * const data) override;
+  bool Gnss(bfs::GnssData * const data) override;
+  bool Inceptor(InceptorData * const data) override;
+  float AnalogCounts(const int8_t pin) override;
+  void Effectors(const SbusCmd &sbus, const PwmCmd &pwm) override;
+
+ private:
+  /* Model step, us */
+  static constexpr int64_t STEP_US_ = 1000;
+  /* Advances the model to the host time */
+  void Update();
+  double Noise(const double sigma);
+  SimModel *model_;
+  SimHome home_;
+  SimSensorConfig cfg_;
+  std::mt19937 gen_;
+  std::normal_distribution<double> dist_;
+  SimState state_;
+  int64_t time_us_ = 0;
+  bool started_ = false;
+  std::array<float, NUM_SIM_EFFECTORS> cmd_ = {};
+  int64_t gnss_epoch_ = -1;
+  int64_t incept_frame_ = -1;
+  std::array<int16_t, NUM_SBUS_CH> incept_ch_;
+};
+
+#endif  // HOST_SIL_SIM_SOURCE_H_
@@ -0,0 +1,46 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "sil/wind.h"
+#include <algorithm>
+#include <cmath>
+
+void Wind::Init(const WindConfig &cfg, const uint32_t seed) {
+  cfg_ = cfg;
+  gen_.seed(seed);
+  dist_.reset();
+  turb_mps_ = {0, 0, 0};
+}
+Vec3 Wind::Step(const double dt_s, const double airspeed_mps) {
+  if ((cfg_.turb_sigma_mps > 0) && (cfg_.turb_length_m > 0)) {
+    double spd = std::max(airspeed_mps, MIN_SPD_MPS_);
+    double a = std::exp(-spd * dt_s / cfg_.turb_length_m);
+    double b = cfg_.turb_sigma_mps * std::sqrt(1 - a * a);
+    for (double &v : turb_mps_) {
+      v = a * v + b * dist_(gen_);
+    }
+  }
+  return ned_mps();
+}
@@ -0,0 +1,65 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_SIL_WIND_H_
+#define HOST_SIL_WIND_H_
+
+#include <cstdint>
+#include <random>
+#include "sil/sim_math.h"
+
+/* Wind settings */
+struct WindConfig {
+  /* Steady wind, NED, m/s, i.e. {0, -5, 0} blows from the east */
+  Vec3 ned_mps = {0, 0, 0};
+  /* Turbulence intensity, 1-sigma per axis, m/s, and length scale, m */
+  double turb_sigma_mps = 0;
+  double turb_length_m = 200;
+};
+/*
+* Steady wind plus turbulence. Each axis of turbulence is a first order
+* Gauss-Markov process with a correlation time of the length scale over
+* the airspeed, the low order form of the Dryden model, drawn from a
+* seeded generator so runs are repeatable.
+*/
+class Wind {
+ public:
+  /* Sets the wind and seeds the turbulence */
+  void Init(const WindConfig &cfg, const uint32_t seed);
+  /* Advances the turbulence by dt at an airspeed, returns the wind, NED */
+  Vec3 Step(const double dt_s, const double airspeed_mps);
+  /* Current wind, NED, m/s */
+  inline Vec3 ned_mps() const {return cfg_.ned_mps + turb_mps_;}
+
+ private:
+  /* Airspeed floor for the correlation time, m/s */
+  static constexpr double MIN_SPD_MPS_ = 1;
+  WindConfig cfg_;
+  std::mt19937 gen_;
+  std::normal_distribution<double> dist_{0, 1};
+  Vec3 turb_mps_ = {0, 0, 0};
+};
+
+#endif  // HOST_SIL_WIND_H_
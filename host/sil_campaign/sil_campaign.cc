@@ -0,0 +1,361 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Monte Carlo campaign of software in the loop runs. Each run is an
+* independent flight_sil process, since the flight software modules hold
+* their state in file scope, launched from a pool of worker threads, one
+* per core by default. Every run draws its wind, turbulence, mass, CG,
+* and initial heading dispersions, and its sensor noise seed, from a seed
+* derived from the campaign seed and the run number only, so a run can be
+* repeated on its own regardless of how the campaign was scheduled.
+* Results stream into a CSV summary, a row per run in run order, with the
+* dispersions, the run metrics, and whether the run passed.
+*/
+
+#include <spawn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sil/mission.h"
+#include "hal/host_tool.h"
+
+extern char **environ;
+
+namespace {
+/* Campaign settings */
+struct Options {
+  std::string sil;
+  std::string out = "campaign.csv";
+  std::string work_dir = "campaign";
+  std::size_t runs = 100;
+  std::size_t jobs = 0;
+  uint64_t seed = 0;
+  bool keep_logs = false;
+  /* Settings passed to every run */
+  std::vector<std::string> run_args;
+  std::string mission;
+  /* Dispersions, wind speed and turbulence are uniform from zero, the
+  * others are normal about nominal */
+  double wind_max_mps = 5;
+  double turb_max_mps = 1;
+  double mass_sigma = 0.05;
+  double cg_sigma_m = 0.01;
+  double heading_deg = 0;
+  double heading_sigma_deg = 10;
+  /* Pass criteria */
+  double max_xtrack_m = 10;
+  double max_alt_err_m = 10;
+  double max_touchdown_mps = 3;
+};
+/* Dispersed settings of a run */
+struct Dispersion {
+  uint32_t seed;
+  double wind_n_mps, wind_e_mps;
+  double turb_mps;
+  double mass_scale;
+  double cg_m[3];
+  double heading_deg;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  if (arg == "--keep-logs") {
+    opt->keep_logs = true;
+    return true;
+  }
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  double num = std::strtod(val.c_str(), nullptr);
+  if (key == "sil") {
+    opt->sil = val;
+  } else if (key == "out") {
+    opt->out = val;
+  } else if (key == "work-dir") {
+    opt->work_dir = val;
+  } else if (key == "runs") {
+    opt->runs = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->runs == 0) {return false;}
+  } else if (key == "jobs") {
+    opt->jobs = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->jobs == 0) {return false;}
+  } else if (key == "seed") {
+    opt->seed = std::strtoull(val.c_str(), nullptr, 10);
+  } else if (key == "mission") {
+    opt->mission = val;
+    opt->run_args.push_back(arg);
+  } else if ((key == "aircraft") || (key == "duration-s") || (key == "lat") ||
+             (key == "lon") || (key == "alt") || (key == "ch") ||
+             (key == "wind-d") || (key == "background-us")) {
+    opt->run_args.push_back(arg);
+  } else if (key == "wind-max") {
+    opt->wind_max_mps = num;
+  } else if (key == "turb-max") {
+    opt->turb_max_mps = num;
+  } else if (key == "mass-sigma") {
+    opt->mass_sigma = num;
+  } else if (key == "cg-sigma") {
+    opt->cg_sigma_m = num;
+  } else if (key == "heading") {
+    opt->heading_deg = num;
+  } else if (key == "heading-sigma") {
+    opt->heading_sigma_deg = num;
+  } else if (key == "max-xtrack") {
+    opt->max_xtrack_m = num;
+  } else if (key == "max-alt-err") {
+    opt->max_alt_err_m = num;
+  } else if (key == "max-touchdown") {
+    opt->max_touchdown_mps = num;
+  } else {
+    return false;
+  }
+  return true;
+}
+/* SplitMix64, spreads the campaign seed and run number into a run seed */
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+/*
+* Draws the dispersions of a run. The engine output is fixed by the
+* standard, but the library distributions are not, so the uniform and
+* normal draws are made here to keep runs repeatable across toolchains.
+*/
+Dispersion Draw(const Options &opt, const std::size_t run) {
+  uint64_t run_seed = SplitMix64(opt.seed ^ SplitMix64(run));
+  std::mt19937_64 rng(run_seed);
+  auto uniform = [&rng]() {
+    return static_cast<double>(rng() >> 11) * 0x1.0p-53;
+  };
+  auto normal = [&uniform]() {
+    double u = 1.0 - uniform();
+    return std::sqrt(-2.0 * std::log(u)) *
+           std::cos(2.0 * std::numbers::pi * uniform());
+  };
+  Dispersion d;
+  d.seed = static_cast<uint32_t>(run_seed >> 32);
+  double wind_mps = opt.wind_max_mps * uniform();
+  double wind_dir_rad = 2.0 * std::numbers::pi * uniform();
+  d.wind_n_mps = wind_mps * std::cos(wind_dir_rad);
+  d.wind_e_mps = wind_mps * std::sin(wind_dir_rad);
+  d.turb_mps = opt.turb_max_mps * uniform();
+  d.mass_scale = std::max(1.0 + opt.mass_sigma * normal(), 0.1);
+  for (double &cg : d.cg_m) {cg = opt.cg_sigma_m * normal();}
+  d.heading_deg = opt.heading_deg + opt.heading_sigma_deg * normal();
+  return d;
+}
+std::string RunName(const Options &opt, const std::size_t run,
+                    const std::string &ext) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "run_%06zu", run);
+  return (std::filesystem::path(opt.work_dir) / (name + ext)).string();
+}
+/* Runs flight_sil, returns its exit status or -1 if it didn't run */
+int Launch(const Options &opt, const std::size_t run, const Dispersion &d) {
+  std::vector<std::string> args = {opt.sil};
+  args.insert(args.end(), opt.run_args.begin(), opt.run_args.end());
+  args.push_back("--seed=" + std::to_string(d.seed));
+  args.push_back("--wind-n=" + std::to_string(d.wind_n_mps));
+  args.push_back("--wind-e=" + std::to_string(d.wind_e_mps));
+  args.push_back("--turb=" + std::to_string(d.turb_mps));
+  args.push_back("--mass-scale=" + std::to_string(d.mass_scale));
+  args.push_back("--cg-x=" + std::to_string(d.cg_m[0]));
+  args.push_back("--cg-y=" + std::to_string(d.cg_m[1]));
+  args.push_back("--cg-z=" + std::to_string(d.cg_m[2]));
+  args.push_back("--heading=" + std::to_string(d.heading_deg));
+  args.push_back("--out=" + (opt.keep_logs ? RunName(opt, run, ".bfs") :
+                             std::string("/dev/null")));
+  args.push_back("--summary=" + RunName(opt, run, ".csv"));
+  std::vector<char *> argv;
+  for (std::string &a : args) {argv.push_back(a.data());}
+  argv.push_back(nullptr);
+  /* Console output goes to a log per run */
+  std::string log = RunName(opt, run, ".txt");
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  pid_t pid;
+  int err = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(),
+                        environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0) {return -1;}
+  int status;
+  if (waitpid(pid, &status, 0) != pid) {return -1;}
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+/* Reads the run summary, returns false if it is missing */
+bool ReadSummary(const std::string &path, std::string * const row,
+                 std::map<std::string, double> * const val) {
+  std::ifstream file(path);
+  std::string header;
+  if (!std::getline(file, header) || !std::getline(file, *row)) {
+    return false;
+  }
+  std::istringstream names(header), values(*row);
+  std::string name, v;
+  while (std::getline(names, name, ',') && std::getline(values, v, ',')) {
+    (*val)[name] = std::strtod(v.c_str(), nullptr);
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " --aircraft=file.dat "
+              << "[--mission=file] [--runs=100] [--jobs=cores] [--seed=0] "
+              << "[--out=campaign.csv] [--work-dir=campaign] [--keep-logs] "
+              << "[--sil=flight_sil] [--duration-s=60] [--wind-max=5] "
+              << "[--turb-max=1] [--mass-sigma=0.05] [--cg-sigma=0.01] "
+              << "[--heading=0] [--heading-sigma=10] [--max-xtrack=10] "
+              << "[--max-alt-err=10] [--max-touchdown=3] [flight_sil "
+              << "options: --lat --lon --alt --wind-d --ch "
+              << "--background-us]" << std::endl;
+    return -1;
+  }
+  if (opt.sil.empty()) {
+    opt.sil = (std::filesystem::absolute(argv[0]).parent_path() /
+               "flight_sil").string();
+  }
+  if (opt.jobs == 0) {
+    opt.jobs = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  /* Waypoints to reach, for the pass criteria */
+  std::size_t num_waypoints = 0;
+  if (!opt.mission.empty()) {
+    std::vector<bfs::MissionItem> plan;
+    if (!MissionLoad(opt.mission, &plan)) {
+      std::cerr << "ERROR: Unable to load flight plan " << opt.mission
+                << std::endl;
+      return -1;
+    }
+    num_waypoints = plan.size();
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(opt.work_dir, ec);
+  std::ofstream out(opt.out);
+  if (ec || !out) {
+    std::cerr << "ERROR: Unable to open " << opt.out << " or "
+              << opt.work_dir << std::endl;
+    return -1;
+  }
+  std::string header = MissionStatsHeader();
+  std::string empty_row(std::count(header.begin(), header.end(), ','), ',');
+  out << "run,seed,status,pass,wind_n_mps,wind_e_mps,turb_mps,mass_scale,"
+      << "cg_x_m,cg_y_m,cg_z_m,heading_deg," << header << std::endl;
+  /* Results waiting on earlier runs, written in run order */
+  std::mutex mtx;
+  std::map<std::size_t, std::string> pending;
+  std::size_t next_write = 0, num_pass = 0, num_done = 0;
+  std::vector<std::size_t> failed;
+  double worst_xtrack_m = 0;
+  std::atomic<std::size_t> next_run = 0;
+  auto worker = [&]() {
+    for (std::size_t run = next_run++; run < opt.runs; run = next_run++) {
+      Dispersion d = Draw(opt, run);
+      int status = Launch(opt, run, d);
+      std::string row;
+      std::map<std::string, double> val;
+      bool ok = (status == 0) &&
+                ReadSummary(RunName(opt, run, ".csv"), &row, &val);
+      bool pass = ok &&
+        (val["xtrack_max_m"] <= opt.max_xtrack_m) &&
+        (val["alt_err_max_m"] <= opt.max_alt_err_m) &&
+        (val["touchdown_mps"] <= opt.max_touchdown_mps) &&
+        (val["waypoints_reached"] >= static_cast<double>(num_waypoints));
+      std::ostringstream ss;
+      ss << run << "," << d.seed << "," << status << "," << pass << ","
+         << d.wind_n_mps << "," << d.wind_e_mps << "," << d.turb_mps << ","
+         << d.mass_scale << "," << d.cg_m[0] << "," << d.cg_m[1] << ","
+         << d.cg_m[2] << "," << d.heading_deg << ","
+         << (ok ? row : empty_row);
+      std::lock_guard<std::mutex> lock(mtx);
+      pending[run] = ss.str();
+      for (auto p = pending.find(next_write); p != pending.end();
+           p = pending.find(next_write)) {
+        out << p->second << std::endl;
+        pending.erase(p);
+        next_write++;
+      }
+      num_done++;
+      if (pass) {
+        num_pass++;
+      } else {
+        failed.push_back(run);
+      }
+      if (ok) {worst_xtrack_m = std::max(worst_xtrack_m, val["xtrack_max_m"]);}
+      std::cout << "\rCompleted " << num_done << " of " << opt.runs
+                << std::flush;
+    }
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (std::size_t i = 0; i < std::min(opt.jobs, opt.runs); i++) {
+    pool.emplace_back(worker);
+  }
+  for (std::thread &t : pool) {t.join();}
+  double wall_s = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  std::sort(failed.begin(), failed.end());
+  std::cout << std::endl << "Runs: " << opt.runs << " on " << pool.size()
+            << " jobs in " << wall_s << " s" << std::endl
+            << "Passed: " << num_pass << " ("
+            << 100.0 * static_cast<double>(num_pass) /
+               static_cast<double>(opt.runs) << "%)" << std::endl
+            << "Worst cross track error: " << worst_xtrack_m << " m"
+            << std::endl;
+  if (!failed.empty()) {
+    std::cout << "Failed runs:";
+    for (std::size_t i = 0; i < std::min<std::size_t>(failed.size(), 20);
+         i++) {
+      std::cout << " " << failed[i];
+    }
+    if (failed.size() > 20) {std::cout << " ...";}
+    std::cout << std::endl;
+  }
+  std::cout << "Wrote " << opt.out << std::endl;
+  return failed.empty() ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Validates a host aircraft model against a recorded time history, from a
+* Simulink run or a flight, exported by simulation/matlab/export_simout.m.
+* The model is flown open loop with the recorded effector commands and
+* reset to the recorded state at the start of each horizon, so the errors
+* measure how well the model predicts the aircraft response over that
+* horizon rather than how an open loop run drifts. The RMS and maximum
+* error of each state are reported and, given tolerances, checked against
+* them, so a checked in reference history gates the model.
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sil/aircraft_params.h"
+#include "sil/aircraft_model.h"
+#include "sil/sim_math.h"
+#include "hal/host_tool.h"
+
+namespace {
+static constexpr double DEG2RAD = std::numbers::pi / 180.0;
+/* Model step, s */
+static constexpr double STEP_S = 0.001;
+/* Columns of the time history */
+static constexpr std::size_t CMD_COL = 1;
+static constexpr std::size_t STATE_COL = CMD_COL + NUM_SIM_EFFECTORS;
+static constexpr std::size_t NUM_STATES = 15;
+static constexpr std::size_t NUM_COLS = STATE_COL + NUM_STATES;
+const std::array<const char *, NUM_STATES> STATE_NAMES = {
+  "pos_n_m", "pos_e_m", "pos_d_m", "vel_n_mps", "vel_e_mps", "vel_d_mps",
+  "roll_rad", "pitch_rad", "heading_rad", "p_radps", "q_radps", "r_radps",
+  "ax_mps2", "ay_mps2", "az_mps2"
+};
+/* Validation settings */
+struct Options {
+  std::string aircraft;
+  std::string output;
+  double horizon_s = 1;
+  /* RMS error tolerance of each state, unchecked if negative */
+  std::array<double, NUM_STATES> tol;
+  SimHome home = {35.691544 * DEG2RAD, -105.944183 * DEG2RAD, 100};
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "aircraft") {
+    opt->aircraft = val;
+  } else if (key == "out") {
+    opt->output = val;
+  } else if (key == "horizon-s") {
+    opt->horizon_s = std::strtod(val.c_str(), nullptr);
+    if (opt->horizon_s <= 0) {return false;}
+  } else if (key == "alt") {
+    opt->home.alt_m = std::strtod(val.c_str(), nullptr);
+  } else if (key == "tol") {
+    /* Comma separated state:rms pairs */
+    std::istringstream ss(val);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      std::size_t colon = item.find(':');
+      if (colon == std::string::npos) {return false;}
+      auto name = std::find(STATE_NAMES.begin(), STATE_NAMES.end(),
+                            item.substr(0, colon));
+      if (name == STATE_NAMES.end()) {return false;}
+      opt->tol[name - STATE_NAMES.begin()] =
+        std::strtod(item.c_str() + colon + 1, nullptr);
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+bool ReadHistory(const std::string &path,
+                 std::vector<std::array<double, NUM_COLS>> * const rows) {
+  std::ifstream file(path);
+  if (!file) {return false;}
+  std::string line;
+  /* Header */
+  if (!std::getline(file, line)) {return false;}
+  while (std::getline(file, line)) {
+    if (line.empty()) {continue;}
+    std::array<double, NUM_COLS> row;
+    std::istringstream ss(line);
+    std::string val;
+    for (std::size_t i = 0; i < NUM_COLS; i++) {
+      if (!std::getline(ss, val, ',')) {return false;}
+      row[i] = std::strtod(val.c_str(), nullptr);
+    }
+    rows->push_back(row);
+  }
+  return !rows->empty();
+}
+/* States of the model, in the time history order */
+std::array<double, NUM_STATES> States(const SimState &s) {
+  return {s.ned_pos_m[0], s.ned_pos_m[1], s.ned_pos_m[2],
+          s.ned_vel_mps[0], s.ned_vel_mps[1], s.ned_vel_mps[2],
+          s.roll_rad, s.pitch_rad, s.heading_rad,
+          s.gyro_radps[0], s.gyro_radps[1], s.gyro_radps[2],
+          s.accel_mps2[0], s.accel_mps2[1], s.accel_mps2[2]};
+}
+/* Resets the model kinematics to a recorded state */
+void Reset(const std::array<double, NUM_COLS> &row, SimState * const s) {
+  const double *x = &row[STATE_COL];
+  s->ned_pos_m = {x[0], x[1], x[2]};
+  s->ned_vel_mps = {x[3], x[4], x[5]};
+  s->roll_rad = x[6];
+  s->pitch_rad = x[7];
+  s->heading_rad = x[8];
+  s->quat = EulerToQuat(x[6], x[7], x[8]);
+  s->gyro_radps = {x[9], x[10], x[11]};
+  s->accel_mps2 = {x[12], x[13], x[14]};
+  s->on_ground = (x[2] >= 0);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  opt.tol.fill(-1);
+  if (argc < 2) {
+    std::cerr << "Usage:  " << argv[0] << " <TIME HISTORY CSV> "
+              << "--aircraft=<AIRCRAFT DATA FILE> [--horizon-s=1] "
+              << "[--alt=100] [--out=model.csv] "
+              << "[--tol=state:rms,...]" << std::endl;
+    return -1;
+  }
+  if (!HostParseArgs(argc, argv, 2, ParseOption, &opt)) {
+    return -1;
+  }
+  AircraftParams params;
+  if (!params.Load(opt.aircraft)) {
+    std::cerr << "ERROR: Unable to load aircraft data " << opt.aircraft
+              << std::endl;
+    return -1;
+  }
+  AircraftModel model;
+  if (!model.Config(params, WindConfig(), 0)) {
+    std::cerr << "ERROR: Aircraft is not supported by the host models."
+              << std::endl;
+    return -1;
+  }
+  std::vector<std::array<double, NUM_COLS>> rows;
+  if (!ReadHistory(argv[1], &rows)) {
+    std::cerr << "ERROR: Unable to read the time history, expected a "
+              << "header and " << NUM_COLS << " columns." << std::endl;
+    return -1;
+  }
+  std::ofstream out;
+  if (!opt.output.empty()) {
+    out.open(opt.output);
+    out << "time_s";
+    for (const char *name : STATE_NAMES) {out << "," << name;}
+    out << std::endl << std::setprecision(9);
+  }
+  SimState s;
+  model.Init(opt.home, &s);
+  Reset(rows[0], &s);
+  std::array<double, NUM_STATES> sum_sq = {}, max_err = {};
+  std::size_t num = 0;
+  double t = rows[0][0], t_reset = rows[0][0];
+  std::array<float, NUM_SIM_EFFECTORS> cmd;
+  for (std::size_t k = 1; k < rows.size(); k++) {
+    /* Commands held from the previous frame */
+    for (std::size_t i = 0; i < NUM_SIM_EFFECTORS; i++) {
+      cmd[i] = static_cast<float>(rows[k - 1][CMD_COL + i]);
+    }
+    while (t + STEP_S / 2 < rows[k][0]) {
+      model.Step(STEP_S, cmd, &s);
+      t += STEP_S;
+    }
+    std::array<double, NUM_STATES> x = States(s);
+    for (std::size_t i = 0; i < NUM_STATES; i++) {
+      double err = x[i] - rows[k][STATE_COL + i];
+      /* Angles wrap */
+      if ((i >= 6) && (i <= 8)) {
+        err = std::remainder(err, 2 * std::numbers::pi);
+      }
+      sum_sq[i] += err * err;
+      max_err[i] = std::max(max_err[i], std::abs(err));
+    }
+    num++;
+    if (out.is_open()) {
+      out << rows[k][0];
+      for (double v : x) {out << "," << v;}
+      out << std::endl;
+    }
+    if (rows[k][0] - t_reset >= opt.horizon_s) {
+      Reset(rows[k], &s);
+      t_reset = rows[k][0];
+    }
+  }
+  std::cout << (model.fixed_wing() ? "Fixed-wing" : "Multirotor")
+            << " model, " << num << " samples, " << opt.horizon_s
+            << " s horizon" << std::endl
+            << std::left << std::setw(14) << "State" << std::right
+            << std::setw(12) << "RMS error" << std::setw(12) << "Max error"
+            << std::setw(12) << "Tolerance" << std::endl;
+  double n = static_cast<double>(std::max<std::size_t>(num, 1));
+  bool checked = false, pass = true;
+  for (std::size_t i = 0; i < NUM_STATES; i++) {
+    double rms = std::sqrt(sum_sq[i] / n);
+    std::cout << std::left << std::setw(14) << STATE_NAMES[i] << std::right
+              << std::setw(12) << rms << std::setw(12) << max_err[i];
+    if (opt.tol[i] >= 0) {
+      bool ok = rms <= opt.tol[i];
+      std::cout << std::setw(12) << opt.tol[i] << (ok ? "" : "  FAIL");
+      checked = true;
+      pass = pass && ok;
+    }
+    std::cout << std::endl;
+  }
+  if (!checked) {return 0;}
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? 0 : 1;
+}
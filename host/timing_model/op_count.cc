@@ -0,0 +1,125 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#include "timing_model/op_count.h"
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/*
+* Everything reached from the trace hook is kept out of the coverage
+* instrumentation, so the hook neither recurses nor counts itself, and
+* uses fixed tables rather than containers for the same reason.
+*/
+#define OP_COUNT_NO_COV __attribute__((no_sanitize_coverage))
+
+namespace {
+static constexpr std::size_t MAX_BENCH_ = 64;
+static constexpr std::size_t MAX_NAME_ = 48;
+/* Open addressing table of benchmark and block address counts */
+static constexpr std::size_t TABLE_SIZE_ = std::size_t{1} << 18;
+struct Entry {
+  uintptr_t pc;
+  uint32_t bench;
+  uint64_t count;
+};
+Entry table_[TABLE_SIZE_];
+std::size_t entries_ = 0;
+bool full_ = false;
+/* Benchmarks and their counted calls */
+char names_[MAX_BENCH_][MAX_NAME_];
+uint64_t calls_[MAX_BENCH_];
+std::size_t num_bench_ = 0;
+/* Benchmark being counted, one based, zero when not counting */
+uint32_t active_ = 0;
+OP_COUNT_NO_COV std::size_t Slot(const uintptr_t pc, const uint32_t bench) {
+  uint64_t h = (static_cast<uint64_t>(pc) ^
+                (static_cast<uint64_t>(bench) << 48)) * 0x9e3779b97f4a7c15u;
+  return static_cast<std::size_t>(h >> 46) & (TABLE_SIZE_ - 1);
+}
+}  // namespace
+
+extern "C" OP_COUNT_NO_COV void __sanitizer_cov_trace_pc() {
+  if (!active_) {return;}
+  uintptr_t pc = reinterpret_cast<uintptr_t>(__builtin_return_address(0));
+  std::size_t i = Slot(pc, active_);
+  for (std::size_t n = 0; n < TABLE_SIZE_; n++) {
+    Entry &e = table_[i];
+    if ((e.pc == pc) && (e.bench == active_)) {
+      e.count++;
+      return;
+    }
+    if (e.count == 0) {
+      /* Kept below three quarters full, so probes stay short */
+      if (4 * (entries_ + 1) > 3 * TABLE_SIZE_) {
+        full_ = true;
+        return;
+      }
+      e = {pc, active_, 1};
+      entries_++;
+      return;
+    }
+    i = (i + 1) & (TABLE_SIZE_ - 1);
+  }
+}
+
+OP_COUNT_NO_COV void OpCountBegin(const char * name) {
+  std::size_t b = 0;
+  while ((b < num_bench_) && std::strcmp(names_[b], name)) {b++;}
+  if (b == num_bench_) {
+    if (num_bench_ == MAX_BENCH_) {return;}
+    std::snprintf(names_[b], MAX_NAME_, "%s", name);
+    num_bench_++;
+  }
+  calls_[b]++;
+  active_ = static_cast<uint32_t>(b + 1);
+}
+
+OP_COUNT_NO_COV void OpCountEnd() {
+  active_ = 0;
+}
+
+OP_COUNT_NO_COV bool OpCountWrite(const std::string &path,
+                                  const int frame_period_ms,
+                                  const float vms_budget_frac) {
+  if (full_) {
+    std::fprintf(stderr, "ERROR: Operation count table full\n");
+    return false;
+  }
+  FILE *fd = std::fopen(path.c_str(), "w");
+  if (!fd) {return false;}
+  std::fprintf(fd, "frame_period_ms %d\n", frame_period_ms);
+  std::fprintf(fd, "vms_budget_frac %g\n", vms_budget_frac);
+  for (std::size_t b = 0; b < num_bench_; b++) {
+    std::fprintf(fd, "bench %s %" PRIu64 "\n", names_[b], calls_[b]);
+    for (const Entry &e : table_) {
+      if (e.count && (e.bench == b + 1)) {
+        std::fprintf(fd, "pc %" PRIxPTR " %" PRIu64 "\n", e.pc, e.count);
+      }
+    }
+  }
+  return std::fclose(fd) == 0;
+}
@@ -0,0 +1,49 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+#ifndef HOST_TIMING_MODEL_OP_COUNT_H_
+#define HOST_TIMING_MODEL_OP_COUNT_H_
+
+#include <cstddef>
+#include <string>
+
+/*
+* Basic block execution counts of benchmarked calls, from code built with
+* -fsanitize-coverage=trace-pc. The compiler calls the trace hook at the
+* start of each basic block; while a benchmark is counting, the hook
+* counts the return address, which is the first instruction of the block
+* after the hook call. The timing model disassembles the blocks to turn
+* the counts into operation counts per call.
+*/
+
+/* Starts counting a call of a benchmark */
+void OpCountBegin(const char * name);
+/* Stops counting */
+void OpCountEnd();
+/* Writes the counts, returning false on failure */
+bool OpCountWrite(const std::string &path, const int frame_period_ms,
+                  const float vms_budget_frac);
+
+#endif  // HOST_TIMING_MODEL_OP_COUNT_H_
@@ -0,0 +1,702 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Target timing model. Estimates the FMU execution time of each per frame
+* module from the operations the module executes on the host, so a change
+* that would overrun the frame is caught without flight hardware.
+*
+* The operation counts come from flight_bench built with OP_COUNT, which
+* counts the basic blocks each benchmark executes. The blocks are
+* disassembled from the flight_bench binary and each instruction sorted
+* into a class of operation: integer ALU, multiply, and divide; loads;
+* stores; branches; calls; single and double precision add, multiply, and
+* divide or square root; and single and double precision math library
+* calls. Packed instructions count each lane, since the FMU is scalar.
+*
+* The cost of each class on the FMU, cycles, is fit to the timing
+* calibration kernels. The flight software built with TIMING_CAL prints
+* the cycles of each kernel on the FMU, and flight_bench counts the
+* operations of the same kernels on the host; the costs are the non
+* negative least squares fit, in relative error, of the kernel cycles to
+* the kernel operation counts. Fit costs can be saved and reused, so the
+* FMU is only needed when the toolchain or hardware changes.
+*
+* The estimate of each module is its mean operations per call times the
+* costs. The modules run each frame are summed, for steady state frames
+* and frames with a new GNSS fix, with the telemetry time measured on the
+* FMU, since the host runs a telemetry stand-in, and compared with the
+* frame period; the
+* VMS is also compared with its share of the frame. A report is printed
+* and the exit code is non-zero if either is over budget. The model
+* doesn't account for caches, pipelining between classes, or code that
+* differs between compilers, so it is a guard against large changes
+* rather than a replacement for timing on the FMU.
+*/
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "hal/host_tool.h"
+
+namespace {
+/* Operation classes */
+enum Op : std::size_t {
+  ALU, MUL, DIV, LOAD, STORE, BRANCH, CALL, F32_ADD, F32_MUL, F32_DIV,
+  F64_ADD, F64_MUL, F64_DIV, F32_LIBM, F64_LIBM, NUM_OPS
+};
+static constexpr std::array<const char *, NUM_OPS> OP_NAMES_ = {
+  "alu", "mul", "div", "load", "store", "branch", "call", "f32_add",
+  "f32_mul", "f32_div", "f64_add", "f64_mul", "f64_div", "f32_libm",
+  "f64_libm"
+};
+using Ops = std::array<double, NUM_OPS>;
+/*
+* Modules run each frame, the nav filter varying with new GNSS fixes;
+* telemetry isn't benchmarked on the host, so its FMU time is given
+*/
+static constexpr std::array<const char *, 3> FRAME_BENCH_ = {
+  "vms_run", "effectors_cmd", "datalog_add"
+};
+static constexpr char NAV_STEADY_[] = "nav_run";
+static constexpr char NAV_GNSS_[] = "nav_run_gnss";
+static constexpr char VMS_[] = "vms_run";
+static constexpr char KERNEL_PREFIX_[] = "kernel:";
+/* Coordinate descent sweeps of the cost fit */
+static constexpr int FIT_SWEEPS_ = 20000;
+/* Model settings */
+struct Options {
+  std::string binary;
+  std::string ops;
+  std::string cal;
+  std::string costs;
+  std::string save_costs;
+  std::string objdump = "objdump";
+  double budget = 1;
+  double telem_us = 0;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "cal") {
+    opt->cal = val;
+  } else if (key == "costs") {
+    opt->costs = val;
+  } else if (key == "save-costs") {
+    opt->save_costs = val;
+  } else if (key == "objdump") {
+    opt->objdump = val;
+  } else if (key == "budget") {
+    opt->budget = std::strtod(val.c_str(), nullptr);
+    if (opt->budget <= 0) {return false;}
+  } else if (key == "telem-us") {
+    opt->telem_us = std::strtod(val.c_str(), nullptr);
+    if (opt->telem_us < 0) {return false;}
+  } else {
+    return false;
+  }
+  return true;
+}
+/* A benchmark and the execution counts of its blocks */
+struct Bench {
+  std::string name;
+  double calls = 0;
+  std::vector<std::pair<uint64_t, double>> blocks;
+};
+struct OpCounts {
+  double frame_period_ms = 0;
+  double vms_budget_frac = 0;
+  std::vector<Bench> bench;
+};
+bool ReadOpCounts(const std::string &path, OpCounts * const counts) {
+  std::ifstream in(path);
+  if (!in) {return false;}
+  std::string line, key;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    if (!(ss >> key)) {continue;}
+    if (key == "frame_period_ms") {
+      ss >> counts->frame_period_ms;
+    } else if (key == "vms_budget_frac") {
+      ss >> counts->vms_budget_frac;
+    } else if (key == "bench") {
+      Bench b;
+      ss >> b.name >> b.calls;
+      counts->bench.push_back(b);
+    } else if ((key == "pc") && !counts->bench.empty()) {
+      uint64_t pc;
+      double n;
+      if (ss >> std::hex >> pc >> std::dec >> n) {
+        counts->bench.back().blocks.push_back({pc, n});
+      }
+    }
+  }
+  return counts->frame_period_ms > 0;
+}
+/* Calibration kernel cycles on the FMU, printed by the TIMING_CAL build */
+struct Calibration {
+  double clock_hz = 0;
+  std::map<std::string, double> cycles;
+};
+bool ReadCalibration(const std::string &path, Calibration * const cal) {
+  std::ifstream in(path);
+  if (!in) {return false;}
+  std::string line, key, name;
+  double val;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    if (!(ss >> key)) {continue;}
+    if ((key == "clock_hz") && (ss >> val)) {
+      cal->clock_hz = val;
+    } else if ((key == "kernel") && (ss >> name >> val) && (val > 0)) {
+      cal->cycles[name] = val;
+    }
+  }
+  return (cal->clock_hz > 0) && !cal->cycles.empty();
+}
+/* Costs of each class, cycles, and the clock rate */
+struct Costs {
+  double clock_hz = 0;
+  Ops cycles = {};
+};
+bool ReadCosts(const std::string &path, Costs * const costs) {
+  std::ifstream in(path);
+  if (!in) {return false;}
+  std::string line, key, name;
+  double val;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    if (!(ss >> key)) {continue;}
+    if ((key == "clock_hz") && (ss >> val)) {
+      costs->clock_hz = val;
+    } else if ((key == "cost") && (ss >> name >> val)) {
+      auto it = std::find(OP_NAMES_.begin(), OP_NAMES_.end(), name);
+      if (it == OP_NAMES_.end()) {return false;}
+      costs->cycles[static_cast<std::size_t>(it - OP_NAMES_.begin())] = val;
+    }
+  }
+  return costs->clock_hz > 0;
+}
+bool WriteCosts(const std::string &path, const Costs &costs) {
+  std::ofstream out(path);
+  if (!out) {return false;}
+  out << "clock_hz " << std::fixed << std::setprecision(0) << costs.clock_hz
+      << "\n" << std::setprecision(4);
+  for (std::size_t i = 0; i < NUM_OPS; i++) {
+    out << "cost " << OP_NAMES_[i] << " " << costs.cycles[i] << "\n";
+  }
+  return static_cast<bool>(out);
+}
+/* A disassembled instruction */
+struct Insn {
+  uint64_t addr;
+  std::string mnemonic;
+  std::string operands;
+};
+/* Disassembles the binary, with objdump, in address order */
+bool Disassemble(const Options &opt, std::vector<Insn> * const insn) {
+  std::string cmd = opt.objdump + " -d --no-show-raw-insn -w \"" +
+                    opt.binary + "\"";
+  FILE *pipe = popen(cmd.c_str(), "r");
+  if (!pipe) {return false;}
+  static const std::set<std::string> PREFIXES = {
+    "rep", "repz", "repe", "repnz", "repne", "lock", "notrack", "bnd",
+    "data16", "cs", "ds"
+  };
+  char buf[1024];
+  while (std::fgets(buf, sizeof(buf), pipe)) {
+    /* Instruction lines are "  addr:<tab>mnemonic operands" */
+    std::string line(buf);
+    std::size_t colon = line.find(":\t");
+    if ((colon == std::string::npos) || (line[0] != ' ')) {continue;}
+    Insn in;
+    in.addr = std::strtoull(line.c_str(), nullptr, 16);
+    std::string text = line.substr(colon + 2);
+    std::size_t comment = text.find('#');
+    if (comment != std::string::npos) {text.resize(comment);}
+    std::istringstream ss(text);
+    std::string word, rest;
+    while ((ss >> word) && PREFIXES.count(word)) {
+      /* A repeated string instruction copies like a library call */
+      if (word.rfind("rep", 0) == 0) {in.operands = "rep";}
+    }
+    if (word.empty() || (word == "(bad)")) {continue;}
+    in.mnemonic = word;
+    std::getline(ss, rest);
+    std::size_t first = rest.find_first_not_of(" \t\n");
+    rest = (first == std::string::npos) ? "" : rest.substr(first);
+    while (!rest.empty() && std::isspace(
+             static_cast<unsigned char>(rest.back()))) {
+      rest.pop_back();
+    }
+    in.operands = (in.operands == "rep") ? "rep " + rest : rest;
+    insn->push_back(in);
+  }
+  if (pclose(pipe) != 0) {return false;}
+  std::sort(insn->begin(), insn->end(), [](const Insn &a, const Insn &b) {
+    return a.addr < b.addr;
+  });
+  return !insn->empty();
+}
+/* Splits AT&T operands at the commas outside parentheses */
+std::vector<std::string> SplitOperands(const std::string &str) {
+  std::vector<std::string> out;
+  std::string cur;
+  int depth = 0;
+  for (char c : str) {
+    if (c == '(') {depth++;}
+    if (c == ')') {depth--;}
+    if ((c == ',') && (depth == 0)) {
+      out.push_back(cur);
+      cur.clear();
+    } else {
+      cur += c;
+    }
+  }
+  if (!cur.empty()) {out.push_back(cur);}
+  return out;
+}
+bool StartsWith(const std::string &s, const std::string &p) {
+  return s.rfind(p, 0) == 0;
+}
+bool EndsWith(const std::string &s, const std::string &p) {
+  return (s.size() >= p.size()) &&
+         (s.compare(s.size() - p.size(), p.size(), p) == 0);
+}
+/* Whether a called function is in the math library, and its precision */
+bool LibmCall(const std::string &operands, bool * const single) {
+  static const std::set<std::string> LIBM = {
+    "sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sinh", "cosh",
+    "tanh", "exp", "exp2", "expm1", "log", "log2", "log10", "log1p", "pow",
+    "sqrt", "cbrt", "hypot", "fmod", "sincos", "floor", "ceil", "round",
+    "trunc", "lround", "remainder"
+  };
+  std::size_t lt = operands.find('<');
+  if (lt == std::string::npos) {return false;}
+  std::string name = operands.substr(lt + 1);
+  name = name.substr(0, name.find_first_of("@+>"));
+  if (LIBM.count(name)) {
+    *single = false;
+    return true;
+  }
+  if (EndsWith(name, "f") && LIBM.count(name.substr(0, name.size() - 1))) {
+    *single = true;
+    return true;
+  }
+  return false;
+}
+/*
+* Floating point class of an SSE or AVX mnemonic, with its lanes, or
+* false if it isn't floating point arithmetic. Moves, shuffles, and bit
+* operations are left to the integer ALU class.
+*/
+bool FloatOp(const std::string &mnemonic, const std::string &operands,
+             Op * const op, double * const lanes) {
+  std::string m = mnemonic;
+  if ((m.size() > 3) && (m[0] == 'v')) {m = m.substr(1);}
+  if (m.size() < 4) {return false;}
+  std::string suffix = m.substr(m.size() - 2);
+  bool packed = (suffix == "ps") || (suffix == "pd");
+  bool dbl = (suffix == "sd") || (suffix == "pd");
+  if (!packed && !dbl && (suffix != "ss")) {
+    /* Conversions to integers end with the integer type */
+    if (!StartsWith(m, "cvt")) {return false;}
+    dbl = (m.find("sd") != std::string::npos) ||
+          (m.find("pd") != std::string::npos);
+  }
+  std::string base = StartsWith(m, "cvt") ? "cvt" :
+                     m.substr(0, m.size() - 2);
+  *lanes = 1;
+  if (packed) {
+    *lanes = dbl ? 2 : 4;
+    if (operands.find("%ymm") != std::string::npos) {*lanes *= 2;}
+  }
+  if (StartsWith(base, "add") || StartsWith(base, "sub") ||
+      (base == "min") || (base == "max") || StartsWith(base, "cmp") ||
+      (base == "ucomi") || (base == "comi") || (base == "cvt") ||
+      StartsWith(base, "round") || (base == "hadd")) {
+    *op = dbl ? F64_ADD : F32_ADD;
+  } else if (base == "mul") {
+    *op = dbl ? F64_MUL : F32_MUL;
+  } else if (StartsWith(base, "fmadd") || StartsWith(base, "fmsub") ||
+             StartsWith(base, "fnmadd") || StartsWith(base, "fnmsub")) {
+    /* Fused multiply adds, counted as a multiply and an add below */
+    *op = dbl ? F64_MUL : F32_MUL;
+    *lanes = -*lanes;
+  } else if ((base == "div") || (base == "sqrt") || (base == "rsqrt") ||
+             (base == "rcp")) {
+    *op = dbl ? F64_DIV : F32_DIV;
+  } else {
+    return false;
+  }
+  return true;
+}
+/*
+* Whether an instruction is a move between a register and a fixed stack
+* slot. The trace hook calls clobber the caller saved registers, so the
+* instrumented code spills and reloads values live across them, which the
+* uninstrumented code keeps in registers. These moves are left out,
+* along with the odd spill the flight software would make anyway.
+*/
+bool Spill(const Insn &in) {
+  if (!StartsWith(in.mnemonic, "mov") && !StartsWith(in.mnemonic, "vmov")) {
+    return false;
+  }
+  for (const std::string &arg : SplitOperands(in.operands)) {
+    std::size_t paren = arg.find('(');
+    if ((paren != std::string::npos) &&
+        (arg.compare(paren, std::string::npos, "(%rsp)") == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+/* Adds the operations of an instruction */
+void Classify(const Insn &in, Ops * const ops) {
+  const std::string &m = in.mnemonic;
+  if (StartsWith(m, "nop") || StartsWith(m, "endbr") ||
+      StartsWith(m, "prefetch")) {
+    return;
+  }
+  if (Spill(in)) {return;}
+  if (StartsWith(in.operands, "rep ")) {
+    (*ops)[CALL] += 1;
+    return;
+  }
+  /* Memory operands, the destination last in AT&T syntax */
+  std::vector<std::string> args = SplitOperands(in.operands);
+  if (!StartsWith(m, "lea")) {
+    bool cmp = StartsWith(m, "cmp") || StartsWith(m, "test") ||
+               StartsWith(m, "ucomi") || StartsWith(m, "vucomi") ||
+               StartsWith(m, "comi") || StartsWith(m, "vcomi") ||
+               StartsWith(m, "call") || StartsWith(m, "jmp");
+    for (std::size_t i = 0; i < args.size(); i++) {
+      if (args[i].find('(') == std::string::npos) {continue;}
+      bool dst = (i + 1 == args.size()) && (args.size() > 1) && !cmp;
+      (*ops)[dst ? STORE : LOAD] += 1;
+    }
+  }
+  Op op;
+  double lanes;
+  if (StartsWith(m, "call")) {
+    bool single;
+    if (LibmCall(in.operands, &single)) {
+      (*ops)[single ? F32_LIBM : F64_LIBM] += 1;
+    } else {
+      (*ops)[CALL] += 1;
+    }
+  } else if ((m[0] == 'j') || StartsWith(m, "ret")) {
+    (*ops)[BRANCH] += 1;
+  } else if (StartsWith(m, "push")) {
+    (*ops)[STORE] += 1;
+  } else if (StartsWith(m, "pop")) {
+    (*ops)[LOAD] += 1;
+  } else if (FloatOp(m, in.operands, &op, &lanes)) {
+    if (lanes < 0) {
+      (*ops)[op] -= lanes;
+      (*ops)[(op == F64_MUL) ? F64_ADD : F32_ADD] -= lanes;
+    } else {
+      (*ops)[op] += lanes;
+    }
+  } else if (StartsWith(m, "imul") || StartsWith(m, "mul") ||
+             StartsWith(m, "pmul")) {
+    (*ops)[MUL] += 1;
+  } else if (StartsWith(m, "div") || StartsWith(m, "idiv")) {
+    (*ops)[DIV] += 1;
+  } else {
+    (*ops)[ALU] += 1;
+  }
+}
+/* Whether an instruction ends a basic block */
+bool EndsBlock(const Insn &in) {
+  return (in.mnemonic[0] == 'j') || StartsWith(in.mnemonic, "ret") ||
+         StartsWith(in.mnemonic, "ud2");
+}
+bool TraceCall(const Insn &in) {
+  return StartsWith(in.mnemonic, "call") &&
+         (in.operands.find("<__sanitizer_cov_trace_pc") != std::string::npos);
+}
+/*
+* Operations of the block starting at an address, from the instruction
+* after one trace hook call to the next, or to the end of the block
+*/
+bool BlockOps(const std::vector<Insn> &insn, const uint64_t pc,
+              Ops * const ops) {
+  auto it = std::lower_bound(insn.begin(), insn.end(), pc,
+                             [](const Insn &in, const uint64_t addr) {
+                               return in.addr < addr;
+                             });
+  if ((it == insn.end()) || (it->addr != pc)) {return false;}
+  *ops = {};
+  for (; (it != insn.end()) && !TraceCall(*it); ++it) {
+    Classify(*it, ops);
+    if (EndsBlock(*it)) {break;}
+  }
+  return true;
+}
+/* Mean operations per call of a benchmark */
+bool BenchOps(const std::vector<Insn> &insn, const Bench &b,
+              std::map<uint64_t, Ops> * const cache, Ops * const ops) {
+  *ops = {};
+  if (b.calls <= 0) {return false;}
+  for (const auto &[pc, count] : b.blocks) {
+    auto it = cache->find(pc);
+    if (it == cache->end()) {
+      Ops block;
+      if (!BlockOps(insn, pc, &block)) {
+        std::cerr << "ERROR: No instruction at 0x" << std::hex << pc
+                  << std::dec << ", is the binary the one counted?"
+                  << std::endl;
+        return false;
+      }
+      it = cache->insert({pc, block}).first;
+    }
+    for (std::size_t i = 0; i < NUM_OPS; i++) {
+      (*ops)[i] += count * it->second[i];
+    }
+  }
+  for (double &v : *ops) {v /= b.calls;}
+  return true;
+}
+double Dot(const Ops &a, const Ops &b) {
+  double d = 0;
+  for (std::size_t i = 0; i < NUM_OPS; i++) {d += a[i] * b[i];}
+  return d;
+}
+double Sum(const Ops &a) {
+  double s = 0;
+  for (double v : a) {s += v;}
+  return s;
+}
+/*
+* Non negative least squares fit of the costs, in relative error, by
+* cyclic coordinate descent
+*/
+Ops FitCosts(const std::vector<Ops> &ops, const std::vector<double> &cycles) {
+  std::size_t n = ops.size();
+  /* Rows scaled by the kernel cycles, so errors are relative */
+  std::vector<Ops> a(n);
+  for (std::size_t k = 0; k < n; k++) {
+    for (std::size_t i = 0; i < NUM_OPS; i++) {
+      a[k][i] = ops[k][i] / cycles[k];
+    }
+  }
+  Ops c = {};
+  std::vector<double> r(n, -1);
+  for (int sweep = 0; sweep < FIT_SWEEPS_; sweep++) {
+    for (std::size_t i = 0; i < NUM_OPS; i++) {
+      double g = 0, h = 0;
+      for (std::size_t k = 0; k < n; k++) {
+        g += a[k][i] * r[k];
+        h += a[k][i] * a[k][i];
+      }
+      if (h <= 0) {continue;}
+      double ci = std::max(0.0, c[i] - g / h);
+      double dc = ci - c[i];
+      c[i] = ci;
+      for (std::size_t k = 0; k < n; k++) {r[k] += a[k][i] * dc;}
+    }
+  }
+  return c;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (argc < 3) {
+    std::cerr << "Usage:  " << argv[0] << " <FLIGHT BENCH BINARY> "
+              << "<OPERATION COUNTS> [--cal=timing_cal.txt] "
+              << "[--costs=timing_costs.txt] "
+              << "[--save-costs=timing_costs.txt] [--budget=1] "
+              << "[--telem-us=0] "
+              << "[--objdump=objdump]" << std::endl;
+    return -1;
+  }
+  opt.binary = argv[1];
+  opt.ops = argv[2];
+  if (!HostParseArgs(argc, argv, 3, ParseOption, &opt)) {
+    return -1;
+  }
+  if (opt.cal.empty() == opt.costs.empty()) {
+    std::cerr << "ERROR: Give either the kernel calibration or stored costs"
+              << std::endl;
+    return -1;
+  }
+  OpCounts counts;
+  if (!ReadOpCounts(opt.ops, &counts)) {
+    std::cerr << "ERROR: Unable to read operation counts " << opt.ops
+              << std::endl;
+    return -1;
+  }
+  std::vector<Insn> insn;
+  if (!Disassemble(opt, &insn)) {
+    std::cerr << "ERROR: Unable to disassemble " << opt.binary << std::endl;
+    return -1;
+  }
+  std::map<uint64_t, Ops> cache;
+  std::map<std::string, Ops> bench_ops;
+  for (const Bench &b : counts.bench) {
+    Ops ops;
+    if (!BenchOps(insn, b, &cache, &ops)) {return -1;}
+    bench_ops[b.name] = ops;
+  }
+  std::cout << std::fixed;
+  /* Costs of each class, fit to the kernels or stored */
+  Costs costs;
+  if (!opt.costs.empty()) {
+    if (!ReadCosts(opt.costs, &costs)) {
+      std::cerr << "ERROR: Unable to read costs " << opt.costs << std::endl;
+      return -1;
+    }
+  } else {
+    Calibration cal;
+    if (!ReadCalibration(opt.cal, &cal)) {
+      std::cerr << "ERROR: Unable to read calibration " << opt.cal
+                << std::endl;
+      return -1;
+    }
+    std::vector<std::string> names;
+    std::vector<Ops> kernel_ops;
+    std::vector<double> kernel_cycles;
+    for (const auto &[name, cycles] : cal.cycles) {
+      auto it = bench_ops.find(KERNEL_PREFIX_ + name);
+      if (it == bench_ops.end()) {
+        std::cerr << "WARNING: No operation counts for kernel " << name
+                  << std::endl;
+        continue;
+      }
+      names.push_back(name);
+      kernel_ops.push_back(it->second);
+      kernel_cycles.push_back(cycles);
+    }
+    if (names.empty()) {
+      std::cerr << "ERROR: No kernels in both the calibration and counts"
+                << std::endl;
+      return -1;
+    }
+    costs.clock_hz = cal.clock_hz;
+    costs.cycles = FitCosts(kernel_ops, kernel_cycles);
+    std::cout << std::endl << "Kernel fit, clock " << std::setprecision(0)
+              << cal.clock_hz << " Hz" << std::endl;
+    std::cout << std::left << std::setw(12) << "Kernel" << std::right
+              << std::setw(12) << "Ops" << std::setw(12) << "Cycles"
+              << std::setw(12) << "Model" << std::setw(10) << "Error %"
+              << std::endl;
+    for (std::size_t k = 0; k < names.size(); k++) {
+      double model = Dot(kernel_ops[k], costs.cycles);
+      std::cout << std::left << std::setw(12) << names[k] << std::right
+                << std::setprecision(0) << std::setw(12)
+                << Sum(kernel_ops[k]) << std::setw(12) << kernel_cycles[k]
+                << std::setw(12) << model << std::setprecision(1)
+                << std::setw(10)
+                << 100 * (model - kernel_cycles[k]) / kernel_cycles[k]
+                << std::endl;
+    }
+    if (!opt.save_costs.empty()) {
+      if (!WriteCosts(opt.save_costs, costs)) {
+        std::cerr << "ERROR: Unable to write " << opt.save_costs
+                  << std::endl;
+        return -1;
+      }
+      std::cout << "Wrote " << opt.save_costs << std::endl;
+    }
+  }
+  std::cout << std::endl << "Cycles per operation" << std::endl;
+  for (std::size_t i = 0; i < NUM_OPS; i++) {
+    std::cout << "  " << std::left << std::setw(10) << OP_NAMES_[i]
+              << std::right << std::setprecision(2) << std::setw(10)
+              << costs.cycles[i] << std::endl;
+  }
+  /* Module estimates */
+  double period_us = counts.frame_period_ms * 1000;
+  std::map<std::string, double> est_us;
+  std::cout << std::endl << std::left << std::setw(16) << "Module"
+            << std::right << std::setw(10) << "Calls" << std::setw(12)
+            << "Ops" << std::setw(12) << "Cycles" << std::setw(10) << "us"
+            << std::setw(10) << "Frame %" << std::endl;
+  for (const Bench &b : counts.bench) {
+    if (StartsWith(b.name, KERNEL_PREFIX_)) {continue;}
+    const Ops &ops = bench_ops[b.name];
+    double cycles = Dot(ops, costs.cycles);
+    double us = 1e6 * cycles / costs.clock_hz;
+    est_us[b.name] = us;
+    std::cout << std::left << std::setw(16) << b.name << std::right
+              << std::setprecision(0) << std::setw(10) << b.calls
+              << std::setw(12) << Sum(ops) << std::setw(12) << cycles
+              << std::setprecision(1) << std::setw(10) << us
+              << std::setw(10) << 100 * us / period_us << std::endl;
+  }
+  /* Frame totals and budgets */
+  double rest_us = 0;
+  for (const char *name : FRAME_BENCH_) {
+    if (!est_us.count(name)) {
+      std::cerr << "WARNING: No estimate of " << name << ", left out of "
+                << "the frame" << std::endl;
+    }
+    rest_us += est_us[name];
+  }
+  rest_us += opt.telem_us;
+  double steady_us = est_us[NAV_STEADY_] + rest_us;
+  double gnss_us = est_us[NAV_GNSS_] + rest_us;
+  double worst_us = std::max(steady_us, gnss_us);
+  double vms_us = est_us[VMS_];
+  std::cout << std::endl << "Frame period: " << std::setprecision(0)
+            << period_us << " us, budget " << std::setprecision(1)
+            << 100 * opt.budget << "%" << std::endl;
+  std::cout << "Telemetry, measured on the FMU: " << opt.telem_us << " us"
+            << std::endl;
+  std::cout << "Steady frame: " << steady_us << " us, "
+            << 100 * steady_us / period_us << "%" << std::endl;
+  std::cout << "GNSS frame: " << gnss_us << " us, "
+            << 100 * gnss_us / period_us << "%" << std::endl;
+  std::cout << "VMS: " << vms_us << " us, " << 100 * vms_us / period_us
+            << "%, budget " << 100 * counts.vms_budget_frac << "%"
+            << std::endl;
+  bool fail = false;
+  if (worst_us > opt.budget * period_us) {
+    std::cout << "FAIL: Estimated frame exceeds its budget" << std::endl;
+    fail = true;
+  }
+  if ((counts.vms_budget_frac > 0) &&
+      (vms_us > counts.vms_budget_frac * period_us)) {
+    std::cout << "FAIL: Estimated VMS exceeds its budget" << std::endl;
+    fail = true;
+  }
+  if (fail) {return 1;}
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
@@ -0,0 +1,313 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Replays a captured UBX stream at full baud through a model of the GNSS
+* UART receive buffer and the main loop, using the flight code UBX parser.
+* Bytes arrive back to back at the configured baud rate, the worst case
+* for the receiver, while the main loop is preempted by the frame ISR and,
+* optionally, by periodic stalls such as SD card writes. Reports received
+* buffer overflows, epochs parsed, epoch latency, and the parse cost per
+* byte on the host. Without a capture, a stream is generated by the host
+* UBX encoder from a known flight, crossing a GPS week, and every parsed
+* epoch is also checked against the solution it was encoded from.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <numbers>
+#include "flight/ubx.h"
+#include "hal/ubx_encode.h"
+#include "hal/host_tool.h"
+
+namespace {
+#if defined(__FMU_R_V2__) || defined(__FMU_R_V2_BETA__)
+static constexpr double FRAME_PERIOD_US = 10000;
+#else
+static constexpr double FRAME_PERIOD_US = 20000;
+#endif
+/* Replay settings */
+struct Options {
+  double baud = 921600;
+  std::size_t rx_buffer_bytes = 4096;
+  int bytes_per_poll = 64;
+  double poll_period_us = 5;
+  double isr_us = 1000;
+  double stall_us = 0;
+  double stall_period_us = 0;
+  std::size_t generate = 0;
+  std::string path;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  if ((arg.rfind("--", 0) != 0) && opt->path.empty()) {
+    opt->path = arg;
+    return true;
+  }
+  std::string key, str;
+  if (!HostOptionSplit(arg, &key, &str)) {return false;}
+  double val = std::strtod(str.c_str(), nullptr);
+  if (val < 0) {return false;}
+  if (key == "baud") {
+    opt->baud = val;
+  } else if (key == "rx-buffer") {
+    opt->rx_buffer_bytes = static_cast<std::size_t>(val);
+  } else if (key == "bytes-per-poll") {
+    opt->bytes_per_poll = static_cast<int>(val);
+  } else if (key == "isr-us") {
+    opt->isr_us = val;
+  } else if (key == "stall-us") {
+    opt->stall_us = val;
+  } else if (key == "stall-period-ms") {
+    opt->stall_period_us = val * 1000;
+  } else if (key == "generate") {
+    opt->generate = static_cast<std::size_t>(val);
+    if (opt->generate == 0) {return false;}
+  } else {
+    return false;
+  }
+  return true;
+}
+/*
+* Solutions of a flight at 10 Hz, starting 30 s before the end of a GPS
+* week, cycling through the fix types and satellite counts
+*/
+std::vector<bfs::GnssData> Generate(const std::size_t num_epochs) {
+  static constexpr int32_t MS_PER_WEEK = 604800000;
+  std::vector<bfs::GnssData> sol(num_epochs);
+  int16_t week = 2300;
+  int32_t tow_ms = MS_PER_WEEK - 30000;
+  for (std::size_t i = 0; i < num_epochs; i++) {
+    double t_s = 0.1 * static_cast<double>(i);
+    double track_rad = 0.05 * t_s;
+    bfs::GnssData &g = sol[i];
+    g = {};
+    g.new_data = true;
+    g.healthy = true;
+    g.fix = static_cast<int8_t>(3 + i / 10 % 4);
+    g.num_sats = static_cast<int8_t>(8 + i % 13);
+    g.week = week;
+    g.tow_ms = tow_ms;
+    g.lat_rad = 0.7 + 1e-6 * std::cos(track_rad) * t_s;
+    g.lon_rad = -1.8 + 1e-6 * std::sin(track_rad) * t_s;
+    g.alt_wgs84_m = static_cast<float>(1500 + 2 * t_s);
+    g.alt_msl_m = g.alt_wgs84_m + 20.5f;
+    g.ned_vel_mps[0] = static_cast<float>(20 * std::cos(track_rad));
+    g.ned_vel_mps[1] = static_cast<float>(20 * std::sin(track_rad));
+    g.ned_vel_mps[2] = -2.0f;
+    g.spd_mps = 20.0f;
+    g.track_rad = static_cast<float>(std::remainder(track_rad,
+                                                    2 * std::numbers::pi));
+    g.horz_acc_m = 1.5f;
+    g.vert_acc_m = 2.25f;
+    g.vel_acc_mps = 0.35f;
+    g.track_acc_rad = 0.02f;
+    g.hdop = 0.85f;
+    g.vdop = 1.3f;
+    tow_ms += 100;
+    if (tow_ms >= MS_PER_WEEK) {
+      tow_ms -= MS_PER_WEEK;
+      week++;
+    }
+  }
+  return sol;
+}
+/*
+* Compares a parsed epoch with the solution it was encoded from, to the
+* UBX resolution. Returns the first field that differs, or nullptr.
+*/
+const char * Compare(const UbxNavData &p, const bfs::GnssData &g) {
+  static constexpr double DEG2RAD = std::numbers::pi / 180.0;
+  auto near = [](const double a, const double b, const double tol) {
+    return std::abs(a - b) <= tol;
+  };
+  if (p.fix != g.fix) {return "fix";}
+  if (p.num_sats != g.num_sats) {return "num_sats";}
+  if (p.week != g.week) {return "week";}
+  if (p.tow_ms != g.tow_ms) {return "tow_ms";}
+  if (!near(p.lat_rad, g.lat_rad, 1e-9 * DEG2RAD)) {return "lat_rad";}
+  if (!near(p.lon_rad, g.lon_rad, 1e-9 * DEG2RAD)) {return "lon_rad";}
+  if (!near(p.alt_wgs84_m, g.alt_wgs84_m, 2e-4)) {return "alt_wgs84_m";}
+  if (!near(p.alt_msl_m, g.alt_msl_m, 2e-4)) {return "alt_msl_m";}
+  for (std::size_t i = 0; i < 3; i++) {
+    if (!near(p.ned_vel_mps[i], g.ned_vel_mps[i], 1e-3)) {
+      return "ned_vel_mps";
+    }
+  }
+  if (!near(p.spd_mps, g.spd_mps, 1e-3)) {return "spd_mps";}
+  if (!near(p.track_rad, g.track_rad, 1e-5 * DEG2RAD)) {return "track_rad";}
+  if (!near(p.horz_acc_m, g.horz_acc_m, 1e-4)) {return "horz_acc_m";}
+  if (!near(p.vert_acc_m, g.vert_acc_m, 1e-4)) {return "vert_acc_m";}
+  if (!near(p.vel_acc_mps, g.vel_acc_mps, 1e-3)) {return "vel_acc_mps";}
+  if (!near(p.track_acc_rad, g.track_acc_rad, 1e-5 * DEG2RAD)) {
+    return "track_acc_rad";
+  }
+  if (!near(p.hdop, g.hdop, 0.01)) {return "hdop";}
+  if (!near(p.vdop, g.vdop, 0.01)) {return "vdop";}
+  return nullptr;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {return -1;}
+  if (opt.path.empty() == (opt.generate == 0)) {
+    std::cerr << "Usage:  " << argv[0] << " <UBX FILE> | --generate=epochs "
+              << "[--baud=921600] [--rx-buffer=4096] [--bytes-per-poll=64] "
+              << "[--isr-us=1000] [--stall-us=0] [--stall-period-ms=0]"
+              << std::endl;
+    return -1;
+  }
+  if ((opt.baud <= 0) || (opt.bytes_per_poll <= 0) ||
+      (opt.rx_buffer_bytes == 0)) {
+    std::cerr << "ERROR: Baud, bytes per poll, and buffer size must be "
+              << "positive." << std::endl;
+    return -1;
+  }
+  std::vector<uint8_t> stream;
+  std::vector<bfs::GnssData> truth;
+  if (opt.generate > 0) {
+    /* Encode a known flight */
+    truth = Generate(opt.generate);
+    for (const bfs::GnssData &g : truth) {UbxEncodeEpoch(g, &stream);}
+  } else {
+    /* Read the capture */
+    FILE *input = fopen(opt.path.c_str(), "rb");
+    if (!input) {
+      std::cerr << "ERROR: Unable to open input file, maybe the path is "
+                << "incorrect." << std::endl;
+      return -1;
+    }
+    uint8_t chunk[1024];
+    std::size_t bytes_read;
+    while ((bytes_read = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+      stream.insert(stream.end(), chunk, chunk + bytes_read);
+    }
+    fclose(input);
+  }
+  if (stream.empty()) {
+    std::cerr << "ERROR: Input file is empty." << std::endl;
+    return -1;
+  }
+  /* Host parse cost */
+  UbxParser timing_parser;
+  auto t0 = std::chrono::steady_clock::now();
+  for (const auto c : stream) {
+    timing_parser.Parse(c);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  double parse_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                    static_cast<double>(stream.size());
+  /* Replay at full baud */
+  const double byte_us = 10.0 / opt.baud * 1e6;
+  UbxParser parser;
+  std::deque<std::pair<uint8_t, double>> rx;
+  std::size_t next_byte = 0;
+  std::size_t overflow_bytes = 0;
+  std::size_t max_fill = 0;
+  std::vector<double> latency_us;
+  std::size_t mismatches = 0;
+  double next_poll_us = 0;
+  for (double t = 0; (next_byte < stream.size()) || !rx.empty(); t += 1) {
+    /* Receive */
+    while ((next_byte < stream.size()) &&
+           (static_cast<double>(next_byte) * byte_us <= t)) {
+      if (rx.size() < opt.rx_buffer_bytes) {
+        rx.emplace_back(stream[next_byte],
+                        static_cast<double>(next_byte) * byte_us);
+      } else {
+        overflow_bytes++;
+      }
+      next_byte++;
+    }
+    max_fill = std::max(max_fill, rx.size());
+    /* Main loop is preempted by the frame ISR and stalls */
+    bool blocked = std::fmod(t, FRAME_PERIOD_US) < opt.isr_us;
+    if (opt.stall_period_us > 0) {
+      blocked |= std::fmod(t, opt.stall_period_us) < opt.stall_us;
+    }
+    if (blocked || (t < next_poll_us)) {continue;}
+    /* Poll */
+    for (int i = 0; (i < opt.bytes_per_poll) && !rx.empty(); i++) {
+      if (parser.Parse(rx.front().first)) {
+        latency_us.push_back(t - rx.front().second);
+        /* Check the epoch against its solution */
+        std::size_t epoch = parser.num_epochs() - 1;
+        if (epoch < truth.size()) {
+          const char *field = Compare(parser.data(), truth[epoch]);
+          if (field) {
+            if (mismatches == 0) {
+              std::cout << "Epoch " << epoch << " " << field
+                        << " differs from the encoded solution" << std::endl;
+            }
+            mismatches++;
+          }
+        }
+      }
+      rx.pop_front();
+    }
+    next_poll_us = t + opt.poll_period_us;
+  }
+  /* Report */
+  double mean_latency_us = 0;
+  double max_latency_us = 0;
+  for (const auto l : latency_us) {
+    mean_latency_us += l / static_cast<double>(latency_us.size());
+    max_latency_us = std::max(max_latency_us, l);
+  }
+  std::cout << "Bytes: " << stream.size() << " ("
+            << static_cast<double>(stream.size()) * byte_us / 1e6
+            << " s at " << opt.baud << " baud)" << std::endl;
+  std::cout << "Epochs: " << parser.num_epochs() << ", checksum errors: "
+            << parser.checksum_errors() << std::endl;
+  std::cout << "Receive buffer: max fill " << max_fill << " of "
+            << opt.rx_buffer_bytes << " bytes, overflowed bytes "
+            << overflow_bytes << std::endl;
+  std::cout << "Epoch latency: mean " << mean_latency_us << " us, max "
+            << max_latency_us << " us" << std::endl;
+  if (!truth.empty()) {
+    std::cout << "Epochs differing from the encoded solutions: "
+              << mismatches << std::endl;
+  }
+  std::cout << "Host parse cost: " << parse_ns << " ns/byte" << std::endl;
+  std::cout << "Frame cost: fixed copy of " << sizeof(UbxNavData)
+            << " bytes" << std::endl;
+  if ((overflow_bytes > 0) || (parser.num_epochs() == 0) ||
+      (parser.num_epochs() != timing_parser.num_epochs()) ||
+      (mismatches > 0) ||
+      (!truth.empty() && (parser.num_epochs() != truth.size()))) {
+    std::cout << "FAIL" << std::endl;
+    return 1;
+  }
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
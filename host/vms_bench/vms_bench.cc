@@ -0,0 +1,354 @@
+/*
+* Brian R Taylor
+* brian.taylor@bolderflight.com
+* 
+* Copyright (c) 2022 Bolder Flight Systems Inc
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the “Software”), to
+* deal in the Software without restriction, including without limitation the
+* rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+* sell copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*/
+
+/*
+* Execution time benchmark of a Simulink autocode VMS, or of the native
+* C++ control law, on the host. The step is run for many frames on inputs
+* that sweep the flight envelope: attitude, rates, position, and air data
+* follow random walks, sticks move, and switch channels change every
+* couple of seconds so mode transitions and their initialization paths
+* are exercised too. The native benchmark is built from the same sweep, so
+* its times compare directly with those of the equivalent autocode. The
+* step is timed on its own, with the host clock, and the worst case is
+* compared with the VMS share of the frame period. Host times are scaled
+* by the given CPU factor to estimate the FMU; the run fails if the
+* estimate exceeds the budget, so it can gate the build.
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <string>
+#include <vector>
+#include "flight/global_defs.h"
+#include "flight/hardware_defs.h"
+#include "flight/vms.h"
+#include "flight/vms_telem.h"
+#include "hal/host_tool.h"
+#ifdef VMS_BENCH_NATIVE
+  #include "flight/config.h"
+  #include "flight/control.h"
+#else
+  #include "./autocode.h"
+#endif
+
+namespace {
+/* SBUS channel range */
+static constexpr int16_t SBUS_MIN_ = 172;
+static constexpr int16_t SBUS_MAX_ = 1811;
+/* Frames between switch channel changes */
+static constexpr std::size_t SWITCH_FRAMES_ = 2000 / FRAME_PERIOD_MS;
+/* Switch channels, 0-based; the rest are sticks */
+static constexpr std::size_t NUM_STICKS_ = 4;
+/* Run settings */
+struct Options {
+  std::size_t frames = 100000;
+  std::size_t warmup = 1000;
+  double budget = VMS_BUDGET_FRAC;
+  double background = VMS_BACKGROUND_FRAC;
+  double cpu_scale = 1;
+  std::size_t repeats = 3;
+  uint64_t seed = 0;
+};
+bool ParseOption(const std::string &arg, Options * const opt) {
+  std::string key, val;
+  if (!HostOptionSplit(arg, &key, &val)) {return false;}
+  if (key == "frames") {
+    opt->frames = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->frames == 0) {return false;}
+  } else if (key == "warmup") {
+    opt->warmup = std::strtoul(val.c_str(), nullptr, 10);
+  } else if (key == "budget") {
+    opt->budget = std::strtod(val.c_str(), nullptr);
+    if ((opt->budget <= 0) || (opt->budget > 1)) {return false;}
+  } else if (key == "background") {
+    opt->background = std::strtod(val.c_str(), nullptr);
+    if ((opt->background < 0) || (opt->background >= 1)) {return false;}
+  } else if (key == "cpu-scale") {
+    opt->cpu_scale = std::strtod(val.c_str(), nullptr);
+    if (opt->cpu_scale <= 0) {return false;}
+  } else if (key == "repeats") {
+    opt->repeats = std::strtoul(val.c_str(), nullptr, 10);
+    if (opt->repeats == 0) {return false;}
+  } else if (key == "seed") {
+    opt->seed = std::strtoull(val.c_str(), nullptr, 10);
+  } else {
+    return false;
+  }
+  return true;
+}
+/* VMS under test, the native control law with the autocode interface */
+#ifdef VMS_BENCH_NATIVE
+class NativeVms {
+ public:
+  void initialize() {ControlInit(config.control);}
+  void Run(const SysData &sys, const SensorData &sensor, const NavData &nav,
+           const VmsTelemData &telem, VmsData *vms) {
+    ControlRun(sys, sensor, nav, telem, vms);
+  }
+};
+using BenchVms = NativeVms;
+static constexpr char VMS_NAME_[] = "native C++ control law";
+#else
+using BenchVms = bfs::Autocode;
+static constexpr char VMS_NAME_[] = "Simulink autocode";
+#endif
+/* Random walk within limits */
+class Walk {
+ public:
+  Walk(const float min, const float max, const float step)
+    : min_(min), max_(max), step_(step), val_(0.5f * (min + max)) {}
+  float Step(std::mt19937_64 * const rng) {
+    std::uniform_real_distribution<float> d(-step_, step_);
+    val_ = std::clamp(val_ + d(*rng), min_, max_);
+    return val_;
+  }
+
+ private:
+  float min_, max_, step_, val_;
+};
+/* Keeps the compiler from eliding or hoisting the stores to an object */
+template <typename T>
+inline void KeepStores(const T &obj) {
+  asm volatile("" : : "r"(&obj) : "memory");
+}
+/* Envelope sweep, the same sequence for a given seed */
+class Sweep {
+ public:
+  explicit Sweep(const uint64_t seed) : rng_(seed) {
+    nav_.nav_initialized = true;
+    sensor_.pitot_static_installed = true;
+    sensor_.inceptor.ch.fill((SBUS_MIN_ + SBUS_MAX_) / 2);
+  }
+  void Next(const std::size_t frame) {
+    sys_.sys_time_us = static_cast<int64_t>(frame) * FRAME_PERIOD_MS * 1000;
+    sensor_.inceptor.new_data = true;
+    for (std::size_t i = 0; i < NUM_STICKS_; i++) {
+      sensor_.inceptor.ch[i] = static_cast<int16_t>(stick_[i].Step(&rng_));
+    }
+    if (frame % SWITCH_FRAMES_ == 0) {
+      std::uniform_int_distribution<int> sw(SBUS_MIN_, SBUS_MAX_);
+      for (std::size_t i = NUM_STICKS_; i < sensor_.inceptor.ch.size();
+           i++) {
+        sensor_.inceptor.ch[i] = static_cast<int16_t>(sw(rng_));
+      }
+    }
+    nav_.roll_rad = roll_.Step(&rng_);
+    nav_.pitch_rad = pitch_.Step(&rng_);
+    nav_.heading_rad = heading_.Step(&rng_);
+    nav_.alt_rel_m = alt_.Step(&rng_);
+    nav_.alt_msl_m = nav_.alt_rel_m;
+    nav_.alt_wgs84_m = nav_.alt_rel_m;
+    nav_.alt_pres_m = nav_.alt_rel_m;
+    nav_.ias_mps = ias_.Step(&rng_);
+    nav_.gnd_spd_mps = nav_.ias_mps;
+    for (std::size_t i = 0; i < 3; i++) {
+      nav_.gyro_radps[i] = rate_[i].Step(&rng_);
+      nav_.accel_mps2[i] = accel_[i].Step(&rng_);
+      nav_.ned_pos_m[i] = pos_[i].Step(&rng_);
+      nav_.ned_vel_mps[i] = vel_[i].Step(&rng_);
+    }
+  }
+  const SysData & sys() const {return sys_;}
+  const SensorData & sensor() const {return sensor_;}
+  const NavData & nav() const {return nav_;}
+  const TelemData & telem() const {return telem_;}
+
+ private:
+  static constexpr float PI_ = std::numbers::pi_v<float>;
+  std::mt19937_64 rng_;
+  SysData sys_ = {};
+  SensorData sensor_ = {};
+  NavData nav_ = {};
+  TelemData telem_ = {};
+  Walk roll_{-PI_ / 3, PI_ / 3, 0.02f}, pitch_{-PI_ / 6, PI_ / 6, 0.01f};
+  Walk heading_{0, 2 * PI_, 0.02f}, alt_{0, 200, 0.5f}, ias_{0, 30, 0.2f};
+  std::vector<Walk> rate_ = std::vector<Walk>(3, Walk(-2, 2, 0.2f));
+  std::vector<Walk> accel_ = std::vector<Walk>(3, Walk(-20, 20, 1));
+  std::vector<Walk> pos_ = std::vector<Walk>(3, Walk(-500, 500, 1));
+  std::vector<Walk> vel_ = std::vector<Walk>(3, Walk(-20, 20, 0.2f));
+  std::vector<Walk> stick_ = std::vector<Walk>(NUM_STICKS_,
+                                               Walk(SBUS_MIN_, SBUS_MAX_, 40));
+};
+/* VMS output, kept at file scope so the step can't be optimized out */
+VmsData vms;
+VmsTelemData telem_view;
+/* Stand-in for the copy the autocode makes of its telemetry input */
+TelemData telem_copy;
+VmsTelemData telem_view_copy;
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!HostParseArgs(argc, argv, 1, ParseOption, &opt)) {
+    std::cerr << "Usage:  " << argv[0] << " [--frames=100000] "
+              << "[--warmup=1000] [--budget=" << VMS_BUDGET_FRAC << "] "
+              << "[--background=" << VMS_BACKGROUND_FRAC << "] "
+              << "[--cpu-scale=1] [--repeats=3] [--seed=0]" << std::endl;
+    return -1;
+  }
+  /*
+  * The sweep is flown several times from a fresh instance and each frame
+  * keeps its fastest time, so host preemption doesn't count against the
+  * VMS; the worst case is then the slowest path through the VMS.
+  */
+  std::vector<double> time_us(opt.frames,
+                              std::numeric_limits<double>::max());
+  /* Rate groups below the frame rate, timed per release, and period */
+  constexpr int8_t NUM_SUBRATES = VmsNumSubrates<BenchVms>();
+  std::array<std::vector<double>, MAX_VMS_SUBRATES + 1> sub_time_us;
+  std::array<std::size_t, MAX_VMS_SUBRATES + 1> sub_period = {};
+  auto keep_min = [](const std::size_t i, const double t,
+                     std::vector<double> * const v) {
+    if (i < v->size()) {
+      (*v)[i] = std::min((*v)[i], t);
+    } else {
+      v->push_back(t);
+    }
+  };
+  for (std::size_t rep = 0; rep < opt.repeats; rep++) {
+    Sweep sweep(opt.seed);
+    auto model = std::make_unique<BenchVms>();
+    model->initialize();
+    std::array<std::size_t, MAX_VMS_SUBRATES + 1> num_rel = {}, last_rel = {};
+    for (std::size_t f = 0; f < opt.warmup + opt.frames; f++) {
+      sweep.Next(f);
+      /* Releases are read before the base rate advances the counters */
+      std::array<bool, MAX_VMS_SUBRATES + 1> rel = {};
+#ifdef rtmStepTask
+      for (int8_t tid = 1; tid <= NUM_SUBRATES; tid++) {
+        rel[tid] = rtmStepTask(model->getRTM(), tid);
+      }
+#endif
+      auto t0 = std::chrono::steady_clock::now();
+      VmsAutocodeRun(model.get(), sweep.sys(), sweep.sensor(),
+                     sweep.nav(), sweep.telem(), &telem_view, &vms);
+      auto t1 = std::chrono::steady_clock::now();
+      if (f >= opt.warmup) {
+        double t = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        time_us[f - opt.warmup] = std::min(time_us[f - opt.warmup],
+                                           t * opt.cpu_scale);
+      }
+      for (int8_t tid = 1; tid <= NUM_SUBRATES; tid++) {
+        if (!rel[tid]) {continue;}
+        t0 = std::chrono::steady_clock::now();
+        VmsAutocodeStep(model.get(), tid);
+        t1 = std::chrono::steady_clock::now();
+        if (f >= opt.warmup) {
+          double t = std::chrono::duration<double, std::micro>(
+            t1 - t0).count();
+          keep_min(num_rel[tid]++, t * opt.cpu_scale, &sub_time_us[tid]);
+          if (last_rel[tid] > 0) {sub_period[tid] = f - last_rel[tid];}
+        }
+        last_rel[tid] = f;
+      }
+    }
+  }
+  /*
+  * Telemetry input at the autocode boundary, the full TelemData against
+  * the view, and the time to copy each per frame
+  */
+  Sweep sweep(opt.seed);
+  auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    telem_copy = sweep.telem();
+    KeepStores(telem_copy);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (std::size_t f = 0; f < opt.frames; f++) {
+    VmsTelemUpdate(sweep.telem(), &telem_view);
+    telem_view_copy = telem_view;
+    KeepStores(telem_view_copy);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  double full_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+  double view_us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+  std::cout << "VMS: " << VMS_NAME_ << std::endl;
+  std::cout << std::fixed << std::setprecision(2)
+            << "Telemetry input per frame: TelemData " << sizeof(TelemData)
+            << " B, " << 1e3 * opt.cpu_scale * full_us / opt.frames
+            << " ns; VmsTelemData " << sizeof(VmsTelemData) << " B, "
+            << 1e3 * opt.cpu_scale * view_us / opt.frames << " ns; model takes "
+            << (VmsTelemViewInput<BenchVms> ? "VmsTelemData" :
+                "TelemData") << std::endl;
+  /* Statistics */
+  std::vector<double> sorted = time_us;
+  std::sort(sorted.begin(), sorted.end());
+  auto pct = [&sorted](const double p) {
+    std::size_t i = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return sorted[i];
+  };
+  double mean = 0;
+  for (double t : time_us) {mean += t;}
+  mean /= static_cast<double>(time_us.size());
+  double worst = sorted.back();
+  double budget_us = opt.budget * FRAME_PERIOD_MS * 1000;
+  std::cout << std::fixed << std::setprecision(2)
+            << "Frames: " << time_us.size() << ", CPU scale: "
+            << opt.cpu_scale << std::endl
+            << "VMS time, us: mean " << mean << ", median " << pct(0.5)
+            << ", 99% " << pct(0.99) << ", 99.9% " << pct(0.999)
+            << ", worst " << worst << std::endl
+            << "Budget: " << budget_us << " us (" << opt.budget * 100
+            << "% of " << FRAME_PERIOD_MS << " ms), worst case uses "
+            << 100 * worst / budget_us << "%" << std::endl;
+  /*
+  * Rate groups run from the main loop, in the frame time the base rate
+  * and the rest of the background loop leave, so each must fit in that
+  * time over its period
+  */
+  double background_us = opt.background * FRAME_PERIOD_MS * 1000;
+  std::cout << "Background: " << background_us << " us ("
+            << opt.background * 100 << "% of " << FRAME_PERIOD_MS
+            << " ms) kept for the rest of the main loop" << std::endl;
+  bool pass = worst <= budget_us;
+  for (int8_t tid = 1; tid <= NUM_SUBRATES; tid++) {
+    const std::vector<double> &t = sub_time_us[tid];
+    if (t.empty()) {continue;}
+    double sub_worst = *std::max_element(t.begin(), t.end());
+    double avail_us = static_cast<double>(sub_period[tid]) *
+                      std::max(FRAME_PERIOD_MS * 1000 - worst -
+                               background_us, 0.0);
+    std::cout << "Rate group " << static_cast<int>(tid) << ": every "
+              << sub_period[tid] << " frames, worst " << sub_worst
+              << " us of " << avail_us << " us available" << std::endl;
+    pass = pass && (sub_worst <= avail_us);
+  }
+  if (!pass) {
+    std::cout << "FAIL: VMS worst case exceeds its budget" << std::endl;
+    return 1;
+  }
+  std::cout << "PASS" << std::endl;
+  return 0;
+}
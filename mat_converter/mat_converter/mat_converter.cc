@@ -25,7 +25,14 @@
 
 #include <stdio.h>
 #include <google/protobuf/message.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
 #include "framing/framing.h"
 #include "mat_v4/mat_v4.h"
 #include "Eigen/Core"
@@ -40,38 +47,11 @@
 #include "./datalog_fmu_v1.pb.h"
 #endif
 
-int main(int argc, char** argv) {
-  /* Verify version of protobuf */
-  GOOGLE_PROTOBUF_VERIFY_VERSION;
-  /* Grab the input filename */
-  if (argc != 2) {
-    std::cerr << "Usage:  " << argv[0] << " <FLIGHT DATA FILE>" << std::endl;
-    return -1;
-  }
-  /* Input file name */
-  std::string input_file_name(argv[1]);
-  /* Check input file extension */
-  std::string bfs_ext = ".bfs";
-  std::cout << "Parsing file " << input_file_name << "...";
-  if (input_file_name.compare(input_file_name.length() - bfs_ext.length(), bfs_ext.length(), bfs_ext) != 0) {
-    std::cerr << "ERROR: Input file must be a BFS log file, which has a .bfs extension." << std::endl;
-    return -1;
-  }
-  /* Try to read the flight data */
-  FILE *input = fopen(input_file_name.c_str(), "rb");
-  if (!input) {
-    std::cerr << "ERROR: Unable to open input file, maybe the path is incorrect." << std::endl;
-    return -1;
-  }
-  /* Create the output file */
-  std::string mat_ext = ".mat";
-  std::string output_file_name = input_file_name;
-  output_file_name.replace(output_file_name.length() - bfs_ext.length(), bfs_ext.length(), mat_ext);
-  FILE *output = fopen(output_file_name.c_str(), "wb");
-  if (!output) {
-    std::cerr << "ERROR: Unable to open output file." << std::endl;
-    return -1;
-  }
+/*
+* Converts a datalog to MATLAB v4 fields, returning the number of packets,
+* bytes, and fields, or false on an unsupported field
+*/
+bool Convert(FILE *input, FILE *output, std::size_t *packets, std::size_t *bytes, std::size_t *fields) {
   /* The message type */
   DatalogMessage datalog;
   /* Read file in chunks */
@@ -82,7 +62,9 @@ int main(int argc, char** argv) {
   bfs::Decoder<CHUNK_SIZE> temp_decoder;
   /* Iterate through the file once to get the length to allow us to pre-allocate arrays */
   std::size_t num_packets = 0;
+  std::size_t num_bytes = 0;
   while ((bytes_read = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+    num_bytes += bytes_read;
     for (std::size_t i = 0; i < bytes_read; i++) {
       if (temp_decoder.Found(buffer[i])) {
         if (datalog.ParseFromArray(temp_decoder.Data(), temp_decoder.Size())) {
@@ -101,6 +83,9 @@ int main(int argc, char** argv) {
   const google::protobuf::Reflection* reflection = datalog.GetReflection();
   /* Number of fields */
   std::size_t field_count = descriptor->field_count();
+  *packets = num_packets;
+  *bytes = num_bytes;
+  *fields = field_count;
   /* Iterate through fields */
   for (std::size_t field = 0; field < field_count; field++) {
     /* Get the field name */
@@ -234,14 +219,132 @@ int main(int argc, char** argv) {
       default: {
         std::cout << cpp_type << std::endl;
         std::cerr << "ERROR: Unsupported data type." << std::endl;
-        return -1;
+        return false;
       }
     }
   }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  /* Verify version of protobuf */
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  /*
+  * Grab the input filename and, optionally, a JSON file for the conversion
+  * time and the number of times to repeat the conversion
+  */
+  std::string json_prefix = "--json=", repeats_prefix = "--repeats=";
+  std::string json_file_name;
+  long repeats = 1;
+  bool args_ok = (argc >= 2);
+  for (int i = 2; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.rfind(json_prefix, 0) == 0) {
+      json_file_name = arg.substr(json_prefix.length());
+    } else if (arg.rfind(repeats_prefix, 0) == 0) {
+      repeats = std::strtol(arg.c_str() + repeats_prefix.length(), nullptr, 10);
+      args_ok = args_ok && (repeats > 0);
+    } else {
+      args_ok = false;
+    }
+  }
+  if (!args_ok) {
+    std::cerr << "Usage:  " << argv[0] << " <FLIGHT DATA FILE> [--json=mat_converter.json] [--repeats=1]" << std::endl;
+    return -1;
+  }
+  /* Input file name */
+  std::string input_file_name(argv[1]);
+  /* Check input file extension */
+  std::string bfs_ext = ".bfs";
+  std::cout << "Parsing file " << input_file_name << "...";
+  if (input_file_name.compare(input_file_name.length() - bfs_ext.length(), bfs_ext.length(), bfs_ext) != 0) {
+    std::cerr << "ERROR: Input file must be a BFS log file, which has a .bfs extension." << std::endl;
+    return -1;
+  }
+  /* Try to read the flight data */
+  FILE *input = fopen(input_file_name.c_str(), "rb");
+  if (!input) {
+    std::cerr << "ERROR: Unable to open input file, maybe the path is incorrect." << std::endl;
+    return -1;
+  }
+  /*
+  * Read the flight data into memory and convert it to memory, so the
+  * conversion time doesn't include file I/O. Each repeat is timed, giving
+  * a sample of conversion times rather than a single one.
+  */
+  std::vector<char> data;
+  char chunk[4096];
+  std::size_t chunk_read;
+  while ((chunk_read = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+    data.insert(data.end(), chunk, chunk + chunk_read);
+  }
+  fclose(input);
+  std::size_t num_packets = 0, num_bytes = 0, field_count = 0;
+  std::vector<double> duration_s;
+  char *mat = nullptr;
+  std::size_t mat_size = 0;
+  for (long rep = 0; rep < repeats; rep++) {
+    free(mat);
+    mat = nullptr;
+    FILE *mem_input = fmemopen(data.data(), data.size(), "rb");
+    FILE *mem_output = open_memstream(&mat, &mat_size);
+    if (!mem_input || !mem_output) {
+      std::cerr << "ERROR: Unable to allocate conversion buffers." << std::endl;
+      return -1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool ok = Convert(mem_input, mem_output, &num_packets, &num_bytes, &field_count);
+    fflush(mem_output);
+    duration_s.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    fclose(mem_input);
+    fclose(mem_output);
+    if (!ok) {
+      free(mat);
+      return -1;
+    }
+  }
+  /* Create the output file */
+  std::string mat_ext = ".mat";
+  std::string output_file_name = input_file_name;
+  output_file_name.replace(output_file_name.length() - bfs_ext.length(), bfs_ext.length(), mat_ext);
+  FILE *output = fopen(output_file_name.c_str(), "wb");
+  if (!output) {
+    std::cerr << "ERROR: Unable to open output file." << std::endl;
+    free(mat);
+    return -1;
+  }
+  std::size_t mat_written = fwrite(mat, 1, mat_size, output);
+  fclose(output);
+  free(mat);
+  if (mat_written != mat_size) {
+    std::cerr << "ERROR: Unable to write output file." << std::endl;
+    return -1;
+  }
+  /* Mean and median conversion time */
+  std::vector<double> sorted = duration_s;
+  std::sort(sorted.begin(), sorted.end());
+  double median_s = sorted[(sorted.size() - 1) / 2];
+  double mean_s = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
   /* Print out closing info */
   std::cout << "done." << std::endl;
   std::cout << "Wrote " << field_count << " fields and " << num_packets << " data packets." << std::endl;
   std::cout << "Saved as " << output_file_name << std::endl;
+  std::cout << "Converted " << num_bytes / 1e6 / median_s << " MB/s, median of " << repeats << " runs" << std::endl;
+  /* Conversion time per packet, in the format of the host benchmarks */
+  if (!json_file_name.empty()) {
+    std::ofstream json(json_file_name);
+    if (!json) {
+      std::cerr << "ERROR: Unable to write " << json_file_name << std::endl;
+      return -1;
+    }
+    double per_packet = (num_packets > 0) ? 1e9 / num_packets : 0;
+    json << "{\n"
+         << "  \"context\": {\"bytes\": " << num_bytes << ", \"mb_per_s\": " << num_bytes / 1e6 / median_s << ", \"repeats\": " << repeats << "},\n"
+         << "  \"benchmarks\": [\n"
+         << "    {\"name\": \"mat_converter\", \"calls\": " << num_packets << ", \"mean_ns\": " << mean_s * per_packet << ", \"median_ns\": " << median_s * per_packet << "}\n"
+         << "  ]\n}\n";
+    std::cout << "Wrote " << json_file_name << std::endl;
+  }
   return 0;
 }
 
@@ -0,0 +1,32 @@
+function export_aircraft(vehicle, path)
+% Exports the numeric parameters of an aircraft configuration to a data
+% file read by the host simulation models, i.e.
+% export_aircraft('ultra_stick_25e', './aircraft/ultra_stick_25e.dat')
+%
+% Each line holds a parameter name, relative to the Aircraft struct, its
+% number of rows and columns, and its values in row order. Lines starting
+% with % are comments. Strings are not exported.
+
+run(strcat('./aircraft/', vehicle));
+fid = fopen(path, 'w');
+fprintf(fid, '%% Generated from %s.m by export_aircraft.m\n', vehicle);
+write_struct(fid, '', Aircraft);
+fclose(fid);
+
+end
+
+function write_struct(fid, prefix, s)
+names = fieldnames(s);
+for i = 1:numel(names)
+    val = s.(names{i});
+    name = strcat(prefix, names{i});
+    if isstruct(val)
+        write_struct(fid, strcat(name, '.'), val);
+    elseif isnumeric(val) || islogical(val)
+        [rows, cols] = size(val);
+        fprintf(fid, '%s %d %d', name, rows, cols);
+        fprintf(fid, ' %.10g', double(val'));
+        fprintf(fid, '\n');
+    end
+end
+end
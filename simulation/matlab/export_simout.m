@@ -0,0 +1,31 @@
+function export_simout(data, path)
+% Exports a time history for validating the host aircraft models with
+% host/sim_validate, i.e. export_simout(load('flight_data.mat'), 'run.csv')
+%
+% data holds the datalog fields, one row per frame, as written by the MAT
+% converter or logged from the datalog bus of a Simulink run. Each row of
+% the output holds the time, the 8 PWM and 16 SBUS effector commands, and
+% the NED position and velocity, Euler angles, rotation rates, and
+% accelerations of the navigation solution.
+
+if isfield(data, 'sys_time_s')
+    t = double(data.sys_time_s);
+else
+    t = double(data.sys_time_us) / 1e6;
+end
+out = [t, double(data.vms_pwm_cmd), double(data.vms_sbus_cmd), ...
+       double(data.nav_ned_pos_m), double(data.nav_ned_vel_mps), ...
+       double(data.nav_roll_rad), double(data.nav_pitch_rad), ...
+       double(data.nav_heading_rad), double(data.nav_gyro_radps), ...
+       double(data.nav_accel_mps2)];
+fid = fopen(path, 'w');
+fprintf(fid, 'time_s');
+fprintf(fid, ',pwm_cmd_%d', 1:size(data.vms_pwm_cmd, 2));
+fprintf(fid, ',sbus_cmd_%d', 1:size(data.vms_sbus_cmd, 2));
+fprintf(fid, ',pos_n_m,pos_e_m,pos_d_m,vel_n_mps,vel_e_mps,vel_d_mps');
+fprintf(fid, ',roll_rad,pitch_rad,heading_rad');
+fprintf(fid, ',p_radps,q_radps,r_radps,ax_mps2,ay_mps2,az_mps2\n');
+fprintf(fid, [repmat('%.9g,', 1, size(out, 2) - 1), '%.9g\n'], out');
+fclose(fid);
+
+end
@@ -0,0 +1,34 @@
+function gains = gain_table_lookup(x_bp, y_bp, val, x, y)
+% Gain table lookup for MATLAB Function blocks in VMS models. val is
+% indexed (gain, y, x), m gains over numel(y_bp) by numel(x_bp)
+% breakpoints; y_bp is a scalar for a schedule over a single variable. In
+% generated code this calls GainTableLookup from flight/gain_table.h, which
+% starts its search from the intervals of the last call, so the model
+% needs the header included as custom code. In simulation it interpolates
+% with interp1 or interp2, holding the values at the table edges.
+persistent idx
+if isempty(idx)
+    idx = zeros(2, 1, 'int32');
+end
+m = size(val, 1);
+gains = zeros(m, 1, 'single');
+if coder.target('MATLAB') || coder.target('Sfun')
+    xq = min(max(x, x_bp(1)), x_bp(end));
+    yq = min(max(y, y_bp(1)), y_bp(end));
+    for k = 1:m
+        v = reshape(val(k, :, :), numel(y_bp), numel(x_bp));
+        if numel(y_bp) == 1
+            gains(k) = interp1(x_bp, v, xq);
+        else
+            gains(k) = interp2(x_bp, y_bp, v, xq, yq);
+        end
+    end
+else
+    coder.cinclude('flight/gain_table.h');
+    coder.ceval('GainTableLookup', coder.rref(single(x_bp)), ...
+                int32(numel(x_bp)), coder.rref(single(y_bp)), ...
+                int32(numel(y_bp)), coder.rref(single(val)), int32(m), ...
+                single(x), single(y), coder.ref(idx), coder.wref(gains));
+end
+
+end
@@ -0,0 +1,37 @@
+function vms_telem_bus(num_telem_params)
+% Defines the VmsTelemData bus in the base workspace, the slim telemetry
+% input of the VMS. Models that take it on their telemetry inport, in place
+% of TelemData, are passed the active flight plan leg instead of the full
+% flight plan, fence, and rally point arrays; flight/vms_telem.h picks the
+% input from the generated interface. The bus is imported from
+% global_defs.h, like the other bus definitions.
+
+elems = { ...
+    'waypoints_updated', 'boolean', 1; ...
+    'fence_updated', 'boolean', 1; ...
+    'rally_points_updated', 'boolean', 1; ...
+    'current_waypoint', 'int16', 1; ...
+    'num_waypoints', 'int16', 1; ...
+    'num_fence_items', 'int16', 1; ...
+    'num_rally_points', 'int16', 1; ...
+    'param', 'single', num_telem_params; ...
+    'waypoint', 'Bus: MissionItem', 1; ...
+    'next_waypoint', 'Bus: MissionItem', 1; ...
+    'leg_ned_m', 'single', 3; ...
+    'leg_dist_m', 'single', 1; ...
+    'leg_course_rad', 'single', 1};
+bus = Simulink.Bus;
+bus.HeaderFile = 'global_defs.h';
+bus.DataScope = 'Imported';
+bus.Description = ['Telemetry view passed to the VMS, with the active ' ...
+                   'leg of the flight plan in place of the mission arrays'];
+for i = 1:size(elems, 1)
+    e = Simulink.BusElement;
+    e.Name = elems{i, 1};
+    e.DataType = elems{i, 2};
+    e.Dimensions = elems{i, 3};
+    bus.Elements(end + 1) = e;
+end
+assignin('base', 'VmsTelemData', bus);
+
+end
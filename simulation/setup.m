@@ -61,6 +61,9 @@ else
     load('./data/fmu_v1_bus_defs.mat');
 end
 framePeriod_s = 1/frameRate_hz;
+% Slim telemetry input of the VMS
+Telem.NUM_PARAMS = 24;
+vms_telem_bus(Telem.NUM_PARAMS);
 
 %% Trim
 %trim();